@@ -71,9 +71,11 @@ class Bus {
         if(isAsynchronous() && !running_) {
             running_ = true;
 
-            receiveThread_ = std::thread(&Bus::receiveWorker, this);
-            if(!setThreadPriority(receiveThread_, options_->priorityReceiveThread_)) {
-                MELO_WARN("Failed to set receive thread priority for bus %s:\n  %s", options_->name_.c_str(), strerror(errno));
+            if(hasReceiveThread()) {
+                receiveThread_ = std::thread(&Bus::receiveWorker, this);
+                if(!setThreadPriority(receiveThread_, options_->priorityReceiveThread_)) {
+                    MELO_WARN("Failed to set receive thread priority for bus %s:\n  %s", options_->name_.c_str(), strerror(errno));
+                }
             }
 
             transmitThread_ = std::thread(&Bus::transmitWorker, this);
@@ -234,10 +236,7 @@ public: /// Internal functions
     inline bool readMessage()
     {
         if(readData()) {
-            if(isPassive_ && options_->activateBusOnReception_ && !errorMsgFlag_) {
-                isPassive_ = false;
-                MELO_WARN("Auto-activated bus %s", options_->name_.c_str());
-            }
+            activateOnReception();
             return true;
         }
         return false;
@@ -285,6 +284,20 @@ public: /// Internal functions
      */
     virtual bool writeData(std::unique_lock<std::mutex>* lock) = 0;
 
+    /*!
+     * @return false if the messages of this bus are read by another object, e.g. a receiver shared by several buses.
+     *         startThreads() then does not start a receive thread.
+     */
+    virtual bool hasReceiveThread() const { return true; }
+
+    //! Activates a passive bus after a message was read, if configured with BusOptions::activateBusOnReception_
+    inline void activateOnReception() {
+        if(isPassive_ && options_->activateBusOnReception_ && !errorMsgFlag_) {
+            isPassive_ = false;
+            MELO_WARN("Auto-activated bus %s", options_->name_.c_str());
+        }
+    }
+
     /*! Is called after reception of a message, routes the message to the callbacks.
      * @param cmsg  reference to the can message
      */
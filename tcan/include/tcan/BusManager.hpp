@@ -52,6 +52,8 @@ class BusManager {
     /*!
      * Send the messages in the output queue on all buses. Call this function in the control loop if synchronous mode is used.
      * Note that this function may not send all the messages in the output queue if BlockingWrite is disabled (see BusOptions)
+     * A bus whose write does not take a message, e.g. because the netdevice is congested (ENOBUFS) or the bus is passive,
+     * is retried in the next call instead of spinning.
      * @return  False if at least one write error occurred
      */
     bool writeMessagesSynchronous() {
@@ -62,14 +64,16 @@ class BusManager {
 
             for(auto bus : buses_) {
                 if(bus->isSynchronous() && bus->getNumOutgoingMessagesWithoutLock() > 0) {
+                    const unsigned int numMessages = bus->getNumOutgoingMessagesWithoutLock();
                     noError &= bus->writeMessages( nullptr );
-                    sendingData = true;
+                    sendingData |= (bus->getNumOutgoingMessagesWithoutLock() < numMessages);
                 }else if(bus->isSemiSynchronous()) {
                     // we need to acquire lock here because the callbacks of incoming messages may put new messages in the output queue
                     std::unique_lock<std::mutex> lock( bus->getOutgoingMsgsMutex() );
-                    if(bus->getNumOutgoingMessagesWithoutLock() > 0) {
+                    const unsigned int numMessages = bus->getNumOutgoingMessagesWithoutLock();
+                    if(numMessages > 0) {
                         noError &= bus->writeMessages( &lock );
-                        sendingData = true;
+                        sendingData |= (bus->getNumOutgoingMessagesWithoutLock() < numMessages);
                     }
                 }
             }
@@ -258,6 +262,11 @@ class BusManager {
         }
 
         while(running_) {
+            // a bus may replace its socket, e.g. after its interface was added again
+            for(unsigned int i=0; i<numFds; ++i) {
+                fds[i].fd = buses_[busIndices[i]]->getPollableFileDescriptor();
+            }
+
             int ret = poll( fds, numFds, 500 /*timeout [ms]*/ );
 
             if ( ret == -1 ) {
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstring> // memcpy
+#include <type_traits>
+#include <utility>
+
+namespace tcan {
+
+template <typename Signature>
+class Delegate;
+
+/*!
+ * Non-owning, trivially copyable reference to a member function bound to an object.
+ * Unlike std::function with std::bind, constructing a delegate never allocates and calling it is a single indirect
+ * call through a thunk, which restores the member function pointer and invokes it on the object.
+ * The caller has to ensure that the bound object outlives the delegate.
+ */
+template <typename R, typename... Args>
+class Delegate<R(Args...)> {
+ private:
+    struct Dummy {};
+    using MethodStorage = typename std::aligned_storage<sizeof(R (Dummy::*)(Args...)), alignof(R (Dummy::*)(Args...))>::type;
+    using Stub = R (*)(void*, const MethodStorage&, Args...);
+
+ public:
+    Delegate():
+        object_(nullptr),
+        stub_(nullptr),
+        method_()
+    {
+    }
+
+    /*!
+     * Bind a member function to an object
+     * @param object    object to call the member function on
+     * @param method    pointer to the member function
+     */
+    template <class T>
+    Delegate(T* object, R (std::common_type<T>::type::*method)(Args...)):
+        object_(object),
+        stub_(&methodStub<T, R (T::*)(Args...)>),
+        method_()
+    {
+        storeMethod(method);
+    }
+
+    template <class T>
+    Delegate(const T* object, R (std::common_type<T>::type::*method)(Args...) const):
+        object_(const_cast<T*>(object)),
+        stub_(&methodStub<const T, R (T::*)(Args...) const>),
+        method_()
+    {
+        storeMethod(method);
+    }
+
+    /*!
+     * Bind a callable object (e.g. a lambda or std::function) by reference. Does not take ownership of the callable.
+     * @param callable  pointer to the callable
+     */
+    template <class F>
+    static Delegate fromCallable(F* callable) {
+        Delegate delegate;
+        delegate.object_ = callable;
+        delegate.stub_ = &callableStub<F>;
+        return delegate;
+    }
+
+    inline R operator()(Args... args) const { return stub_(object_, method_, std::forward<Args>(args)...); }
+
+    inline explicit operator bool() const { return stub_ != nullptr; }
+
+    inline bool operator==(const Delegate& other) const {
+        return object_ == other.object_ && stub_ == other.stub_ && std::memcmp(&method_, &other.method_, sizeof(MethodStorage)) == 0;
+    }
+
+    inline bool operator!=(const Delegate& other) const { return !(*this == other); }
+
+    //! @return the object the delegate is bound to
+    inline void* getObject() const { return object_; }
+
+ private:
+    template <typename Method>
+    inline void storeMethod(const Method method) {
+        static_assert(sizeof(Method) <= sizeof(MethodStorage), "Member function pointer does not fit into delegate storage");
+        std::memcpy(&method_, &method, sizeof(Method));
+    }
+
+    template <class T, typename Method>
+    static R methodStub(void* object, const MethodStorage& storage, Args... args) {
+        Method method;
+        std::memcpy(&method, &storage, sizeof(Method));
+        return (static_cast<T*>(object)->*method)(std::forward<Args>(args)...);
+    }
+
+    template <class F>
+    static R callableStub(void* object, const MethodStorage& /*storage*/, Args... args) {
+        return (*static_cast<F*>(object))(std::forward<Args>(args)...);
+    }
+
+ private:
+    void* object_;
+    Stub stub_;
+    MethodStorage method_;
+};
+
+} /* namespace tcan */
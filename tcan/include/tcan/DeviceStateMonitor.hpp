@@ -0,0 +1,172 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "tcan/Delegate.hpp"
+#include "tcan/RcuPointer.hpp"
+
+namespace tcan {
+
+/*!
+ * Aggregated state of all devices of a bus. The devices report their state transitions, which update a counter per
+ * state. Whether all devices are active or missing is therefore known without iterating the devices. The counters are
+ * updated under a lock, so getCounters() returns a snapshot in which every device is counted exactly once.
+ * Observers are notified on every transition, by the thread causing it (receive or sanity check thread in most cases).
+ * @tparam Device   device class, defining the enum State with the values Initializing, Active, Error and Missing
+ */
+template <class Device>
+class DeviceStateMonitor {
+ public:
+    using State = typename Device::State;
+    using Observer = Delegate<void(const Device& device, const State previous, const State current)>;
+    using ObserverHandle = uint32_t;
+
+    static constexpr ObserverHandle InvalidObserver = 0;
+
+    //! Number of devices per state
+    struct Counters {
+        unsigned int numDevices_ = 0;
+        unsigned int numInitializing_ = 0;
+        unsigned int numActive_ = 0;
+        unsigned int numError_ = 0;
+        unsigned int numMissing_ = 0;
+
+        //! @return true if all devices are active (or there are no devices)
+        inline bool allDevicesActive() const { return numActive_ == numDevices_; }
+
+        //! @return true if all devices are missing (or there are no devices)
+        inline bool allDevicesMissing() const { return numMissing_ == numDevices_; }
+
+        //! @return true if at least one device is missing or has an error
+        inline bool isMissingDeviceOrHasError() const { return numMissing_ != 0 || numError_ != 0; }
+    };
+
+    DeviceStateMonitor():
+        countersMutex_(),
+        counters_(),
+        observers_(std::unique_ptr<ObserverContainer>(new ObserverContainer())),
+        nextObserverHandle_(InvalidObserver + 1)
+    {
+    }
+
+    /*!
+     * Add an observer, which is called on every state transition of a device.
+     * @param observer  delegate to be called. Has to return quickly, as it is called on the bus threads.
+     * @return handle to be used for removeObserver(..)
+     */
+    inline ObserverHandle addObserver(const Observer& observer) {
+        const ObserverHandle handle = nextObserverHandle_++;
+        observers_.update([&](ObserverContainer& observers) { observers.emplace_back(handle, observer); });
+        return handle;
+    }
+
+    template <class T>
+    inline ObserverHandle addObserver(T* object, void (std::common_type<T>::type::*fp)(const Device&, const State, const State)) {
+        return addObserver(Observer(object, fp));
+    }
+
+    /*!
+     * Remove an observer
+     * @param handle    handle returned by addObserver(..)
+     * @return true if the observer existed
+     */
+    inline bool removeObserver(const ObserverHandle handle) {
+        bool isRemoved = false;
+        observers_.update([&](ObserverContainer& observers) {
+            for(auto it = observers.begin(); it != observers.end(); ++it) {
+                if(it->first == handle) {
+                    observers.erase(it);
+                    isRemoved = true;
+                    break;
+                }
+            }
+        });
+        return isRemoved;
+    }
+
+    //! @return consistent snapshot of the counters
+    inline Counters getCounters() const {
+        std::lock_guard<std::mutex> lock(countersMutex_);
+        return counters_;
+    }
+
+    inline unsigned int getNumDevices() const { return getCounters().numDevices_; }
+    inline unsigned int getNumInitializing() const { return getCounters().numInitializing_; }
+    inline unsigned int getNumActive() const { return getCounters().numActive_; }
+    inline unsigned int getNumError() const { return getCounters().numError_; }
+    inline unsigned int getNumMissing() const { return getCounters().numMissing_; }
+
+    //! @return true if all devices are active (or there are no devices)
+    inline bool allDevicesActive() const { return getCounters().allDevicesActive(); }
+
+    //! @return true if all devices are missing (or there are no devices)
+    inline bool allDevicesMissing() const { return getCounters().allDevicesMissing(); }
+
+    //! @return true if at least one device is missing or has an error
+    inline bool isMissingDeviceOrHasError() const { return getCounters().isMissingDeviceOrHasError(); }
+
+ public: /// Internal functions
+    /*!
+     * Registers a device. Is called by the bus when the device is added.
+     * @param state     current state of the device
+     */
+    inline void addDevice(const State state) {
+        std::lock_guard<std::mutex> lock(countersMutex_);
+        ++getCounter(state);
+        ++counters_.numDevices_;
+    }
+
+    /*!
+     * Is called by the device on a state transition
+     * @param device    device changing its state
+     * @param previous  state before the transition
+     * @param current   state after the transition
+     */
+    inline void onStateChanged(const Device& device, const State previous, const State current) {
+        {
+            std::lock_guard<std::mutex> lock(countersMutex_);
+            ++getCounter(current);
+            --getCounter(previous);
+        }
+
+        const auto observers = observers_.read();
+        for(const auto& observer : *observers) {
+            observer.second(device, previous, current);
+        }
+    }
+
+ protected:
+    using ObserverContainer = std::vector<std::pair<ObserverHandle, Observer>>;
+
+    //! countersMutex_ has to be locked
+    inline unsigned int& getCounter(const State state) {
+        switch(state) {
+            case Device::Active:
+                return counters_.numActive_;
+            case Device::Error:
+                return counters_.numError_;
+            case Device::Missing:
+                return counters_.numMissing_;
+            default: // fall-through!
+            case Device::Initializing:
+                return counters_.numInitializing_;
+        }
+    }
+
+ protected:
+    mutable std::mutex countersMutex_;
+    Counters counters_;
+
+    RcuPointer<ObserverContainer> observers_;
+    std::atomic<ObserverHandle> nextObserverHandle_;
+};
+
+template <class Device>
+constexpr typename DeviceStateMonitor<Device>::ObserverHandle DeviceStateMonitor<Device>::InvalidObserver;
+
+} /* namespace tcan */
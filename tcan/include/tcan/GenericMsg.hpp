@@ -72,6 +72,7 @@ class GenericMsg {
 
     inline unsigned int getLength() const { return length_; }
     inline const uint8_t* getData() const { return data_; }
+    inline uint8_t* getData() { return data_; }
 
  private:
     unsigned int length_;
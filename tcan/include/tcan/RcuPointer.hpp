@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tcan {
+
+/*!
+ * Pointer to an immutable object, which can be read concurrently to being replaced (read-copy-update).
+ * Readers take a snapshot with read(). This is wait-free: it only increments a counter and loads the pointer. Writers
+ * modify a copy of the current object with update(..), publish it and delete the old object as soon as no reader started
+ * before the update holds it anymore (grace period).
+ * If update(..) is called by a thread holding a snapshot itself (e.g. a callback registering another callback), waiting
+ * for the grace period would dead-lock. The old object is then retired and deleted when a thread ends its read section,
+ * by a later update or by the destructor.
+ */
+template <class T>
+class RcuPointer {
+ public:
+    class ReadGuard {
+     public:
+        ReadGuard() = delete;
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        ReadGuard(ReadGuard&& other):
+            pointer_(other.pointer_),
+            readers_(other.readers_),
+            object_(other.object_)
+        {
+            other.readers_ = nullptr;
+        }
+
+        ~ReadGuard()
+        {
+            if(readers_ != nullptr) {
+                readers_->fetch_sub(1, std::memory_order_release);
+                if(--getReadSectionDepth() == 0 && pointer_->hasRetired_.load(std::memory_order_relaxed)) {
+                    // the thread does not hold a snapshot anymore, so it can wait for the grace period
+                    pointer_->reclaim();
+                }
+            }
+        }
+
+        inline const T& operator*() const { return *object_; }
+        inline const T* operator->() const { return object_; }
+
+     private:
+        friend class RcuPointer;
+
+        ReadGuard(const RcuPointer* pointer, std::atomic<unsigned int>* readers, const T* object):
+            pointer_(pointer),
+            readers_(readers),
+            object_(object)
+        {
+        }
+
+        const RcuPointer* pointer_;
+        std::atomic<unsigned int>* readers_;
+        const T* object_;
+    };
+
+    RcuPointer() = delete;
+    RcuPointer(const RcuPointer&) = delete;
+    RcuPointer& operator=(const RcuPointer&) = delete;
+
+    explicit RcuPointer(std::unique_ptr<T>&& object):
+        object_(object.release()),
+        epoch_(0),
+        readers_(),
+        writeMutex_(),
+        gracePeriodMutex_(),
+        retired_(),
+        hasRetired_(false)
+    {
+        readers_[0] = 0;
+        readers_[1] = 0;
+    }
+
+    //! No reader may hold a snapshot anymore
+    ~RcuPointer()
+    {
+        delete object_.load();
+        for(const T* retired : retired_) {
+            delete retired;
+        }
+    }
+
+    /*!
+     * Take a snapshot of the object. The snapshot stays valid until the returned guard is destructed.
+     * @return guard giving access to the object
+     */
+    inline ReadGuard read() const {
+        ++getReadSectionDepth();
+        std::atomic<unsigned int>* readers = &readers_[epoch_.load() & 1u];
+        readers->fetch_add(1);
+        return ReadGuard(this, readers, object_.load());
+    }
+
+    /*!
+     * Replace the object by a modified copy. Concurrent updates are serialized.
+     * @param function  function modifying the copy, taking a T&
+     */
+    template <class Function>
+    void update(Function&& function) {
+        std::vector<const T*> retired;
+        {
+            std::lock_guard<std::mutex> lock(writeMutex_);
+            T* copy = new T(*object_.load());
+            function(*copy);
+            retired_.push_back(object_.exchange(copy));
+            if(getReadSectionDepth() == 0) {
+                retired.swap(retired_);
+            }
+            hasRetired_.store(!retired_.empty(), std::memory_order_relaxed);
+        }
+
+        if(!retired.empty()) {
+            synchronize();
+            for(const T* object : retired) {
+                delete object;
+            }
+        }
+    }
+
+ protected:
+    //! Deletes the retired objects after a grace period. Must not be called in a read section.
+    void reclaim() const {
+        std::vector<const T*> retired;
+        {
+            std::lock_guard<std::mutex> lock(writeMutex_);
+            retired.swap(retired_);
+            hasRetired_.store(false, std::memory_order_relaxed);
+        }
+
+        if(!retired.empty()) {
+            synchronize();
+            for(const T* object : retired) {
+                delete object;
+            }
+        }
+    }
+
+    //! Waits until all readers which started before the call have finished
+    void synchronize() const {
+        std::lock_guard<std::mutex> lock(gracePeriodMutex_);
+        // flip the epoch twice, so that readers which loaded the epoch before the first flip are waited for regardless of
+        // the counter they incremented
+        for(int i = 0; i < 2; ++i) {
+            const unsigned int previous = epoch_.fetch_add(1) & 1u;
+            while(readers_[previous].load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    //! number of snapshots held by the calling thread, over all RcuPointers of type T. A snapshot of another pointer of
+    //! the same type only defers the deletion of old objects to the end of the read section.
+    inline static unsigned int& getReadSectionDepth() {
+        static thread_local unsigned int depth = 0;
+        return depth;
+    }
+
+ protected:
+    std::atomic<T*> object_;
+    mutable std::atomic<unsigned int> epoch_;
+    mutable std::atomic<unsigned int> readers_[2];
+
+    //! serializes writers and access to retired_
+    mutable std::mutex writeMutex_;
+    //! serializes grace periods, never held together with writeMutex_
+    mutable std::mutex gracePeriodMutex_;
+
+    //! objects replaced while the writer held a snapshot, deleted at the end of the next read section of a thread
+    mutable std::vector<const T*> retired_;
+    mutable std::atomic<bool> hasRetired_;
+};
+
+} /* namespace tcan */
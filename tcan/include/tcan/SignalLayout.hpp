@@ -0,0 +1,288 @@
+#pragma once
+
+#include <stdint.h>
+#include <cmath> // std::llround
+#include <cstring> // memcpy
+#include <ratio>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace tcan {
+
+//! Byte order of a signal in a message buffer
+enum class Endianness {
+    Little, // least significant byte first (Intel, CANopen, EtherCAT)
+    Big     // most significant byte first (Motorola)
+};
+
+namespace signal_layout_detail {
+
+//! Smallest unsigned integer holding Bytes bytes
+template <std::size_t Bytes>
+using Word = typename std::conditional<(Bytes <= 1), uint8_t,
+             typename std::conditional<(Bytes <= 2), uint16_t,
+             typename std::conditional<(Bytes <= 4), uint32_t, uint64_t>::type>::type>::type;
+
+inline uint8_t byteSwap(const uint8_t value) { return value; }
+inline uint16_t byteSwap(const uint16_t value) { return __builtin_bswap16(value); }
+inline uint32_t byteSwap(const uint32_t value) { return __builtin_bswap32(value); }
+inline uint64_t byteSwap(const uint64_t value) { return __builtin_bswap64(value); }
+
+//! Swap the bytes of value if the host byte order differs from E
+template <Endianness E, typename W>
+inline W convert(const W value) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    return E == Endianness::Little ? value : byteSwap(value);
+#else
+    return E == Endianness::Big ? value : byteSwap(value);
+#endif
+}
+
+template <std::size_t A, std::size_t B>
+struct Max : std::integral_constant<std::size_t, (A > B ? A : B)> {};
+
+template <std::size_t... Values>
+struct MaxOf;
+
+template <>
+struct MaxOf<> : std::integral_constant<std::size_t, 0> {};
+
+template <std::size_t First, std::size_t... Rest>
+struct MaxOf<First, Rest...> : Max<First, MaxOf<Rest...>::value> {};
+
+} /* namespace signal_layout_detail */
+
+/*!
+ * Integer signal at a fixed position of a message buffer. Reading and writing a signal is straight-line code: the bytes
+ * covered by the signal are copied into a single word with memcpy, byte swapped if the byte order differs from the one
+ * of the host, shifted and masked. No per-byte shifting or looping is involved.
+ *
+ * Bit positions count from the start of the buffer. For little endian signals, BitOffset is the position of the least
+ * significant bit, where bit i is bit (i % 8) of byte (i / 8). For big endian signals, BitOffset is the position of the
+ * most significant bit, where bit i is bit (7 - i % 8) of byte (i / 8). Either way, a byte aligned signal starting at
+ * byte n has BitOffset 8*n.
+ *
+ * @tparam Raw          integer type of the signal. Signed types are sign extended from BitLength bits.
+ * @tparam BitOffset    position of the signal in the buffer, see above
+ * @tparam BitLength    number of bits of the signal
+ * @tparam E            byte order of the signal
+ */
+template <typename Raw, std::size_t BitOffset, std::size_t BitLength = sizeof(Raw) * 8, Endianness E = Endianness::Little>
+struct Signal {
+    static_assert(std::is_integral<Raw>::value, "Raw type of a signal shall be an integer");
+    static_assert(BitLength > 0 && BitLength <= sizeof(Raw) * 8, "Bit length of a signal shall fit into its raw type");
+
+    using Value = Raw;
+
+    //! index of the first byte covered by the signal
+    static constexpr std::size_t FirstByte = BitOffset / 8;
+    //! shift of the signal within the first byte
+    static constexpr std::size_t BitShift = BitOffset % 8;
+    //! number of bytes covered by the signal
+    static constexpr std::size_t NumBytes = (BitShift + BitLength + 7) / 8;
+    //! minimum size of a buffer holding the signal
+    static constexpr std::size_t EndByte = FirstByte + NumBytes;
+
+    static_assert(NumBytes <= 8, "A signal shall not span more than 8 bytes");
+
+    using Word = signal_layout_detail::Word<NumBytes>;
+    using UnsignedRaw = typename std::make_unsigned<Raw>::type;
+
+    static constexpr std::size_t WordBits = sizeof(Word) * 8;
+    static constexpr Word Mask = static_cast<Word>(BitLength >= WordBits ? ~Word(0) : ((Word(1) << (BitLength % WordBits)) - 1));
+    //! right shift moving the signal to bit 0 of the loaded word
+    static constexpr std::size_t WordShift = E == Endianness::Little ? BitShift : WordBits - BitShift - BitLength;
+    //! true if the signal covers whole bytes, so it can be copied without masking
+    static constexpr bool IsByteAligned = BitShift == 0 && BitLength % 8 == 0;
+
+    /*!
+     * Read the signal from a buffer
+     * @param data  buffer of at least EndByte bytes
+     * @return value of the signal
+     */
+    static inline Raw unpack(const uint8_t* data) {
+        const UnsignedRaw value = static_cast<UnsignedRaw>((load(data) >> WordShift) & Mask);
+        return signExtend(value, std::is_signed<Raw>());
+    }
+
+    /*!
+     * Write the signal to a buffer. Bits of the buffer not covered by the signal are kept.
+     * @param data  buffer of at least EndByte bytes
+     * @param value value of the signal, truncated to BitLength bits
+     */
+    static inline void pack(uint8_t* data, const Raw value) {
+        const Word bits = static_cast<Word>((static_cast<Word>(static_cast<UnsignedRaw>(value)) & Mask) << WordShift);
+        if(IsByteAligned) {
+            store(data, bits);
+        }else{
+            store(data, static_cast<Word>((load(data) & ~static_cast<Word>(Mask << WordShift)) | bits));
+        }
+    }
+
+ private:
+    //! copy the covered bytes to the start of a word in E byte order, i.e. big endian signals end up in its upper bytes
+    static inline Word load(const uint8_t* data) {
+        Word word = 0;
+        std::memcpy(&word, data + FirstByte, NumBytes);
+        return signal_layout_detail::convert<E>(word);
+    }
+
+    static inline void store(uint8_t* data, const Word word) {
+        const Word converted = signal_layout_detail::convert<E>(word);
+        std::memcpy(data + FirstByte, &converted, NumBytes);
+    }
+
+    static inline Raw signExtend(const UnsignedRaw value, std::false_type /*isSigned*/) { return static_cast<Raw>(value); }
+
+    static inline Raw signExtend(const UnsignedRaw value, std::true_type /*isSigned*/) {
+        // computed in the unsigned type, which wraps instead of overflowing if the signal uses all bits of Raw
+        const UnsignedRaw signBit = static_cast<UnsignedRaw>(UnsignedRaw(1) << (BitLength - 1));
+        return static_cast<Raw>(static_cast<UnsignedRaw>(static_cast<UnsignedRaw>(value ^ signBit) - signBit));
+    }
+};
+
+template <typename Raw, std::size_t BitOffset, std::size_t BitLength, Endianness E>
+constexpr typename Signal<Raw, BitOffset, BitLength, E>::Word Signal<Raw, BitOffset, BitLength, E>::Mask;
+
+/*!
+ * Signal with a linear conversion between raw and physical value: value = raw * Scale + Offset.
+ * Encoding rounds to the nearest raw value for floating point values.
+ * @tparam T        type of the physical value
+ * @tparam RawSignal Signal holding the raw value
+ * @tparam Scale    std::ratio scaling the raw value
+ * @tparam Offset   std::ratio added to the scaled value
+ */
+template <typename T, class RawSignal, class Scale = std::ratio<1>, class Offset = std::ratio<0>>
+struct ScaledSignal {
+    using Value = T;
+    using Raw = typename RawSignal::Value;
+
+    static constexpr std::size_t EndByte = RawSignal::EndByte;
+
+    static inline T unpack(const uint8_t* data) {
+        return static_cast<T>(RawSignal::unpack(data)) * factor() + offset();
+    }
+
+    static inline void pack(uint8_t* data, const T value) {
+        RawSignal::pack(data, toRaw((value - offset()) / factor(), std::is_floating_point<T>()));
+    }
+
+ private:
+    static constexpr T factor() { return static_cast<T>(Scale::num) / static_cast<T>(Scale::den); }
+    static constexpr T offset() { return static_cast<T>(Offset::num) / static_cast<T>(Offset::den); }
+
+    static inline Raw toRaw(const T value, std::true_type /*isFloatingPoint*/) { return static_cast<Raw>(std::llround(value)); }
+    static inline Raw toRaw(const T value, std::false_type /*isFloatingPoint*/) { return static_cast<Raw>(value); }
+};
+
+/*!
+ * Access to the payload of a message type, used by SignalLayout to decode and encode messages.
+ * Works for all messages having getData() and getLength() functions (e.g. GenericMsg, CanMsg). Specialize it for
+ * other message types.
+ */
+template <class Msg>
+struct SignalBuffer {
+    static inline const uint8_t* getData(const Msg& msg) { return msg.getData(); }
+    static inline uint8_t* getData(Msg& msg) { return msg.getData(); }
+    static inline std::size_t getLength(const Msg& msg) { return msg.getLength(); }
+};
+
+/*!
+ * Typed list of signals making up a message. The signals of a layout are decoded into and encoded from a tuple of
+ * their values, all unrolled at compile time.
+ *
+ * Usage:
+ *   using Feedback = tcan::SignalLayout<
+ *       tcan::Signal<uint16_t, 0>,                                                          // status word
+ *       tcan::ScaledSignal<double, tcan::Signal<int32_t, 16>, std::ratio<1, 1000>>,         // position [mm] -> [m]
+ *       tcan::Signal<uint8_t, 48, 4>, tcan::Signal<uint8_t, 52, 4>>;                        // two nibbles
+ *   Feedback::Values values;
+ *   if(Feedback::decode(msg, values)) { double position = std::get<1>(values); }
+ */
+template <class... Signals>
+struct SignalLayout {
+    using Values = std::tuple<typename Signals::Value...>;
+
+    //! number of signals
+    static constexpr std::size_t NumSignals = sizeof...(Signals);
+    //! minimum size of a buffer holding all signals
+    static constexpr std::size_t Size = signal_layout_detail::MaxOf<Signals::EndByte...>::value;
+
+    template <std::size_t I>
+    using SignalAt = typename std::tuple_element<I, std::tuple<Signals...>>::type;
+
+    /*!
+     * Read a single signal from a buffer
+     * @param data  buffer of at least Size bytes
+     * @return value of signal I
+     */
+    template <std::size_t I>
+    static inline typename SignalAt<I>::Value get(const uint8_t* data) { return SignalAt<I>::unpack(data); }
+
+    /*!
+     * Write a single signal to a buffer
+     * @param data  buffer of at least Size bytes
+     * @param value value of signal I
+     */
+    template <std::size_t I>
+    static inline void set(uint8_t* data, const typename SignalAt<I>::Value value) { SignalAt<I>::pack(data, value); }
+
+    //! Read all signals from a buffer of at least Size bytes
+    static inline void decode(const uint8_t* data, Values& values) {
+        decode(data, values, std::index_sequence_for<Signals...>());
+    }
+
+    //! Write all signals to a buffer of at least Size bytes
+    static inline void encode(const Values& values, uint8_t* data) {
+        encode(values, data, std::index_sequence_for<Signals...>());
+    }
+
+    /*!
+     * Read all signals from a message
+     * @param msg       message, see SignalBuffer
+     * @param values    decoded values
+     * @return false if the message is shorter than Size
+     */
+    template <class Msg, typename = typename std::enable_if<std::is_class<Msg>::value>::type>
+    static inline bool decode(const Msg& msg, Values& values) {
+        if(SignalBuffer<Msg>::getLength(msg) < Size) {
+            return false;
+        }
+        decode(SignalBuffer<Msg>::getData(msg), values);
+        return true;
+    }
+
+    /*!
+     * Write all signals to a message. The message length is not changed.
+     * @param values    values to be encoded
+     * @param msg       message, see SignalBuffer
+     * @return false if the message is shorter than Size
+     */
+    template <class Msg, typename = typename std::enable_if<std::is_class<Msg>::value>::type>
+    static inline bool encode(const Values& values, Msg& msg) {
+        if(SignalBuffer<Msg>::getLength(msg) < Size) {
+            return false;
+        }
+        encode(values, SignalBuffer<Msg>::getData(msg));
+        return true;
+    }
+
+ private:
+    template <std::size_t... I>
+    static inline void decode(const uint8_t* data, Values& values, std::index_sequence<I...>) {
+        using expand = int[];
+        (void)expand{0, (std::get<I>(values) = Signals::unpack(data), 0)...};
+    }
+
+    template <std::size_t... I>
+    static inline void encode(const Values& values, uint8_t* data, std::index_sequence<I...>) {
+        using expand = int[];
+        (void)expand{0, (Signals::pack(data, std::get<I>(values)), 0)...};
+    }
+};
+
+template <class... Signals>
+constexpr std::size_t SignalLayout<Signals...>::Size;
+
+} /* namespace tcan */
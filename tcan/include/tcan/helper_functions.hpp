@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <thread>
 
 namespace tcan {
@@ -12,4 +14,13 @@ inline int calculatePollTimeoutMs(const timeval& tv) {
     return (tv.tv_sec*1000 + tv.tv_usec/1000)-1;
 }
 
+//! @return the smallest power of two which is not less than value, at most 2^31
+inline uint32_t roundUpToPowerOfTwo(const std::size_t value) {
+    uint32_t result = 1;
+    while(result < value && result < (1u << 31)) {
+        result <<= 1;
+    }
+    return result;
+}
+
 } // namespace tcan
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "tcan_can/CanBus.hpp"
+#include "tcan_can/SocketBusOptions.hpp"
+
+namespace tcan_can {
+
+/*!
+ * CAN bus using the linux broadcast manager (CAN_BCM), which sends cyclic frames with the high resolution timers of the
+ * kernel and filters received frames in the kernel.
+ *
+ * Transmission: messages passed to sendMessage(..) are sent once by the transmit thread. Cyclic messages, like SYNC,
+ * refreshed RPDOs or heartbeats, are registered with startCyclicMessage(..) and sent by the kernel until stopped. Their
+ * payload can be updated in place with updateCyclicMessage(..) without restarting the timer. Cyclic messages are also
+ * sent while the bus is passive.
+ *
+ * Reception: the broadcast manager only delivers frames with a receive job. A job is set up for every COB id subscribed
+ * with addCanMessage(..), masked subscriptions are not supported. By default every frame is delivered, with
+ * setContentFilter(..) only frames whose payload changed in the bits of the mask (or whose length changed) are. Note that
+ * the timeout counter of a device is only reset by delivered frames.
+ *
+ * Of the SocketBusOptions, canFdFrames_ selects CAN FD receive jobs (which only receive CAN FD frames) and sndBufLength_
+ * is applied. Error frames are not received.
+ */
+class BcmBus : public CanBus {
+ public:
+    BcmBus(const std::string& interface);
+    BcmBus(std::unique_ptr<SocketBusOptions>&& options);
+
+    ~BcmBus() override;
+
+    int getPollableFileDescriptor() const override { return socket_; }
+
+    /*!
+     * Start sending a message cyclically. Replaces the cyclic message with the same COB id and restarts its timer.
+     * @param msg       message to send, classic or CAN FD
+     * @param period    interval between two transmissions, > 0
+     * @return true if successful
+     */
+    bool startCyclicMessage(const CanMsg& msg, const std::chrono::microseconds& period);
+
+    /*!
+     * Replace the payload of a cyclic message, keeping its timer
+     * @param msg           message with the COB id of a cyclic message
+     * @param sendNow       send the message immediately, in addition to the cyclic transmissions
+     * @return true if successful. False if there is no cyclic message with this COB id.
+     */
+    bool updateCyclicMessage(const CanMsg& msg, const bool sendNow = false);
+
+    /*!
+     * Stop sending a cyclic message
+     * @param cobId     COB id of the message
+     * @return true if successful
+     */
+    bool stopCyclicMessage(const uint32_t cobId);
+
+    /*!
+     * Send SYNC messages cyclically, instead of calling sendSync()
+     * @param period    sync interval
+     * @return true if successful
+     */
+    inline bool startCyclicSync(const std::chrono::microseconds& period) {
+        return startCyclicMessage(CanMsg(0x80, 0, nullptr), period);
+    }
+
+    /*!
+     * Only deliver frames of a subscribed COB id if their payload or length changed.
+     * @param cobId     COB id of the frames
+     * @param mask      bits of the payload to compare, 8 bytes. nullptr to compare all bits.
+     * @return true if successful
+     */
+    bool setContentFilter(const uint32_t cobId, const uint8_t* mask = nullptr);
+
+    /*!
+     * Deliver every frame of a subscribed COB id again
+     * @param cobId     COB id of the frames
+     * @return true if successful
+     */
+    bool removeContentFilter(const uint32_t cobId);
+
+ protected:
+    using PayloadMask = std::array<uint8_t, CanMsg::ClassicCapacity>;
+
+    bool initializeInterface() override;
+    bool readData() override;
+    bool writeData(std::unique_lock<std::mutex>* lock) override;
+
+    //! Sets up the receive jobs of the subscribed COB ids
+    void onSubscriptionsChanged() override;
+
+    /*!
+     * Sets up the receive job of a COB id. rxJobsMutex_ shall be locked.
+     * @param cobId     COB id of the frames
+     * @param replace   delete the existing job of the COB id first
+     * @return true if successful
+     */
+    bool setupReceiveJob(const uint32_t cobId, const bool replace);
+
+    /*!
+     * Writes a command to the broadcast manager
+     * @param opcode    TX_SETUP, TX_DELETE, TX_SEND, RX_SETUP or RX_DELETE
+     * @param flags     flags of the command
+     * @param period    interval of TX_SETUP
+     * @param cobId     COB id of the job
+     * @param msg       frame of the command, or nullptr
+     * @return true if successful
+     */
+    bool writeCommand(const uint32_t opcode, const uint32_t flags, const std::chrono::microseconds& period, const uint32_t cobId, const CanMsg* msg);
+
+ protected:
+    int socket_;
+    int recvFlag_;
+    int sendFlag_;
+
+    //! COB ids with a cyclic message
+    std::mutex txJobsMutex_;
+    std::vector<uint32_t> txJobs_;
+
+    //! COB ids with a receive job, and the content filters
+    std::mutex rxJobsMutex_;
+    std::vector<uint32_t> rxJobs_;
+    std::map<uint32_t, PayloadMask> contentFilters_;
+};
+
+} /* namespace tcan_can */
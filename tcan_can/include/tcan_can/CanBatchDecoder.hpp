@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+
+#include "tcan_can/CanDbcDecodeTable.hpp"
+#include "tcan_can/CanMsg.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Decodes many frames of the same message at once into struct-of-arrays outputs, one contiguous column per signal.
+ * Intended for offline analysis and logging of recorded frames.
+ *
+ * Instead of decoding all signals frame by frame, every signal is decoded over all frames in separate passes: the words
+ * holding the signal are gathered from the frames, then byte swapped, shifted, masked, sign extended and scaled in
+ * branch-free loops over contiguous arrays, which the compiler turns into SIMD code. Frames are processed in chunks of
+ * ChunkSize, so the intermediate arrays stay in the L1 cache and no memory is allocated.
+ */
+class CanBatchDecoder {
+ public:
+    using SignalDecoder = CanDbcDecodeTable::SignalDecoder;
+
+    //! number of frames processed per pass
+    static constexpr std::size_t ChunkSize = 256;
+
+    CanBatchDecoder() = delete;
+
+    /*!
+     * @param table     decode table of the messages
+     */
+    explicit CanBatchDecoder(const std::shared_ptr<const CanDbcDecodeTable>& table);
+
+    /*!
+     * Decode the physical values of frames having the same COB id. Values of frames with a different COB id or a length
+     * shorter than defined in the database, as well as multiplexed signals not selected by the multiplexor, are NaN.
+     * @param frames        frames to decode
+     * @param numFrames     number of frames
+     * @param columns       array of getDecodeTable().getNumSignals() pointers indexed by CanDbcSignal::index_, each
+     *                      pointing to an array of numFrames values. Signals with a nullptr column are skipped.
+     * @return number of valid frames. 0 if the COB id of the first frame is not in the decode table.
+     */
+    std::size_t decode(const CanMsg* frames, const std::size_t numFrames, double* const* columns) const;
+
+    /*!
+     * Same as decode(..), but writes the sign extended raw values. Values of invalid frames and multiplexed signals not
+     * selected by the multiplexor are 0.
+     */
+    std::size_t decodeRaw(const CanMsg* frames, const std::size_t numFrames, int64_t* const* columns) const;
+
+    /*!
+     * Decode the raw values of a single signal of frames having the same layout.
+     * @param signal        decoder of the signal, see CanDbcDecodeTable::makeSignalDecoder(..)
+     * @param frames        frames to decode, at least as long as the signal
+     * @param numFrames     number of frames
+     * @param raw           array of numFrames sign extended raw values
+     */
+    static void decodeRawColumn(const SignalDecoder& signal, const CanMsg* frames, const std::size_t numFrames, int64_t* raw);
+
+    /*!
+     * Decode the physical values of a single signal of frames having the same layout, see decodeRawColumn(..)
+     * @param values        array of numFrames values
+     */
+    static void decodeColumn(const SignalDecoder& signal, const CanMsg* frames, const std::size_t numFrames, double* values);
+
+    inline const CanDbcDecodeTable& getDecodeTable() const { return *table_; }
+
+ protected:
+    const std::shared_ptr<const CanDbcDecodeTable> table_;
+};
+
+} /* namespace tcan_can */
@@ -1,13 +1,18 @@
 #pragma once
 
 #include <stdint.h>
-#include <unordered_map>
+#include <chrono>
 #include <memory>
 #include <functional>
+#include <mutex>
 #include <vector>
 
 #include "tcan/Bus.hpp"
+#include "tcan/RcuPointer.hpp"
+#include "tcan_can/CanBusError.hpp"
 #include "tcan_can/CanBusOptions.hpp"
+#include "tcan_can/CanCallbackExecutor.hpp"
+#include "tcan_can/CanDispatchTable.hpp"
 #include "tcan_can/CanFrameIdentifier.hpp"
 #include "tcan_can/CanMsg.hpp"
 #include "tcan_can/CanDevice.hpp"
@@ -16,8 +21,10 @@ namespace tcan_can {
 
 class CanBus : public tcan::Bus<CanMsg> {
  public:
-    using CallbackPtr =  std::function<bool(const CanMsg&)>;
-    using CanFrameIdentifierToFunctionMap = std::unordered_map<CanFrameIdentifier, std::pair<CanDevice*, CallbackPtr>, CanFrameIdentifierHasher>;
+    using CallbackPtr = CanMessageHandler::CallbackPtr;
+    using Callable = std::function<bool(const CanMsg&)>;
+    using SubscriptionHandle = CanDispatchTable::SubscriptionHandle;
+    static constexpr SubscriptionHandle InvalidSubscription = CanDispatchTable::InvalidSubscription;
     using DeviceContainer = std::vector<CanDevice*>;
 
     CanBus() = delete;
@@ -42,27 +49,30 @@ class CanBus : public tcan::Bus<CanMsg> {
      * @return true if init was successful
      */
     inline bool addDevice(CanDevice* device) {
-        devices_.push_back(device);
+        {
+            std::lock_guard<std::mutex> lock(devicesMutex_);
+            devices_.push_back(device);
+        }
+        device->setStateMonitor(&deviceStateMonitor_);
+        updateDeviceStateFlags();
         return device->initDeviceInternal(this);
     }
 
     /*! Adds a device and callback function for incoming messages identified by its CAN frame identifier. The timeout
      *  counter of the device is reset on reception of the message (treated as heartbeat).
+     *  Several callbacks may be added for the same frame identifier. They are called in the order they were added.
+     *  Callbacks may be added and removed at any time, also while the bus threads are running or from within a callback.
      * @param canFrameId        29 or 11 bit frame ID of the message
      * @param device            pointer to the device
      * @param fp                pointer to the parse function
-     * @return true if successful
+     * @param runInline         call the function on the receive thread even if the bus has callback threads (see
+     *                          CanBusOptions::numCallbackThreads_). Use only for functions which return quickly.
+     * @return true if successful, false if this callback was already added for this frame identifier
      */
     template <class T>
-    inline bool addCanMessage(const uint32_t canFrameId, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), typename std::enable_if<!std::is_base_of<CanDevice, T>::value>::type* = 0)
+    inline bool addCanMessage(const uint32_t canFrameId, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), const bool runInline = false)
     {
-        return canFrameIdentifierToFunctionMap_.emplace(CanFrameIdentifier{canFrameId }, std::make_pair(nullptr, std::bind(fp, device, std::placeholders::_1))).second;
-    }
-
-    template <class T>
-    inline bool addCanMessage(const uint32_t canFrameId, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), typename std::enable_if<std::is_base_of<CanDevice, T>::value>::type* = 0)
-    {
-        return canFrameIdentifierToFunctionMap_.emplace(CanFrameIdentifier{canFrameId }, std::make_pair(device, std::bind(fp, device, std::placeholders::_1))).second;
+        return subscribe(CanFrameIdentifier{canFrameId}, device, fp, runInline) != InvalidSubscription;
     }
 
     /*! Like addCanMessage with a specific CanId, but matches against a range of CanIds through a mask.
@@ -71,20 +81,76 @@ class CanBus : public tcan::Bus<CanMsg> {
     * @param matcher           CanFrameIdentifier for the message
     * @param device            pointer to the device
     * @param fp                pointer to the parse function
+    * @param runInline         call the function on the receive thread even if the bus has callback threads
     * @return true if successful
     */
     template <class T>
-    inline bool addCanMessage(const CanFrameIdentifier matcher, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), typename std::enable_if<!std::is_base_of<CanDevice, T>::value>::type* = 0)
+    inline bool addCanMessage(const CanFrameIdentifier matcher, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), const bool runInline = false)
     {
-        return canFrameIdentifierToFunctionMap_.emplace(matcher, std::make_pair(nullptr, std::bind(fp, device, std::placeholders::_1))).second;
+        return subscribe(matcher, device, fp, runInline) != InvalidSubscription;
+    }
+
+    /*! Compatibility overloads registering an arbitrary callable (e.g. a lambda or the result of std::bind).
+     * The callable is copied and owned by the bus. Prefer the member function overloads above, which do not allocate.
+     * @param canFrameId        29 or 11 bit frame ID of the message
+     * @param matcher           CanFrameIdentifier for the message
+     * @param callable          function to be called on reception of the message
+     * @return true if successful
+     */
+    inline bool addCanMessage(const uint32_t canFrameId, const Callable& callable) {
+        return subscribe(CanFrameIdentifier{canFrameId}, callable) != InvalidSubscription;
     }
 
+    inline bool addCanMessage(const CanFrameIdentifier matcher, const Callable& callable) {
+        return subscribe(matcher, callable) != InvalidSubscription;
+    }
+
+    /*! Same as addCanMessage(..), but returns a handle which can be used to remove the callback again with unsubscribe(..).
+     * If the object is a CanDevice, its timeout counter is reset on reception of a matching message.
+     * @param matcher           CanFrameIdentifier for the message
+     * @param object            pointer to the object (device) to call the function on
+     * @param fp                pointer to the parse function
+     * @param runInline         call the function on the receive thread even if the bus has callback threads
+     * @return handle of the subscription, InvalidSubscription if the callback was already subscribed to this matcher
+     */
     template <class T>
-    inline bool addCanMessage(const CanFrameIdentifier matcher, T* device, bool(std::common_type<T>::type::*fp)(const CanMsg&), typename std::enable_if<std::is_base_of<CanDevice, T>::value>::type* = 0)
+    inline SubscriptionHandle subscribe(const CanFrameIdentifier matcher, T* object, bool(std::common_type<T>::type::*fp)(const CanMsg&), const bool runInline = false)
     {
-        return canFrameIdentifierToFunctionMap_.emplace(matcher, std::make_pair(device, std::bind(fp, device, std::placeholders::_1))).second;
+        return subscribe(matcher, CanMessageHandler(getDevice(object), CallbackPtr(object, fp), runInline));
     }
 
+    /*! Compatibility overload of subscribe(..) taking an arbitrary callable. The callable is copied and kept until it is
+     * unsubscribed.
+     * @param matcher           CanFrameIdentifier for the message
+     * @param callable          function to be called on reception of the message
+     * @return handle of the subscription
+     */
+    inline SubscriptionHandle subscribe(const CanFrameIdentifier matcher, const Callable& callable) {
+        const auto owner = std::make_shared<Callable>(callable);
+        return subscribe(matcher, CanMessageHandler(nullptr, CallbackPtr::fromCallable(owner.get())), owner);
+    }
+
+    /*! Remove a callback added with subscribe(..). If the bus has callback threads, messages queued for the callback are
+     * dropped and the call blocks until no callback thread calls it anymore, so the object can be destructed afterwards.
+     * A callback unsubscribing itself returns immediately. Callbacks on the receive thread unsubscribing others do not
+     * stop the dispatch of the message being handled.
+     * @param handle    handle returned by subscribe(..)
+     * @return true if the subscription existed
+     */
+    bool unsubscribe(const SubscriptionHandle handle);
+
+    /*! Blocks until all messages received so far are handled by the callback threads. Returns immediately if the bus
+     * has no callback threads.
+     */
+    inline void waitForCallbacks() {
+        if(callbackExecutor_) {
+            callbackExecutor_->waitForEmptyQueues();
+        }
+    }
+
+    //! @return number of received messages dropped because the queue of their callback thread was full
+    inline uint64_t getNumDroppedCallbacks() const { return callbackExecutor_ ? callbackExecutor_->getNumDroppedJobs() : 0; }
+
     /*! Send a sync message on the bus. Is called by BusManager::sendSyncOnAllBuses or directly.
      */
     inline void sendSync() {
@@ -92,10 +158,31 @@ class CanBus : public tcan::Bus<CanMsg> {
     }
 
     /*!
-     * @return  Container with all devices handled by this bus
+     * Send a message ahead of the output queue, e.g. a SYNC which shall not be delayed by queued messages. Can be called
+     * from any thread. Derived classes write the message to the interface right away, the default implementation
+     * appends it to the output queue.
+     * @param msg   message to be sent
+     * @return true if the message was sent or queued
+     */
+    virtual bool sendMessageDirectly(const CanMsg& msg) { return sendMessage(msg); }
+
+    /*!
+     * @return  Container with all devices handled by this bus. Must not be used while devices are added.
      */
     const DeviceContainer& getDeviceContainer() const { return devices_; }
 
+    /*!
+     * @return  Aggregated state of all devices handled by this bus. Use addObserver(..) to get notified when a device
+     *          becomes Active, Missing or Error.
+     */
+    inline CanDevice::StateMonitor& getDeviceStateMonitor() { return deviceStateMonitor_; }
+    inline const CanDevice::StateMonitor& getDeviceStateMonitor() const { return deviceStateMonitor_; }
+
+    /*!
+     * @return  Number and rate of received bus error frames per error class. The rates are updated by sanityCheck().
+     */
+    inline const CanBusErrorCounters& getBusErrorCounters() const { return busErrorCounters_; }
+
     /*!
      * Resets all devices handled by this bus to Initializing state and sends appropriate restart commands to the devices
      */
@@ -103,15 +190,61 @@ class CanBus : public tcan::Bus<CanMsg> {
 
     /*!
      * Set the callback function to be called for incoming messages with an id not found in the callback function map
-     * @param callbackPtr std::function wrapper containing the callback function pointer
+     * @param callbackPtr delegate wrapping the callback object and member function
      */
     inline void setUnmappedMessageCallback(const CallbackPtr& callbackPtr) {
-        // todo: protect this with a mutex? (also inside handleMessage)
-        unmappedMessageCallbackFunction_ = callbackPtr;
+        dispatchTable_.update([&callbackPtr](CanDispatchTable& table) { table.setUnmappedCallback(callbackPtr); });
+    }
+
+    template <class T>
+    inline void setUnmappedMessageCallback(T* object, bool(std::common_type<T>::type::*fp)(const CanMsg&)) {
+        setUnmappedMessageCallback(CallbackPtr(object, fp));
+    }
+
+    /*!
+     * Compatibility overload taking an arbitrary callable, which is copied and kept until the callback is replaced.
+     * @param callable  function to be called for unmapped messages
+     */
+    inline void setUnmappedMessageCallback(const Callable& callable) {
+        const auto owner = std::make_shared<Callable>(callable);
+        dispatchTable_.update([&owner](CanDispatchTable& table) { table.setUnmappedCallback(CallbackPtr::fromCallable(owner.get()), owner); });
     }
 
     bool defaultHandleUnmappedMessage(const CanMsg& msg);
 
+ protected:
+    /*!
+     * @param matcher   identifier and mask of the frames to be handled
+     * @param handler   handler to be called
+     * @param owner     object kept alive until the handler is unsubscribed and not called anymore (optional)
+     * @return handle of the subscription, InvalidSubscription if the handler was already subscribed to this matcher
+     */
+    SubscriptionHandle subscribe(const CanFrameIdentifier& matcher, const CanMessageHandler& handler, const std::shared_ptr<void>& owner = nullptr);
+
+    /*! Is called after a callback was added or removed. Can be overridden by derived classes to e.g. update
+     * hardware or kernel filters from dispatchTable_.read()->getMatchers().
+     */
+    virtual void onSubscriptionsChanged() {}
+
+    /*!
+     * Is called by derived classes on reception of a bus error frame. Sets the error message flags, passivates the bus if
+     * configured, counts the error and logs it. The description is only formatted if the log is not throttled by
+     * BusOptions::errorThrottleTime_, and does not allocate.
+     * @param error     decoded error frame
+     */
+    void handleBusError(const CanBusError& error);
+
+    //! Is called on every state transition of a device. Updates the device state flags of the bus.
+    void onDeviceStateChanged(const CanDevice& device, const CanDevice::State previous, const CanDevice::State current);
+
+    //! Sets isMissingDeviceOrHasError_, allDevicesActive_ and allDevicesMissing_ from deviceStateMonitor_
+    void updateDeviceStateFlags();
+
+    template <class T>
+    inline static CanDevice* getDevice(T* object, typename std::enable_if<std::is_base_of<CanDevice, T>::value>::type* = 0) { return object; }
+
+    template <class T>
+    inline static CanDevice* getDevice(T* /*object*/, typename std::enable_if<!std::is_base_of<CanDevice, T>::value>::type* = 0) { return nullptr; }
 
  public:/// INTERNAL FUNCTIONS
     /*! Send a sync message on the bus without locking the queue.
@@ -133,12 +266,27 @@ class CanBus : public tcan::Bus<CanMsg> {
  protected:
     // vector containing all devices
     DeviceContainer devices_;
+    std::mutex devicesMutex_;
+
+    // number of devices per state, updated on state transitions
+    CanDevice::StateMonitor deviceStateMonitor_;
+    // serializes updateDeviceStateFlags()
+    std::mutex deviceStateFlagsMutex_;
+
+    // table mapping COB id to the list of parse functions, including the function to be called for unmapped COB ids.
+    // Standard 11-bit ids are resolved by direct indexing. The receive thread reads a snapshot of the table without
+    // locking, (un)subscribing publishes a modified copy.
+    tcan::RcuPointer<CanDispatchTable> dispatchTable_;
+
+    // threads calling the callbacks, nullptr if they are called on the receive thread
+    std::unique_ptr<CanCallbackExecutor> callbackExecutor_;
 
-    // map mapping COB id to parse functions
-    CanFrameIdentifierToFunctionMap canFrameIdentifierToFunctionMap_;
+    // received bus errors per class
+    CanBusErrorCounters busErrorCounters_;
 
-    // function pointer to be called for unmapped COB ids
-    CallbackPtr unmappedMessageCallbackFunction_;
+    // time and number of error frames of the last logged bus error, only accessed by the receive thread
+    CanBusErrorCounters::Clock::time_point lastBusErrorLog_;
+    uint64_t numErrorFramesAtLastLog_;
 };
 
 } /* namespace tcan_can */
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include "tcan_can/CanMsg.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Decoded bus error frame. The values match the ones of the linux socketcan error frames (linux/can/error.h), decoding
+ * copies the bytes of the frame and does not allocate. Use format(..) or toString() to get a readable description.
+ */
+struct CanBusError {
+    //! error classes, the bits of the COB id of error frames
+    enum Class : uint16_t {
+        TxTimeout = 0x001,          // TX timeout (by netdevice driver)
+        LostArbitration = 0x002,    // lost arbitration, see lostArbitrationBit_
+        Controller = 0x004,         // controller problems, see controller_
+        Protocol = 0x008,           // protocol violations, see protocolType_ and protocolLocation_
+        Transceiver = 0x010,        // transceiver status, see transceiver_
+        NoAck = 0x020,              // received no ACK on transmission
+        BusOff = 0x040,             // bus off
+        BusError = 0x080,           // bus error (may flood!)
+        Restarted = 0x100,          // controller restarted
+        ErrorCounters = 0x200       // TX and RX error counters are valid
+    };
+
+    //! number of error classes
+    static constexpr unsigned int NumClasses = 10;
+
+    //! size of a buffer holding any output of format(..)
+    static constexpr std::size_t MaxFormattedLength = 1024;
+
+    /*!
+     * @param msg   error frame, with the error classes in the COB id
+     * @return decoded error
+     */
+    static inline CanBusError fromFrame(const CanMsg& msg) {
+        const uint8_t* data = msg.getData();
+        CanBusError error;
+        error.classes_ = static_cast<uint16_t>(msg.getCobId() & ((1u << NumClasses) - 1));
+        error.lostArbitrationBit_ = data[0];
+        error.controller_ = data[1];
+        error.protocolType_ = data[2];
+        error.protocolLocation_ = data[3];
+        error.transceiver_ = data[4];
+        error.controllerSpecific_ = data[5];
+        error.txErrorCounter_ = data[6];
+        error.rxErrorCounter_ = data[7];
+        return error;
+    }
+
+    //! @return index of a class in [0, NumClasses)
+    static inline unsigned int getClassIndex(const Class errorClass) { return static_cast<unsigned int>(__builtin_ctz(errorClass)); }
+
+    //! @return name of the class with index classIndex
+    static const char* getClassName(const unsigned int classIndex);
+
+    inline bool hasClass(const Class errorClass) const { return (classes_ & errorClass) != 0; }
+
+    /*!
+     * Write a readable description of the error, like snprintf.
+     * @param buffer    output buffer, MaxFormattedLength bytes are always sufficient
+     * @param size      size of the buffer
+     * @return length of the description, excluding the terminating null character
+     */
+    std::size_t format(char* buffer, const std::size_t size) const;
+
+    //! @return readable description of the error
+    std::string toString() const;
+
+    //! combination of Class
+    uint16_t classes_;
+    //! bit position in the bit stream, for LostArbitration
+    uint8_t lostArbitrationBit_;
+    //! controller status flags (CAN_ERR_CRTL_*), for Controller
+    uint8_t controller_;
+    //! protocol violation flags (CAN_ERR_PROT_*), for Protocol
+    uint8_t protocolType_;
+    //! location of the protocol violation (CAN_ERR_PROT_LOC_*), for Protocol
+    uint8_t protocolLocation_;
+    //! transceiver status (CAN_ERR_TRX_*), for Transceiver
+    uint8_t transceiver_;
+    //! controller specific additional information
+    uint8_t controllerSpecific_;
+    //! error counters, for ErrorCounters
+    uint8_t txErrorCounter_;
+    uint8_t rxErrorCounter_;
+};
+
+/*!
+ * Per-class counters and rates of bus errors. Counting is lock-free and can be done on the receive thread, the rates are
+ * updated periodically by the sanity check of the bus.
+ */
+class CanBusErrorCounters {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    CanBusErrorCounters();
+
+    //! Count an error frame and each of its classes
+    inline void count(const CanBusError& error) {
+        numErrorFrames_.fetch_add(1, std::memory_order_relaxed);
+        for(unsigned int i = 0; i < CanBusError::NumClasses; ++i) {
+            if(error.classes_ & (1u << i)) {
+                counts_[i].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //! @return number of error frames since construction
+    inline uint64_t getNumErrorFrames() const { return numErrorFrames_.load(std::memory_order_relaxed); }
+
+    //! @return number of errors of a class since construction
+    inline uint64_t getCount(const CanBusError::Class errorClass) const {
+        return counts_[CanBusError::getClassIndex(errorClass)].load(std::memory_order_relaxed);
+    }
+
+    //! @return error frames per second between the last two calls of updateRates(..)
+    inline double getErrorFrameRate() const { return errorFrameRate_.load(std::memory_order_relaxed); }
+
+    //! @return errors of a class per second between the last two calls of updateRates(..)
+    inline double getRate(const CanBusError::Class errorClass) const {
+        return rates_[CanBusError::getClassIndex(errorClass)].load(std::memory_order_relaxed);
+    }
+
+    /*!
+     * Compute the rates from the errors counted since the last call. Must not be called concurrently.
+     * @param now   current time
+     */
+    void updateRates(const Clock::time_point& now);
+
+ protected:
+    std::atomic<uint64_t> numErrorFrames_;
+    std::atomic<uint64_t> counts_[CanBusError::NumClasses];
+
+    std::atomic<double> errorFrameRate_;
+    std::atomic<double> rates_[CanBusError::NumClasses];
+
+    // counts at the last update of the rates
+    Clock::time_point lastUpdate_;
+    uint64_t lastNumErrorFrames_;
+    uint64_t lastCounts_[CanBusError::NumClasses];
+};
+
+} /* namespace tcan_can */
@@ -23,6 +23,7 @@ class CanBusManager : public tcan::BusManager<CanMsg> {
      * @param waitForEmptyQueues     whether the busmanager should wait until the output message queues of all buses are empty before sending the global SYNC.
      * 			ensures that the sync messages are sent at the same time and not just appended to a queue.
      * 			Only useful in asynchronous mode.
+     * The SYNC is sent when this function is called. Use a SyncProducer to send it at a fixed communication cycle period.
      */
     void sendSyncOnAllBuses(const bool waitForEmptyQueues=false);
 
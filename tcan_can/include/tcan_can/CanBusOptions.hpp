@@ -5,6 +5,12 @@
 namespace tcan_can {
 
 struct CanBusOptions : public tcan::BusOptions {
+    //! What happens to a received message if the queue of its callback thread is full
+    enum class CallbackOverflowPolicy : uint8_t {
+        DropNewest, // the message is not queued
+        DropOldest  // the oldest queued message of the thread is dropped
+    };
+
     CanBusOptions():
         CanBusOptions(std::string())
     {
@@ -13,7 +19,11 @@ struct CanBusOptions : public tcan::BusOptions {
     CanBusOptions(const std::string& name):
         BusOptions(name),
         passivateOnBusError_(false),
-        passivateIfNoDevices_(false)
+        passivateIfNoDevices_(false),
+        numCallbackThreads_(0),
+        priorityCallbackThreads_(50),
+        callbackQueueCapacity_(1024),
+        callbackOverflowPolicy_(CallbackOverflowPolicy::DropNewest)
     {
     }
 
@@ -24,6 +34,20 @@ struct CanBusOptions : public tcan::BusOptions {
 
     //! If set to true, bus goes to passive mode (no messages are sent on the bus) if all devices are missing.
     bool passivateIfNoDevices_;
+
+    //! Number of threads calling the callbacks of received messages. 0 = call them on the receive thread.
+    // Messages of the same device are always handled by the same thread, in order of reception. Callbacks added with
+    // runInline=true are still called on the receive thread.
+    unsigned int numCallbackThreads_;
+
+    //! Priority of the callback threads (SCHED_FIFO). 0 = keep the default scheduling policy
+    int priorityCallbackThreads_;
+
+    //! Number of messages each callback thread can queue, rounded up to a power of two. The queues are preallocated.
+    unsigned int callbackQueueCapacity_;
+
+    //! Policy if a callback thread falls behind and its queue is full, see CanBus::getNumDroppedCallbacks()
+    CallbackOverflowPolicy callbackOverflowPolicy_;
 };
 
 } /* namespace tcan_can */
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tcan_can/CanBusOptions.hpp"
+#include "tcan_can/CanDevice.hpp"
+#include "tcan_can/CanDispatchTable.hpp"
+#include "tcan_can/CanMsg.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Small pool of worker threads calling CAN message handlers outside of the receive thread.
+ * All messages of the same handler key (the device, or the object of the callback if there is no device) are passed to
+ * the same worker and therefore handled in order of reception, while handlers of different keys run in parallel.
+ * Every worker queues the messages in a preallocated ring. If a worker falls behind and its ring is full, a message is
+ * dropped according to the overflow policy and counted.
+ */
+class CanCallbackExecutor {
+ public:
+    CanCallbackExecutor() = delete;
+
+    /*!
+     * Starts the worker threads
+     * @param name              name of the bus, used for log messages
+     * @param numThreads        number of worker threads (at least 1)
+     * @param priority          priority of the worker threads
+     * @param queueCapacity     number of messages each worker can queue, rounded up to a power of two
+     * @param overflowPolicy    message to drop if the queue of a worker is full
+     */
+    CanCallbackExecutor(const std::string& name, const unsigned int numThreads, const int priority, const unsigned int queueCapacity,
+                        const CanBusOptions::CallbackOverflowPolicy overflowPolicy);
+
+    //! Stops the worker threads. Messages still queued are dropped.
+    ~CanCallbackExecutor();
+
+    /*!
+     * Queues a message to be passed to a handler by the worker thread of the handler key
+     * @param handler   handler to be called
+     * @param msg       received message
+     */
+    void post(const CanMessageHandler& handler, const CanMsg& msg);
+
+    /*!
+     * Drops the queued messages of a handler and waits until its worker is not calling it anymore, unless called by that
+     * worker. The handler is not called afterwards, as long as it is not posted again.
+     * @param handler   handler which was unsubscribed
+     * @param owner     owner of the subscription. If called by the worker, it is released after the current call of the
+     *                  handler, so a callable can unsubscribe itself.
+     */
+    void cancel(const CanMessageHandler& handler, std::shared_ptr<void>&& owner = nullptr);
+
+    /*!
+     * Blocks until all messages queued so far are handled
+     */
+    void waitForEmptyQueues();
+
+    //! @return number of messages dropped because the queue of their worker was full
+    inline uint64_t getNumDroppedJobs() const { return numDroppedJobs_.load(std::memory_order_relaxed); }
+
+    //! Calls the handler on the calling thread. The timeout counter of the device has to be reset by the caller.
+    static inline void execute(const CanMessageHandler& handler, const CanMsg& msg) {
+        if(handler.device_) {
+            handler.device_->configureDeviceInternal(msg);
+        }
+        handler.callback_(msg); // call function pointer
+    }
+
+ protected:
+    struct Job {
+        Job():
+            handler_(),
+            msg_(0)
+        {
+        }
+
+        Job(const CanMessageHandler& handler, const CanMsg& msg):
+            handler_(handler),
+            msg_(msg)
+        {
+        }
+
+        CanMessageHandler handler_;
+        CanMsg msg_;
+    };
+
+    struct Worker {
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable condJobs_;
+        std::condition_variable condEmpty_;
+        //! ring of queued jobs, [head_, head_ + numJobs_) modulo the capacity
+        std::vector<Job> jobs_;
+        std::size_t head_ = 0;
+        std::size_t numJobs_ = 0;
+        //! handler being called, if isBusy_
+        CanMessageHandler busyHandler_;
+        bool isBusy_ = false;
+        //! owners of the subscriptions cancelled by the handler being called
+        std::vector<std::shared_ptr<void>> cancelledOwners_;
+    };
+
+    void workerFunction(Worker& worker);
+
+    inline static bool isSameHandler(const CanMessageHandler& a, const CanMessageHandler& b) {
+        return a.device_ == b.device_ && a.callback_ == b.callback_;
+    }
+
+    inline Worker& getWorker(const CanMessageHandler& handler) {
+        const void* key = handler.device_ ? static_cast<const void*>(handler.device_) : handler.callback_.getObject();
+        return *workers_[std::hash<const void*>()(key) % workers_.size()];
+    }
+
+ protected:
+    std::string name_;
+    std::atomic<bool> running_;
+    //! capacity of the rings minus one
+    const std::size_t mask_;
+    const CanBusOptions::CallbackOverflowPolicy overflowPolicy_;
+    std::atomic<uint64_t> numDroppedJobs_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace tcan_can {
+
+//! Signal of a CAN message as defined in a DBC file
+struct CanDbcSignal {
+    enum class Multiplex : uint8_t {
+        None,           // signal is always present
+        Multiplexor,    // signal selects which multiplexed signals are present
+        Multiplexed     // signal is present if the multiplexor has the value multiplexValue_
+    };
+
+    std::string name_;
+    std::string unit_;
+
+    //! start bit as given in the DBC file. LSB for little endian (Intel) signals, MSB for big endian (Motorola) signals.
+    uint16_t startBit_ = 0;
+    uint8_t bitLength_ = 0;
+    bool isBigEndian_ = false;
+    bool isSigned_ = false;
+
+    //! physical value = raw value * factor_ + offset_
+    double factor_ = 1.0;
+    double offset_ = 0.0;
+    double minimum_ = 0.0;
+    double maximum_ = 0.0;
+
+    Multiplex multiplex_ = Multiplex::None;
+    uint32_t multiplexValue_ = 0;
+
+    //! index of the signal in the signal array of the database, see CanDbc::getNumSignals()
+    uint32_t index_ = 0;
+};
+
+//! CAN message as defined in a DBC file
+struct CanDbcMessage {
+    //! COB id, including CAN_EFF_FLAG for extended frames (the DBC notation of extended ids)
+    uint32_t cobId_ = 0;
+    std::string name_;
+    //! payload length in bytes
+    uint8_t length_ = 0;
+    std::vector<CanDbcSignal> signals_;
+};
+
+/*!
+ * Database of CAN messages and their signals, loaded from a DBC file.
+ * Supported are the message (BO_) and signal (SG_) definitions, including simple multiplexing with one multiplexor per
+ * message. All other sections (comments, attributes, value tables, ...) are ignored. Every signal gets a unique index,
+ * assigned in order of definition, so that the values of all signals of a bus fit into one array.
+ * Use CanDbcDecodeTable to decode received frames.
+ */
+class CanDbc {
+ public:
+    static constexpr uint32_t InvalidSignalIndex = 0xffffffffu;
+
+    CanDbc();
+
+    /*!
+     * Load a DBC file. Messages already in the database are kept.
+     * @param path  path of the DBC file
+     * @return true if the file was parsed successfully
+     */
+    bool loadFile(const std::string& path);
+
+    /*!
+     * Parse DBC content. Messages already in the database are kept.
+     * @param stream    stream providing the DBC content
+     * @return true if the content was parsed successfully
+     */
+    bool parse(std::istream& stream);
+
+    //! @return all messages, in order of definition
+    inline const std::vector<CanDbcMessage>& getMessages() const { return messages_; }
+
+    //! @return the number of signals of all messages
+    inline uint32_t getNumSignals() const { return numSignals_; }
+
+    /*!
+     * @param cobId     COB id of the message, including CAN_EFF_FLAG for extended frames
+     * @return the message, nullptr if the database has no message with this id
+     */
+    const CanDbcMessage* getMessage(const uint32_t cobId) const;
+
+    /*!
+     * @param messageName   name of the message
+     * @param signalName    name of the signal
+     * @return index of the signal in the signal array, InvalidSignalIndex if it does not exist
+     */
+    uint32_t getSignalIndex(const std::string& messageName, const std::string& signalName) const;
+
+ protected:
+    std::vector<CanDbcMessage> messages_;
+    uint32_t numSignals_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring> // memcpy
+#include <endian.h>
+#include <vector>
+
+#include "tcan_can/CanDbc.hpp"
+#include "tcan_can/CanMsg.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Compact, precomputed form of a CanDbc for decoding received frames.
+ * Every signal is reduced to the position of an 8 byte word in the payload, a shift, a mask and its scaling, so that
+ * decoding a signal is one unaligned load, an optional byte swap, a shift, a mask and a multiply-add. Decoding writes the
+ * physical values into a caller provided array indexed by CanDbcSignal::index_ and does not allocate.
+ */
+class CanDbcDecodeTable {
+ public:
+    struct SignalDecoder {
+        //! @return raw value of the signal, without sign extension
+        inline uint64_t getRaw(const uint8_t* data) const {
+            uint64_t word;
+            std::memcpy(&word, data + byte_, sizeof(word));
+            word = isBigEndian_ ? be64toh(word) : le64toh(word);
+            return (word >> shift_) & mask_;
+        }
+
+        //! @return physical value of a raw value
+        inline double toPhysical(const uint64_t raw) const {
+            const double value = (signBit_ != 0) ? static_cast<double>(static_cast<int64_t>((raw ^ signBit_) - signBit_)) : static_cast<double>(raw);
+            return value * factor_ + offset_;
+        }
+
+        uint64_t mask_;
+        //! most significant bit of signed signals, 0 for unsigned signals
+        uint64_t signBit_;
+        double factor_;
+        double offset_;
+        //! index in the signal value array
+        uint32_t index_;
+        uint32_t multiplexValue_;
+        //! first byte of the 8 byte word holding the signal
+        uint8_t byte_;
+        //! right shift moving the signal to bit 0 of the word
+        uint8_t shift_;
+        bool isBigEndian_;
+        CanDbcSignal::Multiplex multiplex_;
+    };
+
+    struct MessageDecoder {
+        uint32_t cobId_;
+        //! range [firstSignal_, firstSignal_ + numSignals_) in the signal decoders. The multiplexor, if any, comes first.
+        uint32_t firstSignal_;
+        uint32_t numSignals_;
+        uint8_t length_;
+    };
+
+    CanDbcDecodeTable() = delete;
+
+    /*!
+     * Precompute the decoders of all messages of a database
+     * @param dbc   database
+     */
+    explicit CanDbcDecodeTable(const CanDbc& dbc);
+
+    /*!
+     * Precompute the decoder of a single signal
+     * @param signal    signal definition. The index_ is copied to the decoder.
+     * @param decoder   decoder of the signal
+     * @return false if the signal cannot be decoded from a single 8 byte word, which may happen for long signals at odd
+     *         positions in CAN FD frames
+     */
+    static bool makeSignalDecoder(const CanDbcSignal& signal, SignalDecoder& decoder);
+
+    /*!
+     * @param cobId     COB id of the message, including CAN_EFF_FLAG for extended frames
+     * @return decoder of the message, nullptr if the database has no message with this id
+     */
+    const MessageDecoder* findMessage(const uint32_t cobId) const;
+
+    /*!
+     * Decode a frame. Multiplexed signals are only decoded if the multiplexor selects them. The values of signals which
+     * are not decoded are kept.
+     * @param msg       received frame
+     * @param values    array of getNumSignals() values
+     * @return number of decoded signals. 0 if the message is unknown or shorter than defined in the database.
+     */
+    inline uint32_t decode(const CanMsg& msg, double* values) const {
+        const MessageDecoder* message = findMessage(msg.getCobId());
+        return message == nullptr ? 0 : decode(*message, msg, values);
+    }
+
+    /*!
+     * Decode a frame of a known message, see decode(msg, values)
+     * @param message   decoder of the message, from findMessage(..)
+     * @param msg       received frame
+     * @param values    array of getNumSignals() values
+     * @return number of decoded signals
+     */
+    inline uint32_t decode(const MessageDecoder& message, const CanMsg& msg, double* values) const {
+        if(msg.getLength() < message.length_) {
+            return 0;
+        }
+
+        const uint8_t* data = msg.getData();
+        uint64_t multiplexValue = 0;
+        uint32_t numDecoded = 0;
+        for(uint32_t i = message.firstSignal_; i < message.firstSignal_ + message.numSignals_; ++i) {
+            const SignalDecoder& signal = signals_[i];
+            const uint64_t raw = signal.getRaw(data);
+            if(signal.multiplex_ == CanDbcSignal::Multiplex::Multiplexed && signal.multiplexValue_ != multiplexValue) {
+                continue;
+            }
+            if(signal.multiplex_ == CanDbcSignal::Multiplex::Multiplexor) {
+                multiplexValue = raw;
+            }
+            values[signal.index_] = signal.toPhysical(raw);
+            ++numDecoded;
+        }
+        return numDecoded;
+    }
+
+    //! @return size of the value array passed to decode(..)
+    inline uint32_t getNumSignals() const { return numSignals_; }
+
+    //! @return decoders of all messages, sorted by COB id
+    inline const std::vector<MessageDecoder>& getMessages() const { return messages_; }
+
+    //! @return decoders of all signals, grouped by message
+    inline const std::vector<SignalDecoder>& getSignals() const { return signals_; }
+
+ protected:
+    std::vector<MessageDecoder> messages_;
+    std::vector<SignalDecoder> signals_;
+    uint32_t numSignals_;
+};
+
+} /* namespace tcan_can */
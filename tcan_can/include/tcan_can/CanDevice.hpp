@@ -5,6 +5,7 @@
 #include <atomic>
 #include <memory>
 
+#include "tcan/DeviceStateMonitor.hpp"
 #include "tcan_can/CanMsg.hpp"
 #include "tcan_can/CanDeviceOptions.hpp"
 
@@ -16,6 +17,8 @@ class CanBus;
 //! A device that is connected via CAN.
 class CanDevice {
  public:
+    using StateMonitor = tcan::DeviceStateMonitor<CanDevice>;
+
     enum State {
         Initializing=0,
         Active=1,
@@ -38,7 +41,8 @@ class CanDevice {
         options_(std::move(options)),
         deviceTimeoutCounter_(0),
         state_(Initializing),
-        bus_(nullptr)
+        bus_(nullptr),
+        stateMonitor_(nullptr)
     {
     }
 
@@ -69,7 +73,7 @@ class CanDevice {
     virtual bool sanityCheck() {
         if(!isMissing()) {
             if(isTimedOut()) {
-                state_ = Missing;
+                setState(Missing);
                 MELO_WARN("Device %s timed out!", getName().c_str());
             }
         }
@@ -90,7 +94,7 @@ class CanDevice {
     /*!
      * Resets the device to Initializing state
      */
-    virtual void resetDevice() { state_ = Initializing; }
+    virtual void resetDevice() { setState(Initializing); }
 
  public: /// Internal functions
     /*! Initialize the device. This function is automatically called by Bus::addDevice(..).
@@ -104,7 +108,7 @@ class CanDevice {
     inline void configureDeviceInternal(const CanMsg& msg) {
         if(state_ != Active && state_ != Error) {
             if(configureDevice(msg)) {
-                state_ = Active;
+                setState(Active);
                 if(options_->printConfigInfo_) {
                     MELO_INFO("Device %s configured successfully.", options_->name_.c_str());
                 }
@@ -116,6 +120,14 @@ class CanDevice {
         deviceTimeoutCounter_ = 0;
     }
 
+    /*! Registers the device and its current state at the state monitor of the bus. Is called by CanBus::addDevice(..).
+     * @param stateMonitor  monitor to be notified on state transitions
+     */
+    inline void setStateMonitor(StateMonitor* stateMonitor) {
+        stateMonitor_ = stateMonitor;
+        stateMonitor_->addDevice(state_);
+    }
+
  protected:
     /*!
      * @return True if the device timed out
@@ -126,6 +138,17 @@ class CanDevice {
         // deviceTimeoutCounter_ is only increased if options_->maxDeviceTimeoutCounter != 0
     }
 
+    /*!
+     * Changes the state of the device and notifies the state monitor of the bus. Derived classes shall not assign state_ directly.
+     * @param state     new state
+     */
+    inline void setState(const State state) {
+        const State previous = state_.exchange(state);
+        if(previous != state && stateMonitor_ != nullptr) {
+            stateMonitor_->onStateChanged(*this, previous, state);
+        }
+    }
+
  protected:
     const std::unique_ptr<CanDeviceOptions> options_;
 
@@ -135,6 +158,9 @@ class CanDevice {
 
     //!  reference to the CAN bus the device is connected to
     CanBus* bus_;
+
+    //! aggregated device states of the bus, notified on state transitions
+    StateMonitor* stateMonitor_;
 };
 
 } /* namespace tcan_can */
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tcan/Delegate.hpp"
+#include "tcan_can/CanFrameIdentifier.hpp"
+#include "tcan_can/CanMsg.hpp"
+
+namespace tcan_can {
+
+class CanDevice;
+
+//! Callback registered for a CAN frame identifier, together with the device it belongs to (may be nullptr)
+struct CanMessageHandler {
+    using CallbackPtr = tcan::Delegate<bool(const CanMsg&)>;
+
+    CanMessageHandler():
+        device_(nullptr),
+        callback_(),
+        runInline_(false)
+    {
+    }
+
+    CanMessageHandler(CanDevice* device, const CallbackPtr& callback, const bool runInline = false):
+        device_(device),
+        callback_(callback),
+        runInline_(runInline)
+    {
+    }
+
+    inline bool isValid() const { return static_cast<bool>(callback_); }
+
+    CanDevice* device_;
+    CallbackPtr callback_;
+
+    //! call the callback on the receive thread even if the bus has callback threads
+    bool runInline_;
+};
+
+static_assert(std::is_trivially_copyable<CanMessageHandler>::value, "CanMessageHandler shall be trivially copyable");
+
+/*!
+ * Lookup structure routing received CAN frames to their handlers.
+ * Any number of handlers can subscribe to the same identifier or mask. A frame is passed to all matching handlers in
+ * order of subscription. The handler lists are precomputed on (un)subscription:
+ *  - 11-bit standard identifiers index a direct table of handler ranges, so dispatching a standard frame is a single
+ *    array access followed by the calls of its handlers. Masked subscriptions are already merged into these ranges.
+ *  - Extended identifiers subscribed exactly are looked up in a hash map holding their merged handler range.
+ *  - All other frames are matched against the masked subscriptions.
+ */
+class CanDispatchTable {
+ public:
+    using SubscriptionHandle = uint32_t;
+
+    static constexpr SubscriptionHandle InvalidSubscription = 0;
+    static constexpr uint32_t StandardFrameTableSize = 0x800;
+
+    CanDispatchTable();
+
+    /*!
+     * Subscribe a handler to frames matching an identifier and mask.
+     * @param matcher   identifier and mask of the frames to be handled
+     * @param handler   handler to be called
+     * @param owner     object kept alive as long as the subscription exists, e.g. the callable of the callback (optional)
+     * @return handle to be used for unsubscribe(..). InvalidSubscription if the handler was already subscribed to this matcher.
+     */
+    SubscriptionHandle subscribe(const CanFrameIdentifier& matcher, const CanMessageHandler& handler, const std::shared_ptr<void>& owner = nullptr);
+
+    /*!
+     * Remove a subscription
+     * @param handle    handle returned by subscribe(..)
+     * @param handler   handler of the removed subscription (output parameter, optional)
+     * @param owner     owner of the removed subscription (output parameter, optional)
+     * @return true if the subscription existed
+     */
+    bool unsubscribe(const SubscriptionHandle handle, CanMessageHandler* handler = nullptr, std::shared_ptr<void>* owner = nullptr);
+
+    //! @return true if the handler is subscribed to any frames
+    bool isSubscribed(const CanMessageHandler& handler) const;
+
+    /*!
+     * Call a function for every handler of a frame, in order of subscription.
+     * @param cobId     identifier of the received frame (including EFF/RTR flags)
+     * @param function  function taking a const CanMessageHandler&
+     * @return false if the frame is not handled
+     */
+    template <class Function>
+    inline bool forEachHandler(const uint32_t cobId, Function&& function) const {
+        if(cobId < StandardFrameTableSize) {
+            return forEachHandler(standardFrameHandlers_[cobId], function);
+        }
+
+        auto it = extendedFrameHandlers_.find(cobId);
+        if(it != extendedFrameHandlers_.end()) {
+            return forEachHandler(it->second, function);
+        }
+
+        bool handled = false;
+        for(const auto& subscription : maskedSubscriptions_) {
+            if(matches(subscription.matcher_, cobId)) {
+                function(subscription.handler_);
+                handled = true;
+            }
+        }
+        return handled;
+    }
+
+    //! @return number of subscriptions
+    inline std::size_t getNumSubscriptions() const { return subscriptions_.size(); }
+
+    //! @return identifiers and masks of all subscriptions, in order of subscription
+    std::vector<CanFrameIdentifier> getMatchers() const;
+
+    //! Set the callback for frames without any handler, and the object kept alive as long as the callback is set (optional)
+    inline void setUnmappedCallback(const CanMessageHandler::CallbackPtr& callback, const std::shared_ptr<void>& owner = nullptr) {
+        unmappedCallback_ = callback;
+        unmappedCallbackOwner_ = owner;
+    }
+
+    //! @return the callback for frames without any handler
+    inline const CanMessageHandler::CallbackPtr& getUnmappedCallback() const { return unmappedCallback_; }
+
+ protected:
+    struct Subscription {
+        Subscription(const SubscriptionHandle handle, const CanFrameIdentifier& matcher, const CanMessageHandler& handler,
+                     const std::shared_ptr<void>& owner):
+            handle_(handle),
+            matcher_(matcher),
+            handler_(handler),
+            owner_(owner)
+        {
+        }
+
+        SubscriptionHandle handle_;
+        CanFrameIdentifier matcher_;
+        CanMessageHandler handler_;
+        //! shared by all copies of the table, so it is released after the last snapshot holding the subscription
+        std::shared_ptr<void> owner_;
+    };
+
+    //! range [begin_, end_) in handlers_
+    struct HandlerRange {
+        uint32_t begin_;
+        uint32_t end_;
+    };
+
+    template <class Function>
+    inline bool forEachHandler(const HandlerRange& range, Function& function) const {
+        for(uint32_t i = range.begin_; i < range.end_; ++i) {
+            function(handlers_[i]);
+        }
+        return range.begin_ != range.end_;
+    }
+
+    //! Recompute the handler ranges from the subscriptions
+    void rebuild();
+
+    inline static bool isExact(const CanFrameIdentifier& matcher) { return matcher.mask == 0xffffffffu; }
+    inline static bool matches(const CanFrameIdentifier& matcher, const uint32_t cobId) { return !((cobId ^ matcher.identifier) & matcher.mask); }
+
+ protected:
+    //! all subscriptions, in order of subscription
+    std::vector<Subscription> subscriptions_;
+    SubscriptionHandle nextHandle_;
+
+    //! precomputed handler lists, referenced by the handler ranges below
+    std::vector<CanMessageHandler> handlers_;
+
+    //! handler ranges indexed by 11-bit identifier
+    std::array<HandlerRange, StandardFrameTableSize> standardFrameHandlers_;
+
+    //! handler ranges of extended identifiers having an exact subscription
+    std::unordered_map<uint32_t, HandlerRange> extendedFrameHandlers_;
+
+    //! masked subscriptions, in order of subscription, for frames not found in the tables above
+    std::vector<Subscription> maskedSubscriptions_;
+
+    //! callback for frames without any handler
+    CanMessageHandler::CallbackPtr unmappedCallback_;
+    std::shared_ptr<void> unmappedCallbackOwner_;
+};
+
+} /* namespace tcan_can */
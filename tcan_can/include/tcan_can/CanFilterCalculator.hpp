@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <linux/can.h> // for can_filter
+
+#include "tcan_can/CanFrameIdentifier.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Computes a set of kernel CAN_RAW_FILTERs letting pass all frames matched by the given identifiers and masks.
+ * Duplicate filters and filters covered by a less specific one are removed. If more than maxNumFilters remain, the
+ * filters are merged pairwise into common masks, preferring merges which keep the most mask bits set, until the limit
+ * is met. The result may therefore let pass more frames than requested, but never less.
+ * @param matchers          identifiers and masks of the frames to be received
+ * @param maxNumFilters     maximum number of filters (at least 1)
+ * @return filters to be applied with setsockopt(.., CAN_RAW_FILTER, ..)
+ */
+std::vector<can_filter> computeCanFilters(const std::vector<CanFrameIdentifier>& matchers, const std::size_t maxNumFilters = CAN_RAW_FILTER_MAX);
+
+} /* namespace tcan_can */
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+struct nlmsghdr;
+
+namespace tcan_can {
+
+/*!
+ * Monitors a CAN network interface with rtnetlink: existence and index of the interface, link up/down, state and error
+ * counters of the CAN controller. Requests and notifications are processed without blocking by update(), which is
+ * called periodically, e.g. from the sanity check of the bus. The getters can be called from any thread.
+ */
+class CanLinkMonitor {
+ public:
+    //! state of the CAN controller, the values match enum can_state of linux/can/netlink.h
+    enum class ControllerState : uint8_t {
+        ErrorActive = 0,    // RX/TX error count < 96
+        ErrorWarning,       // RX/TX error count < 128
+        ErrorPassive,       // RX/TX error count < 256
+        BusOff,             // RX/TX error count >= 256
+        Stopped,            // device is stopped
+        Sleeping,           // device is sleeping
+        Unknown             // not reported, e.g. by virtual interfaces
+    };
+
+    explicit CanLinkMonitor(const std::string& interface);
+
+    ~CanLinkMonitor();
+
+    /*!
+     * Open the netlink socket, subscribe to link notifications and request the current state
+     * @return true if successful
+     */
+    bool open();
+
+    /*!
+     * Process the pending replies and notifications, and request the state for the next call. Error counters and
+     * controller states other than bus off are not notified by the kernel, they are updated by the requests.
+     * @return true if the state changed
+     */
+    bool update();
+
+    /*!
+     * Restart the controller after bus off (like "ip link set <interface> type can restart"). Requires CAP_NET_ADMIN.
+     * The result is logged by a later update().
+     * @return true if the request was sent
+     */
+    bool restartController();
+
+    //! @return true if the interface exists
+    inline bool exists() const { return interfaceIndex_.load(std::memory_order_relaxed) > 0; }
+
+    //! @return index of the interface, 0 if it does not exist
+    inline int getInterfaceIndex() const { return interfaceIndex_.load(std::memory_order_relaxed); }
+
+    //! @return true if the link is up and running
+    inline bool isLinkUp() const { return isLinkUp_.load(std::memory_order_relaxed); }
+
+    inline ControllerState getControllerState() const { return controllerState_.load(std::memory_order_relaxed); }
+
+    inline uint16_t getTxErrorCounter() const { return txErrorCounter_.load(std::memory_order_relaxed); }
+
+    inline uint16_t getRxErrorCounter() const { return rxErrorCounter_.load(std::memory_order_relaxed); }
+
+    //! @return name of a controller state
+    static const char* getControllerStateName(const ControllerState state);
+
+ protected:
+    //! Requests the state of the interface
+    bool requestState();
+
+    /*!
+     * Processes a RTM_NEWLINK or RTM_DELLINK message of any interface
+     * @return true if the state of the monitored interface changed
+     */
+    bool handleLinkMessage(const struct nlmsghdr* msg);
+
+ protected:
+    const std::string interface_;
+    int socket_;
+    uint32_t sequenceNumber_;
+
+    std::atomic<int> interfaceIndex_;
+    std::atomic<bool> isLinkUp_;
+    std::atomic<ControllerState> controllerState_;
+    std::atomic<uint16_t> txErrorCounter_;
+    std::atomic<uint16_t> rxErrorCounter_;
+};
+
+} /* namespace tcan_can */
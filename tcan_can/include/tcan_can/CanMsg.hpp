@@ -2,68 +2,98 @@
 
 #include <algorithm> // std::copy
 #include <stdint.h>
+#include <cstddef>
 #include <initializer_list>
 #include <cassert>
+#include <type_traits>
 
 namespace tcan_can {
 
-//! General CANOpen message container
-
+/*!
+ * General CANOpen message container. Holds classic CAN as well as CAN FD frames.
+ * The message is trivially copyable and its memory layout matches the linux socketcan canfd_frame, whose first
+ * 16 bytes in turn match can_frame. SocketBus reads and writes messages without converting them, and messages can be
+ * copied with memcpy, e.g. into send arrays or through lock-free queues. Classes adding helpers, like SdoMsg, derive
+ * without virtual functions.
+ */
 class CanMsg {
  public:
-    static constexpr size_t Capacity = 8;
+    //! maximum payload of a classic CAN frame
+    static constexpr size_t ClassicCapacity = 8;
+    //! maximum payload of a CAN FD frame
+    static constexpr size_t Capacity = 64;
+    //! size of the header preceding the payload
+    static constexpr size_t HeaderSize = 8;
+
+    //! flags of CAN FD frames. The values match the ones of the linux socketcan canfd_frame.
+    enum Flags {
+        BitRateSwitch = 0x01,       // bit rate switch (second bitrate for payload data)
+        ErrorStateIndicator = 0x02, // error state indicator of the transmitting node
+        Fd = 0x04                   // frame is a CAN FD frame
+    };
 
     /*! Constructor
      * @param  COBId  Communication Object Identifier
      */
     CanMsg() = delete;
 
+    // The constructors only zero the payload up to the length, and at least the ClassicCapacity bytes sent in a classic
+    // frame, so constructing a classic frame does not clear 64 bytes. The rest of the CAN FD payload is zeroed by
+    // write(.., pos) and when the frame is sent.
+
     CanMsg(const uint32_t CobId):
         CobId_(CobId),
         length_{0},
-        data_{0, 0, 0, 0, 0, 0, 0, 0}
+        flags_{0},
+        reserved_{}
     {
+        std::fill(&data_[0], &data_[ClassicCapacity], 0);
     }
 
     CanMsg(const uint32_t CobId, const uint8_t length):
           CobId_(CobId),
           length_(length),
-          data_{0, 0, 0, 0, 0, 0, 0, 0}
+          flags_{0},
+          reserved_{}
     {
         assert(length <= Capacity);
+        std::fill(&data_[0], &data_[length > ClassicCapacity ? length : ClassicCapacity], 0);
     }
 
     CanMsg(const uint32_t CobId, const uint8_t length, const uint8_t* data):
         CobId_(CobId),
         length_(length),
-        data_{0, 0, 0, 0, 0, 0, 0, 0}
+        flags_{0},
+        reserved_{}
     {
         assert(length <= Capacity);
         std::copy(&data[0], &data[length], data_);
+        clearClassicPadding();
     }
 
     CanMsg(const uint32_t CobId, const uint8_t length, const std::initializer_list<uint8_t> data):
         CobId_(CobId),
         length_(length),
-        data_{0, 0, 0, 0, 0, 0, 0, 0}
+        flags_{0},
+        reserved_{}
     {
         assert(length <= Capacity);
         assert(length == data.size());
         std::copy(data.begin(), data.end(), data_);
+        clearClassicPadding();
     }
 
     CanMsg(const uint32_t CobId, const std::initializer_list<uint8_t> data):
         CobId_(CobId),
         length_(data.size()),
-        data_{0, 0, 0, 0, 0, 0, 0, 0}
+        flags_{0},
+        reserved_{}
     {
         assert(data.size() <= Capacity);
         std::copy(data.begin(), data.end(), data_);
+        clearClassicPadding();
     }
 
-    //! Destructor
-    virtual ~CanMsg() = default;
-
     /*! Gets the Communication Object Identifier
      *
      * @return COBId
@@ -73,10 +103,17 @@ class CanMsg {
 
     /*! Gets the stack of values
      *
-     * @return reference to data_[8]
+     * @return reference to data_[64]
      */
     inline const uint8_t* getData() const { return data_; }
 
+    /*! Gets the stack of values for writing, e.g. with tcan::SignalLayout. Use setLength(..) to set the length.
+     * Bytes beyond ClassicCapacity and the length given to the constructor are not initialized.
+     *
+     * @return pointer to data_[64]
+     */
+    inline uint8_t* getData() { return data_; }
+
     /*! Gets the lengths of the values in the stack
      * @return reference to length
      */
@@ -84,11 +121,60 @@ class CanMsg {
 
 
     /*!
-     * Set length of the message. Note that the data is not set (but was initialized to 0)
-     * @param length    length of the message in bytes [0,8]
+     * Set length of the message. Note that the data is not set (but was initialized to 0 up to ClassicCapacity)
+     * @param length    length of the message in bytes [0,8], [0,64] for CAN FD frames
      */
     inline void setLength(const uint8_t length) { length_ = length; }
 
+    //! @return flags of the frame, see Flags
+    constexpr uint8_t getFlags() const { return flags_; }
+
+    /*!
+     * Set the flags of the frame
+     * @param flags     combination of Flags
+     */
+    inline void setFlags(const uint8_t flags) { flags_ = flags; }
+
+    //! @return true if this is a CAN FD frame
+    constexpr bool isFd() const { return (flags_ & Fd) != 0; }
+
+    /*!
+     * Mark the message as CAN FD frame.
+     * @param bitRateSwitch     transmit the payload with the data phase bit rate
+     */
+    inline void setFd(const bool bitRateSwitch = true) { flags_ = static_cast<uint8_t>(Fd | (bitRateSwitch ? BitRateSwitch : 0)); }
+
+    /*!
+     * @param length    payload length in bytes
+     * @return the smallest valid CAN FD payload length (0..8, 12, 16, 20, 24, 32, 48, 64) not smaller than length
+     */
+    static inline uint8_t getValidFdLength(const uint8_t length) {
+        return dlcToLength(lengthToDlc(length));
+    }
+
+    /*!
+     * @param length    payload length in bytes
+     * @return data length code of the smallest CAN FD frame fitting the payload
+     */
+    static inline uint8_t lengthToDlc(const uint8_t length) {
+        if(length <= 8) {
+            return length;
+        }
+        if(length <= 24) {
+            return static_cast<uint8_t>(9 + (length - 9) / 4);
+        }
+        return length <= 32 ? 13 : (length <= 48 ? 14 : 15);
+    }
+
+    /*!
+     * @param dlc   data length code [0,15]
+     * @return CAN FD payload length in bytes
+     */
+    static inline uint8_t dlcToLength(const uint8_t dlc) {
+        static constexpr uint8_t lengths[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+        return lengths[dlc & 0x0F];
+    }
+
 
     /*! Sets the stack of values
      * @param value   array of length 8
@@ -158,6 +244,7 @@ class CanMsg {
     inline void write(const int32_t value, const uint8_t pos)
     {
         assert(pos + 4u <= Capacity);
+        clearGap(pos);
         data_[3 + pos] = static_cast<uint8_t>((value >> 24) & 0xFF);
         data_[2 + pos] = static_cast<uint8_t>((value >> 16) & 0xFF);
         data_[1 + pos] = static_cast<uint8_t>((value >> 8) & 0xFF);
@@ -171,6 +258,7 @@ class CanMsg {
     inline void write(const uint32_t value, const uint8_t pos)
     {
         assert(pos + 4u <= Capacity);
+        clearGap(pos);
         data_[3 + pos] = static_cast<uint8_t>((value >> 24) & 0xFF);
         data_[2 + pos] = static_cast<uint8_t>((value >> 16) & 0xFF);
         data_[1 + pos] = static_cast<uint8_t>((value >> 8) & 0xFF);
@@ -184,6 +272,7 @@ class CanMsg {
     inline void write(const int16_t value, const uint8_t pos)
     {
         assert(pos + 2u <= Capacity);
+        clearGap(pos);
         data_[1 + pos] = static_cast<uint8_t>((value >> 8) & 0xFF);
         data_[0 + pos] = static_cast<uint8_t>((value >> 0) & 0xFF);
 
@@ -195,6 +284,7 @@ class CanMsg {
     inline void write(const uint16_t value, const uint8_t pos)
     {
         assert(pos + 2u <= Capacity);
+        clearGap(pos);
         data_[1 + pos] = static_cast<uint8_t>((value >> 8) & 0xFF);
         data_[0 + pos] = static_cast<uint8_t>((value >> 0) & 0xFF);
 
@@ -206,6 +296,7 @@ class CanMsg {
     inline void write(const int8_t value, const uint8_t pos)
     {
         assert(pos + 1u <= Capacity);
+        clearGap(pos);
         data_[0 + pos] = static_cast<uint8_t>(value);
 
         if(pos + 1u > length_) {
@@ -216,6 +307,7 @@ class CanMsg {
     inline void write(const uint8_t value, const uint8_t pos)
     {
         assert(pos + 1u <= Capacity);
+        clearGap(pos);
         data_[0 + pos] = value;
 
         if(pos + 1u > length_) {
@@ -275,15 +367,38 @@ class CanMsg {
     }
 
  private:
+    //! Zeroes the bytes of a classic frame after the payload
+    inline void clearClassicPadding() {
+        if(length_ < ClassicCapacity) {
+            std::fill(&data_[length_], &data_[ClassicCapacity], 0);
+        }
+    }
+
+    //! Zeroes the uninitialized CAN FD payload between the length and pos, before writing at pos
+    inline void clearGap(const uint8_t pos) {
+        if(pos > ClassicCapacity && pos > length_) {
+            std::fill(&data_[length_ > ClassicCapacity ? length_ : ClassicCapacity], &data_[pos], 0);
+        }
+    }
+
     //! Communication Object Identifier
     uint32_t CobId_;
 
     //! the message data length
     uint8_t length_;
 
+    //! CAN FD flags, see Flags
+    uint8_t flags_;
+
+    //! reserved bytes of canfd_frame, 0 unless received from the kernel
+    uint8_t reserved_[2];
+
     /*! Data of the CAN message
      */
-    uint8_t data_[Capacity];
+    alignas(8) uint8_t data_[Capacity];
 };
 
+static_assert(std::is_trivially_copyable<CanMsg>::value && std::is_standard_layout<CanMsg>::value, "CanMsg shall be copyable with memcpy");
+static_assert(sizeof(CanMsg) == CanMsg::HeaderSize + CanMsg::Capacity, "CanMsg shall not contain padding");
+
 } /* namespace tcan_can */
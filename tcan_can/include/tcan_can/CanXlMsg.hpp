@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm> // std::copy
+#include <stdint.h>
+#include <cstddef>
+#include <cassert>
+
+namespace tcan_can {
+
+/*!
+ * CAN XL message container with up to 2048 bytes payload.
+ * The memory layout matches the linux socketcan canxl_frame, so that SocketBus reads and writes the message without copying.
+ * The payload is not initialized on construction, as only the first getLength() bytes are sent.
+ */
+class CanXlMsg {
+ public:
+    static constexpr size_t Capacity = 2048;
+    //! size of the header preceding the payload
+    static constexpr size_t HeaderSize = 12;
+
+    //! flags of CAN XL frames. The values match the ones of the linux socketcan canxl_frame.
+    enum Flags {
+        SimpleExtendedContent = 0x01,   // security/segmentation content
+        Xl = 0x80                       // frame is a CAN XL frame, always set
+    };
+
+    /*! Constructor
+     * @param priority              11 bit priority used for arbitration
+     * @param acceptanceField       acceptance field (e.g. addressing the receiver)
+     * @param serviceDataUnitType   type of the payload
+     */
+    CanXlMsg() = delete;
+
+    explicit CanXlMsg(const uint32_t priority, const uint32_t acceptanceField = 0, const uint8_t serviceDataUnitType = 0):
+        priority_(priority & 0x7FF),
+        flags_(Xl),
+        serviceDataUnitType_(serviceDataUnitType),
+        length_(0),
+        acceptanceField_(acceptanceField)
+    {
+    }
+
+    CanXlMsg(const uint32_t priority, const uint32_t acceptanceField, const uint8_t serviceDataUnitType, const uint16_t length, const uint8_t* data):
+        CanXlMsg(priority, acceptanceField, serviceDataUnitType)
+    {
+        setData(length, data);
+    }
+
+    inline uint32_t getPriority() const { return priority_; }
+    inline uint32_t getAcceptanceField() const { return acceptanceField_; }
+    inline uint8_t getServiceDataUnitType() const { return serviceDataUnitType_; }
+
+    //! @return flags of the frame, see Flags
+    inline uint8_t getFlags() const { return flags_; }
+
+    /*!
+     * Set the flags of the frame. The Xl flag is always kept.
+     * @param flags     combination of Flags
+     */
+    inline void setFlags(const uint8_t flags) { flags_ = static_cast<uint8_t>(flags | Xl); }
+
+    inline uint16_t getLength() const { return length_; }
+
+    /*!
+     * Set length of the message. Note that the data is not set.
+     * @param length    length of the message in bytes [1,2048]
+     */
+    inline void setLength(const uint16_t length) {
+        assert(length <= Capacity);
+        length_ = length;
+    }
+
+    inline const uint8_t* getData() const { return data_; }
+
+    //! @return pointer to the payload, e.g. to fill it in-place before calling setLength(..)
+    inline uint8_t* getData() { return data_; }
+
+    inline void setData(const uint16_t length, const uint8_t* data) {
+        assert(length <= Capacity);
+        length_ = length;
+        std::copy(&data[0], &data[length], data_);
+    }
+
+ private:
+    //! 11 bit priority (in place of the COB id of classic frames)
+    uint32_t priority_;
+    uint8_t flags_;
+    uint8_t serviceDataUnitType_;
+    uint16_t length_;
+    uint32_t acceptanceField_;
+
+    //! payload, only the first length_ bytes are valid
+    uint8_t data_[Capacity];
+};
+
+static_assert(sizeof(CanXlMsg) == CanXlMsg::HeaderSize + CanXlMsg::Capacity, "CanXlMsg shall not contain padding");
+
+} /* namespace tcan_can */
@@ -1,16 +1,20 @@
 #pragma once
 
 #include <stdint.h>
-#include <queue>
+#include <cstring>
 #include <mutex>
 #include <atomic>
-#include <unordered_map>
 #include <memory>
+#include <type_traits>
 
 #include "tcan_can/DeviceCanOpenOptions.hpp"
 #include "tcan_can/CanDevice.hpp"
 #include "tcan_can/CanBus.hpp"
+#include "tcan_can/SdoAnswerTable.hpp"
 #include "tcan_can/SdoMsg.hpp"
+#include "tcan_can/SdoQueue.hpp"
+#include "tcan_can/SdoRequest.hpp"
+#include "tcan_can/SdoTransfer.hpp"
 
 
 namespace tcan_can {
@@ -62,15 +66,17 @@ class DeviceCanOpen : public CanDevice {
      */
     void sendPdo(const CanMsg& pdoMsg);
 
-    /*! Put an SDO at the end of the sdo queue and send automatically on the CAN bus.
+    /*! Put an SDO at the end of the sdo queue and send automatically on the CAN bus. Can be called from any thread,
+     * without locking nor allocating.
      * To receive the answer of read SDO's it is necessary to implement the handleReadSDOAnswer(..) function.
      * @param sdoMsg Message to be sent
+     * @return false if the sdo queue is full (see DeviceCanOpenOptions::sdoQueueCapacity_)
      */
-    void sendSdo(const SdoMsg& sdoMsg);
+    bool sendSdo(const SdoMsg& sdoMsg);
 
     /*! Handle a SDO answer
      * this function is automatically called by parseSDO(..) and provides the possibility to save data from read SDO requests.
-     * @param sdoMsg	the SDO response message (Note that sdoMsg is not a complete instance of an SdoMsg, only the members defined in CanMsg are initialized)
+     * @param sdoMsg	the SDO response message
      */
     virtual void handleReadSdoAnswer(const SdoMsg& /*sdoMsg*/) { }
 
@@ -93,6 +99,65 @@ class DeviceCanOpen : public CanDevice {
      */
     bool getSdoAnswer(SdoMsg& sdoAnswer);
 
+    /*! Put an expedited read of an object at the end of the sdo queue. The answer, an abort or a timeout finishes the
+     * request, handleReadSdoAnswer(..), handleSdoError(..) and handleTimedoutSdo(..) are not called.
+     * @param request   completion token, owned by the caller, holding the value or abort code when it is finished
+     * @param index     index of the object
+     * @param subIndex  subindex of the object
+     * @return false if the request is pending
+     */
+    bool readSdoAsync(SdoRequest& request, const uint16_t index, const uint8_t subIndex);
+
+    /*! Put an expedited write of an object at the end of the sdo queue, see readSdoAsync(..).
+     * @param request   completion token, owned by the caller, holding the abort code when it is finished
+     * @param index     index of the object
+     * @param subIndex  subindex of the object
+     * @param value     value of 1, 2 or 4 bytes
+     * @return false if the request is pending
+     */
+    template <typename T>
+    bool writeSdoAsync(SdoRequest& request, const uint16_t index, const uint8_t subIndex, const T value) {
+        static_assert((sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4) && std::is_trivially_copyable<T>::value,
+                      "T shall be trivially copyable and have 1, 2 or 4 bytes");
+        uint32_t data = 0;
+        std::memcpy(&data, &value, sizeof(T));
+        const SdoMsg::Command command = (sizeof(T) == 1) ? SdoMsg::Command::WRITE_1_BYTE :
+                                        (sizeof(T) == 2) ? SdoMsg::Command::WRITE_2_BYTE : SdoMsg::Command::WRITE_4_BYTE;
+        return sendSdoAsync(request, SdoMsg(getNodeId(), command, index, subIndex, data));
+    }
+
+    /*! Put a segmented or block upload (read) of an object at the end of the sdo queue. Only one transfer can be queued
+     * at a time. The segments are exchanged on reception of the answers and timeouts are checked by sanityCheck(), so
+     * nothing blocks. handleSdoTransfer(..) is called when the transfer is done or aborted.
+     * @param index             index of the object
+     * @param subIndex          subindex of the object
+     * @param buffer            buffer receiving the object, valid until the transfer is finished
+     * @param capacity          size of the buffer
+     * @param blockTransfer     use SDO block upload with CRC
+     * @return false if a transfer is already queued or running
+     */
+    bool uploadSdo(const uint16_t index, const uint8_t subIndex, uint8_t* buffer, const std::size_t capacity, const bool blockTransfer = false);
+
+    /*! Put a segmented or block download (write) of an object at the end of the sdo queue, see uploadSdo(..).
+     * Data of up to 4 bytes is sent expedited if blockTransfer is false.
+     * @param index             index of the object
+     * @param subIndex          subindex of the object
+     * @param data              data of the object, valid until the transfer is finished
+     * @param length            length of the data
+     * @param blockTransfer     use SDO block download with CRC
+     * @return false if a transfer is already queued or running
+     */
+    bool downloadSdo(const uint16_t index, const uint8_t subIndex, const uint8_t* data, const std::size_t length, const bool blockTransfer = false);
+
+    //! @return true if a segmented or block transfer is queued or running
+    bool isSdoTransferBusy();
+
+    /*!
+     * This function is called when a transfer queued by uploadSdo(..) or downloadSdo(..) is done or aborted.
+     * @param transfer  the finished transfer, getLength() is the length of an uploaded object
+     */
+    virtual void handleSdoTransfer(const SdoTransfer& transfer);
+
     /*! NMT state requests. Send a NMT CAN message to the device.
      * The following functions also clear the sdo queue and set the nmtState_:
      *    setNmtEnterPreOperational(), setNmtResetRemoteCommunication(), setNmtRestartRemoteDevice()
@@ -142,13 +207,36 @@ class DeviceCanOpen : public CanDevice {
     bool checkSdoTimeout();
 
     /*!
-     * put the next SDO from the sdo queue into the bus output queue.
-     * WARNING: This function does not lock the sdoMsgsMutex_, so its up to the caller to do so.
+     * put the next SDO from the sdo queue into the bus output queue, if it was not sent yet.
+     * Called after pushing to an empty queue and after popping the front.
      */
     void sendNextSdo();
 
     /*!
-     * Acquires lock on the sdo queue mutex and clears the queue
+     * Put the request of an asynchronous SDO at the end of the sdo queue
+     * @return false if the request is pending
+     */
+    bool sendSdoAsync(SdoRequest& request, SdoMsg sdoMsg);
+
+    /*!
+     * Finish the request of an SDO, which was popped from the sdo queue, with an answer
+     */
+    void finishSdoRequest(SdoRequest& request, const uint8_t requestCommand, const SdoMsgView& answer);
+
+    /*!
+     * Pass an answer to the transfer at the front of the sdo queue and send its requests.
+     * @param position  position of the transfer in the sdo queue
+     */
+    bool parseSdoTransferAnswer(const CanMsg& cmsg, const uint32_t position);
+
+    /*!
+     * Put the pending requests of the transfer into the bus output queue, and continue with the next SDO if it is finished.
+     * WARNING: This function expects the caller to hold the sdoTransferMutex_ with guard.
+     */
+    void continueSdoTransfer(const uint32_t position, std::unique_lock<std::mutex>& guard);
+
+    /*!
+     * Pops all SDOs from the sdo queue and aborts the transfer and the asynchronous requests
      */
     void clearSdoQueue();
 
@@ -165,15 +253,21 @@ class DeviceCanOpen : public CanDevice {
     //! the can state the device is in
     std::atomic<NMTStates> nmtState_;
 
+    //! timeout counters of the sdo at sdoTimeoutPosition_ of the sdo queue, changed by the sanity check. The receive thread
+    //! resets sdoTimeoutCounter_ when a segment of a transfer was answered, so the transfer times out per segment.
     std::atomic<unsigned int> sdoTimeoutCounter_;
     std::atomic<unsigned int> sdoSentCounter_;
+    uint32_t sdoTimeoutPosition_;
+
+    //! The receive thread and the sanity check hand the front over by popping it, without locking
+    SdoQueue sdoMsgs_;
 
-    std::mutex sdoMsgsMutex_;
-    std::queue<SdoMsg> sdoMsgs_;
+    //! SDO answers by index and subindex, see getSdoAnswer(..)
+    SdoAnswerTable sdoAnswers_;
 
-    // Map from SDO answer id to SDO answer.
-    std::mutex sdoAnswerMapMutex_;
-    std::unordered_map<uint32_t, SdoMsg> sdoAnswerMap_;
+    //! segmented or block transfer, whose placeholder is in sdoMsgs_
+    std::mutex sdoTransferMutex_;
+    SdoTransfer sdoTransfer_;
 };
 
 } /* namespace tcan_can */
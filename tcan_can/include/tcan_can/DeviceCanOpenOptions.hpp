@@ -23,7 +23,9 @@ class DeviceCanOpenOptions : public CanDeviceOptions {
         CanDeviceOptions(nodeId, name, maxDeviceTimeoutCounter),
         maxSdoTimeoutCounter_(maxSdoTimeoutCounter),
         maxSdoSentCounter_(maxSdoSentCounter),
-        producerHeartBeatTime_(producerHeartBeatTime)
+        producerHeartBeatTime_(producerHeartBeatTime),
+        sdoQueueCapacity_(64),
+        sdoAnswerTableCapacity_(32)
     {
     }
 
@@ -48,6 +50,12 @@ class DeviceCanOpenOptions : public CanDeviceOptions {
     //! Heartbeat time interval [ms], produced by the device. Set to 0 to disable heartbeat message reception checking.
     uint16_t producerHeartBeatTime_;
 
+    //! maximum number of queued SDOs, rounded up to a power of two. Further SDOs are dropped.
+    unsigned int sdoQueueCapacity_;
+
+    //! maximum number of read answers which are stored and not yet taken with getSdoAnswer(..), rounded up to a power of two
+    unsigned int sdoAnswerTableCapacity_;
+
 };
 
 } /* namespace tcan_can */
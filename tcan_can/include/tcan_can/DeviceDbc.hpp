@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tcan_can/CanDbcDecodeTable.hpp"
+#include "tcan_can/CanDevice.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Generic device receiving all messages of a DBC database. Received frames are decoded into an array holding the latest
+ * physical value of every signal, indexed by CanDbcSignal::index_ (see CanDbc::getSignalIndex(..)).
+ * Derived classes can override onMessageDecoded(..) to process the values of a message as soon as it is received.
+ */
+class DeviceDbc : public CanDevice {
+ public:
+    /*! Constructors
+     * @param options   options of the device. The node id is not used.
+     * @param table     decode table of the messages to be received
+     */
+    DeviceDbc(std::unique_ptr<CanDeviceOptions>&& options, const std::shared_ptr<const CanDbcDecodeTable>& table);
+    DeviceDbc(const std::string& name, const std::shared_ptr<const CanDbcDecodeTable>& table);
+
+    ~DeviceDbc() override = default;
+
+    //! Subscribes to all messages of the decode table
+    bool initDevice() override;
+
+    bool configureDevice(const CanMsg& /*msg*/) override { return true; }
+
+    /*!
+     * @param index     index of the signal
+     * @return latest value of the signal, 0 if it was not received yet
+     */
+    double getSignalValue(const uint32_t index) const;
+
+    /*!
+     * Copy the latest values of all signals
+     * @param values    array of getDecodeTable().getNumSignals() values
+     */
+    void getSignalValues(double* values) const;
+
+    inline const CanDbcDecodeTable& getDecodeTable() const { return *table_; }
+
+ protected:
+    /*!
+     * Is called after a message was decoded, with valuesMutex_ locked.
+     * @param message   decoder of the received message
+     * @param values    values of all signals
+     */
+    virtual void onMessageDecoded(const CanDbcDecodeTable::MessageDecoder& /*message*/, const double* /*values*/) {}
+
+    bool parseMessage(const CanMsg& msg);
+
+ protected:
+    const std::shared_ptr<const CanDbcDecodeTable> table_;
+
+    // latest values of all signals, allocated on construction
+    std::vector<double> values_;
+    mutable std::mutex valuesMutex_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tcan/Bus.hpp"
+#include "tcan/GenericMsg.hpp"
+#include "tcan_can/IsoTpBusOptions.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Bus transmitting and receiving ISO 15765-2 (ISO-TP) PDUs with a CAN_ISOTP socket. The kernel segments transmitted
+ * PDUs, reassembles received PDUs and handles the flow control, so a PDU of up to 4095 bytes is a single GenericMsg
+ * instead of hundreds of frames. Each bus is a single connection between two CAN ids, see IsoTpBusOptions.
+ *
+ * Like the other GenericMsg buses, derived classes implement handleMessage(..), which is called with every received PDU.
+ */
+class IsoTpBus : public tcan::Bus<tcan::GenericMsg> {
+ public:
+    IsoTpBus() = delete;
+    IsoTpBus(std::unique_ptr<IsoTpBusOptions>&& options);
+
+    ~IsoTpBus() override;
+
+    /*! Do a sanity check of all devices on this bus.
+     */
+    bool sanityCheck() override;
+
+    int getPollableFileDescriptor() const override { return socket_; }
+
+    //! @return number of received PDUs dropped because they were longer than IsoTpBusOptions::maxPduLength_
+    inline uint64_t getNumTruncatedPdus() const { return numTruncatedPdus_.load(std::memory_order_relaxed); }
+
+ protected:
+    bool initializeInterface() override;
+    bool readData() override;
+    bool writeData(std::unique_lock<std::mutex>* lock) override;
+
+ private:
+    int socket_;
+    int recvFlag_;
+    int sendFlag_;
+
+    //! buffer of a received PDU, maxPduLength_ bytes
+    std::vector<uint8_t> receiveBuffer_;
+
+    std::atomic<uint64_t> numTruncatedPdus_;
+
+    std::atomic<unsigned int> deviceTimeoutCounter_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <linux/can/isotp.h>
+
+#include "tcan/BusOptions.hpp"
+
+namespace tcan_can {
+
+struct IsoTpBusOptions : public tcan::BusOptions {
+    IsoTpBusOptions():
+        IsoTpBusOptions(std::string(), 0, 0)
+    {
+    }
+
+    IsoTpBusOptions(const std::string& interface_name, const uint32_t txId, const uint32_t rxId):
+        BusOptions(interface_name),
+        txId_(txId),
+        rxId_(rxId),
+        blockSize_(CAN_ISOTP_DEFAULT_RECV_BS),
+        stMin_(CAN_ISOTP_DEFAULT_RECV_STMIN),
+        maxWaitFrames_(CAN_ISOTP_DEFAULT_RECV_WFTMAX),
+        txPadding_(false),
+        rxPaddingCheck_(false),
+        paddingContent_(CAN_ISOTP_DEFAULT_PAD_CONTENT),
+        canFdFrames_(false),
+        bitRateSwitch_(true),
+        maxPduLength_(4095),
+        maxDeviceTimeoutCounter_(0)
+    {
+    }
+
+    ~IsoTpBusOptions() override = default;
+
+    //! CAN id of the transmitted frames, and of the received flow control frames. Set CAN_EFF_FLAG for extended ids.
+    uint32_t txId_;
+
+    //! CAN id of the received frames, and of the transmitted flow control frames. Set CAN_EFF_FLAG for extended ids.
+    uint32_t rxId_;
+
+    //! block size sent in the flow control frames: number of consecutive frames the sender may send before waiting for
+    // the next flow control frame. 0 = send all frames without waiting.
+    uint8_t blockSize_;
+
+    //! separation time sent in the flow control frames, encoded as on the bus: 0x00-0x7F = 0-127 ms, 0xF1-0xF9 = 100-900 us.
+    uint8_t stMin_;
+
+    //! maximum number of wait frames before a transmission is aborted. 0 = wait frames are not accepted.
+    uint8_t maxWaitFrames_;
+
+    //! pad transmitted frames to the full frame length with paddingContent_
+    bool txPadding_;
+
+    //! drop received frames which are not padded with paddingContent_
+    bool rxPaddingCheck_;
+
+    //! content of padding bytes. The default 0xCC prevents bit stuffing.
+    uint8_t paddingContent_;
+
+    //! segment into CAN FD frames of up to 64 bytes. The interface has to be configured for CAN FD.
+    bool canFdFrames_;
+
+    //! send the data phase of the CAN FD frames at the data bitrate of the interface. Only used with canFdFrames_.
+    bool bitRateSwitch_;
+
+    //! length of the largest PDU that can be received, longer PDUs are dropped. The classic ISO-TP limit is 4095.
+    unsigned int maxPduLength_;
+
+    //! if > 0, the bus reports a missing device if no PDU was received for this number of sanity checks
+    unsigned int maxDeviceTimeoutCounter_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <cstring> // memcpy
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "tcan/SignalLayout.hpp"
+#include "tcan_can/DeviceCanOpen.hpp"
+#include "tcan_can/SdoMsg.hpp"
+
+
+namespace tcan_can {
+
+//! Direction of a PDO, seen from the device
+enum class PdoType {
+    Transmit,   // TPDO, sent by the device, communication parameters at 0x1800, mapping at 0x1A00
+    Receive     // RPDO, received by the device, communication parameters at 0x1400, mapping at 0x1600
+};
+
+//! Communication parameters of a PDO
+struct PdoParameters {
+    /*!
+     * @param type              TPDO or RPDO
+     * @param number            number of the PDO, starting at 1
+     * @param cobId             COB-ID, e.g. DeviceCanOpen::TxPDO1Id + nodeId. Flags as 0x40000000 (no RTR) are kept.
+     * @param transmissionType  0 (acyclic synchronous), 1-240 (every n-th SYNC), 254/255 (event driven)
+     * @param inhibitTime       minimum time between two TPDOs [100us], 0 to keep the value of the device
+     * @param eventTimer        period of an event driven TPDO, or RPDO deadline [ms], 0 to keep the value of the device
+     */
+    PdoParameters(const PdoType type, const unsigned int number, const uint32_t cobId, const uint8_t transmissionType = 0xFF,
+                  const uint16_t inhibitTime = 0, const uint16_t eventTimer = 0):
+        type_(type),
+        number_(number),
+        cobId_(cobId),
+        transmissionType_(transmissionType),
+        inhibitTime_(inhibitTime),
+        eventTimer_(eventTimer)
+    {
+    }
+
+    inline uint16_t getCommunicationIndex() const {
+        return static_cast<uint16_t>((type_ == PdoType::Transmit ? 0x1800 : 0x1400) + number_ - 1);
+    }
+
+    inline uint16_t getMappingIndex() const { return static_cast<uint16_t>(getCommunicationIndex() + 0x200); }
+
+    PdoType type_;
+    unsigned int number_;
+    uint32_t cobId_;
+    uint8_t transmissionType_;
+    uint16_t inhibitTime_;
+    uint16_t eventTimer_;
+};
+
+/*!
+ * Object of the object dictionary mapped into a PDO, stored in a member of a struct
+ * @tparam Struct       struct the PDO is decoded into
+ * @tparam T            type of the member: an integer, bool, float or double
+ * @tparam Member       pointer to the member
+ * @tparam Index        index of the object
+ * @tparam SubIndex     subindex of the object
+ * @tparam Bits         number of bits of the object in the PDO, e.g. 1 for a BOOLEAN or 24 for an INTEGER24
+ */
+template <class Struct, typename T, T Struct::*Member, uint16_t Index, uint8_t SubIndex, std::size_t Bits = sizeof(T) * 8>
+struct PdoEntry {
+    using Value = T;
+
+    static constexpr std::size_t BitLength = Bits;
+
+    //! value of the object in the mapping parameters of the PDO
+    static constexpr uint32_t MappingValue = (static_cast<uint32_t>(Index) << 16) | (static_cast<uint32_t>(SubIndex) << 8) | BitLength;
+
+    static inline T& get(Struct& values) { return values.*Member; }
+    static inline const T& get(const Struct& values) { return values.*Member; }
+};
+
+template <class Struct, typename T, T Struct::*Member, uint16_t Index, uint8_t SubIndex, std::size_t Bits>
+constexpr std::size_t PdoEntry<Struct, T, Member, Index, SubIndex, Bits>::BitLength;
+
+template <class Struct, typename T, T Struct::*Member, uint16_t Index, uint8_t SubIndex, std::size_t Bits>
+constexpr uint32_t PdoEntry<Struct, T, Member, Index, SubIndex, Bits>::MappingValue;
+
+namespace pdo_mapping_detail {
+
+//! Integers are packed by tcan::Signal, CANopen is little endian
+template <typename T, std::size_t BitOffset, std::size_t BitLength, typename = void>
+struct Codec : tcan::Signal<T, BitOffset, BitLength> {};
+
+//! BOOLEAN, any non-zero value is true
+template <std::size_t BitOffset, std::size_t BitLength>
+struct Codec<bool, BitOffset, BitLength, void> {
+    using Value = bool;
+    using RawSignal = tcan::Signal<uint8_t, BitOffset, BitLength>;
+    static constexpr std::size_t EndByte = RawSignal::EndByte;
+
+    static inline bool unpack(const uint8_t* data) { return RawSignal::unpack(data) != 0; }
+    static inline void pack(uint8_t* data, const bool value) { RawSignal::pack(data, value ? 1 : 0); }
+};
+
+//! REAL32 and REAL64 are copied bitwise
+template <typename T, std::size_t BitOffset, std::size_t BitLength>
+struct Codec<T, BitOffset, BitLength, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static_assert(BitLength == sizeof(T) * 8, "A floating point object shall be mapped with all its bits");
+
+    using Value = T;
+    using RawSignal = tcan::Signal<tcan::signal_layout_detail::Word<sizeof(T)>, BitOffset>;
+    static constexpr std::size_t EndByte = RawSignal::EndByte;
+
+    static inline T unpack(const uint8_t* data) {
+        const auto raw = RawSignal::unpack(data);
+        T value;
+        std::memcpy(&value, &raw, sizeof(T));
+        return value;
+    }
+
+    static inline void pack(uint8_t* data, const T value) {
+        typename RawSignal::Value raw;
+        std::memcpy(&raw, &value, sizeof(T));
+        RawSignal::pack(data, raw);
+    }
+};
+
+template <std::size_t BitOffset, std::size_t BitLength>
+constexpr std::size_t Codec<bool, BitOffset, BitLength, void>::EndByte;
+
+template <typename T, std::size_t BitOffset, std::size_t BitLength>
+constexpr std::size_t Codec<T, BitOffset, BitLength, typename std::enable_if<std::is_floating_point<T>::value>::type>::EndByte;
+
+//! Bit offset of entry I, the objects are mapped back to back
+template <std::size_t I, class... Entries>
+struct BitOffset;
+
+template <class First, class... Rest>
+struct BitOffset<0, First, Rest...> : std::integral_constant<std::size_t, 0> {};
+
+template <std::size_t I, class First, class... Rest>
+struct BitOffset<I, First, Rest...> : std::integral_constant<std::size_t, First::BitLength + BitOffset<I - 1, Rest...>::value> {};
+
+} /* namespace pdo_mapping_detail */
+
+/*!
+ * Mapping of a PDO onto the members of a struct. The same descriptor generates the SDOs configuring the mapping in the
+ * device and decodes and encodes the PDO, with the positions of the objects resolved at compile time.
+ *
+ * Usage:
+ *   struct Feedback { uint16_t statusword_; int32_t position_; int16_t torque_; };
+ *   using FeedbackPdo = tcan_can::PdoMapping<Feedback,
+ *       tcan_can::PdoEntry<Feedback, uint16_t, &Feedback::statusword_, 0x6041, 0x00>,
+ *       tcan_can::PdoEntry<Feedback, int32_t, &Feedback::position_, 0x6064, 0x00>,
+ *       tcan_can::PdoEntry<Feedback, int16_t, &Feedback::torque_, 0x6077, 0x00>>;
+ *
+ *   // in configureDevice(..), while the device is pre-operational
+ *   FeedbackPdo::configure(*this, tcan_can::PdoParameters(tcan_can::PdoType::Transmit, 1, TxPDO1Id + getNodeId(), 1));
+ *   // in the callback of the PDO
+ *   return FeedbackPdo::decode(msg, feedback_);
+ */
+template <class Struct, class... Entries>
+struct PdoMapping {
+    //! number of mapped objects
+    static constexpr std::size_t NumEntries = sizeof...(Entries);
+    //! number of bits of all objects, which is the offset past the last one
+    static constexpr std::size_t BitLength = pdo_mapping_detail::BitOffset<NumEntries, Entries..., void>::value;
+    //! size of the PDO
+    static constexpr std::size_t Size = (BitLength + 7) / 8;
+    //! maximum number of SDOs configuring the PDO, see getConfigurationSdos(..)
+    static constexpr std::size_t MaxConfigurationSdos = NumEntries + 6;
+
+    static_assert(NumEntries > 0, "A PDO shall map at least one object");
+    static_assert(Size <= 8, "A PDO shall not exceed 8 bytes");
+
+    template <std::size_t I>
+    using EntryAt = typename std::tuple_element<I, std::tuple<Entries...>>::type;
+
+    //! Codec of entry I, a tcan::Signal at the position of the object in the PDO
+    template <std::size_t I>
+    using SignalAt = pdo_mapping_detail::Codec<typename EntryAt<I>::Value, pdo_mapping_detail::BitOffset<I, Entries...>::value,
+                                               EntryAt<I>::BitLength>;
+
+    //! Read all objects from a buffer of at least Size bytes
+    static inline void decode(const uint8_t* data, Struct& values) {
+        decode(data, values, std::index_sequence_for<Entries...>());
+    }
+
+    //! Write all objects to a buffer of at least Size bytes
+    static inline void encode(const Struct& values, uint8_t* data) {
+        encode(values, data, std::index_sequence_for<Entries...>());
+    }
+
+    /*!
+     * Read all objects from a PDO
+     * @param msg       PDO, see tcan::SignalBuffer
+     * @param values    decoded values
+     * @return false if the message is shorter than Size
+     */
+    template <class Msg, typename = typename std::enable_if<std::is_class<Msg>::value>::type>
+    static inline bool decode(const Msg& msg, Struct& values) {
+        if(tcan::SignalBuffer<Msg>::getLength(msg) < Size) {
+            return false;
+        }
+        decode(tcan::SignalBuffer<Msg>::getData(msg), values);
+        return true;
+    }
+
+    /*!
+     * Write all objects to a PDO. The message length is not changed.
+     * @param values    values to be encoded
+     * @param msg       PDO, see tcan::SignalBuffer
+     * @return false if the message is shorter than Size
+     */
+    template <class Msg, typename = typename std::enable_if<std::is_class<Msg>::value>::type>
+    static inline bool encode(const Struct& values, Msg& msg) {
+        if(tcan::SignalBuffer<Msg>::getLength(msg) < Size) {
+            return false;
+        }
+        encode(values, tcan::SignalBuffer<Msg>::getData(msg));
+        return true;
+    }
+
+    /*!
+     * Generate the SDOs configuring the PDO in the device: the PDO is disabled, its mapping is cleared and written, its
+     * communication parameters are set and it is enabled again. The device shall be pre-operational.
+     * @param nodeId        node id of the device
+     * @param parameters    communication parameters of the PDO
+     * @param sdos          generated SDOs (output parameter)
+     * @return number of generated SDOs
+     */
+    static std::size_t getConfigurationSdos(const uint32_t nodeId, const PdoParameters& parameters,
+                                            std::array<SdoMsg, MaxConfigurationSdos>& sdos) {
+        const uint16_t communicationIndex = parameters.getCommunicationIndex();
+        const uint16_t mappingIndex = parameters.getMappingIndex();
+        const uint32_t cobId = parameters.cobId_ & ~InvalidCobIdBit;
+
+        std::size_t num = 0;
+        sdos[num++] = SdoMsg(nodeId, SdoMsg::Command::WRITE_4_BYTE, communicationIndex, 0x01, cobId | InvalidCobIdBit);
+        sdos[num++] = SdoMsg(nodeId, SdoMsg::Command::WRITE_1_BYTE, mappingIndex, 0x00, 0);
+        const uint32_t mappingValues[] = {Entries::MappingValue...};
+        for(std::size_t i = 0; i < NumEntries; ++i) {
+            sdos[num++] = SdoMsg(nodeId, SdoMsg::Command::WRITE_4_BYTE, mappingIndex, static_cast<uint8_t>(i + 1), mappingValues[i]);
+        }
+        sdos[num++] = SdoMsg(nodeId, SdoMsg::Command::WRITE_1_BYTE, mappingIndex, 0x00, NumEntries);
+        sdos[num++] = SdoMsg(nodeId, SdoMsg::Command::WRITE_1_BYTE, communicationIndex, 0x02, parameters.transmissionType_);
+        if(parameters.type_ == PdoType::Transmit && parameters.inhibitTime_ != 0) {
+            sdos[num++] = SdoMsg(nodeId, SdoMsg::Command::WRITE_2_BYTE, communicationIndex, 0x03, parameters.inhibitTime_);
+        }
+        if(parameters.eventTimer_ != 0) {
+            sdos[num++] = SdoMsg(nodeId, SdoMsg::Command::WRITE_2_BYTE, communicationIndex, 0x05, parameters.eventTimer_);
+        }
+        sdos[num++] = SdoMsg(nodeId, SdoMsg::Command::WRITE_4_BYTE, communicationIndex, 0x01, cobId);
+        return num;
+    }
+
+    /*!
+     * Queue the SDOs configuring the PDO in a device, see getConfigurationSdos(..)
+     * @param device        device, shall be pre-operational
+     * @param parameters    communication parameters of the PDO
+     * @return false if the SDO queue of the device is full
+     */
+    static bool configure(DeviceCanOpen& device, const PdoParameters& parameters) {
+        std::array<SdoMsg, MaxConfigurationSdos> sdos;
+        const std::size_t num = getConfigurationSdos(device.getNodeId(), parameters, sdos);
+        for(std::size_t i = 0; i < num; ++i) {
+            if(!device.sendSdo(sdos[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+ private:
+    //! bit 31 of the COB-ID marks a PDO as invalid (disabled)
+    static constexpr uint32_t InvalidCobIdBit = 0x80000000;
+
+    template <std::size_t... I>
+    static inline void decode(const uint8_t* data, Struct& values, std::index_sequence<I...>) {
+        using expand = int[];
+        (void)expand{0, (EntryAt<I>::get(values) = SignalAt<I>::unpack(data), 0)...};
+    }
+
+    template <std::size_t... I>
+    static inline void encode(const Struct& values, uint8_t* data, std::index_sequence<I...>) {
+        using expand = int[];
+        (void)expand{0, (SignalAt<I>::pack(data, EntryAt<I>::get(values)), 0)...};
+    }
+};
+
+template <class Struct, class... Entries>
+constexpr std::size_t PdoMapping<Struct, Entries...>::NumEntries;
+
+template <class Struct, class... Entries>
+constexpr std::size_t PdoMapping<Struct, Entries...>::BitLength;
+
+template <class Struct, class... Entries>
+constexpr std::size_t PdoMapping<Struct, Entries...>::Size;
+
+template <class Struct, class... Entries>
+constexpr std::size_t PdoMapping<Struct, Entries...>::MaxConfigurationSdos;
+
+template <class Struct, class... Entries>
+constexpr uint32_t PdoMapping<Struct, Entries...>::InvalidCobIdBit;
+
+} /* namespace tcan_can */
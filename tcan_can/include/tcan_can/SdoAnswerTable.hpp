@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+
+namespace tcan_can {
+
+/*!
+ * Preallocated table of the latest SDO answer per index and subindex. A slot is bound to a key when an answer of the key
+ * is stored and stays bound to it while further answers are stored. Once its answer was taken or erased, the slot can
+ * be rebound to another key, so the capacity limits the number of answers which are not taken, not the number of
+ * objects. Answers are stored by a single thread, the receive thread, and taken by any thread without locking.
+ */
+class SdoAnswerTable {
+ public:
+    /*!
+     * @param capacity  maximum number of objects, rounded up to a power of two
+     */
+    explicit SdoAnswerTable(const std::size_t capacity);
+
+    /*!
+     * Store the data of an answer, replacing a previous answer which was not taken
+     * @param key       index and subindex, see DeviceCanOpen::getSdoAnswerId(..)
+     * @param data      8 data bytes of the answer
+     * @return false if all slots hold answers which were not taken
+     */
+    bool store(const uint32_t key, const uint8_t* data);
+
+    /*!
+     * Take the data of an answer
+     * @param key       index and subindex
+     * @param data      8 data bytes of the answer (output parameter)
+     * @return false if no answer was stored since the last call
+     */
+    bool take(const uint32_t key, uint8_t* data);
+
+    //! Drop an answer which was not taken
+    void erase(const uint32_t key);
+
+    inline std::size_t capacity() const { return mask_ + 1; }
+
+ protected:
+    static constexpr uint32_t EmptyKey = 0xFFFFFFFF;
+    //! bit of the state of a slot which is set while the slot holds an answer
+    static constexpr uint32_t HasAnswer = 1;
+    //! increment of the version in the state of a slot, which changes whenever the slot is written
+    static constexpr uint32_t Version = 2;
+
+    /*!
+     * The state holds the key in the upper 32 bits, a version and the HasAnswer bit. A reader only takes the data if the
+     * state did not change while it read the data, so it never takes data stored for another key.
+     */
+    struct Slot {
+        std::atomic<uint64_t> state_;
+        std::atomic<uint64_t> data_;
+    };
+
+    static inline uint32_t getKey(const uint64_t state) { return static_cast<uint32_t>(state >> 32); }
+
+    static inline uint64_t makeState(const uint32_t key, const uint32_t version, const bool hasAnswer) {
+        return (static_cast<uint64_t>(key) << 32) | (hasAnswer ? (version | HasAnswer) : (version & ~HasAnswer));
+    }
+
+    /*!
+     * Find the slot bound to a key
+     * @return slot, nullptr if not found
+     */
+    Slot* find(const uint32_t key);
+
+    /*!
+     * Find the slot bound to a key, or a slot to bind to it. Only called by the thread storing the answers.
+     * @return slot, nullptr if all slots hold answers of other keys
+     */
+    Slot* findOrBind(const uint32_t key);
+
+ protected:
+    const uint32_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+};
+
+} /* namespace tcan_can */
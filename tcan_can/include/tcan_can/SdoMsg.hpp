@@ -8,7 +8,42 @@
 
 namespace tcan_can {
 
-//! Service Data Object Message Container
+class SdoRequest;
+
+/*!
+ * Read-only view of a CanMsg as SDO request or answer. The view does not copy the message, so it is valid as long as
+ * the viewed message.
+ */
+class SdoMsgView {
+ public:
+    explicit SdoMsgView(const CanMsg& msg):
+        msg_(msg)
+    {
+    }
+
+    inline uint8_t getCommandByte() const { return msg_.readuint8(0); }
+    inline uint16_t getIndex() const { return msg_.readuint16(1); }
+    inline uint8_t getSubIndex() const { return msg_.readuint8(3); }
+
+    //! @return data bytes 4 to 7, e.g. the value of an expedited transfer or the abort code
+    inline uint32_t getData() const { return msg_.readuint32(4); }
+
+    //! @return true if the command byte is the answer to an expedited read of 1, 2, 4 bytes or of unspecified length
+    inline bool isReadAnswer() const {
+        const uint8_t command = getCommandByte();
+        return command == 0x42 || command == 0x43 || command == 0x4B || command == 0x4F;
+    }
+
+    //! @return true if the command byte is an SDO abort
+    inline bool isAbort() const { return getCommandByte() == 0x80; }
+
+    inline const CanMsg& getMsg() const { return msg_; }
+
+ protected:
+    const CanMsg& msg_;
+};
+
+//! Service Data Object Message Container. Derives from CanMsg without virtual functions, so it is trivially copyable.
 class SdoMsg : public CanMsg {
  public:
 
@@ -49,6 +84,24 @@ class SdoMsg : public CanMsg {
     {
     }
 
+    //! Copy a received SDO answer. The answer does not require an answer.
+    explicit SdoMsg(const CanMsg& msg):
+            CanMsg(msg),
+            requiresAnswer_(false)
+    {
+    }
+
+    /*! Placeholder of a segmented or block transfer in the SDO queue
+     * @param initiateRequest   initiate request of the transfer, see SdoTransfer
+     * @param isTransfer        true
+     */
+    SdoMsg(const CanMsg& initiateRequest, const bool isTransfer):
+            CanMsg(initiateRequest),
+            requiresAnswer_(true),
+            isTransfer_(isTransfer)
+    {
+    }
+
     // special constructor for NMT messages
     SdoMsg(const uint8_t nodeId, const uint8_t nmtState):
             CanMsg(0x0, 2, {nmtState, nodeId}),
@@ -56,8 +109,6 @@ class SdoMsg : public CanMsg {
     {
     }
 
-    ~SdoMsg() override = default;
-
     //! getters for index and subindex for answer verfication
     inline uint8_t getCommandByte() const { return readuint8(0); }
     inline uint16_t getIndex() const { return readuint16(1); }
@@ -65,6 +116,13 @@ class SdoMsg : public CanMsg {
 
     inline bool getRequiresAnswer() const { return requiresAnswer_; }
 
+    //! @return true if the message is the placeholder of a segmented or block transfer
+    inline bool isTransfer() const { return isTransfer_; }
+
+    //! @return completion token of an asynchronous request, nullptr if the answer is handled by the device
+    inline SdoRequest* getRequest() const { return request_; }
+    inline void setRequest(SdoRequest* request) { request_ = request; }
+
     static std::string getErrorName(const int32_t error) {
         std::string name;
         switch (error) {
@@ -80,6 +138,15 @@ class SdoMsg : public CanMsg {
             case 0x05040001:
                 name = std::string{"Client / Server Specifier Error"};
                 break;
+            case 0x05040002:
+                name = std::string{"Invalid Block Size Error"};
+                break;
+            case 0x05040003:
+                name = std::string{"Invalid Sequence Number Error"};
+                break;
+            case 0x05040004:
+                name = std::string{"CRC Error"};
+                break;
             case 0x05040005:
                 name = std::string{"Out of Memory Error"};
                 break;
@@ -156,6 +223,12 @@ class SdoMsg : public CanMsg {
  protected:
     //! if true, message will stay in the SDO queue until answer was received or timed out.
     bool requiresAnswer_;
+
+    //! if true, the answers are handled by the SDO transfer of the device.
+    bool isTransfer_ = false;
+
+    //! completion token of readSdoAsync(..) and writeSdoAsync(..) of DeviceCanOpen
+    SdoRequest* request_ = nullptr;
 };
 
 } /* namespace tcan_can */
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "tcan_can/SdoMsg.hpp"
+
+
+namespace tcan_can {
+
+/*!
+ * Fixed-capacity ring of the SDOs of a device, of which only the front is in flight. Any thread can push, without
+ * locking nor allocating. The front is popped by whichever thread finishes it first: the thread receiving the answer or
+ * the thread checking the timeouts, so exactly one of them handles it.
+ *
+ * Positions are sequence numbers of the pushed messages. A message is sent once, by the thread which claims it with
+ * claimSend(..): the pushing thread if the queue was empty, otherwise the thread which popped its predecessor.
+ */
+class SdoQueue {
+ public:
+    /*!
+     * @param capacity  maximum number of queued SDOs, rounded up to a power of two
+     */
+    explicit SdoQueue(const std::size_t capacity);
+
+    /*!
+     * Put a message at the end of the queue
+     * @param msg           message
+     * @param position      position of the message (output parameter)
+     * @return false if the queue is full
+     */
+    bool push(const SdoMsg& msg, uint32_t& position);
+
+    /*!
+     * Copy the message at the front of the queue
+     * @param position      position of the front (output parameter)
+     * @param msg           message at the front (output parameter)
+     * @return false if the queue is empty, or the front is still being pushed
+     */
+    bool peek(uint32_t& position, SdoMsg& msg) const;
+
+    /*!
+     * Claim sending the message at a position
+     * @return false if it was claimed before
+     */
+    bool claimSend(const uint32_t position);
+
+    //! @return true if the message at a position was claimed for sending
+    bool isSent(const uint32_t position) const;
+
+    /*!
+     * Remove the front of the queue, if it is still at a position
+     * @return false if the front was removed by another thread
+     */
+    bool pop(const uint32_t position);
+
+    //! @return position of the front, which is the position of the next pushed message if the queue is empty
+    inline uint32_t getFrontPosition() const { return head_.load(); }
+
+    inline bool isEmpty() const { return head_.load() == tail_.load(); }
+
+    inline std::size_t size() const { return tail_.load() - head_.load(); }
+
+    inline std::size_t capacity() const { return mask_ + 1; }
+
+ protected:
+    struct Slot {
+        //! position of the message when it is pushed completely
+        std::atomic<uint32_t> pushed_;
+        //! position of the message when it is claimed for sending
+        std::atomic<uint32_t> sent_;
+        SdoMsg msg_;
+    };
+
+    const uint32_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    std::atomic<uint32_t> head_;
+    std::atomic<uint32_t> tail_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+
+namespace tcan_can {
+
+class DeviceCanOpen;
+
+/*!
+ * Completion token of an asynchronous expedited SDO read or write, see DeviceCanOpen::readSdoAsync(..) and
+ * DeviceCanOpen::writeSdoAsync(..). The request is owned by the caller and reused for further requests, so issuing a
+ * request does not allocate. It must stay valid until it is finished.
+ *
+ * The result can be polled with isFinished() from any thread, or received by a callback, which is called from the
+ * thread receiving the answer or checking the timeouts. A request with a callback must stay valid until the callback
+ * returned.
+ */
+class SdoRequest {
+ public:
+    enum class State : uint8_t {
+        Idle,
+        Pending,
+        Done,
+        Aborted     // the abort code was received, or is set by the client, e.g. on timeout
+    };
+
+    //! The callback is copied into the request, small captures (up to two pointers) do not allocate.
+    using Callback = std::function<void(const SdoRequest&)>;
+
+    SdoRequest() = default;
+
+    explicit SdoRequest(Callback callback):
+        callback_(std::move(callback))
+    {
+    }
+
+    SdoRequest(const SdoRequest&) = delete;
+    SdoRequest& operator=(const SdoRequest&) = delete;
+
+    //! Set the callback. Must not be called while the request is pending.
+    inline void setCallback(Callback callback) { callback_ = std::move(callback); }
+
+    /*!
+     * Set the timeout of the request. Must not be called while the request is pending.
+     * @param maxTimeoutCounter     number of sanity checks until the request is sent again. 0 to use the device options.
+     * @param maxSentCounter        number of repetitions until the request is aborted. 0 to use the device options.
+     */
+    inline void setTimeout(const unsigned int maxTimeoutCounter, const unsigned int maxSentCounter) {
+        maxTimeoutCounter_ = maxTimeoutCounter;
+        maxSentCounter_ = maxSentCounter;
+    }
+
+    inline State getState() const { return state_.load(std::memory_order_acquire); }
+    inline bool isPending() const { return getState() == State::Pending; }
+    inline bool isFinished() const { return getState() == State::Done || getState() == State::Aborted; }
+    inline bool isDone() const { return getState() == State::Done; }
+
+    inline uint16_t getIndex() const { return index_; }
+    inline uint8_t getSubIndex() const { return subIndex_; }
+
+    //! @return SDO abort code, 0 unless the request was aborted
+    inline uint32_t getAbortCode() const { return abortCode_; }
+
+    //! @return number of bytes of a read value, 4 if the server did not indicate it
+    inline uint8_t getLength() const { return length_; }
+
+    //! @return the value read, or written, as type T of up to 4 bytes
+    template <typename T>
+    inline T getValue() const {
+        static_assert(sizeof(T) <= sizeof(uint32_t) && std::is_trivially_copyable<T>::value, "T shall be trivially copyable and have up to 4 bytes");
+        T value;
+        std::memcpy(&value, &value_, sizeof(T));
+        return value;
+    }
+
+ protected:
+    friend class DeviceCanOpen;
+
+    //! Resets the result and marks the request as pending
+    inline void start(const uint16_t index, const uint8_t subIndex, const uint32_t value) {
+        index_ = index;
+        subIndex_ = subIndex;
+        value_ = value;
+        length_ = 0;
+        abortCode_ = 0;
+        state_.store(State::Pending, std::memory_order_release);
+    }
+
+    //! Sets the result and calls the callback
+    inline void finish(const uint32_t abortCode, const uint32_t value, const uint8_t length) {
+        abortCode_ = abortCode;
+        value_ = value;
+        length_ = length;
+        state_.store(abortCode == 0 ? State::Done : State::Aborted, std::memory_order_release);
+        if(callback_) {
+            callback_(*this);
+        }
+    }
+
+ protected:
+    Callback callback_;
+    unsigned int maxTimeoutCounter_ = 0;
+    unsigned int maxSentCounter_ = 0;
+
+    std::atomic<State> state_{State::Idle};
+    uint16_t index_ = 0;
+    uint8_t subIndex_ = 0;
+    uint8_t length_ = 0;
+    uint32_t value_ = 0;
+    uint32_t abortCode_ = 0;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+
+#include "tcan_can/CanMsg.hpp"
+
+
+namespace tcan_can {
+
+/*!
+ * Client side state machine of a segmented or block SDO transfer of one object (CiA 301). The transfer reads into or
+ * writes from a buffer of the caller, which must stay valid until the transfer is finished. It does not send nor
+ * allocate anything: answers of the server are passed to handleAnswer(..) and the requests to send are fetched with
+ * getNextRequest(..). Timeouts are handled by the owner, see DeviceCanOpen.
+ */
+class SdoTransfer {
+ public:
+    enum class Type : uint8_t {
+        Upload,         // segmented upload (read), expedited if the server answers so
+        Download,       // segmented download (write), expedited if the data fits into 4 bytes
+        BlockUpload,
+        BlockDownload
+    };
+
+    enum class State : uint8_t {
+        Idle,
+        Initiating,     // the initiate request is sent, but not answered
+        Running,        // segments are transferred
+        Done,
+        Aborted
+    };
+
+    //! SDO abort codes detected by the client
+    static constexpr uint32_t ToggleError = 0x05030000;
+    static constexpr uint32_t TimeoutError = 0x05040000;
+    static constexpr uint32_t CommandSpecifierError = 0x05040001;
+    static constexpr uint32_t BlockSizeError = 0x05040002;
+    static constexpr uint32_t SequenceNumberError = 0x05040003;
+    static constexpr uint32_t CrcError = 0x05040004;
+    static constexpr uint32_t OutOfMemoryError = 0x05040005;
+    static constexpr uint32_t LengthError = 0x06070010;
+    static constexpr uint32_t GeneralError = 0x08000000;
+
+    //! maximum number of segments per block
+    static constexpr uint8_t MaxBlockSize = 127;
+
+    SdoTransfer();
+
+    /*!
+     * Set up an upload of an object into a buffer
+     * @param nodeId            ID of the CAN node
+     * @param index             index of the object
+     * @param subIndex          subindex of the object
+     * @param buffer            buffer receiving the object, valid until the transfer is finished
+     * @param capacity          size of the buffer
+     * @param blockTransfer     use block upload
+     * @param blockSize         number of segments per block of block upload, 1..127
+     * @return false if a transfer is in progress or the block size is invalid
+     */
+    bool setupUpload(const uint32_t nodeId, const uint16_t index, const uint8_t subIndex, uint8_t* buffer, const std::size_t capacity,
+                     const bool blockTransfer = false, const uint8_t blockSize = MaxBlockSize);
+
+    /*!
+     * Set up a download of an object from a buffer
+     * @param nodeId            ID of the CAN node
+     * @param index             index of the object
+     * @param subIndex          subindex of the object
+     * @param data              data of the object, valid until the transfer is finished
+     * @param length            length of the data
+     * @param blockTransfer     use block download
+     * @return false if a transfer is in progress
+     */
+    bool setupDownload(const uint32_t nodeId, const uint16_t index, const uint8_t subIndex, const uint8_t* data, const std::size_t length,
+                       const bool blockTransfer = false);
+
+    /*!
+     * Process an answer of the server. Protocol errors abort the transfer.
+     * @param answer    SDO answer of the server
+     * @return false if the answer does not belong to the transfer
+     */
+    bool handleAnswer(const CanMsg& answer);
+
+    /*!
+     * Get the next request to send. Block downloads return all segments of a block one after another.
+     * @param request   request to send (output parameter)
+     * @return true if there was a request to send
+     */
+    bool getNextRequest(CanMsg& request);
+
+    /*!
+     * Abort the transfer. The abort request is returned by getNextRequest(..) if sendRequest is true.
+     * @param abortCode     SDO abort code
+     * @param sendRequest   notify the server
+     */
+    void abort(const uint32_t abortCode, const bool sendRequest = true);
+
+    //! @return the initiate request, which is sent again if it is not answered
+    inline const CanMsg& getInitiateRequest() const { return initiateRequest_; }
+
+    inline Type getType() const { return type_; }
+    inline State getState() const { return state_; }
+    inline uint16_t getIndex() const { return index_; }
+    inline uint8_t getSubIndex() const { return subIndex_; }
+
+    //! @return true if the transfer is initiating or running
+    inline bool isBusy() const { return state_ == State::Initiating || state_ == State::Running; }
+
+    //! @return true if the transfer is done or aborted
+    inline bool isFinished() const { return state_ == State::Done || state_ == State::Aborted; }
+
+    //! @return abort code sent or received, 0 if not aborted
+    inline uint32_t getAbortCode() const { return abortCode_; }
+
+    //! @return number of bytes transferred. When an upload is done, the length of the object.
+    inline std::size_t getLength() const { return offset_; }
+
+    //! @return size of the object indicated by the server for uploads, or the length of the data for downloads. 0 if unknown.
+    inline std::size_t getSize() const { return size_; }
+
+    /*!
+     * Compute the CRC of block transfers (CRC-16-CCITT, polynomial 0x1021)
+     * @param data      data
+     * @param length    length of the data
+     * @param crc       CRC of the preceding data, 0 at the start
+     * @return CRC
+     */
+    static uint16_t computeCrc(const uint8_t* data, const std::size_t length, uint16_t crc = 0);
+
+ protected:
+    void setup(const Type type, const uint32_t nodeId, const uint16_t index, const uint8_t subIndex);
+
+    bool handleUploadAnswer(const CanMsg& answer);
+    bool handleDownloadAnswer(const CanMsg& answer);
+    bool handleBlockUploadAnswer(const CanMsg& answer);
+    bool handleBlockDownloadAnswer(const CanMsg& answer);
+
+    //! @return true if the answer is the initiate answer with the expected command specifier, index and subindex
+    bool isInitiateAnswer(const CanMsg& answer, const uint8_t mask, const uint8_t command) const;
+
+    //! Copy received data into the buffer, false if it does not fit
+    bool receive(const uint8_t* data, const std::size_t length);
+
+    //! Queue a request consisting of a command byte and up to 7 more bytes
+    void setRequest(const uint8_t command);
+
+    //! Fill the request with the next segment of a segmented download
+    void setDownloadSegment();
+
+    //! Fill the request with the next segment of the block, false if all segments of the block were sent
+    bool getBlockSegment(CanMsg& request);
+
+    void finish();
+
+ protected:
+    Type type_;
+    State state_;
+
+    uint32_t requestCobId_;
+    uint16_t index_;
+    uint8_t subIndex_;
+
+    uint8_t* rxBuffer_;
+    const uint8_t* txData_;
+    //! capacity of rxBuffer_ or length of txData_
+    std::size_t capacity_;
+
+    //! number of bytes transferred and acknowledged
+    std::size_t offset_;
+    std::size_t size_;
+    //! length of the segment sent last by a segmented download, or of the last segment of a block download
+    std::size_t segmentLength_;
+
+    bool toggle_;
+
+    //! block transfers
+    bool crcSupported_;
+    uint8_t blockSize_;
+    //! block upload: last sequence number received in order. block download: last sequence number sent.
+    uint8_t sequenceNumber_;
+    //! block upload: the last segment was received. block download: the last segment was sent.
+    bool lastSegment_;
+    //! the last block was acknowledged, the end is sent or expected
+    bool ending_;
+
+    uint32_t abortCode_;
+
+    CanMsg initiateRequest_;
+    CanMsg request_;
+    bool hasRequest_;
+};
+
+} /* namespace tcan_can */
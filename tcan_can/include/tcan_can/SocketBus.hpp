@@ -1,35 +1,211 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tcan/Delegate.hpp"
+#include "tcan/RcuPointer.hpp"
 #include "tcan_can/CanBus.hpp"
+#include "tcan_can/CanLinkMonitor.hpp"
+#include "tcan_can/CanXlMsg.hpp"
 #include "tcan_can/SocketBusOptions.hpp"
 
 namespace tcan_can {
 
+class SocketBusReceiver;
+
 class SocketBus : public CanBus {
  public:
+    using XlCallbackPtr = tcan::Delegate<bool(const CanXlMsg&)>;
 
     SocketBus(const std::string& interface);
     SocketBus(std::unique_ptr<SocketBusOptions>&& options);
 
     ~SocketBus() override;
 
-    int getPollableFileDescriptor() const override { return socket_; }
+    //! @return socket of the bus, which is replaced if the socket is reopened (see SocketBusOptions::monitorLink_)
+    int getPollableFileDescriptor() const override { return *socket_.read(); }
+
+    /*!
+     * Sends a CAN XL message directly on the socket, bypassing the output queue of the bus. Can be called from any thread.
+     * @param msg   message to be sent
+     * @return true if successful. False if CAN XL is not enabled on this socket (see SocketBusOptions::canXlFrames_ and isXlEnabled())
+     *         or if the socket or netdevice queue is full, in which case the message can be sent again later
+     */
+    bool sendXlMessage(const CanXlMsg& msg);
+
+    /*!
+     * Sends a classic CAN message directly on the socket, bypassing the output queue of the bus. CAN FD messages are
+     * queued. Can be called from any thread.
+     * @param msg   message to be sent
+     * @return true if successful. False if the bus is passive or the socket did not take the frame
+     */
+    bool sendMessageDirectly(const CanMsg& msg) override;
+
+    /*!
+     * Adds a callback for received CAN XL messages with matching priority
+     * @param matcher   priority and mask of the messages
+     * @param object    pointer to the object to call the function on
+     * @param fp        pointer to the parse function
+     */
+    template <class T>
+    inline void addCanXlMessage(const CanFrameIdentifier matcher, T* object, bool(std::common_type<T>::type::*fp)(const CanXlMsg&)) {
+        const XlCallbackPtr callback(object, fp);
+        xlHandlers_.update([&matcher, &callback](XlHandlerContainer& handlers) { handlers.emplace_back(matcher, callback); });
+    }
+
+    //! @return true if CAN XL frames were successfully negotiated with the interface
+    inline bool isXlEnabled() const { return isXlEnabled_; }
+
+    //! @return index of the network interface, 0 before initBus()
+    inline int getInterfaceIndex() const { return interfaceIndex_.load(std::memory_order_acquire); }
+
+    /*!
+     * @return  frames per second the netdevice drained while it was congested, 0 if it was never congested.
+     *          Only measured with SocketBusOptions::adaptiveTxPacing_.
+     */
+    inline double getTxCapacity() const { return txCapacity_.load(std::memory_order_relaxed); }
+
+    //! @return number of writes that failed with ENOBUFS, with SocketBusOptions::adaptiveTxPacing_
+    inline uint64_t getNumTxCongestions() const { return numTxCongestions_.load(std::memory_order_relaxed); }
+
+    //! @return monitor of the link and controller state, nullptr if SocketBusOptions::monitorLink_ is not set
+    inline const CanLinkMonitor* getLinkMonitor() const { return linkMonitor_.get(); }
+
+    //! @return number of automatic controller restarts after bus off
+    inline unsigned int getNumControllerRestarts() const { return numControllerRestarts_.load(std::memory_order_relaxed); }
+
+    /*! Updates the link state, restarts the controller after bus off and reopens the socket if the interface was added
+     * again, if enabled in the options and the bus is not asynchronous. Then checks the devices.
+     * @return true if there is no bus error and no device is missing
+     */
+    bool sanityCheck() override;
 
 protected:
+    friend class SocketBusReceiver;
+
     bool initializeInterface() override;
     bool readData() override;
     bool writeData(std::unique_lock<std::mutex>* lock) override;
 
+    //! No receive thread is started if the frames are received by a SocketBusReceiver
+    bool hasReceiveThread() const override;
+
     /*!
-     * Is called on reception of a bus error message. Sets the flag
+     * Passes a classic or CAN FD frame received from the socket to the callbacks, or to handleBusErrorMessage(..)
+     * @param msg       received frame, in the layout of a canfd_frame
+     * @param numBytes  number of bytes received, CAN_MTU or CANFD_MTU
+     */
+    void handleReceivedFrame(CanMsg& msg, const std::size_t numBytes);
+
+    /*!
+     * Is called on reception of a bus error message. Decodes it and passes it to CanBus::handleBusError(..). Remembers
+     * if the bus was passivated because of bus off, see checkLink().
      * @param msg  reference to the bus error message
      */
-    void handleBusErrorMessage(const can_frame& msg);
+    void handleBusErrorMessage(const CanMsg& msg);
+
+    //! Reapplies the automatically computed can filters if enabled in the options
+    void onSubscriptionsChanged() override;
+
+    /*!
+     * Opens and configures a socket bound to the interface of the bus
+     * @param interfaceIndex    index of the interface (output parameter)
+     * @param isXlEnabled       true if CAN XL frames are usable on the socket (output parameter)
+     * @return the socket, -1 if it could not be opened
+     */
+    int openSocket(int& interfaceIndex, bool& isXlEnabled);
+
+    /*!
+     * Applies the can filters given in the options, complemented with the ones computed from the registered callbacks if
+     * autoCanFilters_ is set.
+     * @param socket    socket to apply the filters to
+     * @return true if successful
+     */
+    bool applyCanFilters(const int socket);
+
+    /*!
+     * Enables CAN XL frames on the socket and checks whether the interface supports them
+     * @param socket    socket to enable CAN XL frames on
+     * @return true if CAN XL is usable
+     */
+    bool enableXlFrames(const int socket);
+
+    //! Passes a received CAN XL message to all matching callbacks
+    void handleXlMessage(const CanXlMsg& msg);
+
+    /*!
+     * Is called if a write failed with ENOBUFS and adaptive pacing is enabled. Calibrates the sndbuf on the first call and
+     * waits until the netdevice drained frames, if the bus is asynchronous.
+     */
+    void handleTxCongestion(const int socket);
+
+    //! Counts a sent frame for the measurement of the tx capacity
+    void countSentFrame();
+
+    /*!
+     * Handles changes of the link state, see SocketBusOptions::monitorLink_. A bus passivated because of bus off (see
+     * BusOptions::passivateOnBusError_) is activated again once the controller recovered.
+     */
+    void checkLink();
+
+    //! Calls checkLink() every SocketBusOptions::linkCheckInterval_ in asynchronous mode
+    void linkWorker();
+
+    //! @return SocketBusOptions::linkCheckInterval_, at least 1 ms
+    inline std::chrono::milliseconds getLinkCheckInterval() const {
+        const unsigned int interval = static_cast<const SocketBusOptions*>(options_.get())->linkCheckInterval_;
+        return std::chrono::milliseconds(interval > 0 ? interval : 1);
+    }
+
+    /*!
+     * Opens a new socket after the interface was added (again) and publishes it once it is configured. The old socket is
+     * closed after the receive and transmit threads have left it. The sndbuf of the new socket is calibrated again.
+     * @return true if successful, the old socket is kept otherwise
+     */
+    bool reopenSocket();
 
  protected:
-    int socket_;
+    using XlHandlerContainer = std::vector<std::pair<CanFrameIdentifier, XlCallbackPtr>>;
+
+    //! socket of the bus, replaced by reopenSocket() while the other threads use it. -1 until the interface exists.
+    tcan::RcuPointer<int> socket_;
+    //! index of the interface, read by the SocketBusReceiver
+    std::atomic<int> interfaceIndex_;
     int recvFlag_;
     int sendFlag_;
+
+    //! CAN XL frames are enabled on the socket and supported by the interface
+    std::atomic<bool> isXlEnabled_;
+
+    //! receive buffer for CAN XL frames
+    CanXlMsg xlReceiveMsg_;
+
+    //! callbacks for received CAN XL messages
+    tcan::RcuPointer<XlHandlerContainer> xlHandlers_;
+
+    // adaptive tx pacing, only accessed by writeData(..) except for the atomics
+    std::atomic<bool> isTxCalibrated_;
+    std::chrono::steady_clock::time_point txWindowStart_;
+    unsigned int txWindowFrames_;
+    bool isTxWindowCongested_;
+    std::atomic<double> txCapacity_;
+    std::atomic<uint64_t> numTxCongestions_;
+
+    // link monitoring, only accessed by checkLink() except for the atomics
+    std::unique_ptr<CanLinkMonitor> linkMonitor_;
+    std::thread linkThread_;
+    std::atomic<bool> isLinkThreadRunning_;
+    //! the bus was passivated because of bus off and is activated when the controller recovered
+    std::atomic<bool> isPassivatedOnBusOff_;
+    CanLinkMonitor::ControllerState controllerState_;
+    std::chrono::steady_clock::time_point busOffTime_;
+    std::chrono::steady_clock::time_point lastRestartTime_;
+    unsigned int busOffRestartDelay_;
+    std::atomic<unsigned int> numControllerRestarts_;
 };
 
 } /* namespace tcan_can */
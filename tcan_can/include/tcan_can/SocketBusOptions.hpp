@@ -19,13 +19,23 @@ struct SocketBusOptions : public CanBusOptions {
         loopback_(false),
         sndBufLength_(0),
         canErrorMask_(CAN_ERR_MASK),
-        canFilters_()
+        canFdFrames_(false),
+        canXlFrames_(false),
+        canFilters_(),
+        autoCanFilters_(false),
+        maxNumCanFilters_(CAN_RAW_FILTER_MAX),
+        sharedReceive_(false),
+        adaptiveTxPacing_(false),
+        monitorLink_(false),
+        linkCheckInterval_(100),
+        busOffRestartDelay_(100),
+        maxBusOffRestartDelay_(5000)
     {
     }
 
     ~SocketBusOptions() override = default;
 
-    //! loop back sent messages
+    //! loop back sent messages to other sockets of the host. Not applied with sharedReceive_.
     bool loopback_;
 
     //! length of the socket buffer. 0=default. If the txqueuelen (default=10) of the netdevice cannot be changed
@@ -38,10 +48,56 @@ struct SocketBusOptions : public CanBusOptions {
     // see https://www.kernel.org/doc/Documentation/networking/can.txt
     unsigned int canErrorMask_;
 
+    //! enable sending and receiving of CAN FD frames (CAN_RAW_FD_FRAMES). Classic frames are still handled. The interface
+    // has to be configured for CAN FD, e.g. with "ip link set <interface> type can bitrate 1000000 dbitrate 5000000 fd on".
+    bool canFdFrames_;
+
+    //! enable sending and receiving of CAN XL frames (CAN_RAW_XL_FRAMES, linux >= 6.2). This implicitly enables CAN FD
+    // frames. The interface MTU has to be set for CAN XL, e.g. "ip link set <interface> mtu 2060". Use SocketBus::isXlEnabled()
+    // to check if CAN XL could be enabled.
+    bool canXlFrames_;
+
 
     //! vector of can filters to be applied
     // see https://www.kernel.org/doc/Documentation/networking/can.txt
     std::vector<can_filter> canFilters_;
+
+    //! compute the can filters from the identifiers and masks registered with addCanMessage(..), in addition to the ones in
+    // canFilters_. The filters are reapplied whenever a callback is added or removed. Note that frames not matched by any
+    // callback no longer reach the unmapped message callback, add them to canFilters_ if required.
+    bool autoCanFilters_;
+
+    //! maximum number of automatically computed can filters. If there are more registered identifiers, they are merged into
+    // masks, which may let pass some frames nobody handles.
+    unsigned int maxNumCanFilters_;
+
+    //! receive the frames of this bus with a SocketBusReceiver shared with other buses, instead of a receive thread per
+    // bus. The socket of the bus only transmits, so canFilters_, autoCanFilters_ and the reception of CAN XL frames do
+    // not apply, and its frames are not looped back (loopback_), as the receiver would pass them to the bus. The bus has
+    // to be added to the receiver with SocketBusReceiver::addBus(..).
+    bool sharedReceive_;
+
+    //! handle ENOBUFS of a netdevice with a short txqueuelen (see sndBufLength_) instead of reporting a bus error. On the
+    // first ENOBUFS, the sndbuf is calibrated to the bytes the socket had in flight, such that writes block (or poll(..)
+    // for POLLOUT) until the netdevice drained frames, which paces transmissions to the drain rate of the bus. The
+    // measured rate is available with SocketBus::getTxCapacity().
+    bool adaptiveTxPacing_;
+
+    //! monitor the interface with rtnetlink in the sanity check (see SocketBus::getLinkMonitor()). The socket is opened
+    // again if the interface is removed and added again, e.g. when a USB adapter is reconnected. The bus is also initialized
+    // if the interface does not exist yet, its socket is opened once the interface is added.
+    bool monitorLink_;
+
+    //! with monitorLink_, period [ms] of the link check, which runs on its own thread in asynchronous mode and in
+    // sanityCheck() otherwise. The receive thread waits at most this long for a frame (SO_RCVTIMEO), so it leaves the
+    // socket of a removed interface.
+    unsigned int linkCheckInterval_;
+
+    //! with monitorLink_, restart the controller this long [ms] after it went bus off. 0 = no automatic restart, e.g.
+    // if the restart-ms of the interface are set. Restarts failing within maxBusOffRestartDelay_ double the delay up to
+    // maxBusOffRestartDelay_. Restarting requires CAP_NET_ADMIN.
+    unsigned int busOffRestartDelay_;
+    unsigned int maxBusOffRestartDelay_;
 };
 
 } /* namespace tcan_can */
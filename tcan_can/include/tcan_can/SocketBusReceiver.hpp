@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "tcan/RcuPointer.hpp"
+#include "tcan_can/SocketBus.hpp"
+#include "tcan_can/SocketBusOptions.hpp"
+
+namespace tcan_can {
+
+/*!
+ * Receives the frames of several SocketBuses with a single CAN_RAW socket bound to all interfaces (ifindex 0), instead of
+ * a socket and receive thread per bus. Received frames are passed to the bus of the interface they arrived on
+ * (sockaddr_can::can_ifindex), frames of interfaces without bus are dropped. The buses still transmit on their own
+ * sockets and threads.
+ *
+ * Usage: set SocketBusOptions::sharedReceive_ for the buses, initialize them, add them with addBus(..), call
+ * initialize() and then startThread() (asynchronous mode) or readData() (synchronous modes) of the receiver.
+ * The options of the receiver select the mode, the receive thread priority and timeout, CAN FD frames and the error mask.
+ * The kernel receives all frames of all interfaces on the socket, CAN filters are not applied. Frames sent by other
+ * local sockets are received. The transmit sockets of the buses disable CAN_RAW_LOOPBACK, so the buses do not receive
+ * their own frames, like a socket of a single bus.
+ */
+class SocketBusReceiver {
+ public:
+    SocketBusReceiver() = delete;
+
+    explicit SocketBusReceiver(std::unique_ptr<SocketBusOptions>&& options);
+
+    ~SocketBusReceiver();
+
+    /*!
+     * Add a bus to receive frames for. Can be called while receiving.
+     * @param bus   initialized bus with SocketBusOptions::sharedReceive_ set. Must outlive the receiver.
+     * @return false if the bus is not initialized, does not share reception or another bus with the same interface was added
+     */
+    bool addBus(SocketBus* bus);
+
+    /*!
+     * Open the socket
+     * @return true if successful
+     */
+    bool initialize();
+
+    //! Start the receive thread if the receiver is asynchronous
+    void startThread();
+
+    //! Stop the receive thread and wait for it to terminate
+    void stopThread();
+
+    /*!
+     * Read a frame from the socket and pass it to its bus. Blocking in asynchronous mode, non-blocking otherwise.
+     * @return true if a frame was read
+     */
+    bool readData();
+
+    //! @return socket to poll for received frames
+    inline int getPollableFileDescriptor() const { return socket_; }
+
+    //! @return number of frames received on interfaces without bus
+    inline uint64_t getNumUnroutedFrames() const { return numUnroutedFrames_.load(std::memory_order_relaxed); }
+
+ protected:
+    //! buses, routed by their current interface index, which changes if a bus reopens its socket
+    using BusContainer = std::vector<SocketBus*>;
+
+    //! @return bus of the interface, nullptr if there is none
+    static SocketBus* findBus(const BusContainer& buses, const int interfaceIndex);
+
+    /*!
+     * Pass a received frame to the bus of its interface
+     * @param msg               received frame, in the layout of a canfd_frame
+     * @param numBytes          number of bytes received
+     * @param interfaceIndex    interface the frame was received on
+     */
+    void routeFrame(CanMsg& msg, const std::size_t numBytes, const int interfaceIndex);
+
+    void receiveWorker();
+
+ protected:
+    const std::unique_ptr<SocketBusOptions> options_;
+
+    int socket_;
+    int recvFlag_;
+
+    tcan::RcuPointer<BusContainer> buses_;
+
+    std::thread receiveThread_;
+    std::atomic<bool> running_;
+
+    std::atomic<uint64_t> numUnroutedFrames_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tcan_can/CanBus.hpp"
+#include "tcan_can/CanMsg.hpp"
+#include "tcan_can/SyncProducerOptions.hpp"
+
+namespace tcan_can {
+
+//! Timing of the SYNCs sent by a SyncProducer. Times in microseconds.
+struct SyncProducerStatistics {
+    //! number of communication cycles with a SYNC
+    uint64_t numSyncs_ = 0;
+    //! number of cycles without SYNC, because the producer was woken up after the next cycle had started
+    uint64_t numMissedCycles_ = 0;
+    //! number of RPDO bursts which were not sent because the synchronous window was over
+    uint64_t numWindowOverruns_ = 0;
+
+    //! delay from the scheduled start of the cycle to the first SYNC
+    double minLatency_ = 0.0;
+    double maxLatency_ = 0.0;
+    double meanLatency_ = 0.0;
+    //! standard deviation of the latency
+    double jitter_ = 0.0;
+
+    //! maximum time from the first to the last SYNC of a cycle
+    double maxSpread_ = 0.0;
+};
+
+/*!
+ * Produces the CANopen SYNC on several buses at a fixed communication cycle period. The producer thread is woken up by
+ * a timerfd armed at absolute times, so the cycles do not drift with the scheduling of the thread, and sends the SYNCs
+ * of all buses back to back with CanBus::sendMessageDirectly(..), bypassing the output queues.
+ *
+ * RPDOs added with addRpdo(..) are sent in a burst at a fixed offset after each SYNC, as long as the synchronous window
+ * is not over. Their data can be updated with setRpdo(..) from any thread, e.g. by the control loop.
+ *
+ * Usage: add the buses with addBus(..) and the RPDOs with addRpdo(..), call initialize() and then startThread(), or
+ * poll getPollableFileDescriptor() and call produceSync().
+ */
+class SyncProducer {
+ public:
+    using Clock = std::chrono::steady_clock;
+
+    SyncProducer() = delete;
+
+    explicit SyncProducer(std::unique_ptr<SyncProducerOptions>&& options);
+
+    ~SyncProducer();
+
+    /*!
+     * Add a bus to send the SYNC on. Must not be called after initialize().
+     * @param bus   bus, must outlive the producer
+     * @return false if the producer is already initialized
+     */
+    bool addBus(CanBus* bus);
+
+    /*!
+     * Add an RPDO which is sent after every SYNC. Must not be called after initialize().
+     * @param bus   bus to send the RPDO on, must outlive the producer
+     * @param msg   initial RPDO
+     * @param index index of the RPDO for setRpdo(..) (output parameter)
+     * @return false if the producer is already initialized
+     */
+    bool addRpdo(CanBus* bus, const CanMsg& msg, unsigned int& index);
+
+    /*!
+     * Replace an RPDO, which is sent from the next burst on. Can be called from any thread.
+     * @param index index returned by addRpdo(..)
+     * @param msg   RPDO
+     * @return false if there is no RPDO with this index
+     */
+    bool setRpdo(const unsigned int index, const CanMsg& msg);
+
+    /*!
+     * Create the timer and start it. The first cycle starts one period from now.
+     * @return true if successful, false if the producer is already initialized
+     */
+    bool initialize();
+
+    //! Start the producer thread
+    void startThread();
+
+    //! Stop the producer thread and wait for it to terminate, which takes up to one cycle period
+    void stopThread();
+
+    /*!
+     * Wait for the start of the next cycle and send the SYNCs, followed by the RPDO burst
+     * @return true if the SYNCs were sent
+     */
+    bool produceSync();
+
+    //! @return timer to poll for the start of a cycle
+    inline int getPollableFileDescriptor() const { return timerFd_; }
+
+    //! @return true if the synchronous window of the current cycle is not over
+    bool isInSyncWindow() const;
+
+    //! @return time of the last SYNC
+    inline Clock::time_point getLastSyncTime() const { return Clock::time_point(Clock::duration(lastSyncTime_.load(std::memory_order_acquire))); }
+
+    //! @return counter of the last SYNC, 0 if the SYNC has no counter
+    inline uint8_t getCounter() const { return counter_.load(std::memory_order_relaxed); }
+
+    //! @return timing of the SYNCs since initialize() or the last call of resetStatistics()
+    SyncProducerStatistics getStatistics() const;
+
+    void resetStatistics();
+
+ protected:
+    /*!
+     * Sends the RPDOs at the offset after the scheduled start of the cycle
+     * @return false if the synchronous window was over
+     */
+    bool sendRpdos(const Clock::time_point cycleStart);
+
+    //! Adds the timing of a cycle to the statistics
+    void updateStatistics(const uint64_t numExpirations, const Clock::duration latency, const Clock::duration spread,
+                          const bool isWindowOverrun);
+
+    void producerWorker();
+
+ protected:
+    const std::unique_ptr<SyncProducerOptions> options_;
+
+    int timerFd_;
+
+    std::vector<CanBus*> buses_;
+
+    //! RPDOs and their bus, the messages are protected by rpdoMutex_
+    std::vector<std::pair<CanBus*, CanMsg>> rpdos_;
+    std::mutex rpdoMutex_;
+
+    //! scheduled start of the next cycle, only accessed by produceSync()
+    Clock::time_point nextCycleStart_;
+    std::atomic<Clock::rep> lastSyncTime_;
+    std::atomic<uint8_t> counter_;
+
+    // statistics, sums of the latencies in microseconds
+    mutable std::mutex statisticsMutex_;
+    SyncProducerStatistics statistics_;
+    double latencySum_;
+    double latencySquareSum_;
+
+    std::thread producerThread_;
+    std::atomic<bool> running_;
+};
+
+} /* namespace tcan_can */
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace tcan_can {
+
+struct SyncProducerOptions {
+    SyncProducerOptions():
+        SyncProducerOptions(std::string())
+    {
+    }
+
+    SyncProducerOptions(const std::string& name):
+        name_(name),
+        cyclePeriod_(1000),
+        syncWindowLength_(0),
+        syncCounterOverflow_(0),
+        rpdoOffset_(0),
+        priorityThread_(99)
+    {
+    }
+
+    virtual ~SyncProducerOptions() = default;
+
+    //! name of the producer, used for logging
+    std::string name_;
+
+    //! communication cycle period (object 0x1006) [us]
+    unsigned int cyclePeriod_;
+
+    //! synchronous window length (object 0x1007) [us], time after the SYNC in which the synchronous RPDOs are sent.
+    // 0 = the window lasts the whole cycle
+    unsigned int syncWindowLength_;
+
+    //! synchronous counter overflow value (object 0x1019). 0 = SYNC without counter, 2..240 = SYNC carries a counter
+    // running from 1 to this value
+    uint8_t syncCounterOverflow_;
+
+    //! time from the SYNC to the burst of RPDOs added with SyncProducer::addRpdo(..) [us]
+    unsigned int rpdoOffset_;
+
+    //! priority of the producer thread (SCHED_FIFO). 0 = keep the default scheduling policy
+    int priorityThread_;
+};
+
+} /* namespace tcan_can */
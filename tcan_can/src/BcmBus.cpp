@@ -0,0 +1,359 @@
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/bcm.h>
+#include <net/if.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "tcan_can/BcmBus.hpp"
+
+#include "message_logger/message_logger.hpp"
+#include <algorithm>
+
+namespace tcan_can {
+
+static_assert(offsetof(bcm_msg_head, frames) == sizeof(bcm_msg_head), "the frames of a BCM message shall follow its header");
+
+namespace {
+
+//! Buffer of a BCM message with at most one frame. CanMsg has the layout of a canfd_frame.
+struct BcmBuffer {
+    alignas(8) uint8_t bytes_[sizeof(bcm_msg_head) + sizeof(CanMsg)];
+
+    inline bcm_msg_head* getHead() { return reinterpret_cast<bcm_msg_head*>(bytes_); }
+    inline CanMsg* getFrame() { return reinterpret_cast<CanMsg*>(bytes_ + sizeof(bcm_msg_head)); }
+};
+
+inline bcm_timeval toBcmTimeval(const std::chrono::microseconds& period) {
+    bcm_timeval tv;
+    tv.tv_sec = static_cast<long>(period.count() / 1000000);
+    tv.tv_usec = static_cast<long>(period.count() % 1000000);
+    return tv;
+}
+
+} /* namespace */
+
+BcmBus::BcmBus(const std::string& interface):
+    BcmBus(std::unique_ptr<SocketBusOptions>(new SocketBusOptions(interface)))
+{
+}
+
+BcmBus::BcmBus(std::unique_ptr<SocketBusOptions>&& options):
+    CanBus(std::move(options)),
+    socket_(-1),
+    recvFlag_(0),
+    sendFlag_(0),
+    txJobsMutex_(),
+    txJobs_(),
+    rxJobsMutex_(),
+    rxJobs_(),
+    contentFilters_()
+{
+}
+
+BcmBus::~BcmBus()
+{
+    stopThreads();
+    // closing the socket deletes all jobs
+    if(socket_ >= 0) {
+        close(socket_);
+    }
+}
+
+bool BcmBus::initializeInterface()
+{
+    const SocketBusOptions* options = static_cast<const SocketBusOptions*>(options_.get());
+    const char* interface = options->name_.c_str();
+
+    socket_ = socket(PF_CAN, SOCK_DGRAM, CAN_BCM);
+    if(socket_ < 0) {
+        MELO_FATAL("Opening CAN broadcast manager channel %s failed: %d", interface, socket_);
+        return false;
+    }
+
+    struct ifreq ifr;
+    strcpy(ifr.ifr_name, interface);
+    if(ioctl(socket_, SIOCGIFINDEX, &ifr) != 0) {
+        MELO_FATAL("Unknown CAN interface %s: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    if(options->sndBufLength_ != 0) {
+        if(setsockopt(socket_, SOL_SOCKET, SO_SNDBUF, &(options->sndBufLength_), sizeof(options->sndBufLength_)) != 0) {
+            MELO_WARN("Failed to set sndBuf length: (%d)\n  %s", errno, strerror(errno));
+        }
+    }
+
+    if (options_->readTimeout_.tv_sec != 0 || options_->readTimeout_.tv_usec != 0) {
+        if(setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &options_->readTimeout_, sizeof(options->readTimeout_)) != 0) {
+            MELO_WARN("Failed to set read timeout: (%d)\n  %s", errno, strerror(errno));
+        }
+    }
+
+    if (options_->writeTimeout_.tv_sec != 0 || options_->writeTimeout_.tv_usec != 0) {
+        if(setsockopt(socket_, SOL_SOCKET, SO_SNDTIMEO, &options_->writeTimeout_, sizeof(options->writeTimeout_)) != 0) {
+            MELO_WARN("Failed to set write timeout: (%d)\n  %s", errno, strerror(errno));
+        }
+    }
+
+    if(!isAsynchronous()) {
+        recvFlag_ = MSG_DONTWAIT;
+        if(!options_->synchronousBlockingWrite_) {
+            sendFlag_ = MSG_DONTWAIT;
+        }
+    }
+
+    // broadcast manager sockets are connected instead of bound
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(struct sockaddr_can));
+    addr.can_family  = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if(connect(socket_, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        MELO_FATAL("Error in socket %s connect: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    // set up the receive jobs of the messages subscribed so far
+    onSubscriptionsChanged();
+
+    MELO_INFO("Opened broadcast manager socket %s.", interface);
+
+    return true;
+}
+
+bool BcmBus::startCyclicMessage(const CanMsg& msg, const std::chrono::microseconds& period) {
+    if(period.count() <= 0) {
+        MELO_ERROR("Cannot send CAN message %x cyclically on bus %s with period %lld us", msg.getCobId(), options_->name_.c_str(), static_cast<long long>(period.count()));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(txJobsMutex_);
+    // count 0: send with interval ival2 until deleted
+    if(!writeCommand(TX_SETUP, SETTIMER | STARTTIMER, period, msg.getCobId(), &msg)) {
+        return false;
+    }
+    if(std::find(txJobs_.begin(), txJobs_.end(), msg.getCobId()) == txJobs_.end()) {
+        txJobs_.push_back(msg.getCobId());
+    }
+    return true;
+}
+
+bool BcmBus::updateCyclicMessage(const CanMsg& msg, const bool sendNow) {
+    std::lock_guard<std::mutex> lock(txJobsMutex_);
+    if(std::find(txJobs_.begin(), txJobs_.end(), msg.getCobId()) == txJobs_.end()) {
+        MELO_ERROR("Cannot update CAN message %x on bus %s: the message is not sent cyclically", msg.getCobId(), options_->name_.c_str());
+        return false;
+    }
+    // without SETTIMER, the kernel only replaces the frame of the job
+    return writeCommand(TX_SETUP, sendNow ? TX_ANNOUNCE : 0, std::chrono::microseconds(0), msg.getCobId(), &msg);
+}
+
+bool BcmBus::stopCyclicMessage(const uint32_t cobId) {
+    std::lock_guard<std::mutex> lock(txJobsMutex_);
+    const auto it = std::find(txJobs_.begin(), txJobs_.end(), cobId);
+    if(it == txJobs_.end()) {
+        return false;
+    }
+    txJobs_.erase(it);
+    return writeCommand(TX_DELETE, 0, std::chrono::microseconds(0), cobId, nullptr);
+}
+
+bool BcmBus::setContentFilter(const uint32_t cobId, const uint8_t* mask) {
+    PayloadMask payloadMask;
+    if(mask == nullptr) {
+        payloadMask.fill(0xff);
+    }else{
+        std::copy(mask, mask + payloadMask.size(), payloadMask.begin());
+    }
+
+    std::lock_guard<std::mutex> lock(rxJobsMutex_);
+    contentFilters_[cobId] = payloadMask;
+    if(std::find(rxJobs_.begin(), rxJobs_.end(), cobId) == rxJobs_.end()) {
+        // applied when the COB id is subscribed
+        return true;
+    }
+    // the kernel does not change the number of frames of an existing job, replace it
+    return setupReceiveJob(cobId, true);
+}
+
+bool BcmBus::removeContentFilter(const uint32_t cobId) {
+    std::lock_guard<std::mutex> lock(rxJobsMutex_);
+    if(contentFilters_.erase(cobId) == 0) {
+        return false;
+    }
+    if(std::find(rxJobs_.begin(), rxJobs_.end(), cobId) == rxJobs_.end()) {
+        return true;
+    }
+    return setupReceiveJob(cobId, true);
+}
+
+void BcmBus::onSubscriptionsChanged() {
+    if(socket_ < 0) {
+        // receive jobs are set up in initializeInterface()
+        return;
+    }
+
+    std::vector<uint32_t> cobIds;
+    bool hasMaskedMatchers = false;
+    for(const CanFrameIdentifier& matcher : dispatchTable_.read()->getMatchers()) {
+        if(matcher.mask == 0xffffffffu) {
+            cobIds.push_back(matcher.identifier);
+        }else{
+            hasMaskedMatchers = true;
+        }
+    }
+    std::sort(cobIds.begin(), cobIds.end());
+    cobIds.erase(std::unique(cobIds.begin(), cobIds.end()), cobIds.end());
+
+    if(hasMaskedMatchers) {
+        MELO_WARN("Bus %s does not receive masked subscriptions, the broadcast manager only filters exact COB ids.", options_->name_.c_str());
+    }
+
+    std::lock_guard<std::mutex> lock(rxJobsMutex_);
+    for(const uint32_t cobId : rxJobs_) {
+        if(!std::binary_search(cobIds.begin(), cobIds.end(), cobId)) {
+            writeCommand(RX_DELETE, 0, std::chrono::microseconds(0), cobId, nullptr);
+        }
+    }
+    std::vector<uint32_t> rxJobs;
+    rxJobs.reserve(cobIds.size());
+    for(const uint32_t cobId : cobIds) {
+        if(std::find(rxJobs_.begin(), rxJobs_.end(), cobId) != rxJobs_.end() || setupReceiveJob(cobId, false)) {
+            rxJobs.push_back(cobId);
+        }
+    }
+    rxJobs_.swap(rxJobs);
+}
+
+bool BcmBus::setupReceiveJob(const uint32_t cobId, const bool replace) {
+    if(replace) {
+        writeCommand(RX_DELETE, 0, std::chrono::microseconds(0), cobId, nullptr);
+    }
+
+    const auto filter = contentFilters_.find(cobId);
+    if(filter == contentFilters_.end()) {
+        // deliver every frame of the COB id
+        return writeCommand(RX_SETUP, RX_FILTER_ID, std::chrono::microseconds(0), cobId, nullptr);
+    }
+
+    // deliver frames whose masked payload or length changed
+    const CanMsg mask(cobId, static_cast<uint8_t>(filter->second.size()), filter->second.data());
+    return writeCommand(RX_SETUP, RX_CHECK_DLC, std::chrono::microseconds(0), cobId, &mask);
+}
+
+bool BcmBus::writeCommand(const uint32_t opcode, const uint32_t flags, const std::chrono::microseconds& period, const uint32_t cobId, const CanMsg* msg) {
+    const bool isFdEnabled = static_cast<const SocketBusOptions*>(options_.get())->canFdFrames_;
+
+    BcmBuffer buffer;
+    bcm_msg_head* head = buffer.getHead();
+    memset(head, 0, sizeof(bcm_msg_head));
+    head->opcode = opcode;
+    head->flags = flags;
+    head->ival2 = toBcmTimeval(period);
+    head->can_id = cobId;
+
+    // receive jobs receive either classic or CAN FD frames
+    bool isFd = (opcode == RX_SETUP || opcode == RX_DELETE) && isFdEnabled;
+    std::size_t frameSize = 0;
+    if(msg != nullptr) {
+        if(msg->getLength() > (msg->isFd() ? CANFD_MAX_DLEN : CAN_MAX_DLEN) || (msg->isFd() && !isFdEnabled)) {
+            MELO_ERROR("Cannot send CAN message %x with length %d on bus %s: %s", msg->getCobId(), msg->getLength(), options_->name_.c_str(),
+                       msg->isFd() ? "CAN FD frames are not enabled" : "classic frames carry at most 8 bytes");
+            return false;
+        }
+
+        CanMsg* frame = buffer.getFrame();
+        memcpy(static_cast<void*>(frame), msg, sizeof(CanMsg));
+        if(!msg->isFd() && !isFd) {
+            frame->setFlags(0);
+        }else{
+            isFd = true;
+            const uint8_t length = CanMsg::getValidFdLength(frame->getLength());
+            std::fill(&frame->getData()[frame->getLength()], &frame->getData()[length], 0);
+            frame->setLength(length);
+            frame->setFlags(frame->getFlags() & CANFD_BRS);
+        }
+        head->nframes = 1;
+        frameSize = isFd ? CANFD_MTU : CAN_MTU;
+    }
+    if(isFd) {
+        head->flags |= CAN_FD_FRAME;
+    }
+
+    const ssize_t size = static_cast<ssize_t>(sizeof(bcm_msg_head) + frameSize);
+    const ssize_t ret = send(socket_, buffer.bytes_, size, sendFlag_);
+    if(ret != size) {
+        if(errno != EAGAIN && errno != EWOULDBLOCK) {
+            MELO_ERROR("Error at writing broadcast manager command %u for CAN message %x on bus %s (return value=%zd): (%d)\n  %s",
+                       opcode, cobId, options_->name_.c_str(), ret, errno, strerror(errno));
+            hasBusError_ = true;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool BcmBus::readData() {
+    BcmBuffer buffer;
+    const ssize_t bytesRead = recv(socket_, buffer.bytes_, sizeof(buffer.bytes_), recvFlag_);
+    if(bytesRead <= 0) {
+        if(errno != EAGAIN && errno != EWOULDBLOCK) {
+            MELO_ERROR("Failed to read data from bus %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
+            hasBusError_ = true;
+        }else{
+            hasBusError_ = false;
+        }
+        return false;
+    }
+    hasBusError_ = false;
+
+    const bcm_msg_head* head = buffer.getHead();
+    const std::size_t frameSize = static_cast<std::size_t>(bytesRead) - std::min(static_cast<std::size_t>(bytesRead), sizeof(bcm_msg_head));
+    if(head->opcode != RX_CHANGED || head->nframes != 1 || (frameSize != CAN_MTU && frameSize != CANFD_MTU)) {
+        // RX_TIMEOUT and TX_EXPIRED are not requested
+        MELO_WARN_THROTTLE(options_->errorThrottleTime_, "Received unexpected broadcast manager message %u on bus %s", head->opcode, options_->name_.c_str());
+        return true;
+    }
+
+    CanMsg* msg = buffer.getFrame();
+    if(frameSize == CANFD_MTU) {
+        msg->setFlags(static_cast<uint8_t>(CanMsg::Fd | (msg->getFlags() & (CANFD_BRS | CANFD_ESI))));
+    }else{
+        // the flags are at the position of the padding byte of can_frame
+        msg->setFlags(0);
+    }
+    handleMessage(*msg);
+    return true;
+}
+
+bool BcmBus::writeData(std::unique_lock<std::mutex>* lock) {
+    const CanMsg cmsg = outgoingMsgs_.front();
+    if(cmsg.getLength() > (cmsg.isFd() ? CANFD_MAX_DLEN : CAN_MAX_DLEN) ||
+       (cmsg.isFd() && !static_cast<const SocketBusOptions*>(options_.get())->canFdFrames_)) {
+        MELO_ERROR("Dropping CAN message %x with length %d on bus %s: %s", cmsg.getCobId(), cmsg.getLength(), options_->name_.c_str(),
+                   cmsg.isFd() ? "CAN FD frames are not enabled" : "classic frames carry at most 8 bytes");
+        outgoingMsgs_.pop_front();
+        return false;
+    }
+
+    if(lock != nullptr) {
+        lock->unlock();
+    }
+
+    const bool isSent = writeCommand(TX_SEND, 0, std::chrono::microseconds(0), cmsg.getCobId(), &cmsg);
+
+    if(lock != nullptr) {
+        lock->lock();
+    }
+
+    if(!isSent) {
+        return false;
+    }
+
+    hasBusError_ = false;
+    outgoingMsgs_.pop_front();
+    return true;
+}
+
+} /* namespace tcan_can */
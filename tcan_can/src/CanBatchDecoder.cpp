@@ -0,0 +1,231 @@
+#include "tcan_can/CanBatchDecoder.hpp"
+
+#include <algorithm>
+#include <cstring> // memcpy
+#include <endian.h>
+#include <limits>
+
+namespace tcan_can {
+
+constexpr std::size_t CanBatchDecoder::ChunkSize;
+
+namespace {
+
+using SignalDecoder = CanBatchDecoder::SignalDecoder;
+
+//! Copy the 8 byte words holding the signal from the frames and convert them to host byte order
+inline void gatherWords(const SignalDecoder& signal, const CanMsg* frames, const std::size_t numFrames, uint64_t* words) {
+    const uint8_t byte = signal.byte_;
+    for(std::size_t i = 0; i < numFrames; ++i) {
+        std::memcpy(&words[i], frames[i].getData() + byte, sizeof(uint64_t));
+    }
+    if(signal.isBigEndian_) {
+        for(std::size_t i = 0; i < numFrames; ++i) {
+            words[i] = be64toh(words[i]);
+        }
+    }else{
+        for(std::size_t i = 0; i < numFrames; ++i) {
+            words[i] = le64toh(words[i]);
+        }
+    }
+}
+
+//! Shift, mask and sign extend the signal in the words
+inline void extractRaw(const SignalDecoder& signal, const uint64_t* __restrict words, const std::size_t numFrames, int64_t* __restrict raw) {
+    const unsigned int shift = signal.shift_;
+    const uint64_t mask = signal.mask_;
+    const uint64_t signBit = signal.signBit_;
+    for(std::size_t i = 0; i < numFrames; ++i) {
+        raw[i] = static_cast<int64_t>((((words[i] >> shift) & mask) ^ signBit) - signBit);
+    }
+}
+
+//! Convert raw values to physical values
+inline void scale(const SignalDecoder& signal, const int64_t* __restrict raw, const std::size_t numFrames, double* __restrict values) {
+    const double factor = signal.factor_;
+    const double offset = signal.offset_;
+    const bool isSigned = signal.signBit_ != 0;
+    if(signal.mask_ <= (isSigned ? 0xffffffffu : 0x7fffffffu)) {
+        // converting 32 bit integers to double is supported by all SIMD instruction sets, unlike 64 bit integers
+        for(std::size_t i = 0; i < numFrames; ++i) {
+            values[i] = static_cast<double>(static_cast<int32_t>(raw[i])) * factor + offset;
+        }
+    }else if(isSigned || (signal.mask_ >> 63) == 0) {
+        for(std::size_t i = 0; i < numFrames; ++i) {
+            values[i] = static_cast<double>(raw[i]) * factor + offset;
+        }
+    }else{
+        for(std::size_t i = 0; i < numFrames; ++i) {
+            values[i] = static_cast<double>(static_cast<uint64_t>(raw[i])) * factor + offset;
+        }
+    }
+}
+
+template <typename T>
+inline void maskAbsent(const uint8_t* __restrict isPresent, const std::size_t numFrames, const T absentValue, T* __restrict values) {
+    for(std::size_t i = 0; i < numFrames; ++i) {
+        values[i] = isPresent[i] ? values[i] : absentValue;
+    }
+}
+
+//! Determine the frames which are of the message and long enough. @return number of valid frames
+inline std::size_t checkFrames(const CanDbcDecodeTable::MessageDecoder& message, const CanMsg* frames, const std::size_t numFrames, uint8_t* isValid) {
+    std::size_t numValid = 0;
+    for(std::size_t i = 0; i < numFrames; ++i) {
+        isValid[i] = static_cast<uint8_t>(frames[i].getCobId() == message.cobId_ && frames[i].getLength() >= message.length_);
+        numValid += isValid[i];
+    }
+    return numValid;
+}
+
+//! Determine the frames in which the signal is present: valid frames, in which the multiplexor selects multiplexed signals
+inline void checkPresence(const SignalDecoder& signal, const uint8_t* isValid, const int64_t* multiplexor, const std::size_t numFrames, uint8_t* isPresent) {
+    if(signal.multiplex_ != CanDbcSignal::Multiplex::Multiplexed) {
+        std::copy(isValid, isValid + numFrames, isPresent);
+        return;
+    }
+    const int64_t multiplexValue = signal.multiplexValue_;
+    for(std::size_t i = 0; i < numFrames; ++i) {
+        isPresent[i] = static_cast<uint8_t>(isValid[i] & (multiplexor[i] == multiplexValue));
+    }
+}
+
+//! Decode a signal from payload words into physical values
+inline void decodeWords(const SignalDecoder& signal, const uint64_t* words, const std::size_t numFrames, double* values) {
+    int64_t raw[CanBatchDecoder::ChunkSize];
+    extractRaw(signal, words, numFrames, raw);
+    scale(signal, raw, numFrames, values);
+}
+
+//! Decode a signal from payload words into raw values
+inline void decodeWords(const SignalDecoder& signal, const uint64_t* words, const std::size_t numFrames, int64_t* raw) {
+    extractRaw(signal, words, numFrames, raw);
+}
+
+inline void decodeFrames(const SignalDecoder& signal, const CanMsg* frames, const std::size_t numFrames, double* values) {
+    CanBatchDecoder::decodeColumn(signal, frames, numFrames, values);
+}
+
+inline void decodeFrames(const SignalDecoder& signal, const CanMsg* frames, const std::size_t numFrames, int64_t* raw) {
+    CanBatchDecoder::decodeRawColumn(signal, frames, numFrames, raw);
+}
+
+/*!
+ * @return decoder of the signal extracting it from the first 8 bytes of the payload, converted to host byte order. Only
+ *         valid for signals within the first 8 bytes.
+ */
+inline SignalDecoder relativeToFirstWord(const SignalDecoder& signal) {
+    SignalDecoder decoder = signal;
+    decoder.shift_ = static_cast<uint8_t>(signal.isBigEndian_ ? signal.shift_ - 8 * signal.byte_ : signal.shift_ + 8 * signal.byte_);
+    decoder.byte_ = 0;
+    return decoder;
+}
+
+/*!
+ * Decode all signals of frames of the message of the first frame into columns.
+ * The payload of classic frames is gathered once per chunk, in both byte orders, and all signals are extracted from
+ * these contiguous words. Signals of longer frames gather their own words.
+ * @return number of valid frames
+ */
+template <typename T>
+std::size_t decodeMessage(const CanDbcDecodeTable& table, const CanMsg* frames, const std::size_t numFrames, T* const* columns, const T absentValue) {
+    const CanDbcDecodeTable::MessageDecoder* message = (numFrames == 0) ? nullptr : table.findMessage(frames[0].getCobId());
+    if(message == nullptr) {
+        return 0;
+    }
+
+    const SignalDecoder* signals = table.getSignals().data() + message->firstSignal_;
+    const bool isMultiplexed = message->numSignals_ != 0 && signals[0].multiplex_ == CanDbcSignal::Multiplex::Multiplexor;
+    const bool isClassic = message->length_ <= CanMsg::ClassicCapacity;
+    SignalDecoder firstWord = SignalDecoder();
+    firstWord.isBigEndian_ = false;
+    firstWord.byte_ = 0;
+
+    std::size_t numValid = 0;
+    uint8_t isValid[CanBatchDecoder::ChunkSize];
+    uint8_t isPresent[CanBatchDecoder::ChunkSize];
+    int64_t multiplexor[CanBatchDecoder::ChunkSize] = {};
+    uint64_t littleEndianWords[CanBatchDecoder::ChunkSize];
+    uint64_t bigEndianWords[CanBatchDecoder::ChunkSize];
+    for(std::size_t start = 0; start < numFrames; start += CanBatchDecoder::ChunkSize) {
+        const std::size_t count = std::min(CanBatchDecoder::ChunkSize, numFrames - start);
+        const std::size_t numValidInChunk = checkFrames(*message, frames + start, count, isValid);
+        numValid += numValidInChunk;
+
+        if(isClassic) {
+            gatherWords(firstWord, frames + start, count, littleEndianWords);
+            for(std::size_t i = 0; i < count; ++i) {
+                bigEndianWords[i] = __builtin_bswap64(littleEndianWords[i]);
+            }
+        }
+
+        for(uint32_t s = 0; s < message->numSignals_; ++s) {
+            const bool isMultiplexor = (s == 0 && isMultiplexed);
+            T* column = columns[signals[s].index_];
+            if(column == nullptr && !isMultiplexor) {
+                continue;
+            }
+
+            if(isClassic) {
+                const SignalDecoder signal = relativeToFirstWord(signals[s]);
+                const uint64_t* words = signal.isBigEndian_ ? bigEndianWords : littleEndianWords;
+                if(isMultiplexor) {
+                    extractRaw(signal, words, count, multiplexor);
+                }
+                if(column != nullptr) {
+                    decodeWords(signal, words, count, column + start);
+                }
+            }else{
+                if(isMultiplexor) {
+                    CanBatchDecoder::decodeRawColumn(signals[s], frames + start, count, multiplexor);
+                }
+                if(column != nullptr) {
+                    decodeFrames(signals[s], frames + start, count, column + start);
+                }
+            }
+
+            if(column != nullptr && (numValidInChunk != count || signals[s].multiplex_ == CanDbcSignal::Multiplex::Multiplexed)) {
+                checkPresence(signals[s], isValid, multiplexor, count, isPresent);
+                maskAbsent(isPresent, count, absentValue, column + start);
+            }
+        }
+    }
+    return numValid;
+}
+
+} /* namespace */
+
+CanBatchDecoder::CanBatchDecoder(const std::shared_ptr<const CanDbcDecodeTable>& table):
+    table_(table)
+{
+}
+
+void CanBatchDecoder::decodeRawColumn(const SignalDecoder& signal, const CanMsg* frames, const std::size_t numFrames, int64_t* raw) {
+    uint64_t words[ChunkSize];
+    for(std::size_t start = 0; start < numFrames; start += ChunkSize) {
+        const std::size_t count = std::min(ChunkSize, numFrames - start);
+        gatherWords(signal, frames + start, count, words);
+        extractRaw(signal, words, count, raw + start);
+    }
+}
+
+void CanBatchDecoder::decodeColumn(const SignalDecoder& signal, const CanMsg* frames, const std::size_t numFrames, double* values) {
+    uint64_t words[ChunkSize];
+    int64_t raw[ChunkSize];
+    for(std::size_t start = 0; start < numFrames; start += ChunkSize) {
+        const std::size_t count = std::min(ChunkSize, numFrames - start);
+        gatherWords(signal, frames + start, count, words);
+        extractRaw(signal, words, count, raw);
+        scale(signal, raw, count, values + start);
+    }
+}
+
+std::size_t CanBatchDecoder::decode(const CanMsg* frames, const std::size_t numFrames, double* const* columns) const {
+    return decodeMessage(*table_, frames, numFrames, columns, std::numeric_limits<double>::quiet_NaN());
+}
+
+std::size_t CanBatchDecoder::decodeRaw(const CanMsg* frames, const std::size_t numFrames, int64_t* const* columns) const {
+    return decodeMessage(*table_, frames, numFrames, columns, int64_t(0));
+}
+
+} /* namespace tcan_can */
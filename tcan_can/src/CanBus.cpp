@@ -3,64 +3,166 @@
 
 namespace tcan_can {
 
+constexpr CanBus::SubscriptionHandle CanBus::InvalidSubscription;
+
 CanBus::CanBus(std::unique_ptr<CanBusOptions>&& options):
     tcan::Bus<CanMsg>( std::move(options) ),
     devices_(),
-    canFrameIdentifierToFunctionMap_(),
-    unmappedMessageCallbackFunction_(std::bind(&CanBus::defaultHandleUnmappedMessage, this, std::placeholders::_1))
+    devicesMutex_(),
+    deviceStateMonitor_(),
+    deviceStateFlagsMutex_(),
+    dispatchTable_(std::unique_ptr<CanDispatchTable>(new CanDispatchTable())),
+    callbackExecutor_(),
+    busErrorCounters_(),
+    lastBusErrorLog_(),
+    numErrorFramesAtLastLog_(0)
 {
+    setUnmappedMessageCallback(this, &CanBus::defaultHandleUnmappedMessage);
+    deviceStateMonitor_.addObserver(this, &CanBus::onDeviceStateChanged);
+
+    const CanBusOptions* canOptions = static_cast<const CanBusOptions*>(options_.get());
+    if(canOptions->numCallbackThreads_ > 0) {
+        callbackExecutor_.reset(new CanCallbackExecutor(canOptions->name_, canOptions->numCallbackThreads_, canOptions->priorityCallbackThreads_,
+                                                        canOptions->callbackQueueCapacity_, canOptions->callbackOverflowPolicy_));
+    }
 }
 
 CanBus::~CanBus()
 {
+    // stop the callback threads before the devices are destructed
+    stopThreads();
+    callbackExecutor_.reset();
+
     for(auto device : devices_) {
         delete device;
     }
 }
 
+CanBus::SubscriptionHandle CanBus::subscribe(const CanFrameIdentifier& matcher, const CanMessageHandler& handler,
+                                             const std::shared_ptr<void>& owner) {
+    // the table holds the owner, so it is released if the subscription fails
+    SubscriptionHandle handle = InvalidSubscription;
+    dispatchTable_.update([&](CanDispatchTable& table) { handle = table.subscribe(matcher, handler, owner); });
+    if(handle != InvalidSubscription) {
+        onSubscriptionsChanged();
+    }
+    return handle;
+}
+
+bool CanBus::unsubscribe(const SubscriptionHandle handle) {
+    bool isRemoved = false;
+    bool isStillSubscribed = false;
+    CanMessageHandler handler;
+    // the owner is released after the callback threads stopped calling the handler
+    std::shared_ptr<void> owner;
+    dispatchTable_.update([&](CanDispatchTable& table) {
+        isRemoved = table.unsubscribe(handle, &handler, &owner);
+        isStillSubscribed = isRemoved && table.isSubscribed(handler);
+    });
+    if(!isRemoved) {
+        return false;
+    }
+
+    // the receive thread does not post the handler anymore, drop the messages it posted before
+    if(callbackExecutor_ && !handler.runInline_ && !isStillSubscribed) {
+        callbackExecutor_->cancel(handler, std::move(owner));
+    }
+    onSubscriptionsChanged();
+    return true;
+}
+
 void CanBus::handleMessage(const CanMsg& msg) {
 
     errorMsgFlag_ = false;
 
-    // Check if CAN message is handled.
-    auto it = std::find_if(canFrameIdentifierToFunctionMap_.cbegin(), canFrameIdentifierToFunctionMap_.cend(), [&msg](auto p){
-        return !((msg.getCobId() ^ p.first.identifier) & p.first.mask);
+    // Pass the message to all handlers subscribed to it
+    const auto dispatchTable = dispatchTable_.read();
+    const bool isHandled = dispatchTable->forEachHandler(msg.getCobId(), [this, &msg](const CanMessageHandler& handler){
+        if(handler.device_) {
+            handler.device_->resetDeviceTimeoutCounter();
+        }
+        if(callbackExecutor_ && !handler.runInline_) {
+            callbackExecutor_->post(handler, msg);
+        }else{
+            CanCallbackExecutor::execute(handler, msg);
+        }
     });
 
-    if (it != canFrameIdentifierToFunctionMap_.end()) {
-        if(it->second.first) {
-            it->second.first->resetDeviceTimeoutCounter();
-            it->second.first->configureDeviceInternal(msg);
-        }
-        it->second.second(msg); // call function pointer
-    } else {
-        unmappedMessageCallbackFunction_(msg);
+    if(!isHandled) {
+        dispatchTable->getUnmappedCallback()(msg);
     }
 }
 
 bool CanBus::sanityCheck() {
+    // the device states are aggregated on state transitions. Checking the devices updates their timeouts.
     bool isMissingOrError = false;
-    bool allMissing = true;
-    bool allActive = true;
-    for(auto device : devices_) {
-        isMissingOrError |= !device->sanityCheck();
-        allMissing &= device->isMissing();
-        allActive &= device->isActive();
+    {
+        std::lock_guard<std::mutex> lock(devicesMutex_);
+        for(auto device : devices_) {
+            isMissingOrError |= !device->sanityCheck();
+        }
     }
+    updateDeviceStateFlags();
+
+    busErrorCounters_.updateRates(CanBusErrorCounters::Clock::now());
 
-    if(!isPassive() && allMissing && static_cast<const CanBusOptions*>(options_.get())->passivateIfNoDevices_) {
+    if(!isPassive() && allDevicesMissing_ && static_cast<const CanBusOptions*>(options_.get())->passivateIfNoDevices_) {
         passivate();
         MELO_WARN("All devices missing on bus %s. This bus is now PASSIVE!", options_->name_.c_str());
     }
 
-    isMissingDeviceOrHasError_ = isMissingOrError;
-    allDevicesActive_ = allActive;
-    allDevicesMissing_ = allMissing;
+    return !(isMissingOrError || isMissingDeviceOrHasError_ || hasBusError_);
+}
+
+void CanBus::handleBusError(const CanBusError& error) {
+    errorMsgFlagPersistent_ = true;
+    errorMsgFlag_ = true;
+
+    if(static_cast<const CanBusOptions*>(options_.get())->passivateOnBusError_) {
+        if(!isPassive_) {
+            MELO_WARN("Bus error on bus %s. This bus is now PASSIVE!", options_->name_.c_str());
+        }
+        passivate();
+    }
+
+    busErrorCounters_.count(error);
+
+    // error frames may flood the bus, format the description only if it is logged
+    const auto now = CanBusErrorCounters::Clock::now();
+    if(lastBusErrorLog_ != CanBusErrorCounters::Clock::time_point() &&
+       std::chrono::duration<double>(now - lastBusErrorLog_).count() < options_->errorThrottleTime_) {
+        return;
+    }
+    const uint64_t numErrorFrames = busErrorCounters_.getNumErrorFrames();
+    const uint64_t numSuppressed = numErrorFrames - numErrorFramesAtLastLog_ - 1;
+    lastBusErrorLog_ = now;
+    numErrorFramesAtLastLog_ = numErrorFrames;
+
+    char description[CanBusError::MaxFormattedLength];
+    error.format(description, sizeof(description));
+    if(numSuppressed == 0) {
+        MELO_ERROR("Received bus error frame on bus %s: %s", options_->name_.c_str(), description);
+    }else{
+        MELO_ERROR("Received bus error frame on bus %s: %s (%llu more since the last report)", options_->name_.c_str(), description,
+                   static_cast<unsigned long long>(numSuppressed));
+    }
+}
+
+void CanBus::onDeviceStateChanged(const CanDevice& /*device*/, const CanDevice::State /*previous*/, const CanDevice::State /*current*/) {
+    updateDeviceStateFlags();
+}
 
-    return !(isMissingOrError || hasBusError_);
+void CanBus::updateDeviceStateFlags() {
+    // concurrent transitions are serialized, so the flags set last are from the latest snapshot
+    std::lock_guard<std::mutex> lock(deviceStateFlagsMutex_);
+    const CanDevice::StateMonitor::Counters counters = deviceStateMonitor_.getCounters();
+    isMissingDeviceOrHasError_ = counters.isMissingDeviceOrHasError();
+    allDevicesActive_ = counters.allDevicesActive();
+    allDevicesMissing_ = counters.allDevicesMissing();
 }
 
 void CanBus::resetAllDevices() {
+    std::lock_guard<std::mutex> lock(devicesMutex_);
     for(auto device : devices_) {
         device->resetDevice();
     }
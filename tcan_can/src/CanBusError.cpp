@@ -0,0 +1,216 @@
+#include "tcan_can/CanBusError.hpp"
+
+#include <cstdio>
+
+namespace tcan_can {
+
+constexpr unsigned int CanBusError::NumClasses;
+constexpr std::size_t CanBusError::MaxFormattedLength;
+
+namespace {
+
+const char* const classNames[CanBusError::NumClasses] = {
+    "TX timeout (by netdevice driver)",
+    "lost arbitration",
+    "controller problems",
+    "protocol violations",
+    "transceiver status",
+    "received no ACK on transmission",
+    "bus off",
+    "bus error (may flood!)",
+    "controller restarted",
+    "error counters"
+};
+
+const char* const controllerFlagNames[8] = {
+    "rx buffer overflow",
+    "tx buffer overflow",
+    "reached warning level for RX errors",
+    "reached warning level for TX errors",
+    "reached error passive status RX",
+    "reached error passive status TX",
+    "recovered to error active state",
+    "unknown (0x80)"
+};
+
+const char* const protocolFlagNames[8] = {
+    "single bit error",
+    "frame format error",
+    "bit stuffing error",
+    "unable to send dominant bit",
+    "unable to send recessive bit",
+    "bus overload",
+    "active error announcement",
+    "error occurred on transmission"
+};
+
+const char* getProtocolLocationName(const uint8_t location) {
+    switch(location) {
+        case 0x03: return "start of frame";
+        case 0x02: return "ID bits 28 - 21 (SFF: 10 - 3)";
+        case 0x06: return "ID bits 20 - 18 (SFF: 2 - 0 )";
+        case 0x04: return "substitute RTR (SFF: RTR)";
+        case 0x05: return "identifier extension";
+        case 0x07: return "ID bits 17-13";
+        case 0x0F: return "ID bits 12-5";
+        case 0x0E: return "ID bits 4-0";
+        case 0x0C: return "RTR";
+        case 0x0D: return "reserved bit 1";
+        case 0x09: return "reserved bit 0";
+        case 0x0B: return "data length code";
+        case 0x0A: return "data section";
+        case 0x08: return "CRC sequence";
+        case 0x18: return "CRC delimiter";
+        case 0x19: return "ACK slot";
+        case 0x1B: return "ACK delimiter";
+        case 0x1A: return "end of frame";
+        case 0x12: return "intermission";
+        default: return "unspecified";
+    }
+}
+
+const char* getTransceiverName(const uint8_t status) {
+    switch(status) {
+        case 0x04: return "CANH no wire";
+        case 0x05: return "CANH short to BAT";
+        case 0x06: return "CANH short to VCC";
+        case 0x07: return "CANH short to GND";
+        case 0x40: return "CANL no wire";
+        case 0x50: return "CANL short to BAT";
+        case 0x60: return "CANL short to VCC";
+        case 0x70: return "CANL short to GND";
+        case 0x80: return "CANL short to CANH";
+        default: return "unspecified";
+    }
+}
+
+//! Appends to a buffer like snprintf, keeping track of the length
+class Appender {
+ public:
+    Appender(char* buffer, const std::size_t size):
+        buffer_(buffer),
+        size_(size),
+        length_(0)
+    {
+        if(size_ != 0) {
+            buffer_[0] = '\0';
+        }
+    }
+
+    template <typename... Args>
+    void append(const char* format, Args... args) {
+        const std::size_t offset = length_ < size_ ? length_ : size_;
+        const int length = std::snprintf(buffer_ + offset, size_ - offset, format, args...);
+        if(length > 0) {
+            length_ += static_cast<std::size_t>(length);
+        }
+    }
+
+    //! Append the names of the set bits of flags, separated by commas
+    void appendFlags(const uint8_t flags, const char* const* names) {
+        if(flags == 0) {
+            append("unspecified");
+            return;
+        }
+        const char* separator = "";
+        for(unsigned int i = 0; i < 8; ++i) {
+            if(flags & (1u << i)) {
+                append("%s%s", separator, names[i]);
+                separator = ", ";
+            }
+        }
+    }
+
+    inline std::size_t getLength() const { return length_; }
+
+ private:
+    char* buffer_;
+    std::size_t size_;
+    std::size_t length_;
+};
+
+} /* namespace */
+
+const char* CanBusError::getClassName(const unsigned int classIndex) {
+    return classIndex < NumClasses ? classNames[classIndex] : "unknown";
+}
+
+std::size_t CanBusError::format(char* buffer, const std::size_t size) const {
+    Appender out(buffer, size);
+    const char* separator = "";
+    for(unsigned int i = 0; i < NumClasses; ++i) {
+        if(classes_ & (1u << i)) {
+            out.append("%s%s", separator, classNames[i]);
+            separator = ", ";
+        }
+    }
+
+    if(hasClass(LostArbitration)) {
+        out.append(" / lost arbitration at bit %u", static_cast<unsigned int>(lostArbitrationBit_));
+    }
+    if(hasClass(Controller)) {
+        out.append(" / error status of CAN-controller: ");
+        out.appendFlags(controller_, controllerFlagNames);
+    }
+    if(hasClass(Protocol)) {
+        out.append(" / error in CAN protocol (type): ");
+        out.appendFlags(protocolType_, protocolFlagNames);
+        out.append(" / error in CAN protocol (location): %s", getProtocolLocationName(protocolLocation_));
+    }
+    if(hasClass(Transceiver)) {
+        out.append(" / error status of CAN-transceiver: %s", getTransceiverName(transceiver_));
+    }
+    if(hasClass(ErrorCounters)) {
+        out.append(" / error counters: TX %u, RX %u", static_cast<unsigned int>(txErrorCounter_), static_cast<unsigned int>(rxErrorCounter_));
+    }
+    if(controllerSpecific_ != 0) {
+        out.append(" / controller specific additional information: 0x%x", static_cast<unsigned int>(controllerSpecific_));
+    }
+    return out.getLength();
+}
+
+std::string CanBusError::toString() const {
+    char buffer[MaxFormattedLength];
+    const std::size_t length = format(buffer, sizeof(buffer));
+    return std::string(buffer, length < sizeof(buffer) ? length : sizeof(buffer) - 1);
+}
+
+CanBusErrorCounters::CanBusErrorCounters():
+    numErrorFrames_{0},
+    counts_{},
+    errorFrameRate_{0.0},
+    rates_{},
+    lastUpdate_(),
+    lastNumErrorFrames_(0),
+    lastCounts_{}
+{
+}
+
+void CanBusErrorCounters::updateRates(const Clock::time_point& now) {
+    if(lastUpdate_ == Clock::time_point()) {
+        // first call, start measuring
+        lastUpdate_ = now;
+        lastNumErrorFrames_ = getNumErrorFrames();
+        for(unsigned int i = 0; i < CanBusError::NumClasses; ++i) {
+            lastCounts_[i] = counts_[i].load(std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    const double elapsed = std::chrono::duration<double>(now - lastUpdate_).count();
+    if(elapsed <= 0.0) {
+        return;
+    }
+    lastUpdate_ = now;
+
+    const uint64_t numErrorFrames = getNumErrorFrames();
+    errorFrameRate_.store(static_cast<double>(numErrorFrames - lastNumErrorFrames_) / elapsed, std::memory_order_relaxed);
+    lastNumErrorFrames_ = numErrorFrames;
+    for(unsigned int i = 0; i < CanBusError::NumClasses; ++i) {
+        const uint64_t count = counts_[i].load(std::memory_order_relaxed);
+        rates_[i].store(static_cast<double>(count - lastCounts_[i]) / elapsed, std::memory_order_relaxed);
+        lastCounts_[i] = count;
+    }
+}
+
+} /* namespace tcan_can */
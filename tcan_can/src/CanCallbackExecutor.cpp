@@ -0,0 +1,125 @@
+#include "tcan_can/CanCallbackExecutor.hpp"
+
+#include "tcan/helper_functions.hpp"
+#include "message_logger/message_logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tcan_can {
+
+CanCallbackExecutor::CanCallbackExecutor(const std::string& name, const unsigned int numThreads, const int priority, const unsigned int queueCapacity,
+                                         const CanBusOptions::CallbackOverflowPolicy overflowPolicy):
+    name_(name),
+    running_{true},
+    mask_(tcan::roundUpToPowerOfTwo(std::max(queueCapacity, 1u)) - 1),
+    overflowPolicy_(overflowPolicy),
+    numDroppedJobs_{0},
+    workers_()
+{
+    const unsigned int num = std::max(numThreads, 1u);
+    for(unsigned int i = 0; i < num; ++i) {
+        workers_.emplace_back(new Worker());
+        workers_.back()->jobs_.resize(mask_ + 1);
+    }
+
+    for(auto& worker : workers_) {
+        worker->thread_ = std::thread(&CanCallbackExecutor::workerFunction, this, std::ref(*worker));
+        if(priority > 0 && !tcan::setThreadPriority(worker->thread_, priority)) {
+            MELO_WARN("Failed to set callback thread priority for bus %s:\n  %s", name_.c_str(), strerror(errno));
+        }
+    }
+}
+
+CanCallbackExecutor::~CanCallbackExecutor()
+{
+    running_ = false;
+    for(auto& worker : workers_) {
+        {
+            std::lock_guard<std::mutex> lock(worker->mutex_);
+            worker->condJobs_.notify_all();
+            worker->condEmpty_.notify_all();
+        }
+        if(worker->thread_.joinable()) {
+            worker->thread_.join();
+        }
+    }
+}
+
+void CanCallbackExecutor::post(const CanMessageHandler& handler, const CanMsg& msg) {
+    Worker& worker = getWorker(handler);
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex_);
+        if(worker.numJobs_ > mask_) {
+            numDroppedJobs_.fetch_add(1, std::memory_order_relaxed);
+            MELO_WARN_THROTTLE(1.0, "Callback queue of bus %s is full, dropping the %s message.", name_.c_str(),
+                               overflowPolicy_ == CanBusOptions::CallbackOverflowPolicy::DropNewest ? "newest" : "oldest");
+            if(overflowPolicy_ == CanBusOptions::CallbackOverflowPolicy::DropNewest) {
+                return;
+            }
+            worker.head_ = (worker.head_ + 1) & mask_;
+            --worker.numJobs_;
+        }
+        worker.jobs_[(worker.head_ + worker.numJobs_) & mask_] = Job(handler, msg);
+        ++worker.numJobs_;
+    }
+    worker.condJobs_.notify_one();
+}
+
+void CanCallbackExecutor::cancel(const CanMessageHandler& handler, std::shared_ptr<void>&& owner) {
+    Worker& worker = getWorker(handler);
+    std::unique_lock<std::mutex> lock(worker.mutex_);
+
+    // compact the ring, keeping the order of the other jobs
+    std::size_t numKept = 0;
+    for(std::size_t i = 0; i < worker.numJobs_; ++i) {
+        Job& job = worker.jobs_[(worker.head_ + i) & mask_];
+        if(!isSameHandler(job.handler_, handler)) {
+            if(numKept != i) {
+                worker.jobs_[(worker.head_ + numKept) & mask_] = job;
+            }
+            ++numKept;
+        }
+    }
+    worker.numJobs_ = numKept;
+
+    // a handler unsubscribing itself is called by the worker, which must not wait for itself
+    if(std::this_thread::get_id() != worker.thread_.get_id()) {
+        worker.condEmpty_.wait(lock, [this, &worker, &handler]{ return !running_ || !worker.isBusy_ || !isSameHandler(worker.busyHandler_, handler); });
+    }else if(owner) {
+        worker.cancelledOwners_.push_back(std::move(owner));
+    }
+}
+
+void CanCallbackExecutor::waitForEmptyQueues() {
+    for(auto& worker : workers_) {
+        std::unique_lock<std::mutex> lock(worker->mutex_);
+        worker->condEmpty_.wait(lock, [this, &worker]{ return !running_ || (worker->numJobs_ == 0 && !worker->isBusy_); });
+    }
+}
+
+void CanCallbackExecutor::workerFunction(Worker& worker) {
+    std::unique_lock<std::mutex> lock(worker.mutex_);
+    while(running_) {
+        worker.condJobs_.wait(lock, [this, &worker]{ return !running_ || worker.numJobs_ != 0; });
+
+        while(running_ && worker.numJobs_ != 0) {
+            const Job job = worker.jobs_[worker.head_];
+            worker.head_ = (worker.head_ + 1) & mask_;
+            --worker.numJobs_;
+            worker.busyHandler_ = job.handler_;
+            worker.isBusy_ = true;
+
+            lock.unlock();
+            execute(job.handler_, job.msg_);
+            lock.lock();
+
+            worker.isBusy_ = false;
+            worker.cancelledOwners_.clear();
+            // cancel(..) waits for the end of the job
+            worker.condEmpty_.notify_all();
+        }
+    }
+}
+
+} /* namespace tcan_can */
@@ -0,0 +1,230 @@
+#include "tcan_can/CanDbc.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "message_logger/message_logger.hpp"
+
+namespace tcan_can {
+
+constexpr uint32_t CanDbc::InvalidSignalIndex;
+
+namespace {
+
+//! id of the pseudo message holding signals not assigned to any message
+constexpr uint32_t IndependentSignalsMessageId = 0xc0000000u;
+
+//! @return true if line starts with keyword followed by a whitespace, ignoring leading whitespace
+inline bool startsWith(const std::string& line, const char* keyword) {
+    const std::size_t begin = line.find_first_not_of(" \t");
+    if(begin == std::string::npos) {
+        return false;
+    }
+    const std::size_t length = std::char_traits<char>::length(keyword);
+    return line.compare(begin, length, keyword) == 0 && line.size() > begin + length &&
+           (line[begin + length] == ' ' || line[begin + length] == '\t');
+}
+
+//! Parses "BO_ <id> <name>: <length> <transmitter>"
+bool parseMessage(const std::string& line, CanDbcMessage& message) {
+    std::istringstream stream(line);
+    std::string keyword;
+    unsigned long cobId = 0;
+    unsigned int length = 0;
+    char colon = 0;
+    if(!(stream >> keyword >> cobId >> message.name_)) {
+        return false;
+    }
+    if(!message.name_.empty() && message.name_.back() == ':') {
+        message.name_.pop_back();
+    }else if(!(stream >> colon) || colon != ':') {
+        return false;
+    }
+    if(!(stream >> length) || length > 64) {
+        return false;
+    }
+    message.cobId_ = static_cast<uint32_t>(cobId);
+    message.length_ = static_cast<uint8_t>(length);
+    return true;
+}
+
+//! Parses "SG_ <name> [M|m<value>] : <start>|<length>@<order><sign> (<factor>,<offset>) [<min>|<max>] "<unit>" <receivers>"
+bool parseSignal(const std::string& line, CanDbcSignal& signal) {
+    const std::size_t colon = line.find(':');
+    if(colon == std::string::npos) {
+        return false;
+    }
+
+    std::istringstream header(line.substr(0, colon));
+    std::string keyword;
+    std::string multiplex;
+    if(!(header >> keyword >> signal.name_)) {
+        return false;
+    }
+    if(header >> multiplex) {
+        if(multiplex == "M") {
+            signal.multiplex_ = CanDbcSignal::Multiplex::Multiplexor;
+        }else if(multiplex.size() > 1 && multiplex[0] == 'm' && multiplex.find_first_not_of("0123456789", 1) == std::string::npos) {
+            signal.multiplex_ = CanDbcSignal::Multiplex::Multiplexed;
+            signal.multiplexValue_ = static_cast<uint32_t>(std::strtoul(multiplex.c_str() + 1, nullptr, 10));
+        }else{
+            MELO_ERROR("Extended multiplexing of signal %s is not supported.", signal.name_.c_str());
+            return false;
+        }
+    }
+
+    unsigned int startBit = 0;
+    unsigned int bitLength = 0;
+    char byteOrder = 0;
+    char sign = 0;
+    int unitBegin = 0;
+    if(std::sscanf(line.c_str() + colon + 1, " %u|%u@%c%c (%lf,%lf) [%lf|%lf] \"%n", &startBit, &bitLength, &byteOrder, &sign,
+                   &signal.factor_, &signal.offset_, &signal.minimum_, &signal.maximum_, &unitBegin) != 8 || unitBegin == 0) {
+        return false;
+    }
+    if(bitLength == 0 || bitLength > 64 || startBit > 511 || (byteOrder != '0' && byteOrder != '1') || (sign != '+' && sign != '-')) {
+        return false;
+    }
+
+    const std::size_t unitEnd = line.find('"', colon + 1 + unitBegin);
+    if(unitEnd == std::string::npos) {
+        return false;
+    }
+    signal.unit_ = line.substr(colon + 1 + unitBegin, unitEnd - colon - 1 - unitBegin);
+    signal.startBit_ = static_cast<uint16_t>(startBit);
+    signal.bitLength_ = static_cast<uint8_t>(bitLength);
+    signal.isBigEndian_ = (byteOrder == '0');
+    signal.isSigned_ = (sign == '-');
+    return true;
+}
+
+//! @return true if the signal lies within the payload of the message
+bool fitsIntoMessage(const CanDbcSignal& signal, const CanDbcMessage& message) {
+    if(signal.isBigEndian_) {
+        // start bit counts from the lsb of each byte, the signal continues towards the lsb of the next byte
+        const unsigned int msb = 8u * (signal.startBit_ / 8u) + 7u - signal.startBit_ % 8u;
+        return msb + signal.bitLength_ <= 8u * message.length_;
+    }
+    return signal.startBit_ + signal.bitLength_ <= 8u * message.length_;
+}
+
+} /* namespace */
+
+CanDbc::CanDbc():
+    messages_(),
+    numSignals_(0)
+{
+}
+
+bool CanDbc::loadFile(const std::string& path) {
+    std::ifstream file(path);
+    if(!file.is_open()) {
+        MELO_ERROR("Failed to open DBC file %s.", path.c_str());
+        return false;
+    }
+    return parse(file);
+}
+
+bool CanDbc::parse(std::istream& stream) {
+    std::string line;
+    unsigned int lineNumber = 0;
+    bool inMessage = false;
+    bool skipSignals = false;
+    while(std::getline(stream, line)) {
+        ++lineNumber;
+        if(!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if(startsWith(line, "BO_")) {
+            CanDbcMessage message;
+            if(!parseMessage(line, message)) {
+                MELO_ERROR("Invalid message definition in line %u of DBC file.", lineNumber);
+                return false;
+            }
+            inMessage = true;
+            skipSignals = (message.cobId_ == IndependentSignalsMessageId);
+            if(skipSignals) {
+                continue;
+            }
+            if(getMessage(message.cobId_) != nullptr) {
+                MELO_ERROR("Duplicate message id 0x%x in line %u of DBC file.", message.cobId_, lineNumber);
+                return false;
+            }
+            messages_.push_back(std::move(message));
+        }else if(startsWith(line, "SG_")) {
+            if(!inMessage) {
+                MELO_ERROR("Signal definition outside of a message in line %u of DBC file.", lineNumber);
+                return false;
+            }
+            CanDbcSignal signal;
+            if(!parseSignal(line, signal)) {
+                MELO_ERROR("Invalid signal definition in line %u of DBC file.", lineNumber);
+                return false;
+            }
+            if(skipSignals) {
+                continue;
+            }
+
+            CanDbcMessage& message = messages_.back();
+            if(!fitsIntoMessage(signal, message)) {
+                MELO_ERROR("Signal %s exceeds the length of message %s in line %u of DBC file.", signal.name_.c_str(), message.name_.c_str(), lineNumber);
+                return false;
+            }
+            if(signal.multiplex_ == CanDbcSignal::Multiplex::Multiplexor) {
+                for(const CanDbcSignal& other : message.signals_) {
+                    if(other.multiplex_ == CanDbcSignal::Multiplex::Multiplexor) {
+                        MELO_ERROR("Message %s has more than one multiplexor (line %u of DBC file).", message.name_.c_str(), lineNumber);
+                        return false;
+                    }
+                }
+            }
+            signal.index_ = numSignals_++;
+            message.signals_.push_back(std::move(signal));
+        }else if(line.find_first_not_of(" \t") != std::string::npos) {
+            // any other section ends the signal list of a message
+            inMessage = false;
+        }
+    }
+
+    for(const CanDbcMessage& message : messages_) {
+        bool hasMultiplexor = false;
+        bool hasMultiplexed = false;
+        for(const CanDbcSignal& signal : message.signals_) {
+            hasMultiplexor |= (signal.multiplex_ == CanDbcSignal::Multiplex::Multiplexor);
+            hasMultiplexed |= (signal.multiplex_ == CanDbcSignal::Multiplex::Multiplexed);
+        }
+        if(hasMultiplexed && !hasMultiplexor) {
+            MELO_ERROR("Message %s has multiplexed signals but no multiplexor.", message.name_.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+const CanDbcMessage* CanDbc::getMessage(const uint32_t cobId) const {
+    for(const CanDbcMessage& message : messages_) {
+        if(message.cobId_ == cobId) {
+            return &message;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t CanDbc::getSignalIndex(const std::string& messageName, const std::string& signalName) const {
+    for(const CanDbcMessage& message : messages_) {
+        if(message.name_ != messageName) {
+            continue;
+        }
+        for(const CanDbcSignal& signal : message.signals_) {
+            if(signal.name_ == signalName) {
+                return signal.index_;
+            }
+        }
+    }
+    return InvalidSignalIndex;
+}
+
+} /* namespace tcan_can */
@@ -0,0 +1,90 @@
+#include "tcan_can/CanDbcDecodeTable.hpp"
+
+#include <algorithm>
+
+#include "message_logger/message_logger.hpp"
+
+namespace tcan_can {
+
+namespace {
+
+//! last byte at which an 8 byte word fits into the payload buffer of a CanMsg
+constexpr unsigned int MaxWordByte = CanMsg::Capacity - 8;
+
+} /* namespace */
+
+CanDbcDecodeTable::CanDbcDecodeTable(const CanDbc& dbc):
+    messages_(),
+    signals_(),
+    numSignals_(dbc.getNumSignals())
+{
+    messages_.reserve(dbc.getMessages().size());
+    signals_.reserve(dbc.getNumSignals());
+
+    for(const CanDbcMessage& message : dbc.getMessages()) {
+        MessageDecoder messageDecoder;
+        messageDecoder.cobId_ = message.cobId_;
+        messageDecoder.firstSignal_ = static_cast<uint32_t>(signals_.size());
+        messageDecoder.numSignals_ = 0;
+        messageDecoder.length_ = message.length_;
+
+        for(const CanDbcSignal& signal : message.signals_) {
+            SignalDecoder decoder;
+            if(!makeSignalDecoder(signal, decoder)) {
+                MELO_ERROR("Signal %s of message %s cannot be decoded, it spans more than 8 bytes.", signal.name_.c_str(), message.name_.c_str());
+                continue;
+            }
+
+            // the multiplexor is decoded first, as it selects the multiplexed signals
+            if(signal.multiplex_ == CanDbcSignal::Multiplex::Multiplexor) {
+                signals_.insert(signals_.begin() + messageDecoder.firstSignal_, decoder);
+            }else{
+                signals_.push_back(decoder);
+            }
+            ++messageDecoder.numSignals_;
+        }
+        messages_.push_back(messageDecoder);
+    }
+
+    std::sort(messages_.begin(), messages_.end(), [](const MessageDecoder& a, const MessageDecoder& b) { return a.cobId_ < b.cobId_; });
+}
+
+bool CanDbcDecodeTable::makeSignalDecoder(const CanDbcSignal& signal, SignalDecoder& decoder) {
+    if(signal.bitLength_ == 0 || signal.bitLength_ > 64) {
+        return false;
+    }
+
+    // bits are counted from the start of the payload: for little endian signals the start bit is the lsb, with bit i
+    // being bit (i % 8) of byte (i / 8), for big endian signals the msb, with bit i being bit (7 - i % 8) of byte (i / 8).
+    unsigned int startBit = signal.startBit_;
+    if(signal.isBigEndian_) {
+        startBit = 8u * (signal.startBit_ / 8u) + 7u - signal.startBit_ % 8u;
+    }
+    const unsigned int byte = std::min(startBit / 8u, MaxWordByte);
+    const unsigned int offset = startBit - 8u * byte;
+    if(offset + signal.bitLength_ > 64u) {
+        return false;
+    }
+
+    decoder.mask_ = signal.bitLength_ >= 64 ? ~uint64_t(0) : ((uint64_t(1) << signal.bitLength_) - 1);
+    decoder.signBit_ = signal.isSigned_ ? (uint64_t(1) << (signal.bitLength_ - 1)) : 0;
+    decoder.factor_ = signal.factor_;
+    decoder.offset_ = signal.offset_;
+    decoder.index_ = signal.index_;
+    decoder.multiplexValue_ = signal.multiplexValue_;
+    decoder.byte_ = static_cast<uint8_t>(byte);
+    decoder.shift_ = static_cast<uint8_t>(signal.isBigEndian_ ? 64u - offset - signal.bitLength_ : offset);
+    decoder.isBigEndian_ = signal.isBigEndian_;
+    decoder.multiplex_ = signal.multiplex_;
+    return true;
+}
+
+const CanDbcDecodeTable::MessageDecoder* CanDbcDecodeTable::findMessage(const uint32_t cobId) const {
+    auto it = std::lower_bound(messages_.begin(), messages_.end(), cobId, [](const MessageDecoder& message, const uint32_t id) { return message.cobId_ < id; });
+    if(it == messages_.end() || it->cobId_ != cobId) {
+        return nullptr;
+    }
+    return &(*it);
+}
+
+} /* namespace tcan_can */
@@ -0,0 +1,137 @@
+#include "tcan_can/CanDispatchTable.hpp"
+
+#include <algorithm>
+
+namespace tcan_can {
+
+constexpr CanDispatchTable::SubscriptionHandle CanDispatchTable::InvalidSubscription;
+constexpr uint32_t CanDispatchTable::StandardFrameTableSize;
+
+CanDispatchTable::CanDispatchTable():
+    subscriptions_(),
+    nextHandle_(InvalidSubscription + 1),
+    handlers_(),
+    standardFrameHandlers_(),
+    extendedFrameHandlers_(),
+    maskedSubscriptions_(),
+    unmappedCallback_(),
+    unmappedCallbackOwner_()
+{
+    standardFrameHandlers_.fill(HandlerRange{0, 0});
+}
+
+CanDispatchTable::SubscriptionHandle CanDispatchTable::subscribe(const CanFrameIdentifier& matcher, const CanMessageHandler& handler,
+                                                                const std::shared_ptr<void>& owner) {
+    auto it = std::find_if(subscriptions_.cbegin(), subscriptions_.cend(), [&matcher, &handler](const Subscription& s){
+        return s.matcher_ == matcher && s.handler_.device_ == handler.device_ && s.handler_.callback_ == handler.callback_;
+    });
+    if(it != subscriptions_.cend()) {
+        return InvalidSubscription;
+    }
+
+    const SubscriptionHandle handle = nextHandle_++;
+    subscriptions_.emplace_back(handle, matcher, handler, owner);
+    rebuild();
+
+    return handle;
+}
+
+bool CanDispatchTable::unsubscribe(const SubscriptionHandle handle, CanMessageHandler* handler, std::shared_ptr<void>* owner) {
+    auto it = std::find_if(subscriptions_.begin(), subscriptions_.end(), [handle](const Subscription& s){
+        return s.handle_ == handle;
+    });
+    if(it == subscriptions_.end()) {
+        return false;
+    }
+
+    if(handler != nullptr) {
+        *handler = it->handler_;
+    }
+    if(owner != nullptr) {
+        *owner = it->owner_;
+    }
+    subscriptions_.erase(it);
+    rebuild();
+
+    return true;
+}
+
+bool CanDispatchTable::isSubscribed(const CanMessageHandler& handler) const {
+    return std::any_of(subscriptions_.cbegin(), subscriptions_.cend(), [&handler](const Subscription& s){
+        return s.handler_.device_ == handler.device_ && s.handler_.callback_ == handler.callback_;
+    });
+}
+
+std::vector<CanFrameIdentifier> CanDispatchTable::getMatchers() const {
+    std::vector<CanFrameIdentifier> matchers;
+    matchers.reserve(subscriptions_.size());
+    for(const Subscription& s : subscriptions_) {
+        matchers.push_back(s.matcher_);
+    }
+    return matchers;
+}
+
+void CanDispatchTable::rebuild() {
+    handlers_.clear();
+    extendedFrameHandlers_.clear();
+    maskedSubscriptions_.clear();
+
+    // count the handlers of every standard identifier, then lay out their ranges contiguously
+    std::array<uint32_t, StandardFrameTableSize> counts;
+    counts.fill(0);
+    for(const Subscription& s : subscriptions_) {
+        if(isExact(s.matcher_)) {
+            if(s.matcher_.identifier < StandardFrameTableSize) {
+                ++counts[s.matcher_.identifier];
+            }
+        }else{
+            maskedSubscriptions_.push_back(s);
+            for(uint32_t id = 0; id < StandardFrameTableSize; ++id) {
+                if(matches(s.matcher_, id)) {
+                    ++counts[id];
+                }
+            }
+        }
+    }
+
+    uint32_t numStandardHandlers = 0;
+    for(uint32_t id = 0; id < StandardFrameTableSize; ++id) {
+        standardFrameHandlers_[id] = HandlerRange{numStandardHandlers, numStandardHandlers};
+        numStandardHandlers += counts[id];
+    }
+    handlers_.resize(numStandardHandlers);
+
+    // fill the ranges in order of subscription
+    for(const Subscription& s : subscriptions_) {
+        if(isExact(s.matcher_)) {
+            if(s.matcher_.identifier < StandardFrameTableSize) {
+                handlers_[standardFrameHandlers_[s.matcher_.identifier].end_++] = s.handler_;
+            }
+        }else{
+            for(uint32_t id = 0; id < StandardFrameTableSize; ++id) {
+                if(matches(s.matcher_, id)) {
+                    handlers_[standardFrameHandlers_[id].end_++] = s.handler_;
+                }
+            }
+        }
+    }
+
+    // extended identifiers with an exact subscription get all their matching handlers appended
+    for(const Subscription& exact : subscriptions_) {
+        if(!isExact(exact.matcher_) || exact.matcher_.identifier < StandardFrameTableSize ||
+           extendedFrameHandlers_.count(exact.matcher_.identifier) != 0) {
+            continue;
+        }
+
+        HandlerRange range{static_cast<uint32_t>(handlers_.size()), static_cast<uint32_t>(handlers_.size())};
+        for(const Subscription& s : subscriptions_) {
+            if(matches(s.matcher_, exact.matcher_.identifier)) {
+                handlers_.push_back(s.handler_);
+                ++range.end_;
+            }
+        }
+        extendedFrameHandlers_.emplace(exact.matcher_.identifier, range);
+    }
+}
+
+} /* namespace tcan_can */
@@ -0,0 +1,76 @@
+#include "tcan_can/CanFilterCalculator.hpp"
+
+#include <algorithm>
+
+namespace tcan_can {
+
+namespace {
+
+//! @return true if filter a lets pass all frames filter b lets pass
+inline bool covers(const can_filter& a, const can_filter& b) {
+    return (a.can_mask & ~b.can_mask) == 0 && ((a.can_id ^ b.can_id) & a.can_mask) == 0;
+}
+
+//! @return the most specific filter letting pass all frames of a and b
+inline can_filter merge(const can_filter& a, const can_filter& b) {
+    can_filter merged;
+    merged.can_mask = a.can_mask & b.can_mask & ~(a.can_id ^ b.can_id);
+    merged.can_id = a.can_id & merged.can_mask;
+    return merged;
+}
+
+inline void removeCovered(std::vector<can_filter>& filters, const can_filter& filter) {
+    filters.erase(std::remove_if(filters.begin(), filters.end(), [&filter](const can_filter& f){ return covers(filter, f); }), filters.end());
+}
+
+} /* namespace */
+
+std::vector<can_filter> computeCanFilters(const std::vector<CanFrameIdentifier>& matchers, const std::size_t maxNumFilters) {
+    std::vector<can_filter> candidates;
+    candidates.reserve(matchers.size());
+    for(const CanFrameIdentifier& matcher : matchers) {
+        can_filter filter;
+        filter.can_mask = matcher.mask;
+        filter.can_id = matcher.identifier & matcher.mask;
+        candidates.push_back(filter);
+    }
+
+    // least specific filters first, so that each filter is only compared to the ones which may cover it
+    std::stable_sort(candidates.begin(), candidates.end(), [](const can_filter& a, const can_filter& b){
+        return __builtin_popcount(a.can_mask) < __builtin_popcount(b.can_mask);
+    });
+
+    std::vector<can_filter> filters;
+    filters.reserve(candidates.size());
+    for(const can_filter& candidate : candidates) {
+        if(std::none_of(filters.cbegin(), filters.cend(), [&candidate](const can_filter& f){ return covers(f, candidate); })) {
+            filters.push_back(candidate);
+        }
+    }
+
+    // merge neighbouring identifiers until the kernel limit is met. Neighbours mostly differ in their low bits only.
+    const std::size_t maxFilters = std::max<std::size_t>(maxNumFilters, 1);
+    while(filters.size() > maxFilters) {
+        std::sort(filters.begin(), filters.end(), [](const can_filter& a, const can_filter& b){
+            return a.can_id < b.can_id || (a.can_id == b.can_id && a.can_mask < b.can_mask);
+        });
+
+        std::size_t bestIndex = 0;
+        int bestNumMaskBits = -1;
+        for(std::size_t i = 0; i + 1 < filters.size(); ++i) {
+            const int numMaskBits = __builtin_popcount(merge(filters[i], filters[i+1]).can_mask);
+            if(numMaskBits > bestNumMaskBits) {
+                bestNumMaskBits = numMaskBits;
+                bestIndex = i;
+            }
+        }
+
+        const can_filter merged = merge(filters[bestIndex], filters[bestIndex+1]);
+        removeCovered(filters, merged);
+        filters.push_back(merged);
+    }
+
+    return filters;
+}
+
+} /* namespace tcan_can */
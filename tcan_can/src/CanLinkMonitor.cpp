@@ -0,0 +1,248 @@
+#include <sys/socket.h>
+#include <linux/can/netlink.h>
+#include <linux/if.h>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tcan_can/CanLinkMonitor.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+namespace tcan_can {
+
+static_assert(static_cast<int>(CanLinkMonitor::ControllerState::BusOff) == CAN_STATE_BUS_OFF &&
+              static_cast<int>(CanLinkMonitor::ControllerState::Unknown) == CAN_STATE_MAX,
+              "CanLinkMonitor::ControllerState shall match enum can_state");
+
+namespace {
+
+//! netlink request with room for the attributes
+struct LinkRequest {
+    struct nlmsghdr header_;
+    struct ifinfomsg info_;
+    alignas(NLMSG_ALIGNTO) char attributes_[256];
+};
+
+//! Appends an attribute to a netlink message and returns it, nullptr if the message is full
+struct rtattr* addAttribute(struct nlmsghdr* msg, const std::size_t maxLength, const unsigned short type, const void* data, const std::size_t length) {
+    const std::size_t attributeLength = RTA_LENGTH(length);
+    if(NLMSG_ALIGN(msg->nlmsg_len) + RTA_ALIGN(attributeLength) > maxLength) {
+        return nullptr;
+    }
+    struct rtattr* attribute = reinterpret_cast<struct rtattr*>(reinterpret_cast<char*>(msg) + NLMSG_ALIGN(msg->nlmsg_len));
+    attribute->rta_type = type;
+    attribute->rta_len = static_cast<unsigned short>(attributeLength);
+    if(length != 0) {
+        memcpy(RTA_DATA(attribute), data, length);
+    }
+    msg->nlmsg_len = static_cast<uint32_t>(NLMSG_ALIGN(msg->nlmsg_len) + RTA_ALIGN(attributeLength));
+    return attribute;
+}
+
+//! Sets the length of a nested attribute after its children were added
+void endNestedAttribute(struct nlmsghdr* msg, struct rtattr* nested) {
+    nested->rta_len = static_cast<unsigned short>(reinterpret_cast<char*>(msg) + msg->nlmsg_len - reinterpret_cast<char*>(nested));
+}
+
+} /* namespace */
+
+CanLinkMonitor::CanLinkMonitor(const std::string& interface):
+    interface_(interface),
+    socket_(-1),
+    sequenceNumber_(0),
+    interfaceIndex_{0},
+    isLinkUp_{false},
+    controllerState_{ControllerState::Unknown},
+    txErrorCounter_{0},
+    rxErrorCounter_{0}
+{
+}
+
+CanLinkMonitor::~CanLinkMonitor()
+{
+    if(socket_ >= 0) {
+        close(socket_);
+    }
+}
+
+bool CanLinkMonitor::open() {
+    socket_ = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if(socket_ < 0) {
+        MELO_ERROR("Opening netlink socket for interface %s failed: (%d)\n  %s", interface_.c_str(), errno, strerror(errno));
+        return false;
+    }
+
+    struct sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    if(bind(socket_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        MELO_ERROR("Failed to subscribe to link notifications for interface %s: (%d)\n  %s", interface_.c_str(), errno, strerror(errno));
+        return false;
+    }
+
+    return requestState();
+}
+
+bool CanLinkMonitor::requestState() {
+    // the interface is requested by name, its index changes if it is removed and added again
+    LinkRequest request;
+    memset(&request, 0, sizeof(request));
+    request.header_.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request.header_.nlmsg_type = RTM_GETLINK;
+    request.header_.nlmsg_flags = NLM_F_REQUEST;
+    request.header_.nlmsg_seq = ++sequenceNumber_;
+    request.info_.ifi_family = AF_UNSPEC;
+    addAttribute(&request.header_, sizeof(request), IFLA_IFNAME, interface_.c_str(), interface_.size() + 1);
+
+    if(send(socket_, &request, request.header_.nlmsg_len, MSG_DONTWAIT) < 0) {
+        MELO_WARN_THROTTLE(1.0, "Failed to request the state of interface %s: (%d)\n  %s", interface_.c_str(), errno, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool CanLinkMonitor::restartController() {
+    const int interfaceIndex = getInterfaceIndex();
+    if(socket_ < 0 || interfaceIndex <= 0) {
+        return false;
+    }
+
+    LinkRequest request;
+    memset(&request, 0, sizeof(request));
+    request.header_.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request.header_.nlmsg_type = RTM_NEWLINK;
+    request.header_.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    request.header_.nlmsg_seq = ++sequenceNumber_;
+    request.info_.ifi_family = AF_UNSPEC;
+    request.info_.ifi_index = interfaceIndex;
+
+    // IFLA_LINKINFO { IFLA_INFO_KIND "can", IFLA_INFO_DATA { IFLA_CAN_RESTART 1 } }
+    const uint32_t restart = 1;
+    struct rtattr* linkInfo = addAttribute(&request.header_, sizeof(request), IFLA_LINKINFO, nullptr, 0);
+    addAttribute(&request.header_, sizeof(request), IFLA_INFO_KIND, "can", 4);
+    struct rtattr* infoData = addAttribute(&request.header_, sizeof(request), IFLA_INFO_DATA, nullptr, 0);
+    addAttribute(&request.header_, sizeof(request), IFLA_CAN_RESTART, &restart, sizeof(restart));
+    endNestedAttribute(&request.header_, infoData);
+    endNestedAttribute(&request.header_, linkInfo);
+
+    if(send(socket_, &request, request.header_.nlmsg_len, MSG_DONTWAIT) < 0) {
+        MELO_ERROR("Failed to restart the controller of interface %s: (%d)\n  %s", interface_.c_str(), errno, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool CanLinkMonitor::update() {
+    if(socket_ < 0) {
+        return false;
+    }
+
+    bool hasChanged = false;
+    alignas(struct nlmsghdr) char buffer[8192];
+    while(true) {
+        const ssize_t length = recv(socket_, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if(length <= 0) {
+            if(length < 0 && errno == ENOBUFS) {
+                // notifications were lost, the state is requested below
+                continue;
+            }
+            break;
+        }
+
+        int remaining = static_cast<int>(length);
+        for(const struct nlmsghdr* msg = reinterpret_cast<const struct nlmsghdr*>(buffer); NLMSG_OK(msg, remaining); msg = NLMSG_NEXT(msg, remaining)) {
+            if(msg->nlmsg_type == RTM_NEWLINK || msg->nlmsg_type == RTM_DELLINK) {
+                hasChanged |= handleLinkMessage(msg);
+            }else if(msg->nlmsg_type == NLMSG_ERROR) {
+                const struct nlmsgerr* error = static_cast<const struct nlmsgerr*>(NLMSG_DATA(msg));
+                if(error->error == -ENODEV && exists()) {
+                    // the requested interface does not exist (anymore)
+                    interfaceIndex_ = 0;
+                    isLinkUp_ = false;
+                    controllerState_ = ControllerState::Unknown;
+                    hasChanged = true;
+                }else if(error->error != 0 && error->error != -ENODEV) {
+                    MELO_ERROR_THROTTLE(1.0, "Netlink request for interface %s failed: (%d)\n  %s", interface_.c_str(), -error->error, strerror(-error->error));
+                }
+            }
+        }
+    }
+
+    requestState();
+    return hasChanged;
+}
+
+bool CanLinkMonitor::handleLinkMessage(const struct nlmsghdr* msg) {
+    const struct ifinfomsg* info = static_cast<const struct ifinfomsg*>(NLMSG_DATA(msg));
+
+    bool isMonitored = false;
+    bool hasCanState = false;
+    ControllerState controllerState = ControllerState::Unknown;
+    uint16_t txErrorCounter = 0;
+    uint16_t rxErrorCounter = 0;
+
+    int length = static_cast<int>(IFLA_PAYLOAD(msg));
+    for(const struct rtattr* attribute = IFLA_RTA(info); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+        if(attribute->rta_type == IFLA_IFNAME) {
+            isMonitored = (interface_ == static_cast<const char*>(RTA_DATA(attribute)));
+        }else if(attribute->rta_type == IFLA_LINKINFO) {
+            int linkInfoLength = static_cast<int>(RTA_PAYLOAD(attribute));
+            for(const struct rtattr* linkInfo = static_cast<const struct rtattr*>(RTA_DATA(attribute)); RTA_OK(linkInfo, linkInfoLength);
+                linkInfo = RTA_NEXT(linkInfo, linkInfoLength)) {
+                if(linkInfo->rta_type != IFLA_INFO_DATA) {
+                    continue;
+                }
+                int dataLength = static_cast<int>(RTA_PAYLOAD(linkInfo));
+                for(const struct rtattr* data = static_cast<const struct rtattr*>(RTA_DATA(linkInfo)); RTA_OK(data, dataLength); data = RTA_NEXT(data, dataLength)) {
+                    if(data->rta_type == IFLA_CAN_STATE && RTA_PAYLOAD(data) >= sizeof(uint32_t)) {
+                        uint32_t state;
+                        memcpy(&state, RTA_DATA(data), sizeof(state));
+                        controllerState = state < CAN_STATE_MAX ? static_cast<ControllerState>(state) : ControllerState::Unknown;
+                        hasCanState = true;
+                    }else if(data->rta_type == IFLA_CAN_BERR_COUNTER && RTA_PAYLOAD(data) >= sizeof(struct can_berr_counter)) {
+                        struct can_berr_counter counter;
+                        memcpy(&counter, RTA_DATA(data), sizeof(counter));
+                        txErrorCounter = counter.txerr;
+                        rxErrorCounter = counter.rxerr;
+                    }
+                }
+            }
+        }
+    }
+
+    if(!isMonitored) {
+        return false;
+    }
+
+    const int interfaceIndex = (msg->nlmsg_type == RTM_DELLINK) ? 0 : info->ifi_index;
+    const bool isLinkUp = interfaceIndex > 0 && (info->ifi_flags & IFF_UP) && (info->ifi_flags & IFF_RUNNING);
+    if(!hasCanState || interfaceIndex == 0) {
+        controllerState = ControllerState::Unknown;
+    }
+
+    const bool hasChanged = interfaceIndex != getInterfaceIndex() || isLinkUp != this->isLinkUp() || controllerState != getControllerState();
+    interfaceIndex_ = interfaceIndex;
+    isLinkUp_ = isLinkUp;
+    controllerState_ = controllerState;
+    txErrorCounter_ = txErrorCounter;
+    rxErrorCounter_ = rxErrorCounter;
+    return hasChanged;
+}
+
+const char* CanLinkMonitor::getControllerStateName(const ControllerState state) {
+    switch(state) {
+        case ControllerState::ErrorActive: return "error active";
+        case ControllerState::ErrorWarning: return "error warning";
+        case ControllerState::ErrorPassive: return "error passive";
+        case ControllerState::BusOff: return "bus off";
+        case ControllerState::Stopped: return "stopped";
+        case ControllerState::Sleeping: return "sleeping";
+        default: return "unknown";
+    }
+}
+
+} /* namespace tcan_can */
@@ -15,15 +15,18 @@ DeviceCanOpen::DeviceCanOpen(std::unique_ptr<DeviceCanOpenOptions>&& options):
     nmtState_(NMTStates::preOperational),
     sdoTimeoutCounter_(0),
     sdoSentCounter_(0),
-    sdoMsgsMutex_(),
-    sdoMsgs_()
+    sdoTimeoutPosition_(0),
+    sdoMsgs_(static_cast<const DeviceCanOpenOptions*>(options_.get())->sdoQueueCapacity_),
+    sdoAnswers_(static_cast<const DeviceCanOpenOptions*>(options_.get())->sdoAnswerTableCapacity_),
+    sdoTransferMutex_(),
+    sdoTransfer_()
 {
 }
 
 bool DeviceCanOpen::sanityCheck() {
     if(!isMissing()) {
         if(isTimedOut()) {
-            state_ = Missing;
+            setState(Missing);
             MELO_WARN("Device %s timed out!", getName().c_str());
 
             clearSdoQueue();
@@ -39,26 +42,24 @@ void DeviceCanOpen::sendPdo(const CanMsg& pdoMsg) {
     bus_->sendMessage(pdoMsg);
 }
 
-void DeviceCanOpen::sendSdo(const SdoMsg& sdoMsg) {
-
-    std::lock_guard<std::mutex> guard(sdoMsgsMutex_);
-    sdoMsgs_.push(sdoMsg);
-
-    if(sdoMsgs_.size() == 1) {
-        // sdo queue was empty before, so put the new message in the bus output queue
-        sdoTimeoutCounter_ = 0;
-        sdoSentCounter_ = 0;
+bool DeviceCanOpen::sendSdo(const SdoMsg& sdoMsg) {
+    if(sdoMsg.getRequiresAnswer()) {
+        // if an answer to a previously sent similar sdo has been received but not fetched, erase it to prevent storing outdated data
+        sdoAnswers_.erase(getSdoAnswerId(sdoMsg.getIndex(), sdoMsg.getSubIndex()));
+    }
 
-        bus_->sendMessage(sdoMsgs_.front());
+    uint32_t position;
+    if(!sdoMsgs_.push(sdoMsg, position)) {
+        MELO_WARN_THROTTLE(1.0, "Device %s: SDO queue is full, dropping SDO (COB=%x / index=%x / subindex=%x)", getName().c_str(), sdoMsg.getCobId(), sdoMsg.getIndex(), sdoMsg.getSubIndex());
+        return false;
+    }
 
-        if(sdoMsg.getRequiresAnswer()) {
-            // if an answer to a previously sent similar sdo has been received but not fetched, erase it to prevent storing outdated data
-            std::lock_guard<std::mutex> guard(sdoAnswerMapMutex_);
-            sdoAnswerMap_.erase(getSdoAnswerId(sdoMsg.getIndex(), sdoMsg.getSubIndex()));
-        }else{
-            sdoMsgs_.pop();
-        }
+    if(sdoMsgs_.getFrontPosition() == position) {
+        // sdo queue was empty before, so put the new message in the bus output queue. The thread which popped the previous
+        // front may do so as well, claimSend(..) ensures that it is sent once.
+        sendNextSdo();
     }
+    return true;
 }
 
 void DeviceCanOpen::handleTimedoutSdo(const SdoMsg& msg) {
@@ -66,7 +67,7 @@ void DeviceCanOpen::handleTimedoutSdo(const SdoMsg& msg) {
     if(state_ == Active) {
         // only set state to 'error' if state is 'active', to prevent overriding a 'Missing' state
         setNmtStopRemoteDevice();
-        state_ = Error;
+        setState(Error);
     }
 }
 
@@ -74,20 +75,77 @@ void DeviceCanOpen::handleSdoError(const SdoMsg& request, const SdoMsg& answer)
     const int32_t error = answer.readint32(4);
     MELO_WARN("Received SDO error from device %s: %s. COB=%x / index=%x / subindex=%x / error=%x / sent data=%x", options_->name_.c_str(), SdoMsg::getErrorName(error).c_str(), answer.getCobId(), answer.getIndex(), answer.getSubIndex(), error, request.readint32(4));
     setNmtStopRemoteDevice();
-    state_ = Error;
+    setState(Error);
 }
 
 bool DeviceCanOpen::getSdoAnswer(SdoMsg& sdoAnswer) {
-    std::lock_guard<std::mutex> guard(sdoAnswerMapMutex_);
-    auto it = sdoAnswerMap_.find(getSdoAnswerId(sdoAnswer.getIndex(), sdoAnswer.getSubIndex()));
-    if (it == sdoAnswerMap_.end()) {
+    CanMsg answer(TxSDOId + getNodeId(), 8);
+    if(!sdoAnswers_.take(getSdoAnswerId(sdoAnswer.getIndex(), sdoAnswer.getSubIndex()), answer.getData())) {
+        return false;
+    }
+    sdoAnswer = SdoMsg(answer);
+    return true;
+}
+
+bool DeviceCanOpen::readSdoAsync(SdoRequest& request, const uint16_t index, const uint8_t subIndex) {
+    return sendSdoAsync(request, SdoMsg(getNodeId(), SdoMsg::Command::READ, index, subIndex, 0));
+}
+
+bool DeviceCanOpen::sendSdoAsync(SdoRequest& request, SdoMsg sdoMsg) {
+    if(request.isPending()) {
+        MELO_WARN("Device %s: SDO request (index=%x / subindex=%x) is still pending", getName().c_str(), request.getIndex(), request.getSubIndex());
+        return false;
+    }
+
+    request.start(sdoMsg.getIndex(), sdoMsg.getSubIndex(), sdoMsg.readuint32(4));
+    sdoMsg.setRequest(&request);
+    if(!sendSdo(sdoMsg)) {
+        request.finish(SdoTransfer::OutOfMemoryError, request.value_, 0);
         return false;
     }
-    sdoAnswer = it->second;
-    sdoAnswerMap_.erase(it);
     return true;
 }
 
+bool DeviceCanOpen::uploadSdo(const uint16_t index, const uint8_t subIndex, uint8_t* buffer, const std::size_t capacity, const bool blockTransfer) {
+    std::lock_guard<std::mutex> guard(sdoTransferMutex_);
+    if(!sdoTransfer_.setupUpload(getNodeId(), index, subIndex, buffer, capacity, blockTransfer)) {
+        MELO_WARN("Device %s: cannot queue SDO upload (index=%x / subindex=%x), another transfer is in progress", getName().c_str(), index, subIndex);
+        return false;
+    }
+
+    if(!sendSdo(SdoMsg(sdoTransfer_.getInitiateRequest(), true))) {
+        sdoTransfer_.abort(SdoTransfer::OutOfMemoryError, false);
+        return false;
+    }
+    return true;
+}
+
+bool DeviceCanOpen::downloadSdo(const uint16_t index, const uint8_t subIndex, const uint8_t* data, const std::size_t length, const bool blockTransfer) {
+    std::lock_guard<std::mutex> guard(sdoTransferMutex_);
+    if(!sdoTransfer_.setupDownload(getNodeId(), index, subIndex, data, length, blockTransfer)) {
+        MELO_WARN("Device %s: cannot queue SDO download (index=%x / subindex=%x), another transfer is in progress", getName().c_str(), index, subIndex);
+        return false;
+    }
+
+    if(!sendSdo(SdoMsg(sdoTransfer_.getInitiateRequest(), true))) {
+        sdoTransfer_.abort(SdoTransfer::OutOfMemoryError, false);
+        return false;
+    }
+    return true;
+}
+
+bool DeviceCanOpen::isSdoTransferBusy() {
+    std::lock_guard<std::mutex> guard(sdoTransferMutex_);
+    return sdoTransfer_.isBusy();
+}
+
+void DeviceCanOpen::handleSdoTransfer(const SdoTransfer& transfer) {
+    if(transfer.getState() == SdoTransfer::State::Aborted) {
+        MELO_WARN("Device %s: SDO transfer aborted (index=%x / subindex=%x / error=%x: %s) after %zu bytes", getName().c_str(), transfer.getIndex(), transfer.getSubIndex(),
+                  transfer.getAbortCode(), SdoMsg::getErrorName(static_cast<int32_t>(transfer.getAbortCode())).c_str(), transfer.getLength());
+    }
+}
+
 void DeviceCanOpen::setNmtEnterPreOperational() {
     sendSdo( SdoMsg(static_cast<uint8_t>(getNodeId()), 0x80) );
 
@@ -122,7 +180,7 @@ void DeviceCanOpen::setNmtResetRemoteCommunication() {
     clearSdoQueue();
     sendSdo( SdoMsg(static_cast<uint8_t>(getNodeId()), 0x82) );
 
-    state_ = Initializing;
+    setState(Initializing);
 }
 
 void DeviceCanOpen::setNmtRestartRemoteDevice() {
@@ -130,7 +188,7 @@ void DeviceCanOpen::setNmtRestartRemoteDevice() {
     deviceTimeoutCounter_ = 0;
     sendSdo( SdoMsg(static_cast<uint8_t>(getNodeId()), 0x81) );
 
-    state_ = Initializing;
+    setState(Initializing);
 }
 
 void DeviceCanOpen::resetDevice() {
@@ -170,28 +228,30 @@ bool DeviceCanOpen::parseHeartBeat(const CanMsg& cmsg) {
 }
 
 bool DeviceCanOpen::parseSDOAnswer(const CanMsg& cmsg) {
-    const uint8_t responseMode = cmsg.readuint8(0);
-    const uint16_t index = cmsg.readuint16(1);
-    const uint8_t subindex = cmsg.readuint8(3);
-
-    std::unique_lock<std::mutex> guard(sdoMsgsMutex_); // lock sdoMsgsMutex_ to prevent checkSdoTimeout() from making changes on sdoMsgs_
-    if(sdoMsgs_.size() != 0) {
-        const SdoMsg& sdo = sdoMsgs_.front();
+    const SdoMsgView answer(cmsg);
+    const uint16_t index = answer.getIndex();
+    const uint8_t subindex = answer.getSubIndex();
+
+    uint32_t position;
+    SdoMsg sdo;
+    if(sdoMsgs_.peek(position, sdo) && sdoMsgs_.isSent(position)) {
+        if(sdo.isTransfer()) {
+            // segments do not contain index and subindex
+            return parseSdoTransferAnswer(cmsg, position);
+        }
 
-        if(sdo.getIndex() == index && sdo.getSubIndex() == subindex) {
+        // checkSdoTimeout() may pop the sdo concurrently, the answer is only handled if it was not timed out
+        if(sdo.getIndex() == index && sdo.getSubIndex() == subindex && sdoMsgs_.pop(position)) {
 
-            if(responseMode == 0x42 || responseMode == 0x43 || responseMode == 0x4B || responseMode == 0x4F) { // read responses (unspecified length, 4, 2 or 1 byte)
-                {
-                  std::lock_guard<std::mutex> mapGuard(sdoAnswerMapMutex_);
-                  sdoAnswerMap_[getSdoAnswerId(index, subindex)] = static_cast<const SdoMsg&>(cmsg);
+            if(sdo.getRequest() != nullptr) {
+                finishSdoRequest(*sdo.getRequest(), sdo.getCommandByte(), answer);
+            }else if(answer.isReadAnswer()) { // read responses (unspecified length, 4, 2 or 1 byte)
+                if(!sdoAnswers_.store(getSdoAnswerId(index, subindex), cmsg.getData())) {
+                    MELO_WARN_THROTTLE(1.0, "Device %s: SDO answer table is full, answer of index=%x / subindex=%x is not stored", getName().c_str(), index, subindex);
                 }
-                guard.unlock(); // unlock guard here, otherwise the user will not be able to put any sdo in the sdo ouput queue
-                handleReadSdoAnswer( static_cast<const SdoMsg&>(cmsg) );
-                guard.lock();
-            }else if(responseMode == 0x80) { // error response
-                guard.unlock(); // unlock guard here, otherwise the user will not be able to put any sdo in the sdo ouput queue
-                handleSdoError(sdo, static_cast<const SdoMsg&>(cmsg));
-                guard.lock();
+                handleReadSdoAnswer(SdoMsg(cmsg));
+            }else if(answer.isAbort()) { // error response
+                handleSdoError(sdo, SdoMsg(cmsg));
             }
 
             sendNextSdo();
@@ -208,24 +268,56 @@ bool DeviceCanOpen::parseSDOAnswer(const CanMsg& cmsg) {
 bool DeviceCanOpen::checkSdoTimeout() {
     const DeviceCanOpenOptions* options = static_cast<const DeviceCanOpenOptions*>(options_.get());
 
-    if(options->maxSdoTimeoutCounter_ != 0) {
-        std::unique_lock<std::mutex> guard(sdoMsgsMutex_); // lock sdoMsgsMutex_ to prevent parseSDOAnswer from making changes on sdoMsgs_
-        if( sdoMsgs_.size() != 0 && (sdoTimeoutCounter_++ > options->maxSdoTimeoutCounter_) ) {
-            // sdoTimeoutCounter_ is only increased if options_->maxSdoTimeoutCounter != 0 and sdoMsgs_.size() != 0
+    uint32_t position;
+    SdoMsg msg;
+    if(!sdoMsgs_.peek(position, msg) || !sdoMsgs_.isSent(position)) {
+        return true;
+    }
 
-            const SdoMsg &msg = sdoMsgs_.front();
-            if (sdoSentCounter_ > options->maxSdoSentCounter_) {
-                guard.unlock(); // unlock guard here, otherwise the user will not be able to put any sdo in the sdo ouput queue
-                handleTimedoutSdo(msg);
-                guard.lock();
-                sendNextSdo();
+    if(position != sdoTimeoutPosition_) {
+        // the counters belong to the sdo at the front
+        sdoTimeoutPosition_ = position;
+        sdoTimeoutCounter_ = 0;
+        sdoSentCounter_ = 0;
+    }
+
+    // asynchronous requests may override the timeout of the device
+    SdoRequest* request = msg.getRequest();
+    const unsigned int maxSdoTimeoutCounter = (request != nullptr && request->maxTimeoutCounter_ != 0) ? request->maxTimeoutCounter_ : options->maxSdoTimeoutCounter_;
+    const unsigned int maxSdoSentCounter = (request != nullptr && request->maxSentCounter_ != 0) ? request->maxSentCounter_ : options->maxSdoSentCounter_;
+
+    if( maxSdoTimeoutCounter != 0 && (sdoTimeoutCounter_++ > maxSdoTimeoutCounter) ) {
+        // sdoTimeoutCounter_ is only increased if maxSdoTimeoutCounter != 0 and the sdo queue is not empty
+
+        if(msg.isTransfer()) {
+            std::unique_lock<std::mutex> guard(sdoTransferMutex_);
+            if(sdoTransfer_.getState() == SdoTransfer::State::Running || sdoSentCounter_ > maxSdoSentCounter) {
+                // only the initiate request is sent again, segments are not repeated
+                sdoTransfer_.abort(SdoTransfer::TimeoutError);
+                continueSdoTransfer(position, guard);
 
                 return false;
-            } else {
-                sdoSentCounter_++;
+            }
+        }
+
+        if (sdoSentCounter_ > maxSdoSentCounter) {
+            if(!sdoMsgs_.pop(position)) {
+                // the answer was received meanwhile
+                return true;
+            }
 
-                bus_->sendMessage(msg);
+            if(request != nullptr) {
+                request->finish(SdoTransfer::TimeoutError, request->value_, 0);
+            }else{
+                handleTimedoutSdo(msg);
             }
+            sendNextSdo();
+
+            return false;
+        } else {
+            sdoSentCounter_++;
+
+            bus_->sendMessage(msg);
         }
     }
 
@@ -233,27 +325,90 @@ bool DeviceCanOpen::checkSdoTimeout() {
 }
 
 void DeviceCanOpen::sendNextSdo() {
-    sdoTimeoutCounter_ = 0;
-    sdoSentCounter_ = 0;
-
-    sdoMsgs_.pop();
+    uint32_t position;
+    SdoMsg msg;
 
     // put next SDO message(s) into the bus output queue
-    while(sdoMsgs_.size() > 0) {
-        bus_->sendMessage( sdoMsgs_.front() );
+    while(sdoMsgs_.peek(position, msg) && sdoMsgs_.claimSend(position)) {
+        bus_->sendMessage(msg);
 
-        if(!sdoMsgs_.front().getRequiresAnswer()) {
-            sdoMsgs_.pop(); // if sdo requires no answer (e.g. NMT state requests), pop it from the SDO queue and proceed to the next SDO
-        }else{
+        if(msg.getRequiresAnswer() || !sdoMsgs_.pop(position)) {
             break; // if SDO requires answer, wait for it
         }
+        // if sdo requires no answer (e.g. NMT state requests), it is popped from the SDO queue and the next SDO is sent
+    }
+}
+
+void DeviceCanOpen::finishSdoRequest(SdoRequest& request, const uint8_t requestCommand, const SdoMsgView& answer) {
+    const uint8_t command = answer.getCommandByte();
+    uint32_t abortCode = 0;
+    uint32_t value = request.value_;
+    uint8_t length = 0;
+
+    if(answer.isAbort()) {
+        abortCode = answer.getData();
+    }else if(requestCommand == static_cast<uint8_t>(SdoMsg::Command::READ) && (command & 0xE2) == 0x42) {
+        // expedited read answer, the number of bytes without data is indicated if bit 0 is set
+        length = static_cast<uint8_t>((command & 0x01) ? 4 - ((command >> 2) & 0x03) : 4);
+        value = (length < 4) ? answer.getData() & ((1u << (8 * length)) - 1u) : answer.getData();
+    }else if(requestCommand == static_cast<uint8_t>(SdoMsg::Command::READ) || command != 0x60) {
+        // e.g. a segmented upload, which needs uploadSdo(..)
+        abortCode = SdoTransfer::CommandSpecifierError;
+        CanMsg abort(RxSDOId + getNodeId(), 8);
+        abort.write(static_cast<uint8_t>(0x80), 0);
+        abort.write(request.getIndex(), 1);
+        abort.write(request.getSubIndex(), 3);
+        abort.write(abortCode, 4);
+        bus_->sendMessage(abort);
+    }
+
+    request.finish(abortCode, value, length);
+}
+
+bool DeviceCanOpen::parseSdoTransferAnswer(const CanMsg& cmsg, const uint32_t position) {
+    std::unique_lock<std::mutex> guard(sdoTransferMutex_);
+    if(!sdoTransfer_.handleAnswer(cmsg)) {
+        MELO_WARN("Received unexpected SDO answer from device %s during transfer of index=%x / subindex=%x. COB=%x / data=%x %x", options_->name_.c_str(),
+                  sdoTransfer_.getIndex(), sdoTransfer_.getSubIndex(), cmsg.getCobId(), cmsg.readuint32(0), cmsg.readuint32(4));
+        return false;
+    }
+
+    sdoTimeoutCounter_ = 0;
+    continueSdoTransfer(position, guard);
+    return true;
+}
+
+void DeviceCanOpen::continueSdoTransfer(const uint32_t position, std::unique_lock<std::mutex>& guard) {
+    CanMsg request(0);
+    while(sdoTransfer_.getNextRequest(request)) {
+        bus_->sendMessage(request);
+    }
+
+    if(sdoTransfer_.isFinished()) {
+        const SdoTransfer transfer = sdoTransfer_;
+        guard.unlock(); // unlock guard here, otherwise the user will not be able to queue the next transfer
+
+        if(sdoMsgs_.pop(position)) {
+            handleSdoTransfer(transfer);
+            sendNextSdo();
+        }
     }
 }
 
 void DeviceCanOpen::clearSdoQueue() {
-    std::lock_guard<std::mutex> guard(sdoMsgsMutex_);
-    // swap with an empty queue to clear it
-    std::queue<SdoMsg>().swap(sdoMsgs_);
+    {
+        std::lock_guard<std::mutex> guard(sdoTransferMutex_);
+        sdoTransfer_.abort(SdoTransfer::GeneralError, false);
+    }
+
+    // pop all sdos and finish the pending asynchronous requests
+    uint32_t position;
+    SdoMsg msg;
+    while(sdoMsgs_.peek(position, msg)) {
+        if(sdoMsgs_.pop(position) && msg.getRequest() != nullptr) {
+            msg.getRequest()->finish(SdoTransfer::GeneralError, msg.getRequest()->value_, 0);
+        }
+    }
 }
 
 uint32_t DeviceCanOpen::getSdoAnswerId(const uint16_t index, const uint8_t subIndex) {
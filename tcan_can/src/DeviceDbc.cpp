@@ -0,0 +1,57 @@
+#include "tcan_can/DeviceDbc.hpp"
+
+#include <algorithm>
+
+#include "tcan_can/CanBus.hpp"
+
+namespace tcan_can {
+
+DeviceDbc::DeviceDbc(std::unique_ptr<CanDeviceOptions>&& options, const std::shared_ptr<const CanDbcDecodeTable>& table):
+    CanDevice(std::move(options)),
+    table_(table),
+    values_(table->getNumSignals(), 0.0),
+    valuesMutex_()
+{
+}
+
+DeviceDbc::DeviceDbc(const std::string& name, const std::shared_ptr<const CanDbcDecodeTable>& table):
+    DeviceDbc(std::unique_ptr<CanDeviceOptions>(new CanDeviceOptions(0, name)), table)
+{
+}
+
+bool DeviceDbc::initDevice() {
+    bool success = true;
+    for(const CanDbcDecodeTable::MessageDecoder& message : table_->getMessages()) {
+        success &= bus_->addCanMessage(message.cobId_, this, &DeviceDbc::parseMessage);
+    }
+    return success;
+}
+
+double DeviceDbc::getSignalValue(const uint32_t index) const {
+    std::lock_guard<std::mutex> lock(valuesMutex_);
+    return index < values_.size() ? values_[index] : 0.0;
+}
+
+void DeviceDbc::getSignalValues(double* values) const {
+    std::lock_guard<std::mutex> lock(valuesMutex_);
+    std::copy(values_.begin(), values_.end(), values);
+}
+
+bool DeviceDbc::parseMessage(const CanMsg& msg) {
+    const CanDbcDecodeTable::MessageDecoder* message = table_->findMessage(msg.getCobId());
+    if(message == nullptr) {
+        return false;
+    }
+
+    if(msg.getLength() < message->length_) {
+        MELO_WARN("Device %s: message 0x%x is shorter than defined (%u < %u bytes).", getName().c_str(), msg.getCobId(), msg.getLength(), message->length_);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(valuesMutex_);
+    table_->decode(*message, msg, values_.data());
+    onMessageDecoded(*message, values_.data());
+    return true;
+}
+
+} /* namespace tcan_can */
@@ -0,0 +1,218 @@
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/isotp.h>
+#include <net/if.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "tcan_can/IsoTpBus.hpp"
+
+#include "message_logger/message_logger.hpp"
+
+namespace tcan_can {
+
+IsoTpBus::IsoTpBus(std::unique_ptr<IsoTpBusOptions>&& options):
+    tcan::Bus<tcan::GenericMsg>(std::move(options)),
+    socket_(-1),
+    recvFlag_(0),
+    sendFlag_(0),
+    receiveBuffer_(),
+    numTruncatedPdus_{0},
+    deviceTimeoutCounter_{0}
+{
+}
+
+IsoTpBus::~IsoTpBus()
+{
+    stopThreads(true);
+    if(socket_ >= 0) {
+        close(socket_);
+    }
+}
+
+bool IsoTpBus::sanityCheck() {
+    const unsigned int maxTimeout = static_cast<const IsoTpBusOptions*>(options_.get())->maxDeviceTimeoutCounter_;
+    isMissingDeviceOrHasError_ = (maxTimeout != 0 && (deviceTimeoutCounter_++ > maxTimeout) );
+    allDevicesActive_ = !isMissingDeviceOrHasError_;
+    allDevicesMissing_ = isMissingDeviceOrHasError_.load();
+
+    return !(isMissingDeviceOrHasError_ || hasBusError_);
+}
+
+bool IsoTpBus::initializeInterface() {
+    const IsoTpBusOptions* options = static_cast<const IsoTpBusOptions*>(options_.get());
+    const char* interface = options->name_.c_str();
+
+    socket_ = socket(PF_CAN, SOCK_DGRAM, CAN_ISOTP);
+    if(socket_ < 0) {
+        MELO_FATAL("Opening ISO-TP channel %s failed (is the can-isotp module loaded?): (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    struct ifreq ifr;
+    strcpy(ifr.ifr_name, interface);
+    if(ioctl(socket_, SIOCGIFINDEX, &ifr) != 0) {
+        MELO_FATAL("Unknown CAN interface %s: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    // padding
+    struct can_isotp_options isotpOptions;
+    memset(&isotpOptions, 0, sizeof(isotpOptions));
+    isotpOptions.frame_txtime = CAN_ISOTP_DEFAULT_FRAME_TXTIME;
+    isotpOptions.txpad_content = options->paddingContent_;
+    isotpOptions.rxpad_content = options->paddingContent_;
+    if(options->txPadding_) {
+        isotpOptions.flags |= CAN_ISOTP_TX_PADDING;
+    }
+    if(options->rxPaddingCheck_) {
+        isotpOptions.flags |= CAN_ISOTP_RX_PADDING | CAN_ISOTP_CHK_PAD_LEN | CAN_ISOTP_CHK_PAD_DATA;
+    }
+    if(setsockopt(socket_, SOL_CAN_ISOTP, CAN_ISOTP_OPTS, &isotpOptions, sizeof(isotpOptions)) != 0) {
+        MELO_ERROR("Failed to set ISO-TP options on interface %s: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    // flow control sent to the transmitter of received PDUs
+    struct can_isotp_fc_options flowControl;
+    flowControl.bs = options->blockSize_;
+    flowControl.stmin = options->stMin_;
+    flowControl.wftmax = options->maxWaitFrames_;
+    if(setsockopt(socket_, SOL_CAN_ISOTP, CAN_ISOTP_RECV_FC, &flowControl, sizeof(flowControl)) != 0) {
+        MELO_ERROR("Failed to set ISO-TP flow control options on interface %s: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    // CAN FD, the frame flags are only set if the interface takes CAN FD frames
+    if(options->canFdFrames_) {
+        if(ioctl(socket_, SIOCGIFMTU, &ifr) != 0 || ifr.ifr_mtu != CANFD_MTU) {
+            MELO_ERROR("Interface %s is not configured for CAN FD, cannot use CAN FD frames for ISO-TP.", interface);
+            return false;
+        }
+
+        struct can_isotp_ll_options linkLayer;
+        memset(&linkLayer, 0, sizeof(linkLayer));
+        linkLayer.mtu = CANFD_MTU;
+        linkLayer.tx_dl = CANFD_MAX_DLEN;
+        linkLayer.tx_flags = options->bitRateSwitch_ ? CANFD_BRS : 0;
+        if(setsockopt(socket_, SOL_CAN_ISOTP, CAN_ISOTP_LL_OPTS, &linkLayer, sizeof(linkLayer)) != 0) {
+            MELO_ERROR("Failed to enable CAN FD frames for ISO-TP on interface %s: (%d)\n  %s", interface, errno, strerror(errno));
+            return false;
+        }
+    }
+
+    // set read timeout
+    if (options_->readTimeout_.tv_sec != 0 || options_->readTimeout_.tv_usec != 0) {
+        if(setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &options->readTimeout_, sizeof(options->readTimeout_)) != 0) {
+            MELO_WARN("Failed to set read timeout: (%d)\n  %s", errno, strerror(errno));
+        }
+    }
+
+    // set write timeout
+    if (options_->writeTimeout_.tv_sec != 0 || options_->writeTimeout_.tv_usec != 0) {
+        if(setsockopt(socket_, SOL_SOCKET, SO_SNDTIMEO, &options->writeTimeout_, sizeof(options->writeTimeout_)) != 0) {
+            MELO_WARN("Failed to set write timeout: (%d)\n  %s", errno, strerror(errno));
+        }
+    }
+
+    // set nonblocking flags for synchronous mode
+    if(!isAsynchronous()) {
+        recvFlag_ = MSG_DONTWAIT;
+        if(!options_->synchronousBlockingWrite_) {
+            sendFlag_ = MSG_DONTWAIT;
+        }
+    }
+
+    // the buffer is allocated once, a received PDU is copied into a GenericMsg of its length
+    receiveBuffer_.resize(options->maxPduLength_);
+
+    /* bind socket */
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(struct sockaddr_can));
+    addr.can_family  = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    addr.can_addr.tp.tx_id = options->txId_;
+    addr.can_addr.tp.rx_id = options->rxId_;
+    if(bind(socket_, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        MELO_FATAL("Error in socket %s bind: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    MELO_INFO("Opened ISO-TP socket %s (tx id 0x%x, rx id 0x%x).", interface, options->txId_, options->rxId_);
+
+    return true;
+}
+
+bool IsoTpBus::readData() {
+    // the kernel delivers a complete PDU per recv. With MSG_TRUNC it returns the length of the PDU even if it did not
+    // fit into the buffer.
+    struct iovec iov;
+    iov.iov_base = receiveBuffer_.data();
+    iov.iov_len = receiveBuffer_.size();
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    const ssize_t bytesRead = recvmsg(socket_, &message, recvFlag_ | MSG_TRUNC);
+
+    if(bytesRead <= 0) {
+        if(errno != EAGAIN && errno != EWOULDBLOCK) {
+            // ECOMM, EILSEQ, EBADMSG etc. report a failed reception of a single PDU
+            MELO_ERROR_THROTTLE(options_->errorThrottleTime_, "Failed to read PDU from ISO-TP bus %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
+            hasBusError_ = true;
+        }else{
+            hasBusError_ = false;
+        }
+        return false;
+    }
+
+    hasBusError_ = false;
+    deviceTimeoutCounter_ = 0;
+
+    // a partial PDU is not passed on
+    if((message.msg_flags & MSG_TRUNC) != 0 || static_cast<std::size_t>(bytesRead) > receiveBuffer_.size()) {
+        numTruncatedPdus_.fetch_add(1, std::memory_order_relaxed);
+        MELO_ERROR_THROTTLE(options_->errorThrottleTime_, "Dropped PDU of %zd bytes on ISO-TP bus %s, longer than the maximum PDU length of %zu bytes.",
+                            bytesRead, options_->name_.c_str(), receiveBuffer_.size());
+        return true;
+    }
+
+    handleMessage( tcan::GenericMsg(static_cast<unsigned int>(bytesRead), receiveBuffer_.data()) );
+    return true;
+}
+
+bool IsoTpBus::writeData(std::unique_lock<std::mutex>* lock) {
+    const tcan::GenericMsg msg = outgoingMsgs_.front();
+    if(lock != nullptr) {
+        lock->unlock();
+    }
+
+    // returns once the PDU is queued for segmentation, or blocks while the previous PDU is still transmitted
+    const ssize_t ret = send(socket_, msg.getData(), msg.getLength(), sendFlag_);
+
+    if(lock != nullptr) {
+        lock->lock();
+    }
+
+    if( ret != static_cast<ssize_t>(msg.getLength())) {
+        const int error = errno;
+        if(error != EAGAIN && error != EWOULDBLOCK) {
+            MELO_ERROR("Error at sending PDU on ISO-TP bus %s (return value=%zd, length=%u): (%d)\n  %s", options_->name_.c_str(), ret, msg.getLength(), error, strerror(error));
+            hasBusError_ = true;
+            if(error == EMSGSIZE) {
+                // the PDU is too long for ISO-TP, it will never be sent
+                outgoingMsgs_.pop_front();
+            }
+        }else{
+            hasBusError_ = false;
+        }
+        return false;
+    }
+
+    hasBusError_ = false;
+    outgoingMsgs_.pop_front();
+    return true;
+}
+
+} /* namespace tcan_can */
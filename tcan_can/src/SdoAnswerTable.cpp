@@ -0,0 +1,117 @@
+#include <cstring>
+
+#include "tcan_can/SdoAnswerTable.hpp"
+#include "tcan/helper_functions.hpp"
+
+namespace tcan_can {
+
+constexpr uint32_t SdoAnswerTable::EmptyKey;
+constexpr uint32_t SdoAnswerTable::HasAnswer;
+constexpr uint32_t SdoAnswerTable::Version;
+
+SdoAnswerTable::SdoAnswerTable(const std::size_t capacity):
+    mask_(tcan::roundUpToPowerOfTwo(capacity) - 1),
+    slots_(new Slot[mask_ + 1])
+{
+    for(uint32_t i = 0; i <= mask_; ++i) {
+        slots_[i].state_ = makeState(EmptyKey, 0, false);
+        slots_[i].data_ = 0;
+    }
+}
+
+bool SdoAnswerTable::store(const uint32_t key, const uint8_t* data) {
+    Slot* slot = findOrBind(key);
+    if(slot == nullptr) {
+        return false;
+    }
+
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    slot->data_.store(value, std::memory_order_release);
+    // only this thread changes the key and the version, readers only clear HasAnswer
+    const uint64_t state = slot->state_.load(std::memory_order_relaxed);
+    slot->state_.store(makeState(key, static_cast<uint32_t>(state) + Version, true), std::memory_order_release);
+    return true;
+}
+
+bool SdoAnswerTable::take(const uint32_t key, uint8_t* data) {
+    Slot* slot = find(key);
+    if(slot == nullptr) {
+        return false;
+    }
+
+    uint64_t state = slot->state_.load(std::memory_order_acquire);
+    while(getKey(state) == key && (state & HasAnswer)) {
+        // an answer stored meanwhile changes the state, the newer answer is taken then
+        const uint64_t value = slot->data_.load(std::memory_order_acquire);
+        if(slot->state_.compare_exchange_weak(state, state & ~static_cast<uint64_t>(HasAnswer), std::memory_order_acq_rel)) {
+            std::memcpy(data, &value, sizeof(value));
+            return true;
+        }
+    }
+    return false;
+}
+
+void SdoAnswerTable::erase(const uint32_t key) {
+    Slot* slot = find(key);
+    if(slot == nullptr) {
+        return;
+    }
+
+    uint64_t state = slot->state_.load(std::memory_order_relaxed);
+    while(getKey(state) == key && (state & HasAnswer)) {
+        if(slot->state_.compare_exchange_weak(state, state & ~static_cast<uint64_t>(HasAnswer), std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+SdoAnswerTable::Slot* SdoAnswerTable::find(const uint32_t key) {
+    // slots are rebound but never emptied, so probing stops at the first empty slot
+    const uint32_t hash = (key * 2654435761u) >> 8;
+    for(uint32_t i = 0; i <= mask_; ++i) {
+        Slot& slot = slots_[(hash + i) & mask_];
+        const uint32_t slotKey = getKey(slot.state_.load(std::memory_order_acquire));
+        if(slotKey == key) {
+            return &slot;
+        }
+        if(slotKey == EmptyKey) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+SdoAnswerTable::Slot* SdoAnswerTable::findOrBind(const uint32_t key) {
+    const uint32_t hash = (key * 2654435761u) >> 8;
+    Slot* freeSlot = nullptr;
+    for(uint32_t i = 0; i <= mask_; ++i) {
+        Slot& slot = slots_[(hash + i) & mask_];
+        const uint64_t state = slot.state_.load(std::memory_order_acquire);
+        const uint32_t slotKey = getKey(state);
+        if(slotKey == key) {
+            return &slot;
+        }
+        if(slotKey == EmptyKey) {
+            if(freeSlot == nullptr) {
+                freeSlot = &slot;
+            }
+            break;
+        }
+        if(freeSlot == nullptr && !(state & HasAnswer)) {
+            // the answer of the bound key was taken or erased, the slot is reclaimed if the key is not found
+            freeSlot = &slot;
+        }
+    }
+
+    if(freeSlot == nullptr) {
+        return nullptr;
+    }
+
+    // readers only change slots holding an answer, so the slot is rebound without compare and exchange
+    const uint64_t state = freeSlot->state_.load(std::memory_order_relaxed);
+    freeSlot->state_.store(makeState(key, static_cast<uint32_t>(state) + Version, false), std::memory_order_release);
+    return freeSlot;
+}
+
+} /* namespace tcan_can */
@@ -0,0 +1,70 @@
+#include "tcan_can/SdoQueue.hpp"
+#include "tcan/helper_functions.hpp"
+
+namespace tcan_can {
+
+SdoQueue::SdoQueue(const std::size_t capacity):
+    mask_(tcan::roundUpToPowerOfTwo(capacity) - 1),
+    slots_(new Slot[mask_ + 1]),
+    head_{0},
+    tail_{0}
+{
+    for(uint32_t i = 0; i <= mask_; ++i) {
+        // positions of the previous round, so the slots are neither pushed nor sent
+        slots_[i].pushed_ = i - (mask_ + 1);
+        slots_[i].sent_ = i - (mask_ + 1);
+    }
+}
+
+bool SdoQueue::push(const SdoMsg& msg, uint32_t& position) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    do {
+        if(tail - head_.load() > mask_) {
+            return false;
+        }
+    } while(!tail_.compare_exchange_weak(tail, tail + 1));
+
+    Slot& slot = slots_[tail & mask_];
+    slot.msg_ = msg;
+    slot.pushed_.store(tail);
+    position = tail;
+    return true;
+}
+
+bool SdoQueue::peek(uint32_t& position, SdoMsg& msg) const {
+    const uint32_t head = head_.load();
+    if(head == tail_.load()) {
+        return false;
+    }
+
+    const Slot& slot = slots_[head & mask_];
+    if(slot.pushed_.load() != head) {
+        return false;
+    }
+    msg = slot.msg_;
+
+    // the slot is only reused after the front moved on, the copy is valid if it did not
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(head_.load(std::memory_order_relaxed) != head) {
+        return false;
+    }
+    position = head;
+    return true;
+}
+
+bool SdoQueue::claimSend(const uint32_t position) {
+    Slot& slot = slots_[position & mask_];
+    uint32_t sent = slot.sent_.load();
+    return sent != position && slot.sent_.compare_exchange_strong(sent, position);
+}
+
+bool SdoQueue::isSent(const uint32_t position) const {
+    return slots_[position & mask_].sent_.load() == position;
+}
+
+bool SdoQueue::pop(const uint32_t position) {
+    uint32_t expected = position;
+    return head_.compare_exchange_strong(expected, position + 1);
+}
+
+} /* namespace tcan_can */
@@ -0,0 +1,484 @@
+#include <algorithm>
+#include <cstring>
+
+#include "tcan_can/SdoTransfer.hpp"
+
+namespace tcan_can {
+
+constexpr uint32_t SdoTransfer::ToggleError;
+constexpr uint32_t SdoTransfer::TimeoutError;
+constexpr uint32_t SdoTransfer::CommandSpecifierError;
+constexpr uint32_t SdoTransfer::BlockSizeError;
+constexpr uint32_t SdoTransfer::SequenceNumberError;
+constexpr uint32_t SdoTransfer::CrcError;
+constexpr uint32_t SdoTransfer::OutOfMemoryError;
+constexpr uint32_t SdoTransfer::LengthError;
+constexpr uint32_t SdoTransfer::GeneralError;
+constexpr uint8_t SdoTransfer::MaxBlockSize;
+
+namespace {
+
+//! command byte of an abort request or answer
+constexpr uint8_t AbortCommand = 0x80;
+
+//! number of data bytes of a segment
+constexpr std::size_t SegmentLength = 7;
+
+} /* namespace */
+
+SdoTransfer::SdoTransfer():
+    type_(Type::Upload),
+    state_(State::Idle),
+    requestCobId_(0),
+    index_(0),
+    subIndex_(0),
+    rxBuffer_(nullptr),
+    txData_(nullptr),
+    capacity_(0),
+    offset_(0),
+    size_(0),
+    segmentLength_(0),
+    toggle_(false),
+    crcSupported_(false),
+    blockSize_(MaxBlockSize),
+    sequenceNumber_(0),
+    lastSegment_(false),
+    ending_(false),
+    abortCode_(0),
+    initiateRequest_(0),
+    request_(0),
+    hasRequest_(false)
+{
+}
+
+void SdoTransfer::setup(const Type type, const uint32_t nodeId, const uint16_t index, const uint8_t subIndex) {
+    type_ = type;
+    state_ = State::Initiating;
+    requestCobId_ = 0x600 + nodeId;
+    index_ = index;
+    subIndex_ = subIndex;
+    rxBuffer_ = nullptr;
+    txData_ = nullptr;
+    capacity_ = 0;
+    offset_ = 0;
+    size_ = 0;
+    segmentLength_ = 0;
+    toggle_ = false;
+    crcSupported_ = false;
+    sequenceNumber_ = 0;
+    lastSegment_ = false;
+    ending_ = false;
+    abortCode_ = 0;
+    hasRequest_ = false;
+
+    initiateRequest_ = CanMsg(requestCobId_, 8);
+    initiateRequest_.write(index, 1);
+    initiateRequest_.write(subIndex, 3);
+}
+
+bool SdoTransfer::setupUpload(const uint32_t nodeId, const uint16_t index, const uint8_t subIndex, uint8_t* buffer, const std::size_t capacity,
+                              const bool blockTransfer, const uint8_t blockSize) {
+    if(isBusy() || (blockTransfer && (blockSize == 0 || blockSize > MaxBlockSize))) {
+        return false;
+    }
+
+    setup(blockTransfer ? Type::BlockUpload : Type::Upload, nodeId, index, subIndex);
+    rxBuffer_ = buffer;
+    capacity_ = capacity;
+
+    if(blockTransfer) {
+        // client supports CRC, no protocol switch to segmented upload
+        blockSize_ = blockSize;
+        initiateRequest_.write(static_cast<uint8_t>(0xA4), 0);
+        initiateRequest_.write(blockSize_, 4);
+        initiateRequest_.write(static_cast<uint8_t>(0), 5);
+    }else{
+        initiateRequest_.write(static_cast<uint8_t>(0x40), 0);
+    }
+    return true;
+}
+
+bool SdoTransfer::setupDownload(const uint32_t nodeId, const uint16_t index, const uint8_t subIndex, const uint8_t* data, const std::size_t length,
+                                const bool blockTransfer) {
+    if(isBusy() || length > UINT32_MAX) {
+        return false;
+    }
+
+    setup(blockTransfer ? Type::BlockDownload : Type::Download, nodeId, index, subIndex);
+    txData_ = data;
+    capacity_ = length;
+    size_ = length;
+
+    if(blockTransfer) {
+        // client supports CRC, size indicated
+        initiateRequest_.write(static_cast<uint8_t>(0xC6), 0);
+        initiateRequest_.write(static_cast<uint32_t>(length), 4);
+    }else if(length > 0 && length <= 4) {
+        // expedited, size indicated
+        initiateRequest_.write(static_cast<uint8_t>(0x23 | ((4 - length) << 2)), 0);
+        std::copy(data, data + length, initiateRequest_.getData() + 4);
+    }else{
+        // segmented, size indicated
+        initiateRequest_.write(static_cast<uint8_t>(0x21), 0);
+        initiateRequest_.write(static_cast<uint32_t>(length), 4);
+    }
+    return true;
+}
+
+bool SdoTransfer::handleAnswer(const CanMsg& answer) {
+    if(!isBusy()) {
+        return false;
+    }
+
+    if(answer.readuint8(0) == AbortCommand) {
+        // 0x80 is no valid segment of a block upload either (sequence number 0)
+        if(answer.readuint16(1) != index_ || answer.readuint8(3) != subIndex_) {
+            return false;
+        }
+        abortCode_ = answer.readuint32(4);
+        state_ = State::Aborted;
+        hasRequest_ = false;
+        return true;
+    }
+
+    switch(type_) {
+        case Type::Upload:
+            return handleUploadAnswer(answer);
+        case Type::Download:
+            return handleDownloadAnswer(answer);
+        case Type::BlockUpload:
+            return handleBlockUploadAnswer(answer);
+        case Type::BlockDownload:
+            return handleBlockDownloadAnswer(answer);
+        default:
+            return false;
+    }
+}
+
+bool SdoTransfer::handleUploadAnswer(const CanMsg& answer) {
+    const uint8_t command = answer.readuint8(0);
+
+    if(state_ == State::Initiating) {
+        if(!isInitiateAnswer(answer, 0xE0, 0x40)) {
+            return false;
+        }
+
+        const bool sizeIndicated = (command & 0x01) != 0;
+        if(command & 0x02) {
+            // expedited
+            const std::size_t length = sizeIndicated ? 4 - ((command >> 2) & 0x03) : 4;
+            size_ = sizeIndicated ? length : 0;
+            if(receive(answer.getData() + 4, length)) {
+                finish();
+            }
+            return true;
+        }
+
+        size_ = sizeIndicated ? answer.readuint32(4) : 0;
+        if(size_ > capacity_) {
+            abort(OutOfMemoryError);
+            return true;
+        }
+        state_ = State::Running;
+        setRequest(0x60);
+        return true;
+    }
+
+    // upload segment: t << 4 | n << 1 | c
+    if((command & 0xE0) != 0x00) {
+        abort(CommandSpecifierError);
+        return true;
+    }
+    if(((command & 0x10) != 0) != toggle_) {
+        abort(ToggleError);
+        return true;
+    }
+    if(!receive(answer.getData() + 1, SegmentLength - ((command >> 1) & 0x07))) {
+        return true;
+    }
+
+    if(command & 0x01) {
+        if(size_ != 0 && offset_ != size_) {
+            abort(LengthError);
+        }else{
+            finish();
+        }
+        return true;
+    }
+
+    toggle_ = !toggle_;
+    setRequest(static_cast<uint8_t>(0x60 | (toggle_ ? 0x10 : 0x00)));
+    return true;
+}
+
+bool SdoTransfer::handleDownloadAnswer(const CanMsg& answer) {
+    const uint8_t command = answer.readuint8(0);
+
+    if(state_ == State::Initiating) {
+        if(!isInitiateAnswer(answer, 0xE0, 0x60)) {
+            return false;
+        }
+
+        if(initiateRequest_.readuint8(0) & 0x02) {
+            // expedited download was confirmed
+            offset_ = capacity_;
+            finish();
+            return true;
+        }
+        state_ = State::Running;
+        setDownloadSegment();
+        return true;
+    }
+
+    // download segment answer: 0x20 | t << 4
+    if((command & 0xE0) != 0x20) {
+        abort(CommandSpecifierError);
+        return true;
+    }
+    if(((command & 0x10) != 0) != toggle_) {
+        abort(ToggleError);
+        return true;
+    }
+
+    offset_ += segmentLength_;
+    if(offset_ >= capacity_) {
+        finish();
+        return true;
+    }
+
+    toggle_ = !toggle_;
+    setDownloadSegment();
+    return true;
+}
+
+bool SdoTransfer::handleBlockUploadAnswer(const CanMsg& answer) {
+    const uint8_t command = answer.readuint8(0);
+
+    if(state_ == State::Initiating) {
+        if(!isInitiateAnswer(answer, 0xE1, 0xC0)) {
+            return false;
+        }
+
+        crcSupported_ = (command & 0x04) != 0;
+        size_ = (command & 0x02) ? answer.readuint32(4) : 0;
+        if(size_ > capacity_) {
+            abort(OutOfMemoryError);
+            return true;
+        }
+        state_ = State::Running;
+        setRequest(0xA3); // start upload
+        return true;
+    }
+
+    if(ending_) {
+        // end of block upload: 0xC1 | n << 2, CRC
+        if((command & 0xE3) != 0xC1) {
+            abort(CommandSpecifierError);
+            return true;
+        }
+
+        // offset_ counts all bytes of the received segments, the last one contains n bytes without data
+        const std::size_t unused = (command >> 2) & 0x07;
+        if(unused > offset_ || offset_ - unused > capacity_) {
+            abort(OutOfMemoryError);
+            return true;
+        }
+        offset_ -= unused;
+        if(size_ != 0 && offset_ != size_) {
+            abort(LengthError);
+            return true;
+        }
+        if(crcSupported_ && answer.readuint16(1) != computeCrc(rxBuffer_, offset_)) {
+            abort(CrcError);
+            return true;
+        }
+        setRequest(0xA1); // end
+        finish();
+        return true;
+    }
+
+    // block segment: c << 7 | sequence number
+    const bool isLast = (command & 0x80) != 0;
+    const uint8_t sequenceNumber = static_cast<uint8_t>(command & 0x7F);
+    if(sequenceNumber == sequenceNumber_ + 1 && !lastSegment_) {
+        // the last segment may be filled up beyond the size of the object
+        const std::size_t length = std::min(SegmentLength, capacity_ - std::min(offset_, capacity_));
+        if(length < SegmentLength && !isLast) {
+            abort(OutOfMemoryError);
+            return true;
+        }
+        if(length != 0) {
+            std::memcpy(rxBuffer_ + offset_, answer.getData() + 1, length);
+        }
+        offset_ += SegmentLength;
+        sequenceNumber_ = sequenceNumber;
+        lastSegment_ = isLast;
+    }
+    // segments out of order are dropped, the server repeats them in the next block
+
+    if(isLast || sequenceNumber == blockSize_) {
+        setRequest(0xA2);
+        request_.write(sequenceNumber_, 1);
+        request_.write(blockSize_, 2);
+        sequenceNumber_ = 0;
+        ending_ = lastSegment_;
+    }
+    return true;
+}
+
+bool SdoTransfer::handleBlockDownloadAnswer(const CanMsg& answer) {
+    const uint8_t command = answer.readuint8(0);
+
+    if(state_ == State::Initiating) {
+        if(!isInitiateAnswer(answer, 0xE3, 0xA0)) {
+            return false;
+        }
+
+        crcSupported_ = (command & 0x04) != 0;
+        blockSize_ = answer.readuint8(4);
+        if(blockSize_ == 0 || blockSize_ > MaxBlockSize) {
+            abort(BlockSizeError);
+            return true;
+        }
+        state_ = State::Running;
+        return true;
+    }
+
+    if(ending_) {
+        // end of block download confirmed
+        if(command != 0xA1) {
+            abort(CommandSpecifierError);
+            return true;
+        }
+        finish();
+        return true;
+    }
+
+    // block acknowledge: 0xA2, last sequence number received, block size of the next block
+    if(command != 0xA2) {
+        abort(CommandSpecifierError);
+        return true;
+    }
+    const uint8_t acknowledged = answer.readuint8(1);
+    if(acknowledged > sequenceNumber_) {
+        abort(SequenceNumberError);
+        return true;
+    }
+    const bool isComplete = lastSegment_ && acknowledged == sequenceNumber_;
+    offset_ = isComplete ? capacity_ : offset_ + acknowledged * SegmentLength;
+    sequenceNumber_ = 0;
+    lastSegment_ = false;
+
+    if(isComplete) {
+        // end: 0xC1 | n << 2, CRC
+        ending_ = true;
+        setRequest(static_cast<uint8_t>(0xC1 | ((SegmentLength - segmentLength_) << 2)));
+        request_.write(crcSupported_ ? computeCrc(txData_, capacity_) : static_cast<uint16_t>(0), 1);
+        return true;
+    }
+
+    blockSize_ = answer.readuint8(2);
+    if(blockSize_ == 0 || blockSize_ > MaxBlockSize) {
+        abort(BlockSizeError);
+    }
+    return true;
+}
+
+bool SdoTransfer::getNextRequest(CanMsg& request) {
+    if(hasRequest_) {
+        hasRequest_ = false;
+        request = request_;
+        return true;
+    }
+
+    if(type_ == Type::BlockDownload && state_ == State::Running && !ending_) {
+        return getBlockSegment(request);
+    }
+    return false;
+}
+
+bool SdoTransfer::getBlockSegment(CanMsg& request) {
+    if(lastSegment_ || sequenceNumber_ >= blockSize_) {
+        // wait for the acknowledge of the block
+        return false;
+    }
+
+    const std::size_t position = offset_ + sequenceNumber_ * SegmentLength;
+    const std::size_t length = std::min(SegmentLength, capacity_ - position);
+    ++sequenceNumber_;
+    lastSegment_ = (position + length >= capacity_);
+    if(lastSegment_) {
+        segmentLength_ = length;
+    }
+
+    request = CanMsg(requestCobId_, 8);
+    request.write(static_cast<uint8_t>((lastSegment_ ? 0x80 : 0x00) | sequenceNumber_), 0);
+    std::copy(txData_ + position, txData_ + position + length, request.getData() + 1);
+    return true;
+}
+
+void SdoTransfer::abort(const uint32_t abortCode, const bool sendRequest) {
+    if(!isBusy()) {
+        return;
+    }
+
+    abortCode_ = abortCode;
+    state_ = State::Aborted;
+    hasRequest_ = false;
+    if(sendRequest) {
+        setRequest(AbortCommand);
+        request_.write(index_, 1);
+        request_.write(subIndex_, 3);
+        request_.write(abortCode, 4);
+    }
+}
+
+bool SdoTransfer::isInitiateAnswer(const CanMsg& answer, const uint8_t mask, const uint8_t command) const {
+    if(answer.readuint16(1) != index_ || answer.readuint8(3) != subIndex_) {
+        return false;
+    }
+    return (answer.readuint8(0) & mask) == command;
+}
+
+bool SdoTransfer::receive(const uint8_t* data, const std::size_t length) {
+    if(offset_ + length > capacity_) {
+        abort(OutOfMemoryError);
+        return false;
+    }
+    if(length != 0) {
+        std::memcpy(rxBuffer_ + offset_, data, length);
+    }
+    offset_ += length;
+    return true;
+}
+
+void SdoTransfer::setRequest(const uint8_t command) {
+    request_ = CanMsg(requestCobId_, 8);
+    request_.write(command, 0);
+    hasRequest_ = true;
+}
+
+void SdoTransfer::setDownloadSegment() {
+    segmentLength_ = std::min(SegmentLength, capacity_ - offset_);
+    const bool isLast = (offset_ + segmentLength_ >= capacity_);
+
+    // download segment: t << 4 | n << 1 | c
+    setRequest(static_cast<uint8_t>((toggle_ ? 0x10 : 0x00) | ((SegmentLength - segmentLength_) << 1) | (isLast ? 0x01 : 0x00)));
+    std::copy(txData_ + offset_, txData_ + offset_ + segmentLength_, request_.getData() + 1);
+}
+
+void SdoTransfer::finish() {
+    state_ = State::Done;
+}
+
+uint16_t SdoTransfer::computeCrc(const uint8_t* data, const std::size_t length, uint16_t crc) {
+    for(std::size_t i = 0; i < length; ++i) {
+        crc = static_cast<uint16_t>(crc ^ (static_cast<uint16_t>(data[i]) << 8));
+        for(int bit = 0; bit < 8; ++bit) {
+            crc = static_cast<uint16_t>((crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1));
+        }
+    }
+    return crc;
+}
+
+} /* namespace tcan_can */
@@ -1,5 +1,6 @@
 #include <sys/socket.h>
 #include <linux/can.h>
+#include <linux/sockios.h>
 #include <linux/can/raw.h>
 #include <linux/can/error.h>
 #include <net/if.h>
@@ -7,14 +8,29 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 
 #include "tcan_can/SocketBus.hpp"
+#include "tcan_can/CanFilterCalculator.hpp"
 
 #include "message_logger/message_logger.hpp"
-#include <sstream>
+#include <algorithm>
+#include <thread>
 
 namespace tcan_can {
 
+static_assert(sizeof(CanMsg) == CANFD_MTU && CanMsg::HeaderSize == offsetof(canfd_frame, data), "CanMsg shall match the layout of canfd_frame");
+static_assert(CanMsg::BitRateSwitch == CANFD_BRS && CanMsg::ErrorStateIndicator == CANFD_ESI, "CanMsg flags shall match canfd_frame flags");
+static_assert(CanBusError::TxTimeout == CAN_ERR_TX_TIMEOUT && CanBusError::LostArbitration == CAN_ERR_LOSTARB && CanBusError::Controller == CAN_ERR_CRTL &&
+              CanBusError::Protocol == CAN_ERR_PROT && CanBusError::Transceiver == CAN_ERR_TRX && CanBusError::NoAck == CAN_ERR_ACK &&
+              CanBusError::BusOff == CAN_ERR_BUSOFF && CanBusError::BusError == CAN_ERR_BUSERROR && CanBusError::Restarted == CAN_ERR_RESTARTED,
+              "CanBusError classes shall match the classes of socketcan error frames");
+
+#ifdef CANXL_XLF
+static_assert(sizeof(CanXlMsg) == CANXL_MTU && CanXlMsg::HeaderSize == CANXL_HDR_SIZE, "CanXlMsg shall match the layout of canxl_frame");
+static_assert(CanXlMsg::Xl == CANXL_XLF && CanXlMsg::SimpleExtendedContent == CANXL_SEC, "CanXlMsg flags shall match canxl_frame flags");
+#endif
+
 SocketBus::SocketBus(const std::string& interface):
     SocketBus(std::unique_ptr<SocketBusOptions>(new SocketBusOptions(interface)))
 {
@@ -22,16 +38,42 @@ SocketBus::SocketBus(const std::string& interface):
 
 SocketBus::SocketBus(std::unique_ptr<SocketBusOptions>&& options):
     CanBus(std::move(options)),
-    socket_(-1),
+    socket_(std::unique_ptr<int>(new int(-1))),
+    interfaceIndex_{0},
     recvFlag_(0),
-    sendFlag_(0)
+    sendFlag_(0),
+    isXlEnabled_{false},
+    xlReceiveMsg_(0),
+    xlHandlers_(std::unique_ptr<XlHandlerContainer>(new XlHandlerContainer())),
+    isTxCalibrated_{false},
+    txWindowStart_(),
+    txWindowFrames_(0),
+    isTxWindowCongested_(false),
+    txCapacity_{0.0},
+    numTxCongestions_{0},
+    linkMonitor_(),
+    linkThread_(),
+    isLinkThreadRunning_{false},
+    isPassivatedOnBusOff_{false},
+    controllerState_(CanLinkMonitor::ControllerState::Unknown),
+    busOffTime_(),
+    lastRestartTime_(),
+    busOffRestartDelay_(0),
+    numControllerRestarts_{0}
 {
 }
 
 SocketBus::~SocketBus()
 {
+    isLinkThreadRunning_ = false;
+    if(linkThread_.joinable()) {
+        linkThread_.join();
+    }
     stopThreads();
-    close(socket_);
+    const int socket = *socket_.read();
+    if(socket >= 0) {
+        close(socket);
+    }
 }
 
 bool SocketBus::initializeInterface()
@@ -39,45 +81,114 @@ bool SocketBus::initializeInterface()
     const SocketBusOptions* options = static_cast<const SocketBusOptions*>(options_.get());
     const char* interface = options->name_.c_str();
 
-    /* open socket */
-    socket_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
-    if(socket_ < 0) {
-        MELO_FATAL("Opening CAN channel %s failed: %d", interface, socket_);
+    // set nonblocking flags for synchronous mode
+    if(!isAsynchronous()) {
+        recvFlag_ = MSG_DONTWAIT;
+        if(!options_->synchronousBlockingWrite_) {
+            sendFlag_ = MSG_DONTWAIT;
+        }
+    }
+
+    // link monitor, kept when the socket is reopened
+    if(options->monitorLink_ && !linkMonitor_) {
+        busOffRestartDelay_ = options->busOffRestartDelay_;
+        linkMonitor_.reset(new CanLinkMonitor(options->name_));
+        if(!linkMonitor_->open()) {
+            MELO_WARN("Failed to monitor the link of bus %s.", interface);
+            linkMonitor_.reset();
+        }
+    }
+
+    int interfaceIndex = 0;
+    bool isXlEnabled = false;
+    const int socket = openSocket(interfaceIndex, isXlEnabled);
+    if(socket >= 0) {
+        socket_.update([socket](int& fd) { fd = socket; });
+        isXlEnabled_ = isXlEnabled;
+        interfaceIndex_.store(interfaceIndex, std::memory_order_release);
+        MELO_INFO("Opened socket %s.", interface);
+    }else if(linkMonitor_ && if_nametoindex(interface) == 0) {
+        // checkLink() opens the socket once the interface is added
+        MELO_WARN("Interface of bus %s does not exist, waiting for it to be added.", interface);
+    }else{
         return false;
     }
 
+    if(linkMonitor_ && isAsynchronous() && !isLinkThreadRunning_) {
+        isLinkThreadRunning_ = true;
+        linkThread_ = std::thread(&SocketBus::linkWorker, this);
+    }
+
+    return true;
+}
+
+int SocketBus::openSocket(int& interfaceIndex, bool& isXlEnabled)
+{
+    const SocketBusOptions* options = static_cast<const SocketBusOptions*>(options_.get());
+    const char* interface = options->name_.c_str();
+
+    /* open socket */
+    const int socket = ::socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if(socket < 0) {
+        MELO_FATAL("Opening CAN channel %s failed: %d", interface, socket);
+        return -1;
+    }
+
 
     /* configure socket */
     struct ifreq ifr;
     strcpy(ifr.ifr_name, interface);
-    ioctl(socket_, SIOCGIFINDEX, &ifr);
+    if(ioctl(socket, SIOCGIFINDEX, &ifr) != 0) {
+        MELO_ERROR("Failed to get index of interface %s: (%d)\n  %s", interface, errno, strerror(errno));
+        close(socket);
+        return -1;
+    }
 
-    // loopback
-    int loopback = options->loopback_;
-    if(setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_LOOPBACK, &loopback, sizeof(loopback)) != 0) {
+    // loopback. The frames of a bus with shared receive would be looped back to the socket of the SocketBusReceiver.
+    if(options->loopback_ && options->sharedReceive_) {
+        MELO_WARN("Loopback is disabled on bus %s, which shares reception with other buses.", interface);
+    }
+    int loopback = options->loopback_ && !options->sharedReceive_;
+    if(setsockopt(socket, SOL_CAN_RAW, CAN_RAW_LOOPBACK, &loopback, sizeof(loopback)) != 0) {
         MELO_WARN("Failed to set loopback mode");
         perror("setsockopt");
     }
 
     // receive own messages
     int recv_own_msgs = 0; /* 0 = disabled (default), 1 = enabled */
-    if(setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &recv_own_msgs, sizeof(recv_own_msgs)) != 0) {
+    if(setsockopt(socket, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &recv_own_msgs, sizeof(recv_own_msgs)) != 0) {
     	MELO_WARN("Failed to set reception of own messages option: (%d)\n  %s", errno, strerror(errno));
     }
 
-    // CAN error handling
-    can_err_mask_t err_mask = options->canErrorMask_;
-    if(setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &err_mask, sizeof(err_mask)) != 0) {
+    // CAN FD
+    if(options->canFdFrames_) {
+        int enableCanFd = 1;
+        if(setsockopt(socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enableCanFd, sizeof(enableCanFd)) != 0) {
+            MELO_ERROR("Failed to enable CAN FD frames on interface %s: (%d)\n  %s", interface, errno, strerror(errno));
+            close(socket);
+            return -1;
+        }
+    }
+
+    // CAN XL
+    isXlEnabled = false;
+    if(options->canXlFrames_ && !options->sharedReceive_) {
+        isXlEnabled = enableXlFrames(socket);
+    }
+
+    // CAN error handling. Error frames of a bus with shared receive are received by the SocketBusReceiver.
+    can_err_mask_t err_mask = options->sharedReceive_ ? 0 : options->canErrorMask_;
+    if(setsockopt(socket, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &err_mask, sizeof(err_mask)) != 0) {
     	MELO_WARN("Failed to set error mask: (%d)\n  %s", errno, strerror(errno));
     }
 
     // get default bufer sizes
 //    int buf_size;
 //    socklen_t len;
-//    getsockopt(socket_, SOL_SOCKET, SO_SNDBUF, &buf_size, &len);
+//    getsockopt(socket, SOL_SOCKET, SO_SNDBUF, &buf_size, &len);
 //    printf("sndbuf size: %d (%d)\n", buf_size, len);
 //
-//    getsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &buf_size, &len);
+//    getsockopt(socket, SOL_SOCKET, SO_RCVBUF, &buf_size, &len);
 //    printf("rcvbuf size: %d (%d)\n", buf_size, len);
 
     // On some CAN drivers, the txqueuelen of the netdevice cannot be changed (default=10).
@@ -85,24 +196,34 @@ bool SocketBus::initializeInterface()
     // This renders poll(..) useless. Not the writes in the sockets are the limiting pipe but the writes in the underlying netdevice.
     // The recommended way to fix this is to increase the txqueuelen of the netdevice (e.g. command line: ip link set can0 txqueuelen 1000)
     // If this is not possible, the sndbuf size of the socket can be decrease, such that the socket writes are the limiting pipe, leading to blocking socket write(..) calls. (write becomes poll(..)-able)
+    // SocketBusOptions::adaptiveTxPacing_ does this automatically, calibrating the sndbuf on the first ENOBUFS error.
     // https://www.mail-archive.com/socketcan-users@lists.berlios.de/msg00787.html
     // http://socket-can.996257.n3.nabble.com/Solving-ENOBUFS-returned-by-write-td2886.html
     if(options->sndBufLength_ != 0) {
-        if(setsockopt(socket_, SOL_SOCKET, SO_SNDBUF, &(options->sndBufLength_), sizeof(options->sndBufLength_)) != 0) {
+        if(setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &(options->sndBufLength_), sizeof(options->sndBufLength_)) != 0) {
         	MELO_WARN("Failed to set sndBuf length: (%d)\n  %s", errno, strerror(errno));
         }
     }
 
-    // set read timeout
-    if (options_->readTimeout_.tv_sec != 0 || options_->readTimeout_.tv_usec != 0) {
-      if(setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, (char*)&options_->readTimeout_, sizeof(options->readTimeout_)) != 0) {
+    // set read timeout. With link monitoring, the receive thread shall not block forever on the socket of a removed
+    // interface, which would block reopenSocket().
+    struct timeval readTimeout = options_->readTimeout_;
+    if(options->monitorLink_ && isAsynchronous()) {
+        const auto linkCheckInterval = getLinkCheckInterval().count();
+        if((readTimeout.tv_sec == 0 && readTimeout.tv_usec == 0) || readTimeout.tv_sec * 1000 + readTimeout.tv_usec / 1000 > linkCheckInterval) {
+            readTimeout.tv_sec = linkCheckInterval / 1000;
+            readTimeout.tv_usec = (linkCheckInterval % 1000) * 1000;
+        }
+    }
+    if (readTimeout.tv_sec != 0 || readTimeout.tv_usec != 0) {
+      if(setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, (char*)&readTimeout, sizeof(readTimeout)) != 0) {
           MELO_WARN("Failed to set read timeout: (%d)\n  %s", errno, strerror(errno));
       }
     }
 
     // set write timeout
     if (options_->writeTimeout_.tv_sec != 0 || options_->writeTimeout_.tv_usec != 0) {
-      if(setsockopt(socket_, SOL_SOCKET, SO_SNDTIMEO, (char*)&options_->writeTimeout_, sizeof(options->writeTimeout_)) != 0) {
+      if(setsockopt(socket, SOL_SOCKET, SO_SNDTIMEO, (char*)&options_->writeTimeout_, sizeof(options->writeTimeout_)) != 0) {
           MELO_WARN("Failed to set write timeout: (%d)\n  %s", errno, strerror(errno));
       }
     }
@@ -110,49 +231,202 @@ bool SocketBus::initializeInterface()
 
 
     // set up filters
-    if(options->canFilters_.size() != 0) {
-        if(setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FILTER, &(options->canFilters_[0]), sizeof(can_filter)*options->canFilters_.size()) != 0) {
-            MELO_WARN("Failed to set CAN raw filters: (%d)\n  %s", errno, strerror(errno));
-        }
-    }
-
-    // set nonblocking flags for synchronous mode
-    if(!isAsynchronous()) {
-        recvFlag_ = MSG_DONTWAIT;
-        if(!options_->synchronousBlockingWrite_) {
-            sendFlag_ = MSG_DONTWAIT;
-        }
-    }
+    applyCanFilters(socket);
 
     /* bind socket */
     struct sockaddr_can addr;
     memset(&addr, 0, sizeof(struct sockaddr_can));
     addr.can_family  = AF_CAN;
     addr.can_ifindex = ifr.ifr_ifindex;
-    if(bind(socket_, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    if(bind(socket, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
         MELO_FATAL("Error in socket %s bind: (%d)\n  %s", interface, errno, strerror(errno));
+        close(socket);
+        return -1;
+    }
+
+    interfaceIndex = ifr.ifr_ifindex;
+    return socket;
+}
+
+
+bool SocketBus::applyCanFilters(const int socket) {
+    const SocketBusOptions* options = static_cast<const SocketBusOptions*>(options_.get());
+
+    if(socket < 0) {
+        // filters are applied in initializeInterface()
+        return true;
+    }
+
+    if(options->sharedReceive_) {
+        // the socket only transmits, an empty filter set disables the reception of all frames
+        if(setsockopt(socket, SOL_CAN_RAW, CAN_RAW_FILTER, nullptr, 0) != 0) {
+            MELO_WARN("Failed to disable reception on bus %s: (%d)\n  %s", options->name_.c_str(), errno, strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    if(!options->autoCanFilters_) {
+        if(options->canFilters_.size() != 0) {
+            if(setsockopt(socket, SOL_CAN_RAW, CAN_RAW_FILTER, &(options->canFilters_[0]), sizeof(can_filter)*options->canFilters_.size()) != 0) {
+                MELO_WARN("Failed to set CAN raw filters: (%d)\n  %s", errno, strerror(errno));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<CanFrameIdentifier> matchers = dispatchTable_.read()->getMatchers();
+    for(const can_filter& filter : options->canFilters_) {
+        matchers.emplace_back(filter.can_id, filter.can_mask);
+    }
+    const std::vector<can_filter> filters = computeCanFilters(matchers, options->maxNumCanFilters_);
+
+    // an empty filter set disables the reception of all (non-error) frames
+    if(setsockopt(socket, SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(), sizeof(can_filter)*filters.size()) != 0) {
+        MELO_WARN("Failed to set %zu automatic CAN raw filters on bus %s: (%d)\n  %s", filters.size(), options->name_.c_str(), errno, strerror(errno));
         return false;
     }
+    return true;
+}
 
-    MELO_INFO("Opened socket %s.", interface);
+void SocketBus::onSubscriptionsChanged() {
+    if(static_cast<const SocketBusOptions*>(options_.get())->autoCanFilters_) {
+        const auto socket = socket_.read();
+        applyCanFilters(*socket);
+    }
+}
+
+bool SocketBus::enableXlFrames(const int socket) {
+#ifdef CANXL_XLF
+    const char* interface = options_->name_.c_str();
+
+    int enableCanXl = 1;
+    if(setsockopt(socket, SOL_CAN_RAW, CAN_RAW_XL_FRAMES, &enableCanXl, sizeof(enableCanXl)) != 0) {
+        MELO_ERROR("Failed to enable CAN XL frames on interface %s: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    // the socket accepts CAN XL frames also if the interface does not, check the MTU of the interface
+    struct ifreq ifr;
+    strcpy(ifr.ifr_name, interface);
+    if(ioctl(socket, SIOCGIFMTU, &ifr) != 0 || ifr.ifr_mtu < static_cast<int>(CANXL_MIN_MTU)) {
+        MELO_ERROR("Interface %s does not support CAN XL frames (mtu=%d)", interface, ifr.ifr_mtu);
+        return false;
+    }
+
+    return true;
+#else
+    MELO_ERROR("CAN XL frames are not supported by the kernel headers tcan_can was compiled with");
+    return false;
+#endif
+}
+
+bool SocketBus::sendMessageDirectly(const CanMsg& msg) {
+    if(msg.isFd() || msg.getLength() > CAN_MAX_DLEN) {
+        return CanBus::sendMessageDirectly(msg);
+    }
+    if(isPassive_) {
+        return false;
+    }
+
+    // CanMsg has the memory layout of a canfd_frame, the flags are not sent in classic frames
+    CanMsg cmsg(msg);
+    cmsg.setFlags(0);
+    const auto socket = socket_.read();
+    if(*socket < 0) {
+        return false;
+    }
+    const ssize_t ret = send(*socket, &cmsg, CAN_MTU, sendFlag_);
+    if(ret != CAN_MTU) {
+        if(errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+            MELO_ERROR_THROTTLE(options_->errorThrottleTime_, "Error at sending CAN message %x directly on bus %s (return value=%zd): (%d)\n  %s",
+                                cmsg.getCobId(), options_->name_.c_str(), ret, errno, strerror(errno));
+            hasBusError_ = true;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool SocketBus::sendXlMessage(const CanXlMsg& msg) {
+    if(!isXlEnabled_) {
+        MELO_ERROR("Cannot send CAN XL message %x on bus %s: CAN XL frames are not enabled", msg.getPriority(), options_->name_.c_str());
+        return false;
+    }
+
+    // CanXlMsg has the memory layout of a canxl_frame
+    const ssize_t size = static_cast<ssize_t>(CanXlMsg::HeaderSize + msg.getLength());
+    const ssize_t ret = send(*socket_.read(), &msg, size, sendFlag_);
+    if(ret != size) {
+        // a full netdevice queue (ENOBUFS) is no bus error, the caller may retry
+        if(errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+            MELO_ERROR("Error at sending CAN XL message %x on bus %s (return value=%zd): (%d)\n  %s", msg.getPriority(), options_->name_.c_str(), ret, errno, strerror(errno));
+            hasBusError_ = true;
+        }
+        return false;
+    }
 
     return true;
 }
 
+void SocketBus::handleXlMessage(const CanXlMsg& msg) {
+    errorMsgFlag_ = false;
+
+    bool isHandled = false;
+    const auto handlers = xlHandlers_.read();
+    for(const auto& handler : *handlers) {
+        if(!((msg.getPriority() ^ handler.first.identifier) & handler.first.mask)) {
+            handler.second(msg);
+            isHandled = true;
+        }
+    }
+
+    if(!isHandled) {
+        MELO_INFO_THROTTLE(options_->errorThrottleTime_, "Received CAN XL message on bus %s that is not handled: priority: 0x%03X, acceptance field: 0x%08X, length: %d",
+                           options_->name_.c_str(), msg.getPriority(), msg.getAcceptanceField(), msg.getLength());
+    }
+}
 
 bool SocketBus::readData() {
 
     // In synchronous mode, the socket is non-blocking, so this function returns as soon as there is no data available to be read
     // If asynchronous, we set the socket to blocking and have a separate thread reading from it.
 
-    can_frame frame;
-    const int bytes_read = recv( socket_, &frame, sizeof(struct can_frame), recvFlag_);
+    // CanMsg has the layout of a canfd_frame, which starts with the layout of a can_frame, so frames are received in
+    // place. Classic frames are received with CAN_MTU bytes, also if CAN FD frames are enabled.
+    CanMsg msg(0);
+    const bool isXlEnabled = isXlEnabled_;
+    int bytes_read;
+    {
+        // the snapshot of the socket is only held while reading, reopenSocket() waits for it
+        const auto socket = socket_.read();
+        if(*socket < 0) {
+            // the interface was not added yet
+            if(isAsynchronous()) {
+                std::this_thread::sleep_for(getLinkCheckInterval());
+            }
+            return false;
+        }
+        if(isXlEnabled) {
+            // CAN XL frames are received in place, classic and FD frames are copied to msg below
+            bytes_read = recv( *socket, &xlReceiveMsg_, sizeof(CanXlMsg), recvFlag_);
+        }else{
+            const bool isFdEnabled = static_cast<const SocketBusOptions*>(options_.get())->canFdFrames_;
+            bytes_read = recv( *socket, &msg, isFdEnabled ? CANFD_MTU : CAN_MTU, recvFlag_);
+        }
+    }
     //	printf("CanManager_ bytes read: %i\n", bytes_read);
 
     if(bytes_read <= 0) {
         if(errno != EAGAIN && errno != EWOULDBLOCK) {
             MELO_ERROR("Failed to read data from bus %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
             hasBusError_ = true;
+            if(linkMonitor_ && (errno == ENETDOWN || errno == ENODEV)) {
+                // the interface is down or was removed, wait for checkLink() instead of spinning
+                std::this_thread::sleep_for(getLinkCheckInterval());
+            }
         }else{
             hasBusError_ = false;
         }
@@ -161,36 +435,92 @@ bool SocketBus::readData() {
 //	pintf("CanManager:bus_routine: Data received from iBus %i, n. Bytes: %i \n", iBus, bytes_read);
     hasBusError_ = false;
 
-    if(frame.can_id > CAN_ERR_FLAG && frame.can_id < CAN_RTR_FLAG) {
-        handleBusErrorMessage( frame );
-    }else{
-        handleMessage( CanMsg(frame.can_id, frame.can_dlc, frame.data) );
+    if(isXlEnabled) {
+        // the XL flag shares its position with the length of classic and FD frames, which is at most 64
+        if(xlReceiveMsg_.getFlags() & CanXlMsg::Xl) {
+            handleXlMessage(xlReceiveMsg_);
+            return true;
+        }
+        memcpy(static_cast<void*>(&msg), &xlReceiveMsg_, std::min(static_cast<size_t>(bytes_read), sizeof(msg)));
     }
 
+    handleReceivedFrame(msg, static_cast<std::size_t>(bytes_read));
     return true;
 }
 
+void SocketBus::handleReceivedFrame(CanMsg& msg, const std::size_t numBytes) {
+    if(msg.getCobId() > CAN_ERR_FLAG && msg.getCobId() < CAN_RTR_FLAG) {
+        handleBusErrorMessage( msg );
+    }else if(numBytes == CANFD_MTU) {
+        msg.setFlags(static_cast<uint8_t>(CanMsg::Fd | (msg.getFlags() & (CANFD_BRS | CANFD_ESI))));
+        handleMessage( msg );
+    }else{
+        // the flags are at the position of the padding byte of can_frame
+        msg.setFlags(0);
+        handleMessage( msg );
+    }
+}
+
+bool SocketBus::hasReceiveThread() const {
+    return !static_cast<const SocketBusOptions*>(options_.get())->sharedReceive_;
+}
+
 
 bool SocketBus::writeData(std::unique_lock<std::mutex>* lock) {
 
     CanMsg cmsg = outgoingMsgs_.front();
+    if(cmsg.getLength() > (cmsg.isFd() ? CANFD_MAX_DLEN : CAN_MAX_DLEN) ||
+       (cmsg.isFd() && !static_cast<const SocketBusOptions*>(options_.get())->canFdFrames_)) {
+        MELO_ERROR("Dropping CAN message %x with length %d on bus %s: %s", cmsg.getCobId(), cmsg.getLength(), options_->name_.c_str(),
+                   cmsg.isFd() ? "CAN FD frames are not enabled" : "classic frames carry at most 8 bytes");
+        outgoingMsgs_.pop_front();
+        return false;
+    }
+
     if(lock != nullptr) {
         lock->unlock();
     }
 
-    can_frame frame;
-    frame.can_id = cmsg.getCobId();
-    frame.can_dlc = cmsg.getLength();
-    std::copy(cmsg.getData(), &(cmsg.getData()[frame.can_dlc]), frame.data);
+    // the message is sent in place, after clearing the flags which are not sent
+    int mtu;
+    if(!cmsg.isFd()) {
+        cmsg.setFlags(0);
+        mtu = CAN_MTU;
+    }else{
+        const uint8_t length = CanMsg::getValidFdLength(cmsg.getLength());
+        std::fill(&cmsg.getData()[cmsg.getLength()], &cmsg.getData()[length], 0);
+        cmsg.setLength(length);
+        cmsg.setFlags(cmsg.getFlags() & CANFD_BRS);
+        mtu = CANFD_MTU;
+    }
+    int ret;
+    bool isCongested;
+    {
+        // the snapshot of the socket is only held while sending, reopenSocket() waits for it. Without socket, the message
+        // is kept until the interface is added.
+        const auto socket = socket_.read();
+        if(*socket < 0) {
+            errno = ENODEV;
+            ret = -1;
+        }else{
+            ret = send(*socket, &cmsg, mtu, sendFlag_);
+        }
 
-    const int ret = send(socket_, &frame, sizeof(struct can_frame), sendFlag_);
+        // the netdevice queue is full, wait until it drained instead of retrying in a hot loop
+        isCongested = (ret != mtu && errno == ENOBUFS && static_cast<const SocketBusOptions*>(options_.get())->adaptiveTxPacing_);
+        if(isCongested) {
+            handleTxCongestion(*socket);
+        }
+    }
 
     if(lock != nullptr) {
         lock->lock();
     }
 
-    if( ret != sizeof(struct can_frame) ) {
-        if(errno != EAGAIN && errno != EWOULDBLOCK) {
+    if( ret != mtu ) {
+        if(isCongested) {
+            hasBusError_ = false;
+        }else if(errno != EAGAIN && errno != EWOULDBLOCK) {
             MELO_ERROR("Error at sending CAN message %x on bus %s (return value=%d): (%d)\n  %s", cmsg.getCobId(), options_->name_.c_str(), ret, errno, strerror(errno));
             hasBusError_ = true;
         }else{
@@ -201,263 +531,179 @@ bool SocketBus::writeData(std::unique_lock<std::mutex>* lock) {
 
     hasBusError_ = false;
     outgoingMsgs_.pop_front();
+    if(static_cast<const SocketBusOptions*>(options_.get())->adaptiveTxPacing_) {
+        countSentFrame();
+    }
     return true;
 }
 
-void SocketBus::handleBusErrorMessage(const can_frame& msg) {
-
-    errorMsgFlagPersistent_ = true;
-    errorMsgFlag_ = true;
-
-    if(static_cast<const CanBusOptions*>(options_.get())->passivateOnBusError_) {
-        if(!isPassive_) {
-            MELO_WARN("Bus error on bus %s. This bus is now PASSIVE!", options_->name_.c_str());
+void SocketBus::handleTxCongestion(const int socket) {
+    numTxCongestions_.fetch_add(1, std::memory_order_relaxed);
+    isTxWindowCongested_ = true;
+
+    if(!isTxCalibrated_) {
+        isTxCalibrated_ = true;
+        // the bytes still owned by the socket are the frames in the netdevice queue. A smaller sndbuf makes the socket
+        // the limiting pipe, the kernel doubles the value set.
+        int numBytesInFlight = 0;
+        if(ioctl(socket, SIOCOUTQ, &numBytesInFlight) == 0 && numBytesInFlight > 0) {
+            const int sndBufLength = numBytesInFlight * 3 / 8;
+            if(setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &sndBufLength, sizeof(sndBufLength)) == 0) {
+                MELO_INFO("Bus %s is congested, limited the sndbuf to %d of %d bytes in flight.", options_->name_.c_str(), 2*sndBufLength, numBytesInFlight);
+            }else{
+                MELO_WARN("Failed to calibrate sndBuf length: (%d)\n  %s", errno, strerror(errno));
+            }
         }
-        passivate();
-
     }
 
-    std::stringstream errorMsg;
-    errorMsg << "received bus error frame on bus " << options_->name_ << " (";
-    for (int i = 0; i < 8; i++)
-      errorMsg << " " << int(msg.data[i]);
-    errorMsg << ")";
-    // cob id
-    if(msg.can_id & CAN_ERR_TX_TIMEOUT) {
-      errorMsg << "TX timeout (by netdevice driver). ";
-    }
-    if(msg.can_id & CAN_ERR_LOSTARB) {
-      errorMsg << "lost arbitration. ";
-    }
-    if(msg.can_id & CAN_ERR_CRTL) {
-      errorMsg << "controller problems. ";
-    }
-    if(msg.can_id & CAN_ERR_PROT) {
-      errorMsg << "protocol violations. ";
-    }
-    if(msg.can_id & CAN_ERR_TRX) {
-      errorMsg << "transceiver status. ";
-    }
-    if(msg.can_id & CAN_ERR_ACK) {
-      errorMsg << "received no ACK on transmission. ";
-    }
-    if(msg.can_id & CAN_ERR_BUSOFF) {
-      errorMsg << "bus off. ";
-    }
-    if(msg.can_id & CAN_ERR_BUSOFF) {
-      errorMsg << "bus error (may flood!). ";
-    }
-    if(msg.can_id & CAN_ERR_RESTARTED) {
-      errorMsg << "controller restarted. ";
+    if(!isAsynchronous()) {
+        // the message is retried on the next write
+        return;
     }
 
-    // bit 0
-    errorMsg << "bit number in bitstream: 0x" <<  std::hex << static_cast<int>(msg.data[0]);
-
-    // bit 1
-    switch(msg.data[1]) {
-        default: // fall-through!
-        case CAN_ERR_CRTL_UNSPEC:
-          errorMsg << " / error status of CAN-controller: unspecified";
-            break;
-
-        case CAN_ERR_CRTL_RX_OVERFLOW:
-          errorMsg << " / error status of CAN-controller: rx buffer overflow";
-            break;
-
-        case CAN_ERR_CRTL_TX_OVERFLOW:
-          errorMsg << " / error status of CAN-controller: tx buffer overflow";
-            break;
-
-        case CAN_ERR_CRTL_RX_WARNING:
-          errorMsg << " / error status of CAN-controller: reached warning level for RX errors";
-            break;
-
-        case CAN_ERR_CRTL_TX_WARNING:
-          errorMsg << " / error status of CAN-controller: reached warning level for TX errors";
-            break;
-
-        case CAN_ERR_CRTL_RX_PASSIVE:
-          errorMsg << " / error status of CAN-controller: reached error passive status RX";
-            break;
-
-        case CAN_ERR_CRTL_TX_PASSIVE:
-          errorMsg << " / error status of CAN-controller: reached error passive status TX";
-            break;
+    // with a calibrated sndbuf, POLLOUT signals that the netdevice drained frames
+    struct pollfd fds;
+    fds.fd = socket;
+    fds.events = POLLOUT;
+    fds.revents = 0;
+    // the socket is writable right away if the sndbuf could not be calibrated, wait for the drain time of a frame then
+    if(poll(&fds, 1, 0) > 0) {
+        const double capacity = getTxCapacity();
+        std::this_thread::sleep_for(std::chrono::microseconds(capacity > 0.0 ? static_cast<int64_t>(1e6 / capacity) : 100));
+        return;
     }
 
-    // bit 2
-    switch(msg.data[2]) {
-        default: // fall-through!
-        case CAN_ERR_PROT_UNSPEC:
-            errorMsg << " / error in CAN protocol (type): unspecified";
-            break;
-
-        case CAN_ERR_PROT_BIT:
-            errorMsg << " / error in CAN protocol (type): single bit error";
-            break;
-
-        case CAN_ERR_PROT_FORM:
-            errorMsg << " / error in CAN protocol (type): frame format error";
-            break;
-
-        case CAN_ERR_PROT_STUFF:
-            errorMsg << " / error in CAN protocol (type): bit stuffing error";
-            break;
-
-        case CAN_ERR_PROT_BIT0:
-            errorMsg << " / error in CAN protocol (type): unable to send dominant bit";
-            break;
-
-        case CAN_ERR_PROT_BIT1:
-            errorMsg << " / error in CAN protocol (type): unable to send recessive bit";
-            break;
-
-        case CAN_ERR_PROT_OVERLOAD:
-            errorMsg << " / error in CAN protocol (type): bus overload";
-            break;
-
-        case CAN_ERR_PROT_ACTIVE:
-            errorMsg << " / error in CAN protocol (type): active error announcement";
-            break;
+    const int timeoutMs = static_cast<int>(options_->writeTimeout_.tv_sec * 1000 + options_->writeTimeout_.tv_usec / 1000);
+    poll(&fds, 1, timeoutMs > 0 ? timeoutMs : 1);
+}
 
-        case CAN_ERR_PROT_TX:
-            errorMsg << " / error in CAN protocol (type): error occurred on transmission";
-            break;
+void SocketBus::countSentFrame() {
+    // the rate is measured over windows of 100 ms, and only used if the netdevice was congested during the window
+    const auto now = std::chrono::steady_clock::now();
+    ++txWindowFrames_;
+    const auto elapsed = now - txWindowStart_;
+    if(elapsed >= std::chrono::milliseconds(100)) {
+        if(isTxWindowCongested_ && txWindowStart_ != std::chrono::steady_clock::time_point()) {
+            txCapacity_.store(txWindowFrames_ / std::chrono::duration<double>(elapsed).count(), std::memory_order_relaxed);
+        }
+        txWindowStart_ = now;
+        txWindowFrames_ = 0;
+        isTxWindowCongested_ = false;
     }
+}
 
-    // bit 3
-    switch(msg.data[3]) {
-        default:
-        case CAN_ERR_PROT_LOC_UNSPEC:
-            errorMsg << " / error in CAN protocol (location): unspecified";
-            break;
-
-        case CAN_ERR_PROT_LOC_SOF:
-            errorMsg << " / error in CAN protocol (location): start of frame";
-            break;
-
-        case CAN_ERR_PROT_LOC_ID28_21:
-            errorMsg << " / error in CAN protocol (location): ID bits 28 - 21 (SFF: 10 - 3)";
-            break;
-
-        case CAN_ERR_PROT_LOC_ID20_18:
-            errorMsg << " / error in CAN protocol (location): ID bits 20 - 18 (SFF: 2 - 0 )";
-            break;
-
-        case CAN_ERR_PROT_LOC_SRTR:
-            errorMsg << " / error in CAN protocol (location): substitute RTR (SFF: RTR)";
-            break;
-
-        case CAN_ERR_PROT_LOC_IDE:
-            errorMsg << " / error in CAN protocol (location): identifier extension";
-            break;
-
-        case CAN_ERR_PROT_LOC_ID17_13:
-            errorMsg << " / error in CAN protocol (location): ID bits 17-13";
-            break;
-
-        case CAN_ERR_PROT_LOC_ID12_05:
-            errorMsg << " / error in CAN protocol (location): ID bits 12-5";
-            break;
-
-        case CAN_ERR_PROT_LOC_ID04_00:
-            errorMsg << " / error in CAN protocol (location): ID bits 4-0";
-            break;
-
-        case CAN_ERR_PROT_LOC_RTR:
-            errorMsg << " / error in CAN protocol (location): RTR";
-            break;
-
-        case CAN_ERR_PROT_LOC_RES1:
-            errorMsg << " / error in CAN protocol (location): reserved bit 1";
-            break;
-
-        case CAN_ERR_PROT_LOC_RES0:
-            errorMsg << " / error in CAN protocol (location): reserved bit 0";
-            break;
-
-        case CAN_ERR_PROT_LOC_DLC:
-            errorMsg << " / error in CAN protocol (location): data length code";
-            break;
-
-        case CAN_ERR_PROT_LOC_DATA:
-            errorMsg << " / error in CAN protocol (location): data section";
-            break;
-
-        case CAN_ERR_PROT_LOC_CRC_SEQ:
-            errorMsg << " / error in CAN protocol (location): CRC sequence";
-            break;
-
-        case CAN_ERR_PROT_LOC_CRC_DEL:
-            errorMsg << " / error in CAN protocol (location): CRC delimiter";
-            break;
-
-        case CAN_ERR_PROT_LOC_ACK:
-            errorMsg << " / error in CAN protocol (location): ACK slot";
-            break;
-
-        case CAN_ERR_PROT_LOC_ACK_DEL:
-            errorMsg << " / error in CAN protocol (location): ACK delimiter";
-            break;
-
-        case CAN_ERR_PROT_LOC_EOF:
-            errorMsg << " / error in CAN protocol (location): end of frame";
-            break;
-
-        case CAN_ERR_PROT_LOC_INTERM:
-            errorMsg << " / error in CAN protocol (location): intermission";
-            break;
+bool SocketBus::sanityCheck() {
+    if(linkMonitor_ && !isAsynchronous()) {
+        checkLink();
     }
+    return CanBus::sanityCheck();
+}
 
-    // bit 4
-    switch(msg.data[4]) {
-        default:
-        case CAN_ERR_TRX_UNSPEC:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_UNSPEC";
-            break;
-
-        case CAN_ERR_TRX_CANH_NO_WIRE:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_CANH_NO_WIRE";
-            break;
-
-        case CAN_ERR_TRX_CANH_SHORT_TO_BAT:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_CANH_SHORT_TO_BAT";
-            break;
-
-        case CAN_ERR_TRX_CANH_SHORT_TO_VCC:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_CANH_SHORT_TO_VCC";
-            break;
-
-        case CAN_ERR_TRX_CANH_SHORT_TO_GND:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_CANH_SHORT_TO_GND";
-            break;
+void SocketBus::linkWorker() {
+    const std::chrono::milliseconds interval = getLinkCheckInterval();
+    auto nextCheck = std::chrono::steady_clock::now();
+    while(isLinkThreadRunning_) {
+        checkLink();
+        nextCheck += interval;
+        std::this_thread::sleep_until(nextCheck);
+    }
+}
 
-        case CAN_ERR_TRX_CANL_NO_WIRE:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_CANL_NO_WIRE";
-            break;
+void SocketBus::checkLink() {
+    const SocketBusOptions* options = static_cast<const SocketBusOptions*>(options_.get());
+    const char* name = options->name_.c_str();
 
-        case CAN_ERR_TRX_CANL_SHORT_TO_BAT:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_CANL_SHORT_TO_BAT";
-            break;
+    if(linkMonitor_->update()) {
+        if(!linkMonitor_->exists()) {
+            MELO_ERROR("Interface of bus %s was removed.", name);
+        }else{
+            MELO_WARN("Interface of bus %s: link %s, controller %s (tx errors: %u, rx errors: %u)", name, linkMonitor_->isLinkUp() ? "up" : "down",
+                      CanLinkMonitor::getControllerStateName(linkMonitor_->getControllerState()),
+                      linkMonitor_->getTxErrorCounter(), linkMonitor_->getRxErrorCounter());
+        }
+    }
 
-        case CAN_ERR_TRX_CANL_SHORT_TO_VCC:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_CANL_SHORT_TO_VCC";
-            break;
+    // the interface was added (again) with a new index, the old socket is dead
+    if(linkMonitor_->exists() && linkMonitor_->getInterfaceIndex() != interfaceIndex_) {
+        if(reopenSocket()) {
+            MELO_WARN("Opened socket of bus %s after its interface was added.", name);
+        }
+    }
 
-        case CAN_ERR_TRX_CANL_SHORT_TO_GND:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_CANL_SHORT_TO_GND";
-            break;
+    const CanLinkMonitor::ControllerState state = linkMonitor_->getControllerState();
+    const auto now = std::chrono::steady_clock::now();
+    if(state == CanLinkMonitor::ControllerState::BusOff) {
+        if(controllerState_ != CanLinkMonitor::ControllerState::BusOff) {
+            busOffTime_ = now;
+            // the bus off error frame may be masked (SocketBusOptions::canErrorMask_)
+            if(options->passivateOnBusError_ && !isPassive()) {
+                passivate();
+                isPassivatedOnBusOff_ = true;
+                MELO_WARN("Bus off on bus %s. This bus is now PASSIVE!", name);
+            }
+        }
+        if(options->busOffRestartDelay_ != 0 && now - busOffTime_ >= std::chrono::milliseconds(busOffRestartDelay_)) {
+            if(linkMonitor_->restartController()) {
+                ++numControllerRestarts_;
+                MELO_WARN("Restarting controller of bus %s after bus off (%u ms).", name, busOffRestartDelay_);
+            }
+            // restarts in quick succession back off, the restart is repeated after the delay if the controller stays bus off
+            if(lastRestartTime_ != std::chrono::steady_clock::time_point() &&
+               now - lastRestartTime_ < std::chrono::milliseconds(options->maxBusOffRestartDelay_)) {
+                busOffRestartDelay_ = std::min(2*busOffRestartDelay_, options->maxBusOffRestartDelay_);
+            }else{
+                busOffRestartDelay_ = options->busOffRestartDelay_;
+            }
+            lastRestartTime_ = now;
+            busOffTime_ = now;
+        }
+    }else if(controllerState_ == CanLinkMonitor::ControllerState::BusOff && state != CanLinkMonitor::ControllerState::Unknown) {
+        MELO_INFO("Controller of bus %s recovered from bus off.", name);
+        // a bus passivated by the user or for other errors stays passive
+        if(isPassivatedOnBusOff_.exchange(false) && isPassive()) {
+            activate();
+        }
+    }
+    controllerState_ = state;
+}
 
-        case CAN_ERR_TRX_CANL_SHORT_TO_CANH:
-            errorMsg << " / error status of CAN-transceiver: CAN_ERR_TRX_CANL_SHORT_TO_CANH";
-            break;
+bool SocketBus::reopenSocket() {
+    // the new socket is fully configured before it is published, so the other threads never see it half-initialized
+    int interfaceIndex = 0;
+    bool isXlEnabled = false;
+    const int socket = openSocket(interfaceIndex, isXlEnabled);
+    if(socket < 0) {
+        return false;
     }
 
-    // bit 5-7
-    errorMsg << " / controller specific additional information: 0x" << std::hex << static_cast<int>(msg.data[5]) << " 0x" <<  std::hex << static_cast<int>(msg.data[6]) << " 0x" <<  std::hex << static_cast<int>(msg.data[7]);
+    // threads blocked on the old socket were woken with ENODEV when the interface was removed. update(..) waits until all
+    // threads which took a snapshot of the old socket have left it, so its descriptor cannot be reused while in use.
+    int oldSocket = -1;
+    socket_.update([socket, &oldSocket](int& fd) { oldSocket = fd; fd = socket; });
+    if(oldSocket >= 0) {
+        close(oldSocket);
+    }
+    isXlEnabled_ = isXlEnabled;
+    // the netdevice may differ, the sndbuf of the new socket has its default length
+    isTxCalibrated_ = false;
+    txCapacity_.store(0.0, std::memory_order_relaxed);
+    // the SocketBusReceiver routes the frames of the new interface to this bus from now on
+    interfaceIndex_.store(interfaceIndex, std::memory_order_release);
+
+    // subscriptions changed while the new socket was configured were applied to the old one
+    if(static_cast<const SocketBusOptions*>(options_.get())->autoCanFilters_) {
+        applyCanFilters(socket);
+    }
+    return true;
+}
 
-    MELO_ERROR_THROTTLE_STREAM(options_->errorThrottleTime_, errorMsg.str());
+void SocketBus::handleBusErrorMessage(const CanMsg& msg) {
+    const CanBusError error = CanBusError::fromFrame(msg);
+    const bool wasPassive = isPassive();
+    handleBusError(error);
+    if(!wasPassive && isPassive() && error.hasClass(CanBusError::BusOff)) {
+        isPassivatedOnBusOff_ = true;
+    }
 }
 
 } /* namespace tcan_can */
@@ -0,0 +1,175 @@
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "tcan_can/SocketBusReceiver.hpp"
+
+#include "message_logger/message_logger.hpp"
+#include "tcan/helper_functions.hpp"
+
+namespace tcan_can {
+
+SocketBusReceiver::SocketBusReceiver(std::unique_ptr<SocketBusOptions>&& options):
+    options_(std::move(options)),
+    socket_(-1),
+    recvFlag_(0),
+    buses_(std::unique_ptr<BusContainer>(new BusContainer())),
+    receiveThread_(),
+    running_{false},
+    numUnroutedFrames_{0}
+{
+}
+
+SocketBusReceiver::~SocketBusReceiver()
+{
+    stopThread();
+    if(socket_ >= 0) {
+        close(socket_);
+    }
+}
+
+bool SocketBusReceiver::addBus(SocketBus* bus) {
+    const SocketBusOptions* busOptions = static_cast<const SocketBusOptions*>(bus->options_.get());
+    if(!busOptions->sharedReceive_ || bus->getInterfaceIndex() <= 0) {
+        MELO_ERROR("Cannot add bus %s to receiver %s: the bus is not initialized or does not share reception.", busOptions->name_.c_str(), options_->name_.c_str());
+        return false;
+    }
+
+    bool isAdded = false;
+    buses_.update([bus, &isAdded](BusContainer& buses) {
+        if(findBus(buses, bus->getInterfaceIndex()) == nullptr) {
+            buses.push_back(bus);
+            isAdded = true;
+        }
+    });
+
+    if(!isAdded) {
+        MELO_ERROR("Cannot add bus %s to receiver %s: a bus with the same interface was already added.", busOptions->name_.c_str(), options_->name_.c_str());
+    }
+    return isAdded;
+}
+
+bool SocketBusReceiver::initialize() {
+    const char* name = options_->name_.c_str();
+
+    socket_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if(socket_ < 0) {
+        MELO_FATAL("Opening CAN receive socket %s failed: %d", name, socket_);
+        return false;
+    }
+
+    if(options_->canFdFrames_) {
+        int enableCanFd = 1;
+        if(setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enableCanFd, sizeof(enableCanFd)) != 0) {
+            MELO_ERROR("Failed to enable CAN FD frames on receive socket %s: (%d)\n  %s", name, errno, strerror(errno));
+            return false;
+        }
+    }
+
+    can_err_mask_t err_mask = options_->canErrorMask_;
+    if(setsockopt(socket_, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &err_mask, sizeof(err_mask)) != 0) {
+        MELO_WARN("Failed to set error mask: (%d)\n  %s", errno, strerror(errno));
+    }
+
+    if(options_->readTimeout_.tv_sec != 0 || options_->readTimeout_.tv_usec != 0) {
+        if(setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &options_->readTimeout_, sizeof(options_->readTimeout_)) != 0) {
+            MELO_WARN("Failed to set read timeout: (%d)\n  %s", errno, strerror(errno));
+        }
+    }
+
+    if(options_->mode_ != tcan::BusOptions::Mode::Asynchronous) {
+        recvFlag_ = MSG_DONTWAIT;
+    }
+
+    // interface index 0 binds the socket to all CAN interfaces
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(struct sockaddr_can));
+    addr.can_family  = AF_CAN;
+    addr.can_ifindex = 0;
+    if(bind(socket_, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        MELO_FATAL("Error in socket %s bind: (%d)\n  %s", name, errno, strerror(errno));
+        return false;
+    }
+
+    MELO_INFO("Opened receive socket %s for all CAN interfaces.", name);
+    return true;
+}
+
+void SocketBusReceiver::startThread() {
+    if(options_->mode_ == tcan::BusOptions::Mode::Asynchronous && !running_) {
+        running_ = true;
+        receiveThread_ = std::thread(&SocketBusReceiver::receiveWorker, this);
+        if(!tcan::setThreadPriority(receiveThread_, options_->priorityReceiveThread_)) {
+            MELO_WARN("Failed to set receive thread priority for receiver %s:\n  %s", options_->name_.c_str(), strerror(errno));
+        }
+    }
+}
+
+void SocketBusReceiver::stopThread() {
+    running_ = false;
+    if(receiveThread_.joinable()) {
+        receiveThread_.join();
+    }
+}
+
+bool SocketBusReceiver::readData() {
+    // CanMsg has the layout of a canfd_frame, see SocketBus::readData(). recvmsg(..) reports the interface of the frame.
+    CanMsg msg(0);
+    struct sockaddr_can addr;
+    struct iovec iov;
+    iov.iov_base = &msg;
+    iov.iov_len = options_->canFdFrames_ ? CANFD_MTU : CAN_MTU;
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_name = &addr;
+    header.msg_namelen = sizeof(addr);
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    const ssize_t bytesRead = recvmsg(socket_, &header, recvFlag_);
+    if(bytesRead <= 0) {
+        if(errno != EAGAIN && errno != EWOULDBLOCK) {
+            MELO_ERROR_THROTTLE(options_->errorThrottleTime_, "Failed to read data from receive socket %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
+        }
+        return false;
+    }
+
+    routeFrame(msg, static_cast<std::size_t>(bytesRead), addr.can_ifindex);
+    return true;
+}
+
+void SocketBusReceiver::routeFrame(CanMsg& msg, const std::size_t numBytes, const int interfaceIndex) {
+    // frames of other local sockets are received like the ones of remote nodes. The transmit sockets of the buses do not
+    // loop back their frames (see SocketBusOptions::sharedReceive_).
+    const auto buses = buses_.read();
+    SocketBus* bus = findBus(*buses, interfaceIndex);
+    if(bus == nullptr) {
+        numUnroutedFrames_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    bus->hasBusError_ = false;
+    bus->handleReceivedFrame(msg, numBytes);
+    bus->activateOnReception();
+}
+
+SocketBus* SocketBusReceiver::findBus(const BusContainer& buses, const int interfaceIndex) {
+    // linear search, there are only a few interfaces
+    for(SocketBus* bus : buses) {
+        if(bus->getInterfaceIndex() == interfaceIndex) {
+            return bus;
+        }
+    }
+    return nullptr;
+}
+
+void SocketBusReceiver::receiveWorker() {
+    while(running_) {
+        readData();
+    }
+
+    MELO_INFO("receive thread for receiver %s terminated", options_->name_.c_str());
+}
+
+} /* namespace tcan_can */
@@ -0,0 +1,234 @@
+#include <sys/timerfd.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+
+#include "tcan_can/SyncProducer.hpp"
+
+#include "message_logger/message_logger.hpp"
+#include "tcan/helper_functions.hpp"
+
+namespace tcan_can {
+
+SyncProducer::SyncProducer(std::unique_ptr<SyncProducerOptions>&& options):
+    options_(std::move(options)),
+    timerFd_(-1),
+    buses_(),
+    rpdos_(),
+    rpdoMutex_(),
+    nextCycleStart_(),
+    lastSyncTime_{0},
+    counter_{0},
+    statisticsMutex_(),
+    statistics_(),
+    latencySum_(0.0),
+    latencySquareSum_(0.0),
+    producerThread_(),
+    running_{false}
+{
+}
+
+SyncProducer::~SyncProducer()
+{
+    stopThread();
+    if(timerFd_ >= 0) {
+        close(timerFd_);
+    }
+}
+
+bool SyncProducer::addBus(CanBus* bus) {
+    if(timerFd_ >= 0) {
+        MELO_ERROR("Cannot add bus %s to SYNC producer %s after initialization.", bus->getName().c_str(), options_->name_.c_str());
+        return false;
+    }
+    buses_.push_back(bus);
+    return true;
+}
+
+bool SyncProducer::addRpdo(CanBus* bus, const CanMsg& msg, unsigned int& index) {
+    if(timerFd_ >= 0) {
+        MELO_ERROR("Cannot add RPDO %x to SYNC producer %s after initialization.", msg.getCobId(), options_->name_.c_str());
+        return false;
+    }
+    index = rpdos_.size();
+    rpdos_.emplace_back(bus, msg);
+    return true;
+}
+
+bool SyncProducer::setRpdo(const unsigned int index, const CanMsg& msg) {
+    if(index >= rpdos_.size()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(rpdoMutex_);
+    rpdos_[index].second = msg;
+    return true;
+}
+
+bool SyncProducer::initialize() {
+    if(timerFd_ >= 0) {
+        MELO_ERROR("SYNC producer %s is already initialized.", options_->name_.c_str());
+        return false;
+    }
+    if(options_->cyclePeriod_ == 0) {
+        MELO_ERROR("Cannot initialize SYNC producer %s: the cycle period is 0.", options_->name_.c_str());
+        return false;
+    }
+
+    // steady_clock is CLOCK_MONOTONIC, so the timer expires at the scheduled cycle starts
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if(timerFd_ < 0) {
+        MELO_ERROR("Failed to create timer of SYNC producer %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
+        return false;
+    }
+
+    const std::chrono::microseconds period(options_->cyclePeriod_);
+    nextCycleStart_ = Clock::now() + period;
+    const auto start = std::chrono::duration_cast<std::chrono::nanoseconds>(nextCycleStart_.time_since_epoch()).count();
+    const auto interval = std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
+
+    struct itimerspec spec;
+    spec.it_value.tv_sec = start / 1000000000;
+    spec.it_value.tv_nsec = start % 1000000000;
+    spec.it_interval.tv_sec = interval / 1000000000;
+    spec.it_interval.tv_nsec = interval % 1000000000;
+    if(timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+        MELO_ERROR("Failed to start timer of SYNC producer %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
+        close(timerFd_);
+        timerFd_ = -1;
+        return false;
+    }
+
+    resetStatistics();
+    MELO_INFO("Started SYNC producer %s on %zu buses with a cycle period of %u us.", options_->name_.c_str(), buses_.size(), options_->cyclePeriod_);
+    return true;
+}
+
+void SyncProducer::startThread() {
+    if(timerFd_ >= 0 && !running_) {
+        running_ = true;
+        producerThread_ = std::thread(&SyncProducer::producerWorker, this);
+        if(options_->priorityThread_ > 0 && !tcan::setThreadPriority(producerThread_, options_->priorityThread_)) {
+            MELO_WARN("Failed to set thread priority for SYNC producer %s:\n  %s", options_->name_.c_str(), strerror(errno));
+        }
+    }
+}
+
+void SyncProducer::stopThread() {
+    running_ = false;
+    if(producerThread_.joinable()) {
+        producerThread_.join();
+    }
+}
+
+bool SyncProducer::produceSync() {
+    uint64_t numExpirations = 0;
+    if(read(timerFd_, &numExpirations, sizeof(numExpirations)) != sizeof(numExpirations)) {
+        if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            MELO_ERROR_THROTTLE(1.0, "Failed to read timer of SYNC producer %s: (%d)\n  %s", options_->name_.c_str(), errno, strerror(errno));
+        }
+        return false;
+    }
+
+    // the SYNC is built before the first bus is served, so the buses are served back to back
+    uint8_t counter = 0;
+    if(options_->syncCounterOverflow_ > 1) {
+        counter = static_cast<uint8_t>(counter_.load(std::memory_order_relaxed) % options_->syncCounterOverflow_ + 1);
+    }
+    const CanMsg sync = counter == 0 ? CanMsg(0x80, 0, nullptr) : CanMsg(0x80, {counter});
+
+    const Clock::time_point firstSync = Clock::now();
+    bool isSent = true;
+    for(auto bus : buses_) {
+        isSent &= bus->sendMessageDirectly(sync);
+    }
+    const Clock::time_point lastSync = Clock::now();
+
+    // the expirations which were missed are skipped, the SYNC is sent in the current cycle
+    const std::chrono::microseconds period(options_->cyclePeriod_);
+    const Clock::time_point cycleStart = nextCycleStart_ + period * (numExpirations - 1);
+    nextCycleStart_ = cycleStart + period;
+    lastSyncTime_.store(firstSync.time_since_epoch().count(), std::memory_order_release);
+    counter_.store(counter, std::memory_order_relaxed);
+
+    bool isWindowOverrun = false;
+    if(!rpdos_.empty()) {
+        isWindowOverrun = !sendRpdos(cycleStart);
+    }
+
+    updateStatistics(numExpirations, firstSync - cycleStart, lastSync - firstSync, isWindowOverrun);
+    return isSent;
+}
+
+bool SyncProducer::isInSyncWindow() const {
+    if(options_->syncWindowLength_ == 0) {
+        return true;
+    }
+    return Clock::now() < getLastSyncTime() + std::chrono::microseconds(options_->syncWindowLength_);
+}
+
+SyncProducerStatistics SyncProducer::getStatistics() const {
+    std::lock_guard<std::mutex> guard(statisticsMutex_);
+    SyncProducerStatistics statistics = statistics_;
+    if(statistics.numSyncs_ > 0) {
+        const double num = static_cast<double>(statistics.numSyncs_);
+        statistics.meanLatency_ = latencySum_ / num;
+        statistics.jitter_ = std::sqrt(std::max(0.0, latencySquareSum_ / num - statistics.meanLatency_ * statistics.meanLatency_));
+    }
+    return statistics;
+}
+
+void SyncProducer::resetStatistics() {
+    std::lock_guard<std::mutex> guard(statisticsMutex_);
+    statistics_ = SyncProducerStatistics();
+    latencySum_ = 0.0;
+    latencySquareSum_ = 0.0;
+}
+
+bool SyncProducer::sendRpdos(const Clock::time_point cycleStart) {
+    const Clock::time_point burstTime = cycleStart + std::chrono::microseconds(options_->rpdoOffset_);
+    std::this_thread::sleep_until(burstTime);
+
+    // RPDOs received after the synchronous window are discarded by the devices, so they are not sent
+    if(options_->syncWindowLength_ != 0 && Clock::now() >= cycleStart + std::chrono::microseconds(options_->syncWindowLength_)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(rpdoMutex_);
+    for(const auto& rpdo : rpdos_) {
+        rpdo.first->sendMessageDirectly(rpdo.second);
+    }
+    return true;
+}
+
+void SyncProducer::updateStatistics(const uint64_t numExpirations, const Clock::duration latency, const Clock::duration spread,
+                                    const bool isWindowOverrun) {
+    const double latencyUs = std::chrono::duration<double, std::micro>(latency).count();
+    const double spreadUs = std::chrono::duration<double, std::micro>(spread).count();
+
+    std::lock_guard<std::mutex> guard(statisticsMutex_);
+    if(statistics_.numSyncs_ == 0 || latencyUs < statistics_.minLatency_) {
+        statistics_.minLatency_ = latencyUs;
+    }
+    if(statistics_.numSyncs_ == 0 || latencyUs > statistics_.maxLatency_) {
+        statistics_.maxLatency_ = latencyUs;
+    }
+    statistics_.maxSpread_ = std::max(statistics_.maxSpread_, spreadUs);
+    statistics_.numSyncs_++;
+    statistics_.numMissedCycles_ += numExpirations - 1;
+    if(isWindowOverrun) {
+        statistics_.numWindowOverruns_++;
+    }
+    latencySum_ += latencyUs;
+    latencySquareSum_ += latencyUs * latencyUs;
+}
+
+void SyncProducer::producerWorker() {
+    while(running_) {
+        produceSync();
+    }
+
+    MELO_INFO("thread of SYNC producer %s terminated", options_->name_.c_str());
+}
+
+} /* namespace tcan_can */
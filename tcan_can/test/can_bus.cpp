@@ -1,7 +1,34 @@
 #include <gtest/gtest.h>
 
+#include <linux/can.h>
+#include <linux/can/error.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "tcan/GenericMsg.hpp"
+#include "tcan/RcuPointer.hpp"
+#include "tcan/SignalLayout.hpp"
+#include "tcan_can/CanBusManager.hpp"
+#include "tcan_can/CanFilterCalculator.hpp"
 #include "tcan_can/CanFrameIdentifier.hpp"
+#include "tcan_can/DeviceCanOpen.hpp"
+#include "tcan_can/PdoMapping.hpp"
+#include "tcan_can/SdoAnswerTable.hpp"
+#include "tcan_can/SdoMsg.hpp"
+#include "tcan_can/SdoQueue.hpp"
+#include "tcan_can/SdoRequest.hpp"
+#include "tcan_can/SdoTransfer.hpp"
 #include "tcan_can/SocketBus.hpp"
+#include "tcan_can/SocketBusReceiver.hpp"
+#include "tcan_can/SyncProducer.hpp"
 
 struct BarDevice : public tcan_can::CanDevice {
 	template<typename... Args>
@@ -57,6 +84,1380 @@ TEST(can_bus, handle_cob_mask) {
 	ASSERT_TRUE(dev.wasCalled());
 }
 
+TEST(can_bus, handle_standard_cob) {
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	BarDevice dev {0x123, "Bar"};
+
+	ASSERT_TRUE(bus.addCanMessage(0x7ffu, &dev, &BarDevice::callMe));
+	ASSERT_FALSE(bus.addCanMessage(0x7ffu, &dev, &BarDevice::callMe));
+
+	bus.handleMessage(tcan_can::CanMsg{0x7feu});
+	ASSERT_FALSE(dev.wasCalled());
+	bus.handleMessage(tcan_can::CanMsg{0x7ffu});
+	ASSERT_TRUE(dev.wasCalled());
+
+	// extended frame with the same 11 bit identifier
+	bus.handleMessage(tcan_can::CanMsg{0x800007ffu});
+	ASSERT_FALSE(dev.wasCalled());
+}
+
+TEST(can_bus, handle_fan_out) {
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	BarDevice exact {0x1, "Exact"};
+	BarDevice other {0x2, "Other"};
+	BarDevice masked {0x3, "Masked"};
+	unsigned int numUnmapped = 0;
+
+	bus.setUnmappedMessageCallback([&numUnmapped](const tcan_can::CanMsg&) { ++numUnmapped; return true; });
+	bus.addCanMessage(tcan_can::CanFrameIdentifier{0x180, 0x780}, &masked, &BarDevice::callMe);
+	bus.addCanMessage(0x181u, &exact, &BarDevice::callMe);
+	bus.addCanMessage(0x181u, &other, &BarDevice::callMe);
+	bus.addCanMessage(tcan_can::CanFrameIdentifier{0x18fe3185u, 0xffffff00u}, &masked, &BarDevice::callMe);
+	bus.addCanMessage(0x18fe3185u, &exact, &BarDevice::callMe);
+
+	bus.handleMessage(tcan_can::CanMsg{0x181u});
+	ASSERT_TRUE(exact.wasCalled());
+	ASSERT_TRUE(other.wasCalled());
+	ASSERT_TRUE(masked.wasCalled());
+
+	bus.handleMessage(tcan_can::CanMsg{0x1ffu});
+	ASSERT_FALSE(exact.wasCalled());
+	ASSERT_TRUE(masked.wasCalled());
+
+	bus.handleMessage(tcan_can::CanMsg{0x18fe3185u});
+	ASSERT_TRUE(exact.wasCalled());
+	ASSERT_TRUE(masked.wasCalled());
+
+	bus.handleMessage(tcan_can::CanMsg{0x18fe3186u});
+	ASSERT_FALSE(exact.wasCalled());
+	ASSERT_TRUE(masked.wasCalled());
+
+	bus.handleMessage(tcan_can::CanMsg{0x201u});
+	ASSERT_FALSE(exact.wasCalled());
+	ASSERT_FALSE(masked.wasCalled());
+	ASSERT_EQ(1u, numUnmapped);
+}
+
+TEST(can_bus, unsubscribe) {
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	BarDevice dev {0x1, "Bar"};
+	BarDevice logger {0x2, "Logger"};
+
+	bus.addCanMessage(0x181u, &dev, &BarDevice::callMe);
+	const auto handle = bus.subscribe(tcan_can::CanFrameIdentifier{0x0, 0x0}, &logger, &BarDevice::callMe);
+	ASSERT_NE(tcan_can::CanBus::InvalidSubscription, handle);
+
+	bus.handleMessage(tcan_can::CanMsg{0x181u});
+	ASSERT_TRUE(dev.wasCalled());
+	ASSERT_TRUE(logger.wasCalled());
+
+	ASSERT_TRUE(bus.unsubscribe(handle));
+	ASSERT_FALSE(bus.unsubscribe(handle));
+
+	bus.handleMessage(tcan_can::CanMsg{0x181u});
+	ASSERT_TRUE(dev.wasCalled());
+	ASSERT_FALSE(logger.wasCalled());
+}
+
+TEST(can_bus, handle_callable) {
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	uint32_t lastCobId = 0;
+
+	bus.addCanMessage(0x12345u, [&lastCobId](const tcan_can::CanMsg& msg) { lastCobId = msg.getCobId(); return true; });
+
+	bus.handleMessage(tcan_can::CanMsg{0x12346u});
+	ASSERT_EQ(0u, lastCobId);
+	bus.handleMessage(tcan_can::CanMsg{0x12345u});
+	ASSERT_EQ(0x12345u, lastCobId);
+}
+
+TEST(can_bus, release_callable) {
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->numCallbackThreads_ = 1;
+	tcan_can::SocketBus bus { std::move(options) };
+	auto token = std::make_shared<int>(0);
+
+	// the copy of the callable is released on unsubscribe
+	const auto handle = bus.subscribe(tcan_can::CanFrameIdentifier{0x181u}, [token](const tcan_can::CanMsg&) { return true; });
+	ASSERT_NE(tcan_can::CanBus::InvalidSubscription, handle);
+	ASSERT_EQ(2, token.use_count());
+	ASSERT_TRUE(bus.unsubscribe(handle));
+	ASSERT_EQ(1, token.use_count());
+
+	// a callable unsubscribing itself on a callback thread is released after its call
+	std::atomic<tcan_can::CanBus::SubscriptionHandle> selfHandle {tcan_can::CanBus::InvalidSubscription};
+	std::atomic<bool> isUnsubscribed {false};
+	selfHandle = bus.subscribe(tcan_can::CanFrameIdentifier{0x182u}, [token, &bus, &selfHandle, &isUnsubscribed](const tcan_can::CanMsg&) {
+		isUnsubscribed = bus.unsubscribe(selfHandle);
+		return true;
+	});
+	ASSERT_EQ(2, token.use_count());
+	bus.handleMessage(tcan_can::CanMsg{0x182u});
+	bus.waitForCallbacks();
+	ASSERT_TRUE(isUnsubscribed);
+	ASSERT_EQ(1, token.use_count());
+
+	// replacing the unmapped callback releases the previous callable
+	bus.setUnmappedMessageCallback([token](const tcan_can::CanMsg&) { return true; });
+	ASSERT_EQ(2, token.use_count());
+	bus.setUnmappedMessageCallback(&bus, &tcan_can::CanBus::defaultHandleUnmappedMessage);
+	ASSERT_EQ(1, token.use_count());
+}
+
+TEST(rcu_pointer, update_in_read_section) {
+	auto token = std::make_shared<int>(0);
+	tcan::RcuPointer<std::vector<std::shared_ptr<int>>> pointer {std::make_unique<std::vector<std::shared_ptr<int>>>(1, token)};
+
+	// outside of a read section, the old object is deleted on update
+	pointer.update([](std::vector<std::shared_ptr<int>>& objects) { objects.push_back(objects.front()); });
+	ASSERT_EQ(3, token.use_count());
+
+	// old objects replaced in a read section are retired and deleted at its end
+	{
+		auto snapshot = pointer.read();
+		for(int i = 0; i < 100; ++i) {
+			pointer.update([](std::vector<std::shared_ptr<int>>& objects) { objects.pop_back(); objects.push_back(objects.front()); });
+		}
+		ASSERT_EQ(2u, snapshot->size());
+		ASSERT_EQ(1 + 2 * 101, token.use_count());
+	}
+	ASSERT_EQ(3, token.use_count());
+	ASSERT_EQ(2u, pointer.read()->size());
+}
+
+struct SequenceDevice : public tcan_can::CanDevice {
+	template<typename... Args>
+	explicit SequenceDevice(Args&&... args) : tcan_can::CanDevice(std::forward<Args>(args)...) {}
+	bool initDevice() override { return true; }
+	bool configureDevice(const tcan_can::CanMsg& /*msg*/) override { return true; }
+
+	bool parse(const tcan_can::CanMsg& msg) {
+		sequence.push_back(msg.readuint32(0));
+		threadId = std::this_thread::get_id();
+		return true;
+	}
+
+	std::vector<uint32_t> sequence;
+	std::thread::id threadId;
+};
+
+TEST(can_bus, callback_threads) {
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->numCallbackThreads_ = 2;
+	options->callbackQueueCapacity_ = 2048;
+	tcan_can::SocketBus bus { std::move(options) };
+	SequenceDevice first {0x1, "First"};
+	SequenceDevice second {0x2, "Second"};
+	SequenceDevice fast {0x3, "Fast"};
+
+	bus.addCanMessage(tcan_can::CanFrameIdentifier{0x180, 0x7f0}, &first, &SequenceDevice::parse);
+	bus.addCanMessage(0x182u, &second, &SequenceDevice::parse);
+	bus.addCanMessage(0x183u, &fast, &SequenceDevice::parse, true);
+
+	std::vector<uint32_t> expected;
+	for(uint32_t i = 0; i < 1000; ++i) {
+		tcan_can::CanMsg msg {0x181u + i % 3};
+		msg.write(i, 0);
+		bus.handleMessage(msg);
+		expected.push_back(i);
+	}
+	bus.waitForCallbacks();
+
+	// all messages of a device are handled in order of reception
+	ASSERT_EQ(1000u, first.sequence.size());
+	ASSERT_TRUE(first.sequence == expected);
+	ASSERT_EQ(333u, second.sequence.size());
+	ASSERT_TRUE(std::is_sorted(second.sequence.begin(), second.sequence.end()));
+	ASSERT_TRUE(first.threadId != std::this_thread::get_id());
+	ASSERT_TRUE(second.threadId != std::this_thread::get_id());
+
+	// inline callbacks run on the receiving thread
+	ASSERT_EQ(333u, fast.sequence.size());
+	ASSERT_TRUE(fast.threadId == std::this_thread::get_id());
+}
+
+struct BlockingDevice : public SequenceDevice {
+	using SequenceDevice::SequenceDevice;
+
+	bool block(const tcan_can::CanMsg& /*msg*/) {
+		isBlocking = true;
+		while(!isReleased) {
+			std::this_thread::yield();
+		}
+		return true;
+	}
+
+	std::atomic<bool> isBlocking {false};
+	std::atomic<bool> isReleased {false};
+};
+
+static void fillCallbackQueue(tcan_can::CanBusOptions::CallbackOverflowPolicy policy, std::vector<uint32_t>& sequence, uint64_t& numDropped) {
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->numCallbackThreads_ = 1;
+	options->callbackQueueCapacity_ = 4;
+	options->callbackOverflowPolicy_ = policy;
+	tcan_can::SocketBus bus { std::move(options) };
+	BlockingDevice blocker {0x1, "Blocker"};
+	SequenceDevice dev {0x2, "Dev"};
+	bus.addCanMessage(0x181u, &blocker, &BlockingDevice::block);
+	bus.addCanMessage(0x182u, &dev, &SequenceDevice::parse);
+
+	bus.handleMessage(tcan_can::CanMsg{0x181u});
+	while(!blocker.isBlocking) {
+		std::this_thread::yield();
+	}
+	for(uint32_t i = 0; i < 6; ++i) {
+		tcan_can::CanMsg msg {0x182u};
+		msg.write(i, 0);
+		bus.handleMessage(msg);
+	}
+	numDropped = bus.getNumDroppedCallbacks();
+	blocker.isReleased = true;
+	bus.waitForCallbacks();
+	sequence = dev.sequence;
+}
+
+TEST(can_bus, callback_queue_overflow) {
+	std::vector<uint32_t> sequence;
+	uint64_t numDropped = 0;
+
+	fillCallbackQueue(tcan_can::CanBusOptions::CallbackOverflowPolicy::DropNewest, sequence, numDropped);
+	ASSERT_EQ(2u, numDropped);
+	ASSERT_TRUE((sequence == std::vector<uint32_t>{0, 1, 2, 3}));
+
+	fillCallbackQueue(tcan_can::CanBusOptions::CallbackOverflowPolicy::DropOldest, sequence, numDropped);
+	ASSERT_EQ(2u, numDropped);
+	ASSERT_TRUE((sequence == std::vector<uint32_t>{2, 3, 4, 5}));
+}
+
+TEST(can_bus, unsubscribe_drops_queued_callbacks) {
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+	options->numCallbackThreads_ = 1;
+	tcan_can::SocketBus bus { std::move(options) };
+	BlockingDevice blocker {0x1, "Blocker"};
+	SequenceDevice dev {0x2, "Dev"};
+	bus.addCanMessage(0x181u, &blocker, &BlockingDevice::block);
+	const auto handle = bus.subscribe(tcan_can::CanFrameIdentifier{0x182u}, &dev, &SequenceDevice::parse);
+
+	bus.handleMessage(tcan_can::CanMsg{0x181u});
+	while(!blocker.isBlocking) {
+		std::this_thread::yield();
+	}
+	bus.handleMessage(tcan_can::CanMsg{0x182u});
+	bus.handleMessage(tcan_can::CanMsg{0x182u});
+
+	// the queued messages of dev are dropped, it may be destructed after unsubscribe(..)
+	ASSERT_TRUE(bus.unsubscribe(handle));
+	blocker.isReleased = true;
+	bus.waitForCallbacks();
+	ASSERT_TRUE(dev.sequence.empty());
+	ASSERT_EQ(0u, bus.getNumDroppedCallbacks());
+}
+
+TEST(can_bus, subscribe_while_receiving) {
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	BarDevice dev {0x1, "Bar"};
+	std::atomic<bool> running {true};
+	std::atomic<unsigned int> numReceived {0};
+
+	bus.addCanMessage(0x181u, [&numReceived](const tcan_can::CanMsg&) { ++numReceived; return true; });
+
+	std::thread receiver([&bus, &running]() {
+		while(running) {
+			bus.handleMessage(tcan_can::CanMsg{0x181u});
+		}
+	});
+
+	for(int i = 0; i < 200; ++i) {
+		const auto handle = bus.subscribe(tcan_can::CanFrameIdentifier{0x181u}, &dev, &BarDevice::callMe);
+		ASSERT_NE(tcan_can::CanBus::InvalidSubscription, handle);
+		ASSERT_TRUE(bus.unsubscribe(handle));
+	}
+
+	// the receiver thread may not have been scheduled yet, wait for its first message
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while(numReceived == 0 && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+	running = false;
+	receiver.join();
+	ASSERT_TRUE(numReceived > 0);
+}
+
+TEST(can_bus, subscribe_from_callback) {
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	BarDevice dev {0x1, "Bar"};
+
+	bus.addCanMessage(0x701u, [&bus, &dev](const tcan_can::CanMsg&) {
+		bus.addCanMessage(0x181u, &dev, &BarDevice::callMe);
+		return true;
+	});
+
+	bus.handleMessage(tcan_can::CanMsg{0x181u});
+	ASSERT_FALSE(dev.wasCalled());
+	bus.handleMessage(tcan_can::CanMsg{0x701u});
+	bus.handleMessage(tcan_can::CanMsg{0x181u});
+	ASSERT_TRUE(dev.wasCalled());
+}
+
+struct StateObserver {
+	void onStateChanged(const tcan_can::CanDevice& /*device*/, const tcan_can::CanDevice::State /*previous*/, const tcan_can::CanDevice::State current) {
+		states.push_back(current);
+	}
+
+	std::vector<tcan_can::CanDevice::State> states;
+};
+
+TEST(can_bus, device_state_monitor) {
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	StateObserver observer;
+	auto* first = new BarDevice{std::unique_ptr<tcan_can::CanDeviceOptions>(new tcan_can::CanDeviceOptions(0x1, "First", 1u))};
+	auto* second = new BarDevice{std::unique_ptr<tcan_can::CanDeviceOptions>(new tcan_can::CanDeviceOptions(0x2, "Second", 1u))};
+
+	bus.getDeviceStateMonitor().addObserver(&observer, &StateObserver::onStateChanged);
+	bus.addDevice(first);
+	bus.addDevice(second);
+	bus.addCanMessage(0x701u, first, &BarDevice::callMe);
+	bus.addCanMessage(0x702u, second, &BarDevice::callMe);
+	ASSERT_EQ(2u, bus.getDeviceStateMonitor().getNumInitializing());
+	ASSERT_FALSE(bus.allDevicesActive());
+
+	bus.handleMessage(tcan_can::CanMsg{0x701u});
+	ASSERT_FALSE(bus.allDevicesActive());
+	bus.handleMessage(tcan_can::CanMsg{0x702u});
+	ASSERT_TRUE(bus.allDevicesActive());
+	ASSERT_FALSE(bus.isMissingDeviceOrHasError());
+
+	// the second device stops sending messages
+	for(int i = 0; i < 3; ++i) {
+		bus.handleMessage(tcan_can::CanMsg{0x701u});
+		bus.sanityCheck();
+	}
+	ASSERT_FALSE(bus.allDevicesActive());
+	ASSERT_FALSE(bus.allDevicesMissing());
+	ASSERT_TRUE(bus.isMissingDeviceOrHasError());
+	ASSERT_EQ(1u, bus.getDeviceStateMonitor().getNumActive());
+	ASSERT_EQ(1u, bus.getDeviceStateMonitor().getNumMissing());
+
+	const std::vector<tcan_can::CanDevice::State> expected {tcan_can::CanDevice::Active, tcan_can::CanDevice::Active, tcan_can::CanDevice::Missing};
+	ASSERT_TRUE(observer.states == expected);
+}
+
+TEST(can_msg, fd_length) {
+	ASSERT_EQ(8u, tcan_can::CanMsg::lengthToDlc(8));
+	ASSERT_EQ(9u, tcan_can::CanMsg::lengthToDlc(9));
+	ASSERT_EQ(9u, tcan_can::CanMsg::lengthToDlc(12));
+	ASSERT_EQ(12u, tcan_can::CanMsg::lengthToDlc(24));
+	ASSERT_EQ(13u, tcan_can::CanMsg::lengthToDlc(25));
+	ASSERT_EQ(14u, tcan_can::CanMsg::lengthToDlc(33));
+	ASSERT_EQ(15u, tcan_can::CanMsg::lengthToDlc(64));
+	for(uint8_t dlc = 0; dlc < 16; ++dlc) {
+		ASSERT_EQ(dlc, tcan_can::CanMsg::lengthToDlc(tcan_can::CanMsg::dlcToLength(dlc)));
+	}
+	ASSERT_EQ(20u, tcan_can::CanMsg::getValidFdLength(17));
+	ASSERT_EQ(48u, tcan_can::CanMsg::getValidFdLength(40));
+}
+
+TEST(can_msg, fd_payload) {
+	tcan_can::CanMsg msg {0x181u};
+	ASSERT_FALSE(msg.isFd());
+	msg.setFd();
+	ASSERT_TRUE(msg.isFd());
+	ASSERT_EQ(tcan_can::CanMsg::Fd | tcan_can::CanMsg::BitRateSwitch, msg.getFlags());
+
+	msg.write(static_cast<uint32_t>(0xdeadbeef), 60);
+	ASSERT_EQ(64u, msg.getLength());
+	ASSERT_EQ(0xdeadbeefu, msg.readuint32(60));
+	ASSERT_EQ(0u, msg.readuint32(8));
+}
+
+TEST(can_msg, frame_layout) {
+	tcan_can::CanMsg msg {0x181u, {1, 2, 3}};
+	can_frame classic;
+	std::memcpy(&classic, &msg, sizeof(classic));
+	ASSERT_EQ(0x181u, classic.can_id);
+	ASSERT_EQ(3u, classic.can_dlc);
+	ASSERT_EQ(3u, classic.data[2]);
+
+	msg.setFd(false);
+	msg.write(static_cast<uint16_t>(0xbeef), 20);
+	canfd_frame fd;
+	std::memcpy(&fd, &msg, sizeof(fd));
+	ASSERT_EQ(22u, fd.len);
+	ASSERT_EQ(tcan_can::CanMsg::Fd, fd.flags);
+	ASSERT_EQ(0xefu, fd.data[20]);
+
+	tcan_can::CanMsg copy {0};
+	std::memcpy(static_cast<void*>(&copy), &fd, sizeof(copy));
+	ASSERT_EQ(0xbeefu, copy.readuint16(20));
+	ASSERT_TRUE(copy.isFd());
+}
+
+TEST(can_msg, classic_padding) {
+	// the bytes after the payload of a classic frame are sent and have to be 0
+	const uint8_t data[3] = {1, 2, 3};
+	const tcan_can::CanMsg msgs[] = {tcan_can::CanMsg{0x181u}, tcan_can::CanMsg{0x181u, 2}, tcan_can::CanMsg{0x181u, 3, data},
+	                                 tcan_can::CanMsg{0x181u, 3, {1, 2, 3}}, tcan_can::CanMsg{0x181u, {1, 2, 3}}};
+	for(const auto& msg : msgs) {
+		ASSERT_TRUE(std::all_of(msg.getData() + msg.getLength(), msg.getData() + tcan_can::CanMsg::ClassicCapacity, [](uint8_t b) { return b == 0; }));
+	}
+
+	tcan_can::CanMsg fd {0x181u, 20};
+	ASSERT_TRUE(std::all_of(fd.getData(), fd.getData() + 20, [](uint8_t b) { return b == 0; }));
+}
+
+TEST(can_msg, construction_benchmark) {
+	constexpr uint32_t numMessages = 10000000;
+
+	// previous construction, zeroing the whole CAN FD payload
+	alignas(8) uint8_t ring[16][sizeof(tcan_can::CanMsg)];
+	uint64_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < numMessages; ++i) {
+		tcan_can::CanMsg* msg = new (ring[i % 16]) tcan_can::CanMsg{0x181u, {static_cast<uint8_t>(i), 0x34, 0x56, 0x78}};
+		std::fill(msg->getData() + msg->getLength(), msg->getData() + tcan_can::CanMsg::Capacity, 0);
+		checksum += msg->getData()[i % 8];
+	}
+	const double fullDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < numMessages; ++i) {
+		const tcan_can::CanMsg* msg = new (ring[i % 16]) tcan_can::CanMsg{0x181u, {static_cast<uint8_t>(i), 0x34, 0x56, 0x78}};
+		checksum -= msg->getData()[i % 8];
+	}
+	const double classicDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ASSERT_EQ(0u, checksum);
+
+	std::cout << "Constructed " << numMessages << " classic messages: " << numMessages / classicDuration << " messages/s, "
+	          << numMessages / fullDuration << " messages/s zeroing the CAN FD payload" << std::endl;
+}
+
+TEST(can_msg, sdo_view) {
+	const tcan_can::CanMsg answer {0x581u, {0x4b, 0x17, 0x10, 0x00, 0xe8, 0x03, 0x00, 0x00}};
+	const tcan_can::SdoMsgView view(answer);
+	ASSERT_TRUE(view.isReadAnswer());
+	ASSERT_FALSE(view.isAbort());
+	ASSERT_EQ(0x1017u, view.getIndex());
+	ASSERT_EQ(0u, view.getSubIndex());
+	ASSERT_EQ(1000u, view.getData());
+
+	const tcan_can::SdoMsg sdo(answer);
+	ASSERT_EQ(0x1017u, sdo.getIndex());
+	ASSERT_FALSE(sdo.getRequiresAnswer());
+}
+
+TEST(sdo_transfer, crc) {
+	const uint8_t data[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+	ASSERT_EQ(0x31c3u, tcan_can::SdoTransfer::computeCrc(data, sizeof(data)));
+	ASSERT_EQ(0x31c3u, tcan_can::SdoTransfer::computeCrc(data + 4, 5, tcan_can::SdoTransfer::computeCrc(data, 4)));
+}
+
+TEST(sdo_transfer, segmented_upload) {
+	uint8_t buffer[16] = {};
+	tcan_can::SdoTransfer transfer;
+	ASSERT_TRUE(transfer.setupUpload(1, 0x1008, 0, buffer, sizeof(buffer)));
+	ASSERT_FALSE(transfer.setupUpload(1, 0x1008, 0, buffer, sizeof(buffer)));
+	ASSERT_EQ(0x601u, transfer.getInitiateRequest().getCobId());
+	ASSERT_EQ(0x40u, transfer.getInitiateRequest().readuint8(0));
+
+	tcan_can::CanMsg request {0};
+	ASSERT_FALSE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x41, 0x09, 0x10, 0x00, 10, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x41, 0x08, 0x10, 0x00, 10, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x60u, request.readuint8(0));
+	ASSERT_FALSE(transfer.getNextRequest(request));
+
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x00, 't', 'c', 'a', 'n', ' ', 'd', 'e'}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x70u, request.readuint8(0));
+
+	// toggled, 3 bytes, last segment
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x19, 'v', 'i', 'c', 0, 0, 0, 0}}));
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Done, transfer.getState());
+	ASSERT_EQ(10u, transfer.getLength());
+	ASSERT_EQ(std::string("tcan devic"), std::string(reinterpret_cast<const char*>(buffer), transfer.getLength()));
+
+	// wrong toggle bit
+	ASSERT_TRUE(transfer.setupUpload(1, 0x1008, 0, buffer, sizeof(buffer)));
+	transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x40, 0x08, 0x10, 0x00, 0, 0, 0, 0}});
+	transfer.getNextRequest(request);
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x10, 't', 'c', 'a', 'n', ' ', 'd', 'e'}}));
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Aborted, transfer.getState());
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x80u, request.readuint8(0));
+	ASSERT_EQ(tcan_can::SdoTransfer::ToggleError, request.readuint32(4));
+}
+
+TEST(sdo_transfer, block_upload) {
+	uint8_t buffer[10] = {};
+	tcan_can::SdoTransfer transfer;
+	ASSERT_TRUE(transfer.setupUpload(1, 0x1f50, 1, buffer, sizeof(buffer), true, 4));
+	ASSERT_EQ(0xa4u, transfer.getInitiateRequest().readuint8(0));
+	ASSERT_EQ(4u, transfer.getInitiateRequest().readuint8(4));
+
+	tcan_can::CanMsg request {0};
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0xc6, 0x50, 0x1f, 0x01, 10, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0xa3u, request.readuint8(0));
+
+	// the block ends with the last segment, which contains 3 bytes
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x01, 0, 1, 2, 3, 4, 5, 6}}));
+	ASSERT_FALSE(transfer.getNextRequest(request));
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x82, 7, 8, 9, 0, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0xa2u, request.readuint8(0));
+	ASSERT_EQ(2u, request.readuint8(1));
+
+	const uint8_t expected[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+	const uint16_t crc = tcan_can::SdoTransfer::computeCrc(expected, sizeof(expected));
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0xd1, static_cast<uint8_t>(crc & 0xff), static_cast<uint8_t>(crc >> 8), 0, 0, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0xa1u, request.readuint8(0));
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Done, transfer.getState());
+	ASSERT_EQ(10u, transfer.getLength());
+	ASSERT_TRUE(std::equal(expected, expected + sizeof(expected), buffer));
+}
+
+TEST(sdo_transfer, block_download) {
+	uint8_t data[20];
+	for (uint8_t i = 0; i < sizeof(data); ++i) {
+		data[i] = i;
+	}
+	tcan_can::SdoTransfer transfer;
+	ASSERT_TRUE(transfer.setupDownload(1, 0x1f50, 1, data, sizeof(data), true));
+	ASSERT_EQ(0xc6u, transfer.getInitiateRequest().readuint8(0));
+	ASSERT_EQ(20u, transfer.getInitiateRequest().readuint32(4));
+
+	tcan_can::CanMsg request {0};
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0xa4, 0x50, 0x1f, 0x01, 2, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x01u, request.readuint8(0));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x02u, request.readuint8(0));
+	ASSERT_EQ(7u, request.readuint8(1));
+	ASSERT_FALSE(transfer.getNextRequest(request));
+
+	// only the first segment was received, the second one is sent again
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0xa2, 1, 127, 0, 0, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x01u, request.readuint8(0));
+	ASSERT_EQ(7u, request.readuint8(1));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x82u, request.readuint8(0));
+	ASSERT_EQ(14u, request.readuint8(1));
+	ASSERT_FALSE(transfer.getNextRequest(request));
+
+	// end with 1 byte without data in the last segment and the CRC
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0xa2, 2, 127, 0, 0, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0xc5u, request.readuint8(0));
+	ASSERT_EQ(tcan_can::SdoTransfer::computeCrc(data, sizeof(data)), request.readuint16(1));
+
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0xa1, 0, 0, 0, 0, 0, 0, 0}}));
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Done, transfer.getState());
+	ASSERT_EQ(20u, transfer.getLength());
+}
+
+TEST(sdo_transfer, segmented_download) {
+	const uint8_t data[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+	tcan_can::SdoTransfer transfer;
+	ASSERT_TRUE(transfer.setupDownload(1, 0x1f50, 1, data, sizeof(data)));
+	ASSERT_FALSE(transfer.setupDownload(1, 0x1f50, 1, data, sizeof(data)));
+	ASSERT_EQ(0x601u, transfer.getInitiateRequest().getCobId());
+	ASSERT_EQ(0x21u, transfer.getInitiateRequest().readuint8(0));
+	ASSERT_EQ(10u, transfer.getInitiateRequest().readuint32(4));
+
+	tcan_can::CanMsg request {0};
+	ASSERT_FALSE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x60, 0x51, 0x1f, 0x01, 0, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x60, 0x50, 0x1f, 0x01, 0, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x00u, request.readuint8(0));
+	ASSERT_TRUE(std::equal(data, data + 7, request.getData() + 1));
+	ASSERT_FALSE(transfer.getNextRequest(request));
+
+	// toggled, 4 bytes without data, last segment
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x20, 0, 0, 0, 0, 0, 0, 0}}));
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x19u, request.readuint8(0));
+	ASSERT_TRUE(std::equal(data + 7, data + 10, request.getData() + 1));
+
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x30, 0, 0, 0, 0, 0, 0, 0}}));
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Done, transfer.getState());
+	ASSERT_EQ(10u, transfer.getLength());
+	ASSERT_FALSE(transfer.getNextRequest(request));
+
+	// data of up to 4 bytes is sent expedited
+	ASSERT_TRUE(transfer.setupDownload(1, 0x6040, 0, data, 3));
+	ASSERT_EQ(0x27u, transfer.getInitiateRequest().readuint8(0));
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x60, 0x40, 0x60, 0x00, 0, 0, 0, 0}}));
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Done, transfer.getState());
+
+	// wrong toggle bit
+	ASSERT_TRUE(transfer.setupDownload(1, 0x1f50, 1, data, sizeof(data)));
+	transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x60, 0x50, 0x1f, 0x01, 0, 0, 0, 0}});
+	transfer.getNextRequest(request);
+	ASSERT_TRUE(transfer.handleAnswer(tcan_can::CanMsg{0x581u, {0x30, 0, 0, 0, 0, 0, 0, 0}}));
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Aborted, transfer.getState());
+	ASSERT_TRUE(transfer.getNextRequest(request));
+	ASSERT_EQ(0x80u, request.readuint8(0));
+	ASSERT_EQ(tcan_can::SdoTransfer::ToggleError, request.readuint32(4));
+}
+
+struct SdoDevice : public tcan_can::DeviceCanOpen {
+	using tcan_can::DeviceCanOpen::DeviceCanOpen;
+	bool initDevice() override {
+		bus_->addCanMessage(TxSDOId + getNodeId(), this, &tcan_can::DeviceCanOpen::parseSDOAnswer);
+		return true;
+	}
+	bool configureDevice(const tcan_can::CanMsg& /*msg*/) override { return true; }
+};
+
+TEST(device_canopen, sdo_async) {
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	auto* device = new SdoDevice{std::unique_ptr<tcan_can::DeviceCanOpenOptions>(new tcan_can::DeviceCanOpenOptions(0x1, "Sdo"))};
+	bus.addDevice(device);
+
+	unsigned int numCallbacks = 0;
+	tcan_can::SdoRequest read {[&numCallbacks](const tcan_can::SdoRequest& /*request*/) { ++numCallbacks; }};
+	tcan_can::SdoRequest write;
+
+	// requests are answered in order
+	ASSERT_TRUE(device->readSdoAsync(read, 0x1017, 0));
+	ASSERT_FALSE(device->readSdoAsync(read, 0x1017, 0));
+	ASSERT_TRUE(device->writeSdoAsync(write, 0x6040, 0, static_cast<uint16_t>(0x0f)));
+	ASSERT_TRUE(read.isPending());
+
+	bus.handleMessage(tcan_can::CanMsg{0x581u, {0x4b, 0x17, 0x10, 0x00, 0xe8, 0x03, 0xff, 0xff}});
+	ASSERT_TRUE(read.isDone());
+	ASSERT_EQ(2u, read.getLength());
+	ASSERT_EQ(1000u, read.getValue<uint16_t>());
+	ASSERT_EQ(1000u, read.getValue<uint32_t>());
+	ASSERT_EQ(1u, numCallbacks);
+
+	// an abort finishes the request, but does not stop the device
+	bus.handleMessage(tcan_can::CanMsg{0x581u, {0x80, 0x40, 0x60, 0x00, 0x02, 0x00, 0x01, 0x06}});
+	ASSERT_EQ(tcan_can::SdoRequest::State::Aborted, write.getState());
+	ASSERT_EQ(0x06010002u, write.getAbortCode());
+	ASSERT_FALSE(device->hasError());
+
+	// read answers of sendSdo(..) are stored
+	ASSERT_TRUE(device->sendSdo(tcan_can::SdoMsg(0x1, tcan_can::SdoMsg::Command::READ, 0x1018, 1, 0)));
+	bus.handleMessage(tcan_can::CanMsg{0x581u, {0x43, 0x18, 0x10, 0x01, 0x78, 0x56, 0x34, 0x12}});
+	tcan_can::SdoMsg answer(0x1, tcan_can::SdoMsg::Command::READ, 0x1018, 1, 0);
+	ASSERT_TRUE(device->getSdoAnswer(answer));
+	ASSERT_EQ(0x12345678u, answer.readuint32(4));
+	ASSERT_FALSE(device->getSdoAnswer(answer));
+
+	// a timeout of the request, after sending it twice
+	write.setTimeout(1, 1);
+	ASSERT_TRUE(device->writeSdoAsync(write, 0x6040, 0, static_cast<uint16_t>(0x0f)));
+	for(int i = 0; i < 6 && write.isPending(); ++i) {
+		device->sanityCheck();
+	}
+	ASSERT_EQ(tcan_can::SdoRequest::State::Aborted, write.getState());
+	ASSERT_EQ(tcan_can::SdoTransfer::TimeoutError, write.getAbortCode());
+	ASSERT_FALSE(device->hasError());
+}
+
+struct SdoBus : public tcan_can::CanBus {
+	SdoBus() : tcan_can::CanBus(std::make_unique<tcan_can::CanBusOptions>("Foo")) {}
+
+	//! @return messages in the output queue, which is emptied
+	std::vector<tcan_can::CanMsg> takeSent() {
+		std::lock_guard<std::mutex> guard(outgoingMsgsMutex_);
+		std::vector<tcan_can::CanMsg> sent(outgoingMsgs_.begin(), outgoingMsgs_.end());
+		outgoingMsgs_.clear();
+		return sent;
+	}
+
+protected:
+	bool initializeInterface() override { return true; }
+	bool readData() override { return false; }
+	bool writeData(std::unique_lock<std::mutex>* /*lock*/) override { return true; }
+};
+
+struct SdoTransferDevice : public SdoDevice {
+	using SdoDevice::SdoDevice;
+
+	void handleSdoTransfer(const tcan_can::SdoTransfer& transfer) override {
+		finished.push_back(transfer);
+	}
+
+	std::vector<tcan_can::SdoTransfer> finished;
+};
+
+TEST(device_canopen, sdo_transfer) {
+	SdoBus bus;
+	// the initiate request is sent again twice before the transfer times out
+	auto* device = new SdoTransferDevice{std::unique_ptr<tcan_can::DeviceCanOpenOptions>(new tcan_can::DeviceCanOpenOptions(0x1, "Sdo", 1, 1))};
+	bus.addDevice(device);
+	bus.takeSent();
+
+	// segmented download, the segments are sent on reception of the answers
+	const uint8_t data[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+	ASSERT_TRUE(device->downloadSdo(0x1f50, 1, data, sizeof(data)));
+	ASSERT_FALSE(device->downloadSdo(0x1f50, 1, data, sizeof(data)));
+	ASSERT_TRUE(device->isSdoTransferBusy());
+	auto sent = bus.takeSent();
+	ASSERT_EQ(1u, sent.size());
+	ASSERT_EQ(0x601u, sent[0].getCobId());
+	ASSERT_EQ(0x21u, sent[0].readuint8(0));
+
+	bus.handleMessage(tcan_can::CanMsg{0x581u, {0x60, 0x50, 0x1f, 0x01, 0, 0, 0, 0}});
+	sent = bus.takeSent();
+	ASSERT_EQ(1u, sent.size());
+	ASSERT_EQ(0x00u, sent[0].readuint8(0));
+	bus.handleMessage(tcan_can::CanMsg{0x581u, {0x20, 0, 0, 0, 0, 0, 0, 0}});
+	sent = bus.takeSent();
+	ASSERT_EQ(1u, sent.size());
+	ASSERT_EQ(0x19u, sent[0].readuint8(0));
+	ASSERT_TRUE(device->finished.empty());
+	bus.handleMessage(tcan_can::CanMsg{0x581u, {0x30, 0, 0, 0, 0, 0, 0, 0}});
+	ASSERT_EQ(1u, device->finished.size());
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Done, device->finished[0].getState());
+	ASSERT_EQ(10u, device->finished[0].getLength());
+	ASSERT_FALSE(device->isSdoTransferBusy());
+
+	// an abort of the server finishes the transfer, but does not stop the device
+	uint8_t buffer[16] = {};
+	ASSERT_TRUE(device->uploadSdo(0x1008, 0, buffer, sizeof(buffer)));
+	ASSERT_EQ(0x40u, bus.takeSent().at(0).readuint8(0));
+	bus.handleMessage(tcan_can::CanMsg{0x581u, {0x80, 0x08, 0x10, 0x00, 0x00, 0x00, 0x02, 0x06}});
+	ASSERT_EQ(2u, device->finished.size());
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Aborted, device->finished[1].getState());
+	ASSERT_EQ(0x06020000u, device->finished[1].getAbortCode());
+	ASSERT_TRUE(bus.takeSent().empty());
+	ASSERT_FALSE(device->isSdoTransferBusy());
+	ASSERT_FALSE(device->hasError());
+
+	// a timeout after sending the initiate request again, the transfer is aborted towards the server
+	ASSERT_TRUE(device->uploadSdo(0x1008, 0, buffer, sizeof(buffer)));
+	ASSERT_EQ(1u, bus.takeSent().size());
+	for(int i = 0; i < 6 && device->isSdoTransferBusy(); ++i) {
+		device->sanityCheck();
+	}
+	ASSERT_FALSE(device->isSdoTransferBusy());
+	ASSERT_EQ(3u, device->finished.size());
+	ASSERT_EQ(tcan_can::SdoTransfer::State::Aborted, device->finished[2].getState());
+	ASSERT_EQ(tcan_can::SdoTransfer::TimeoutError, device->finished[2].getAbortCode());
+	sent = bus.takeSent();
+	ASSERT_EQ(3u, sent.size());
+	ASSERT_EQ(0x40u, sent[0].readuint8(0));
+	ASSERT_EQ(0x40u, sent[1].readuint8(0));
+	ASSERT_EQ(0x80u, sent[2].readuint8(0));
+	ASSERT_EQ(tcan_can::SdoTransfer::TimeoutError, sent[2].readuint32(4));
+	ASSERT_FALSE(device->hasError());
+
+	// the next sdo is sent after the transfer
+	tcan_can::SdoRequest read;
+	ASSERT_TRUE(device->readSdoAsync(read, 0x1017, 0));
+	ASSERT_EQ(1u, bus.takeSent().size());
+	bus.handleMessage(tcan_can::CanMsg{0x581u, {0x4b, 0x17, 0x10, 0x00, 0xe8, 0x03, 0x00, 0x00}});
+	ASSERT_TRUE(read.isDone());
+	ASSERT_EQ(1000u, read.getValue<uint16_t>());
+}
+
+TEST(sdo_queue, handoff) {
+	tcan_can::SdoQueue queue(3);
+	ASSERT_EQ(4u, queue.capacity());
+
+	uint32_t position = 0;
+	for(uint16_t i = 0; i < 4; ++i) {
+		ASSERT_TRUE(queue.push(tcan_can::SdoMsg(1, tcan_can::SdoMsg::Command::READ, 0x2000 + i, 0, 0), position));
+		ASSERT_EQ(i, position);
+	}
+	ASSERT_FALSE(queue.push(tcan_can::SdoMsg(1, tcan_can::SdoMsg::Command::READ, 0x2004, 0, 0), position));
+
+	// the front is sent and popped once
+	tcan_can::SdoMsg msg;
+	ASSERT_TRUE(queue.peek(position, msg));
+	ASSERT_EQ(0x2000u, msg.getIndex());
+	ASSERT_FALSE(queue.isSent(position));
+	ASSERT_TRUE(queue.claimSend(position));
+	ASSERT_FALSE(queue.claimSend(position));
+	ASSERT_TRUE(queue.isSent(position));
+	ASSERT_TRUE(queue.pop(position));
+	ASSERT_FALSE(queue.pop(position));
+	ASSERT_TRUE(queue.push(tcan_can::SdoMsg(1, tcan_can::SdoMsg::Command::READ, 0x2004, 0, 0), position));
+	ASSERT_EQ(4u, position);
+	ASSERT_FALSE(queue.isSent(position));
+
+	// a producer and a consumer thread
+	std::atomic<bool> isCorrect{true};
+	std::thread producer([&queue]() {
+		uint32_t pushed;
+		for(uint16_t i = 5; i < 5000; ++i) {
+			while(!queue.push(tcan_can::SdoMsg(1, tcan_can::SdoMsg::Command::READ, i, 0, 0), pushed)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+	uint16_t expected = 1;
+	while(expected < 5000) {
+		if(queue.peek(position, msg)) {
+			isCorrect = isCorrect && (msg.getIndex() == (expected < 5 ? 0x2000 + expected : expected)) && queue.pop(position);
+			++expected;
+		}
+	}
+	producer.join();
+	ASSERT_TRUE(isCorrect);
+	ASSERT_TRUE(queue.isEmpty());
+}
+
+TEST(sdo_answer_table, store_take) {
+	tcan_can::SdoAnswerTable table(2);
+	const uint8_t first[8] = {0x4b, 0x17, 0x10, 0x00, 0xe8, 0x03, 0x00, 0x00};
+	uint8_t data[8] = {};
+
+	ASSERT_FALSE(table.take(0x101700, data));
+	ASSERT_TRUE(table.store(0x101700, first));
+	ASSERT_TRUE(table.take(0x101700, data));
+	ASSERT_TRUE(std::equal(first, first + 8, data));
+	ASSERT_FALSE(table.take(0x101700, data));
+
+	ASSERT_TRUE(table.store(0x101700, first));
+	table.erase(0x101700);
+	ASSERT_FALSE(table.take(0x101700, data));
+
+	// the slot of an answer which was erased or taken is reclaimed for other objects
+	const uint8_t second[8] = {0x4b, 0x08, 0x10, 0x00, 0x01, 0x00, 0x00, 0x00};
+	ASSERT_TRUE(table.store(0x100800, first));
+	ASSERT_TRUE(table.store(0x100900, second));
+	ASSERT_FALSE(table.store(0x101800, first));
+	ASSERT_TRUE(table.take(0x100800, data));
+	ASSERT_TRUE(table.store(0x101800, second));
+	ASSERT_FALSE(table.take(0x100800, data));
+	ASSERT_TRUE(table.take(0x100900, data));
+	ASSERT_TRUE(std::equal(second, second + 8, data));
+	ASSERT_TRUE(table.take(0x101800, data));
+	ASSERT_TRUE(std::equal(second, second + 8, data));
+
+	// more objects than slots, one at a time
+	for(uint32_t key = 0x200000; key < 0x201000; key += 0x100) {
+		ASSERT_TRUE(table.store(key, first));
+		ASSERT_TRUE(table.take(key, data));
+	}
+}
+
+struct ErrorFrameBus : public tcan_can::SocketBus {
+	using tcan_can::SocketBus::SocketBus;
+	using tcan_can::SocketBus::handleBusErrorMessage;
+};
+
+TEST(can_bus_error, decode) {
+	const tcan_can::CanMsg frame {CAN_ERR_FLAG | CAN_ERR_CRTL | CAN_ERR_PROT | CAN_ERR_BUSERROR,
+	                              {0, CAN_ERR_CRTL_RX_WARNING | CAN_ERR_CRTL_TX_WARNING, CAN_ERR_PROT_STUFF, CAN_ERR_PROT_LOC_ACK, 0, 0, 0, 0}};
+	const tcan_can::CanBusError error = tcan_can::CanBusError::fromFrame(frame);
+	ASSERT_TRUE(error.hasClass(tcan_can::CanBusError::BusError));
+	ASSERT_FALSE(error.hasClass(tcan_can::CanBusError::BusOff));
+
+	const std::string description = error.toString();
+	ASSERT_NE(std::string::npos, description.find("bus error (may flood!)"));
+	ASSERT_EQ(std::string::npos, description.find("bus off"));
+	ASSERT_NE(std::string::npos, description.find("reached warning level for RX errors, reached warning level for TX errors"));
+	ASSERT_NE(std::string::npos, description.find("bit stuffing error"));
+	ASSERT_NE(std::string::npos, description.find("ACK slot"));
+
+	// truncated output
+	char buffer[8];
+	ASSERT_EQ(description.size(), error.format(buffer, sizeof(buffer)));
+	ASSERT_EQ(description.substr(0, 7), std::string(buffer));
+}
+
+TEST(can_bus_error, counters) {
+	ErrorFrameBus bus {std::make_unique<tcan_can::SocketBusOptions>("Foo")};
+	const tcan_can::CanMsg busError {CAN_ERR_FLAG | CAN_ERR_BUSERROR, 8};
+	const tcan_can::CanMsg busOff {CAN_ERR_FLAG | CAN_ERR_BUSOFF | CAN_ERR_RESTARTED, 8};
+	for(int i = 0; i < 5; ++i) {
+		bus.handleBusErrorMessage(busError);
+	}
+	bus.handleBusErrorMessage(busOff);
+	ASSERT_TRUE(bus.getErrorMsgFlag());
+
+	const tcan_can::CanBusErrorCounters& counters = bus.getBusErrorCounters();
+	ASSERT_EQ(6u, counters.getNumErrorFrames());
+	ASSERT_EQ(5u, counters.getCount(tcan_can::CanBusError::BusError));
+	ASSERT_EQ(1u, counters.getCount(tcan_can::CanBusError::BusOff));
+	ASSERT_EQ(1u, counters.getCount(tcan_can::CanBusError::Restarted));
+	ASSERT_EQ(0u, counters.getCount(tcan_can::CanBusError::NoAck));
+
+	tcan_can::CanBusErrorCounters rates;
+	const auto start = tcan_can::CanBusErrorCounters::Clock::now();
+	rates.updateRates(start);
+	for(int i = 0; i < 10; ++i) {
+		rates.count(tcan_can::CanBusError::fromFrame(busError));
+	}
+	rates.updateRates(start + std::chrono::milliseconds(500));
+	ASSERT_DOUBLE_EQ(20.0, rates.getErrorFrameRate());
+	ASSERT_DOUBLE_EQ(20.0, rates.getRate(tcan_can::CanBusError::BusError));
+	ASSERT_DOUBLE_EQ(0.0, rates.getRate(tcan_can::CanBusError::BusOff));
+}
+
+struct PacedBus : public tcan_can::SocketBus {
+	explicit PacedBus(const tcan::BusOptions::Mode mode) : tcan_can::SocketBus(makeOptions(mode)) {}
+
+	static std::unique_ptr<tcan_can::SocketBusOptions> makeOptions(const tcan::BusOptions::Mode mode) {
+		auto options = std::make_unique<tcan_can::SocketBusOptions>("Foo");
+		options->mode_ = mode;
+		options->adaptiveTxPacing_ = true;
+		return options;
+	}
+
+	void setTxCapacity(const double capacity) { txCapacity_ = capacity; }
+
+	using tcan_can::SocketBus::handleTxCongestion;
+	using tcan_can::SocketBus::countSentFrame;
+};
+
+TEST(socket_bus, tx_capacity_window) {
+	PacedBus bus {tcan::BusOptions::Mode::Synchronous};
+
+	// the first frame starts the window, the capacity is only measured in congested windows
+	bus.countSentFrame();
+	for(int i = 0; i < 20; ++i) {
+		bus.countSentFrame();
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(110));
+	bus.countSentFrame();
+	ASSERT_EQ(0.0, bus.getTxCapacity());
+
+	// a synchronous bus returns right away, the message is retried on the next write
+	const auto start = std::chrono::steady_clock::now();
+	bus.handleTxCongestion(-1);
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+	ASSERT_EQ(1u, bus.getNumTxCongestions());
+	for(int i = 0; i < 20; ++i) {
+		bus.countSentFrame();
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(110));
+	bus.countSentFrame();
+	// 22 frames in at least 110 ms
+	ASSERT_GT(bus.getTxCapacity(), 0.0);
+	ASSERT_LE(bus.getTxCapacity(), 22.0 / 0.11);
+
+	// the next window is not congested, the capacity is kept
+	const double capacity = bus.getTxCapacity();
+	std::this_thread::sleep_for(std::chrono::milliseconds(110));
+	bus.countSentFrame();
+	ASSERT_EQ(capacity, bus.getTxCapacity());
+}
+
+TEST(socket_bus, tx_congestion_backoff) {
+	PacedBus bus {tcan::BusOptions::Mode::Asynchronous};
+
+	// poll(..) returns right away on a writable descriptor, as on a socket whose sndbuf could not be calibrated. The bus
+	// then waits for the drain time of a frame at the measured capacity.
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+	bus.setTxCapacity(100.0);
+	auto start = std::chrono::steady_clock::now();
+	bus.handleTxCongestion(fds[1]);
+	ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(10));
+
+	// without a measured capacity it waits 100 us
+	bus.setTxCapacity(0.0);
+	start = std::chrono::steady_clock::now();
+	bus.handleTxCongestion(fds[1]);
+	ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::microseconds(100));
+	ASSERT_EQ(2u, bus.getNumTxCongestions());
+	close(fds[0]);
+	close(fds[1]);
+}
+
+struct CongestedBus : public tcan_can::CanBus {
+	CongestedBus() : tcan_can::CanBus(makeOptions()) {}
+
+	static std::unique_ptr<tcan_can::CanBusOptions> makeOptions() {
+		auto options = std::make_unique<tcan_can::CanBusOptions>("Foo");
+		options->mode_ = tcan::BusOptions::Mode::Synchronous;
+		return options;
+	}
+
+	unsigned int numWrites = 0;
+
+protected:
+	bool initializeInterface() override { return true; }
+	bool readData() override { return false; }
+	// the netdevice does not take the message, as on ENOBUFS
+	bool writeData(std::unique_lock<std::mutex>* /*lock*/) override { ++numWrites; return false; }
+};
+
+TEST(bus_manager, write_congested_bus) {
+	tcan_can::CanBusManager manager;
+	auto* bus = new CongestedBus();
+	ASSERT_TRUE(manager.addBus(bus));
+	ASSERT_TRUE(bus->sendMessage(tcan_can::CanMsg{0x181u}));
+
+	// returns instead of retrying until the message is taken
+	ASSERT_FALSE(manager.writeMessagesSynchronous());
+	ASSERT_EQ(1u, bus->numWrites);
+	ASSERT_EQ(1u, bus->getNumOutgoingMessagesWithoutLock());
+}
+
+TEST(signal_layout, byte_aligned) {
+	using Layout = tcan::SignalLayout<
+		tcan::Signal<uint16_t, 0>,
+		tcan::Signal<int32_t, 16>,
+		tcan::Signal<int16_t, 48, 16, tcan::Endianness::Big>>;
+	ASSERT_EQ(8u, Layout::Size);
+
+	tcan_can::CanMsg msg {0x181u, 8};
+	ASSERT_TRUE(Layout::encode(Layout::Values{0x1234, -2, -300}, msg));
+	ASSERT_EQ(0x1234u, msg.readuint16(0));
+	ASSERT_EQ(-2, msg.readint32(2));
+	ASSERT_EQ(0xfe, msg.readuint8(6));
+	ASSERT_EQ(0xd4, msg.readuint8(7));
+
+	Layout::Values values;
+	ASSERT_TRUE(Layout::decode(msg, values));
+	ASSERT_TRUE(values == Layout::Values(0x1234, -2, -300));
+
+	tcan_can::CanMsg shortMsg {0x181u, 4};
+	ASSERT_FALSE(Layout::decode(shortMsg, values));
+	ASSERT_FALSE(Layout::encode(values, shortMsg));
+}
+
+TEST(signal_layout, bit_fields) {
+	using Layout = tcan::SignalLayout<
+		tcan::Signal<uint8_t, 0, 1>,
+		tcan::Signal<int8_t, 1, 3>,
+		tcan::Signal<uint16_t, 4, 12>,
+		tcan::Signal<uint16_t, 20, 10, tcan::Endianness::Big>>;
+	ASSERT_EQ(4u, Layout::Size);
+
+	const uint8_t bytes[4] = {0xff, 0xff, 0xff, 0xff};
+	tcan::GenericMsg msg(4, bytes);
+	ASSERT_TRUE(Layout::encode(Layout::Values{0, -3, 0xabc, 0x155}, msg));
+	// big endian signal starts at the upper bit of the low nibble of byte 2, bits not covered by a signal are kept
+	ASSERT_EQ(0xf5, msg.getData()[2]);
+	ASSERT_EQ(0x57, msg.getData()[3]);
+
+	Layout::Values values;
+	ASSERT_TRUE(Layout::decode(msg, values));
+	ASSERT_TRUE(values == Layout::Values(0, -3, 0xabc, 0x155));
+	ASSERT_EQ(0xabc, (Layout::get<2>(msg.getData())));
+
+	Layout::set<1>(msg.getData(), 3);
+	ASSERT_EQ(3, (Layout::get<1>(msg.getData())));
+	ASSERT_EQ(0xabc, (Layout::get<2>(msg.getData())));
+}
+
+TEST(signal_layout, full_width_signed) {
+	using Layout32 = tcan::SignalLayout<tcan::Signal<int32_t, 0>, tcan::Signal<int32_t, 32, 32, tcan::Endianness::Big>>;
+	using Layout64 = tcan::SignalLayout<tcan::Signal<int64_t, 0>>;
+
+	// the sign bit is the upper bit of the raw type
+	tcan_can::CanMsg msg {0x181u, 8};
+	ASSERT_TRUE(Layout32::encode(Layout32::Values{INT32_MIN, INT32_MIN}, msg));
+	Layout32::Values values32;
+	ASSERT_TRUE(Layout32::decode(msg, values32));
+	ASSERT_TRUE(values32 == Layout32::Values(INT32_MIN, INT32_MIN));
+	ASSERT_TRUE(Layout32::encode(Layout32::Values{INT32_MAX, -1}, msg));
+	ASSERT_TRUE(Layout32::decode(msg, values32));
+	ASSERT_TRUE(values32 == Layout32::Values(INT32_MAX, -1));
+
+	ASSERT_TRUE(Layout64::encode(Layout64::Values{INT64_MIN}, msg));
+	ASSERT_EQ(0x80u, msg.readuint8(7));
+	Layout64::Values values64;
+	ASSERT_TRUE(Layout64::decode(msg, values64));
+	ASSERT_EQ(INT64_MIN, std::get<0>(values64));
+	ASSERT_TRUE(Layout64::encode(Layout64::Values{INT64_MAX}, msg));
+	ASSERT_TRUE(Layout64::decode(msg, values64));
+	ASSERT_EQ(INT64_MAX, std::get<0>(values64));
+}
+
+TEST(signal_layout, scaled) {
+	using Temperature = tcan::ScaledSignal<double, tcan::Signal<int16_t, 0>, std::ratio<1, 10>, std::ratio<-40>>;
+	using Voltage = tcan::ScaledSignal<float, tcan::Signal<uint8_t, 16>, std::ratio<1, 4>>;
+	using Layout = tcan::SignalLayout<Temperature, Voltage>;
+
+	tcan_can::CanMsg msg {0x281u, Layout::Size};
+	ASSERT_TRUE(Layout::encode(Layout::Values{21.5, 12.25f}, msg));
+	ASSERT_EQ(615, msg.readint16(0));
+	ASSERT_EQ(49u, msg.readuint8(2));
+
+	Layout::Values values;
+	ASSERT_TRUE(Layout::decode(msg, values));
+	ASSERT_DOUBLE_EQ(21.5, std::get<0>(values));
+	ASSERT_FLOAT_EQ(12.25f, std::get<1>(values));
+}
+
+struct PdoFeedback {
+	uint16_t statusword_;
+	int32_t position_;
+	bool enabled_;
+	uint8_t mode_;
+};
+
+using PdoFeedbackMapping = tcan_can::PdoMapping<PdoFeedback,
+	tcan_can::PdoEntry<PdoFeedback, uint16_t, &PdoFeedback::statusword_, 0x6041, 0x00>,
+	tcan_can::PdoEntry<PdoFeedback, int32_t, &PdoFeedback::position_, 0x6064, 0x00>,
+	tcan_can::PdoEntry<PdoFeedback, bool, &PdoFeedback::enabled_, 0x2000, 0x01, 1>,
+	tcan_can::PdoEntry<PdoFeedback, uint8_t, &PdoFeedback::mode_, 0x2000, 0x02, 7>>;
+
+TEST(pdo_mapping, configuration_sdos) {
+	std::array<tcan_can::SdoMsg, PdoFeedbackMapping::MaxConfigurationSdos> sdos;
+	const tcan_can::PdoParameters tpdo(tcan_can::PdoType::Transmit, 2, 0x40000285u, 1, 0, 10);
+	ASSERT_EQ(10u, PdoFeedbackMapping::getConfigurationSdos(5, tpdo, sdos));
+
+	const uint8_t commands[] = {0x23, 0x2f, 0x23, 0x23, 0x23, 0x23, 0x2f, 0x2f, 0x2b, 0x23};
+	const uint16_t indices[] = {0x1801, 0x1A01, 0x1A01, 0x1A01, 0x1A01, 0x1A01, 0x1A01, 0x1801, 0x1801, 0x1801};
+	const uint8_t subIndices[] = {1, 0, 1, 2, 3, 4, 0, 2, 5, 1};
+	// the inhibit time is kept, the mapping is cleared before it is written
+	const uint32_t data[] = {0xC0000285u, 0, 0x60410010u, 0x60640020u, 0x20000101u, 0x20000207u, 4, 1, 10, 0x40000285u};
+	for(unsigned int i = 0; i < 10; ++i) {
+		const tcan_can::SdoMsgView sdo(sdos[i]);
+		ASSERT_EQ(0x605u, sdos[i].getCobId());
+		ASSERT_EQ(commands[i], sdo.getCommandByte());
+		ASSERT_EQ(indices[i], sdo.getIndex());
+		ASSERT_EQ(subIndices[i], sdo.getSubIndex());
+		ASSERT_EQ(data[i], sdo.getData());
+	}
+
+	// the event timer is kept
+	const tcan_can::PdoParameters rpdo(tcan_can::PdoType::Receive, 1, 0x205u, 1, 100);
+	ASSERT_EQ(9u, PdoFeedbackMapping::getConfigurationSdos(5, rpdo, sdos));
+	ASSERT_EQ(0x1600, tcan_can::SdoMsgView(sdos[1]).getIndex());
+	ASSERT_EQ(0x1400, tcan_can::SdoMsgView(sdos[8]).getIndex());
+	ASSERT_EQ(0x205u, tcan_can::SdoMsgView(sdos[8]).getData());
+}
+
+TEST(pdo_mapping, decode_encode) {
+	ASSERT_EQ(56u, PdoFeedbackMapping::BitLength);
+	ASSERT_EQ(7u, PdoFeedbackMapping::Size);
+
+	tcan_can::CanMsg msg {0x285u, PdoFeedbackMapping::Size};
+	ASSERT_TRUE(PdoFeedbackMapping::encode(PdoFeedback{0x1237, -100000, true, 0x55}, msg));
+	ASSERT_EQ(0x1237u, msg.readuint16(0));
+	ASSERT_EQ(-100000, msg.readint32(2));
+	ASSERT_EQ(0xab, msg.readuint8(6));
+
+	PdoFeedback feedback {0, 0, false, 0};
+	ASSERT_TRUE(PdoFeedbackMapping::decode(msg, feedback));
+	ASSERT_EQ(0x1237u, feedback.statusword_);
+	ASSERT_EQ(-100000, feedback.position_);
+	ASSERT_TRUE(feedback.enabled_);
+	ASSERT_EQ(0x55u, feedback.mode_);
+
+	tcan_can::CanMsg shortMsg {0x285u, 6};
+	ASSERT_FALSE(PdoFeedbackMapping::decode(shortMsg, feedback));
+
+	struct Setpoint {
+		float torque_;
+		int16_t velocity_;
+	};
+	using SetpointMapping = tcan_can::PdoMapping<Setpoint,
+		tcan_can::PdoEntry<Setpoint, float, &Setpoint::torque_, 0x6071, 0x00>,
+		tcan_can::PdoEntry<Setpoint, int16_t, &Setpoint::velocity_, 0x60ff, 0x00>>;
+	uint8_t data[SetpointMapping::Size];
+	SetpointMapping::encode(Setpoint{-1.5f, -2}, data);
+	ASSERT_EQ(0x00, data[0]);
+	ASSERT_EQ(0xbf, data[3]);
+	Setpoint setpoint {0.f, 0};
+	SetpointMapping::decode(data, setpoint);
+	ASSERT_FLOAT_EQ(-1.5f, setpoint.torque_);
+	ASSERT_EQ(-2, setpoint.velocity_);
+}
+
+struct RoutedBus : public tcan_can::SocketBus {
+	RoutedBus(const std::string& name, const int interfaceIndex) : tcan_can::SocketBus(std::make_unique<tcan_can::SocketBusOptions>(name)) {
+		interfaceIndex_ = interfaceIndex;
+	}
+
+	void setInterfaceIndex(const int interfaceIndex) { interfaceIndex_ = interfaceIndex; }
+};
+
+struct RoutingReceiver : public tcan_can::SocketBusReceiver {
+	RoutingReceiver() : tcan_can::SocketBusReceiver(std::make_unique<tcan_can::SocketBusOptions>("All")) {}
+
+	void add(tcan_can::SocketBus* bus) {
+		buses_.update([bus](BusContainer& buses) { buses.push_back(bus); });
+	}
+
+	using tcan_can::SocketBusReceiver::routeFrame;
+};
+
+TEST(socket_bus_receiver, route_frames) {
+	RoutedBus bus {"Foo", 3};
+	BarDevice dev {0x1, "Bar"};
+	bus.addCanMessage(0x181u, &dev, &BarDevice::callMe);
+	RoutingReceiver receiver;
+	receiver.add(&bus);
+
+	tcan_can::CanMsg msg {0x181u, 1};
+	receiver.routeFrame(msg, CAN_MTU, 3);
+	ASSERT_TRUE(dev.wasCalled());
+
+	receiver.routeFrame(msg, CAN_MTU, 4);
+	ASSERT_FALSE(dev.wasCalled());
+	ASSERT_EQ(1u, receiver.getNumUnroutedFrames());
+}
+
+TEST(socket_bus_receiver, follow_reopened_interface) {
+	RoutedBus bus {"Foo", 3};
+	BarDevice dev {0x1, "Bar"};
+	bus.addCanMessage(0x181u, &dev, &BarDevice::callMe);
+	RoutingReceiver receiver;
+	receiver.add(&bus);
+
+	// the interface was added again and the bus reopened its socket
+	bus.setInterfaceIndex(5);
+	tcan_can::CanMsg msg {0x181u, 1};
+	receiver.routeFrame(msg, CAN_MTU, 3);
+	ASSERT_FALSE(dev.wasCalled());
+	receiver.routeFrame(msg, CAN_MTU, 5);
+	ASSERT_TRUE(dev.wasCalled());
+}
+
+struct RecordingBus : public tcan_can::CanBus {
+	explicit RecordingBus(const std::string& name) : tcan_can::CanBus(std::make_unique<tcan_can::CanBusOptions>(name)) {}
+
+	bool sendMessageDirectly(const tcan_can::CanMsg& msg) override {
+		std::lock_guard<std::mutex> guard(mutex);
+		sent.push_back(msg);
+		return true;
+	}
+
+	std::vector<tcan_can::CanMsg> getSent() {
+		std::lock_guard<std::mutex> guard(mutex);
+		return sent;
+	}
+
+protected:
+	bool initializeInterface() override { return true; }
+	bool readData() override { return false; }
+	bool writeData(std::unique_lock<std::mutex>* /*lock*/) override { return true; }
+
+	std::mutex mutex;
+	std::vector<tcan_can::CanMsg> sent;
+};
+
+TEST(sync_producer, cycles) {
+	RecordingBus first {"First"};
+	RecordingBus second {"Second"};
+	auto options = std::make_unique<tcan_can::SyncProducerOptions>("Sync");
+	options->cyclePeriod_ = 10000;
+	options->syncCounterOverflow_ = 3;
+	options->syncWindowLength_ = 8000;
+	options->rpdoOffset_ = 200;
+	options->priorityThread_ = 0;
+	tcan_can::SyncProducer producer(std::move(options));
+
+	unsigned int rpdoIndex = 0;
+	ASSERT_TRUE(producer.addBus(&first));
+	ASSERT_TRUE(producer.addBus(&second));
+	ASSERT_TRUE(producer.addRpdo(&second, tcan_can::CanMsg{0x205u, {1}}, rpdoIndex));
+	ASSERT_TRUE(producer.initialize());
+	const int timerFd = producer.getPollableFileDescriptor();
+	ASSERT_FALSE(producer.initialize());
+	ASSERT_EQ(timerFd, producer.getPollableFileDescriptor());
+	ASSERT_FALSE(producer.addBus(&first));
+
+	for(int i = 0; i < 4; ++i) {
+		ASSERT_TRUE(producer.produceSync());
+		// the RPDO burst is sent 200 us after the start of the cycle, within the window of 8000 us
+		const bool isInSyncWindow = producer.isInSyncWindow();
+		ASSERT_TRUE(isInSyncWindow || std::chrono::steady_clock::now() >= producer.getLastSyncTime() + std::chrono::microseconds(8000));
+		ASSERT_TRUE(producer.setRpdo(rpdoIndex, tcan_can::CanMsg{0x205u, {static_cast<uint8_t>(i + 2)}}));
+	}
+	std::this_thread::sleep_until(producer.getLastSyncTime() + std::chrono::microseconds(8000));
+	ASSERT_FALSE(producer.isInSyncWindow());
+	ASSERT_FALSE(producer.setRpdo(rpdoIndex + 1, tcan_can::CanMsg{0x205u}));
+
+	// SYNCs carry the counter, the RPDO follows the SYNC
+	const auto sentFirst = first.getSent();
+	const auto sentSecond = second.getSent();
+	ASSERT_EQ(4u, sentFirst.size());
+	ASSERT_EQ(8u, sentSecond.size());
+	const uint8_t counters[] = {1, 2, 3, 1};
+	for(unsigned int i = 0; i < 4; ++i) {
+		ASSERT_EQ(0x80u, sentFirst[i].getCobId());
+		ASSERT_EQ(counters[i], sentFirst[i].readuint8(0));
+		ASSERT_EQ(0x80u, sentSecond[2 * i].getCobId());
+		ASSERT_EQ(0x205u, sentSecond[2 * i + 1].getCobId());
+		ASSERT_EQ(i + 1, sentSecond[2 * i + 1].readuint8(0));
+	}
+	ASSERT_EQ(1, producer.getCounter());
+
+	const tcan_can::SyncProducerStatistics statistics = producer.getStatistics();
+	ASSERT_EQ(4u, statistics.numSyncs_);
+	ASSERT_EQ(0u, statistics.numWindowOverruns_);
+	ASSERT_GE(statistics.minLatency_, 0.0);
+	ASSERT_GE(statistics.maxLatency_, statistics.meanLatency_);
+	ASSERT_GE(statistics.jitter_, 0.0);
+
+	producer.resetStatistics();
+	ASSERT_EQ(0u, producer.getStatistics().numSyncs_);
+}
+
+TEST(sync_producer, window_overrun) {
+	RecordingBus bus {"Bus"};
+	auto options = std::make_unique<tcan_can::SyncProducerOptions>("Sync");
+	options->cyclePeriod_ = 2000;
+	options->syncWindowLength_ = 500;
+	options->rpdoOffset_ = 600;
+	options->priorityThread_ = 0;
+	tcan_can::SyncProducer producer(std::move(options));
+
+	unsigned int rpdoIndex = 0;
+	ASSERT_TRUE(producer.addBus(&bus));
+	ASSERT_TRUE(producer.addRpdo(&bus, tcan_can::CanMsg{0x205u, {1}}, rpdoIndex));
+	ASSERT_TRUE(producer.initialize());
+	producer.startThread();
+	std::this_thread::sleep_for(std::chrono::milliseconds(9));
+	producer.stopThread();
+
+	// the RPDOs are sent after the window, so they are dropped
+	const auto sent = bus.getSent();
+	ASSERT_FALSE(sent.empty());
+	for(const auto& msg : sent) {
+		ASSERT_EQ(0x80u, msg.getCobId());
+		ASSERT_EQ(0u, msg.getLength());
+	}
+	const tcan_can::SyncProducerStatistics statistics = producer.getStatistics();
+	ASSERT_EQ(sent.size(), statistics.numSyncs_);
+	ASSERT_EQ(statistics.numSyncs_, statistics.numWindowOverruns_);
+}
+
+static bool passesFilters(const std::vector<can_filter>& filters, const uint32_t cobId) {
+	for(const auto& filter : filters) {
+		if(((cobId ^ filter.can_id) & filter.can_mask) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+TEST(can_filter_calculator, remove_covered) {
+	const std::vector<tcan_can::CanFrameIdentifier> matchers {
+		tcan_can::CanFrameIdentifier{0x181}, tcan_can::CanFrameIdentifier{0x180, 0x780},
+		tcan_can::CanFrameIdentifier{0x181}, tcan_can::CanFrameIdentifier{0x201}};
+
+	const auto filters = tcan_can::computeCanFilters(matchers);
+	ASSERT_EQ(2u, filters.size());
+	ASSERT_TRUE(passesFilters(filters, 0x181));
+	ASSERT_TRUE(passesFilters(filters, 0x1ff));
+	ASSERT_TRUE(passesFilters(filters, 0x201));
+	ASSERT_FALSE(passesFilters(filters, 0x202));
+	ASSERT_FALSE(passesFilters(filters, 0x80000201));
+}
+
+TEST(can_filter_calculator, merge_to_limit) {
+	std::vector<tcan_can::CanFrameIdentifier> matchers;
+	for(uint32_t nodeId = 1; nodeId <= 8; ++nodeId) {
+		matchers.emplace_back(0x180 + nodeId);
+		matchers.emplace_back(0x580 + nodeId);
+	}
+
+	const auto filters = tcan_can::computeCanFilters(matchers, 2);
+	ASSERT_EQ(2u, filters.size());
+	for(const auto& matcher : matchers) {
+		ASSERT_TRUE(passesFilters(filters, matcher.identifier));
+	}
+	ASSERT_FALSE(passesFilters(filters, 0x201));
+	ASSERT_FALSE(passesFilters(filters, 0x80000181));
+}
+
 int main(int argc, char* argv[]) {
 	testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
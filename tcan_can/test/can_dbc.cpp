@@ -0,0 +1,312 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+#include "tcan_can/CanBatchDecoder.hpp"
+#include "tcan_can/CanDbc.hpp"
+#include "tcan_can/CanDbcDecodeTable.hpp"
+#include "tcan_can/DeviceDbc.hpp"
+#include "tcan_can/SocketBus.hpp"
+
+// count allocations to check that decoding does not allocate
+static std::atomic<std::size_t> numAllocations {0};
+
+// not inlined, gcc would otherwise report a mismatch between malloc() and delete, or new and free()
+__attribute__((noinline)) void* operator new(std::size_t size) {
+	++numAllocations;
+	if(void* ptr = std::malloc(size == 0 ? 1 : size)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+__attribute__((noinline)) void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+	std::free(ptr);
+}
+
+static const char* testDbc = R"(VERSION ""
+
+NS_ :
+	CM_
+
+BS_:
+
+BU_: ECU
+
+BO_ 2364540158 EEC1: 8 ECU
+ SG_ EngineSpeed : 24|16@1+ (0.125,0) [0|8031.875] "rpm" Vector__XXX
+ SG_ EngineTorqueMode : 0|4@1+ (1,0) [0|15] "" Vector__XXX
+ SG_ ActualTorque : 16|8@1+ (1,-125) [-125|125] "%" Vector__XXX
+
+BO_ 291 Motorola: 8 ECU
+ SG_ Temperature : 7|12@0- (0.5,0) [-1024|1023.5] "degC" Vector__XXX
+ SG_ Flag : 11|1@0+ (1,0) [0|1] "" Vector__XXX
+
+BO_ 292 Muxed: 8 ECU
+ SG_ Value0 m0 : 8|16@1- (1,0) [0|0] "" Vector__XXX
+ SG_ Page M : 0|8@1+ (1,0) [0|255] "" Vector__XXX
+ SG_ Value1 m1 : 8|32@1+ (0.01,0) [0|0] "V" Vector__XXX
+
+BO_ 3221225472 VECTOR__INDEPENDENT_SIG_MSG: 0 Vector__XXX
+ SG_ Orphan : 0|8@1+ (1,0) [0|0] "" Vector__XXX
+
+CM_ SG_ 291 Temperature "Coolant temperature";
+)";
+
+static tcan_can::CanDbc loadTestDbc() {
+	tcan_can::CanDbc dbc;
+	std::istringstream stream(testDbc);
+	EXPECT_TRUE(dbc.parse(stream));
+	return dbc;
+}
+
+TEST(can_dbc, parse) {
+	const auto dbc = loadTestDbc();
+	ASSERT_EQ(3u, dbc.getMessages().size());
+	ASSERT_EQ(8u, dbc.getNumSignals());
+
+	const tcan_can::CanDbcMessage* eec1 = dbc.getMessage(0x8cf004feu);
+	ASSERT_TRUE(eec1 != nullptr);
+	ASSERT_EQ("EEC1", eec1->name_);
+	ASSERT_EQ(8u, eec1->length_);
+	ASSERT_EQ(3u, eec1->signals_.size());
+	ASSERT_EQ("rpm", eec1->signals_[0].unit_);
+	ASSERT_DOUBLE_EQ(0.125, eec1->signals_[0].factor_);
+	ASSERT_DOUBLE_EQ(-125.0, eec1->signals_[2].offset_);
+
+	const tcan_can::CanDbcMessage* motorola = dbc.getMessage(291);
+	ASSERT_TRUE(motorola != nullptr);
+	ASSERT_TRUE(motorola->signals_[0].isBigEndian_);
+	ASSERT_TRUE(motorola->signals_[0].isSigned_);
+
+	ASSERT_EQ(4u, dbc.getSignalIndex("Motorola", "Flag"));
+	ASSERT_EQ(tcan_can::CanDbc::InvalidSignalIndex, dbc.getSignalIndex("Motorola", "Orphan"));
+
+	tcan_can::CanDbc invalid;
+	std::istringstream stream("BO_ 100 Short: 2 ECU\n SG_ TooLong : 8|16@1+ (1,0) [0|0] \"\" ECU\n");
+	ASSERT_FALSE(invalid.parse(stream));
+}
+
+TEST(can_dbc, decode) {
+	const auto dbc = loadTestDbc();
+	const tcan_can::CanDbcDecodeTable table(dbc);
+	std::vector<double> values(table.getNumSignals(), 0.0);
+
+	ASSERT_EQ(3u, table.decode(tcan_can::CanMsg(0x8cf004feu, {0x03, 0x00, 150, 0x40, 0x1f, 0x00, 0x00, 0x00}), values.data()));
+	ASSERT_DOUBLE_EQ(1000.0, values[dbc.getSignalIndex("EEC1", "EngineSpeed")]);
+	ASSERT_DOUBLE_EQ(3.0, values[dbc.getSignalIndex("EEC1", "EngineTorqueMode")]);
+	ASSERT_DOUBLE_EQ(25.0, values[dbc.getSignalIndex("EEC1", "ActualTorque")]);
+
+	// temperature -20.5 (raw -41 = 0xfd7) in the upper 12 bits, flag in bit 3 of byte 1
+	ASSERT_EQ(2u, table.decode(tcan_can::CanMsg(291, {0xfd, 0x78, 0, 0, 0, 0, 0, 0}), values.data()));
+	ASSERT_DOUBLE_EQ(-20.5, values[dbc.getSignalIndex("Motorola", "Temperature")]);
+	ASSERT_DOUBLE_EQ(1.0, values[dbc.getSignalIndex("Motorola", "Flag")]);
+
+	// unknown and too short messages are not decoded
+	ASSERT_EQ(0u, table.decode(tcan_can::CanMsg(0x100, {0, 0, 0, 0, 0, 0, 0, 0}), values.data()));
+	ASSERT_EQ(0u, table.decode(tcan_can::CanMsg(291, {0xff, 0xff}), values.data()));
+	ASSERT_DOUBLE_EQ(-20.5, values[dbc.getSignalIndex("Motorola", "Temperature")]);
+}
+
+TEST(can_dbc, multiplexed) {
+	const auto dbc = loadTestDbc();
+	const tcan_can::CanDbcDecodeTable table(dbc);
+	std::vector<double> values(table.getNumSignals(), 0.0);
+	const uint32_t value0 = dbc.getSignalIndex("Muxed", "Value0");
+	const uint32_t value1 = dbc.getSignalIndex("Muxed", "Value1");
+
+	ASSERT_EQ(2u, table.decode(tcan_can::CanMsg(292, {1, 0xd2, 0x04, 0, 0, 0, 0, 0}), values.data()));
+	ASSERT_DOUBLE_EQ(1.0, values[dbc.getSignalIndex("Muxed", "Page")]);
+	ASSERT_DOUBLE_EQ(12.34, values[value1]);
+	ASSERT_DOUBLE_EQ(0.0, values[value0]);
+
+	ASSERT_EQ(2u, table.decode(tcan_can::CanMsg(292, {0, 0xfe, 0xff, 0, 0, 0, 0, 0}), values.data()));
+	ASSERT_DOUBLE_EQ(-2.0, values[value0]);
+	ASSERT_DOUBLE_EQ(12.34, values[value1]);
+}
+
+TEST(can_dbc, device) {
+	const auto dbc = loadTestDbc();
+	auto table = std::make_shared<const tcan_can::CanDbcDecodeTable>(dbc);
+
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	auto* device = new tcan_can::DeviceDbc("Dbc", table);
+	ASSERT_TRUE(bus.addDevice(device));
+
+	bus.handleMessage(tcan_can::CanMsg(0x8cf004feu, {0x03, 0x00, 150, 0x40, 0x1f, 0x00, 0x00, 0x00}));
+	ASSERT_DOUBLE_EQ(1000.0, device->getSignalValue(dbc.getSignalIndex("EEC1", "EngineSpeed")));
+	ASSERT_TRUE(device->isActive());
+}
+
+TEST(can_dbc, batch_decode) {
+	const auto dbc = loadTestDbc();
+	auto table = std::make_shared<const tcan_can::CanDbcDecodeTable>(dbc);
+	const tcan_can::CanBatchDecoder decoder(table);
+
+	// frames of the multiplexed message with varying payload, one too short and one of another message
+	std::vector<tcan_can::CanMsg> frames;
+	for(uint8_t i = 0; i < 200; ++i) {
+		frames.emplace_back(292, std::initializer_list<uint8_t>{static_cast<uint8_t>(i % 2), i, static_cast<uint8_t>(0xff - i), static_cast<uint8_t>(3 * i), 0x80, 0, 0, 0});
+	}
+	frames[17] = tcan_can::CanMsg(292, {0, 0});
+	frames[33] = tcan_can::CanMsg(291, {0, 0, 0, 0, 0, 0, 0, 0});
+
+	std::vector<std::vector<double>> columns(table->getNumSignals(), std::vector<double>(frames.size(), 0.0));
+	std::vector<double*> columnPtrs(table->getNumSignals(), nullptr);
+	const uint32_t page = dbc.getSignalIndex("Muxed", "Page");
+	const uint32_t value0 = dbc.getSignalIndex("Muxed", "Value0");
+	const uint32_t value1 = dbc.getSignalIndex("Muxed", "Value1");
+	for(const uint32_t index : {page, value0, value1}) {
+		columnPtrs[index] = columns[index].data();
+	}
+	ASSERT_EQ(frames.size() - 2, decoder.decode(frames.data(), frames.size(), columnPtrs.data()));
+
+	for(std::size_t i = 0; i < frames.size(); ++i) {
+		if(i == 17 || i == 33) {
+			ASSERT_TRUE(std::isnan(columns[page][i]));
+			ASSERT_TRUE(std::isnan(columns[value1][i]));
+			continue;
+		}
+		std::vector<double> values(table->getNumSignals(), std::nan(""));
+		ASSERT_EQ(2u, table->decode(frames[i], values.data()));
+		for(const uint32_t index : {page, value0, value1}) {
+			if(std::isnan(values[index])) {
+				ASSERT_TRUE(std::isnan(columns[index][i]));
+			}else{
+				ASSERT_DOUBLE_EQ(values[index], columns[index][i]);
+			}
+		}
+	}
+
+	std::vector<int64_t> raw(frames.size(), 0);
+	std::vector<int64_t*> rawPtrs(table->getNumSignals(), nullptr);
+	rawPtrs[value0] = raw.data();
+	ASSERT_EQ(frames.size() - 2, decoder.decodeRaw(frames.data(), frames.size(), rawPtrs.data()));
+	ASSERT_EQ(static_cast<int16_t>(0xff00), raw[0]);
+	ASSERT_EQ(0, raw[1]);
+}
+
+//! Generates a DBC with numMessages messages of 8 bytes, each holding signals of various sizes and byte orders
+static std::string generateDbc(const uint32_t numMessages) {
+	std::ostringstream dbc;
+	for(uint32_t i = 0; i < numMessages; ++i) {
+		const uint32_t id = (i % 2 == 0) ? 0x100 + i : (0x80000000u | (0x18ff0000u + i));
+		dbc << "BO_ " << id << " Msg" << i << ": 8 ECU\n";
+		dbc << " SG_ A" << i << " : 0|4@1+ (1,0) [0|15] \"\" ECU\n";
+		dbc << " SG_ B" << i << " : 4|12@1- (0.1,-5) [0|0] \"\" ECU\n";
+		dbc << " SG_ C" << i << " : 16|16@1+ (0.125,0) [0|0] \"rpm\" ECU\n";
+		dbc << " SG_ D" << i << " : 39|8@0+ (1,-40) [0|0] \"degC\" ECU\n";
+		dbc << " SG_ E" << i << " : 47|8@0- (0.01,0) [0|0] \"\" ECU\n";
+		dbc << " SG_ F" << i << " : 63|3@0+ (1,0) [0|0] \"\" ECU\n";
+		dbc << " SG_ G" << i << " : 60|5@0+ (1,0) [0|0] \"\" ECU\n";
+		dbc << " SG_ H" << i << " : 48|8@1+ (1,0) [0|0] \"\" ECU\n";
+	}
+	return dbc.str();
+}
+
+TEST(can_dbc, decode_benchmark) {
+	constexpr uint32_t numMessages = 500;
+	constexpr uint32_t numFrames = 2000000;
+	// upper bound of the frame rate of a classic CAN bus at 1 Mbit/s with 8 byte frames
+	constexpr double fullBusRate = 9000.0;
+
+	tcan_can::CanDbc dbc;
+	std::istringstream stream(generateDbc(numMessages));
+	ASSERT_TRUE(dbc.parse(stream));
+	auto table = std::make_shared<const tcan_can::CanDbcDecodeTable>(dbc);
+	ASSERT_EQ(8 * numMessages, table->getNumSignals());
+
+	std::vector<tcan_can::CanMsg> frames;
+	for(const auto& message : dbc.getMessages()) {
+		frames.emplace_back(message.cobId_, std::initializer_list<uint8_t>{0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0});
+	}
+
+	// decode table only
+	std::vector<double> values(table->getNumSignals(), 0.0);
+	uint64_t numDecoded = 0;
+	numAllocations = 0;
+	auto start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < numFrames; ++i) {
+		numDecoded += table->decode(frames[i % numMessages], values.data());
+	}
+	const double tableDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ASSERT_EQ(0u, numAllocations.load());
+	ASSERT_EQ(8ull * numFrames, numDecoded);
+
+	// through the bus dispatch into a device
+	tcan_can::SocketBus bus { std::make_unique<tcan_can::SocketBusOptions>("Foo") };
+	auto* device = new tcan_can::DeviceDbc("Dbc", table);
+	ASSERT_TRUE(bus.addDevice(device));
+	numAllocations = 0;
+	start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < numFrames; ++i) {
+		bus.handleMessage(frames[i % numMessages]);
+	}
+	const double busDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ASSERT_EQ(0u, numAllocations.load());
+	ASSERT_DOUBLE_EQ(values[dbc.getSignalIndex("Msg7", "E7")], device->getSignalValue(dbc.getSignalIndex("Msg7", "E7")));
+
+	const double tableRate = numFrames / tableDuration;
+	const double busRate = numFrames / busDuration;
+	std::cout << "Decoded " << numFrames << " frames of " << numMessages << " messages: " << tableRate << " frames/s (decode table), "
+	          << busRate << " frames/s (bus and device), " << busRate / fullBusRate << " times the rate of a full 1 Mbit/s bus" << std::endl;
+	ASSERT_GT(busRate, fullBusRate);
+}
+
+TEST(can_dbc, batch_benchmark) {
+	constexpr uint32_t numFrames = 1000000;
+
+	tcan_can::CanDbc dbc;
+	std::istringstream stream(generateDbc(1));
+	ASSERT_TRUE(dbc.parse(stream));
+	auto table = std::make_shared<const tcan_can::CanDbcDecodeTable>(dbc);
+	const tcan_can::CanBatchDecoder decoder(table);
+
+	std::vector<tcan_can::CanMsg> frames;
+	frames.reserve(numFrames);
+	for(uint32_t i = 0; i < numFrames; ++i) {
+		const uint8_t b = static_cast<uint8_t>(i);
+		frames.emplace_back(dbc.getMessages()[0].cobId_, std::initializer_list<uint8_t>{b, 0x34, b, 0x78, 0x9a, b, 0xde, 0xf0});
+	}
+
+	// frame by frame, copying the values into columns
+	std::vector<std::vector<double>> columns(table->getNumSignals(), std::vector<double>(numFrames, 0.0));
+	std::vector<double> values(table->getNumSignals(), 0.0);
+	auto start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < numFrames; ++i) {
+		table->decode(frames[i], values.data());
+		for(uint32_t s = 0; s < table->getNumSignals(); ++s) {
+			columns[s][i] = values[s];
+		}
+	}
+	const double frameDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<std::vector<double>> batchColumns(table->getNumSignals(), std::vector<double>(numFrames, 0.0));
+	std::vector<double*> columnPtrs;
+	for(auto& column : batchColumns) {
+		columnPtrs.push_back(column.data());
+	}
+	numAllocations = 0;
+	start = std::chrono::steady_clock::now();
+	ASSERT_EQ(numFrames, decoder.decode(frames.data(), numFrames, columnPtrs.data()));
+	const double batchDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ASSERT_EQ(0u, numAllocations.load());
+	ASSERT_TRUE(columns == batchColumns);
+
+	std::cout << "Decoded " << numFrames << " frames: " << numFrames / frameDuration << " frames/s (frame by frame), "
+	          << numFrames / batchDuration << " frames/s (batch)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,317 @@
+#include <gtest/gtest.h>
+
+#include <net/if.h>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "tcan_can/BcmBus.hpp"
+#include "tcan_can/CanLinkMonitor.hpp"
+#include "tcan_can/IsoTpBus.hpp"
+#include "tcan_can/SocketBus.hpp"
+#include "tcan_can/SocketBusReceiver.hpp"
+
+// These tests need a virtual CAN interface supporting CAN XL, e.g.:
+//   ip link add dev vcan0 type vcan && ip link set vcan0 mtu 2060 && ip link set up vcan0
+// They are skipped if the interface does not exist.
+static const char* interface = "vcan0";
+static constexpr unsigned int numChunks = 200;
+
+struct XlReceiver {
+	bool parseXl(const tcan_can::CanXlMsg& msg) {
+		numBytes += msg.getLength();
+		++numMsgs;
+		return true;
+	}
+
+	bool parseClassic(const tcan_can::CanMsg& msg) {
+		numBytes += msg.getLength();
+		++numMsgs;
+		return true;
+	}
+
+	unsigned int numBytes = 0;
+	unsigned int numMsgs = 0;
+};
+
+static std::unique_ptr<tcan_can::SocketBus> makeBus(const bool loopback) {
+	auto options = std::make_unique<tcan_can::SocketBusOptions>(interface);
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	options->synchronousBlockingWrite_ = true;
+	options->loopback_ = loopback;
+	options->canXlFrames_ = true;
+	options->sndBufLength_ = 1u << 20;
+	auto bus = std::make_unique<tcan_can::SocketBus>(std::move(options));
+	if(!bus->initBus()) {
+		return nullptr;
+	}
+	return bus;
+}
+
+static bool isVcanAvailable() {
+	if(if_nametoindex(interface) == 0) {
+		printf("%s not available, skipping test\n", interface);
+		return false;
+	}
+	return true;
+}
+
+TEST(socket_bus_vcan, xl_msg_layout) {
+	tcan_can::CanXlMsg msg {0x1234u, 0xdeadbeefu, 0x03};
+	ASSERT_EQ(0x234u, msg.getPriority());
+	ASSERT_EQ(tcan_can::CanXlMsg::Xl, msg.getFlags());
+	msg.setFlags(tcan_can::CanXlMsg::SimpleExtendedContent);
+	ASSERT_EQ(tcan_can::CanXlMsg::Xl | tcan_can::CanXlMsg::SimpleExtendedContent, msg.getFlags());
+}
+
+TEST(socket_bus_vcan, xl_throughput) {
+	if(!isVcanAvailable()) {
+		return;
+	}
+
+	auto sender = makeBus(true);
+	auto receiver = makeBus(false);
+	ASSERT_TRUE(sender && receiver);
+	if(!sender->isXlEnabled() || !receiver->isXlEnabled()) {
+		printf("%s does not support CAN XL, skipping test\n", interface);
+		return;
+	}
+
+	XlReceiver xl;
+	XlReceiver classic;
+	receiver->addCanXlMessage(tcan_can::CanFrameIdentifier{0x100u}, &xl, &XlReceiver::parseXl);
+	receiver->addCanMessage(0x100u, &classic, &XlReceiver::parseClassic);
+
+	tcan_can::CanXlMsg chunk {0x100u};
+	for(uint16_t i = 0; i < tcan_can::CanXlMsg::Capacity; ++i) {
+		chunk.getData()[i] = static_cast<uint8_t>(i);
+	}
+	chunk.setLength(tcan_can::CanXlMsg::Capacity);
+
+	// one CAN XL frame per chunk
+	auto start = std::chrono::steady_clock::now();
+	for(unsigned int i = 0; i < numChunks; ++i) {
+		ASSERT_TRUE(sender->sendXlMessage(chunk));
+		while(receiver->readMessage()) {}
+	}
+	while(xl.numMsgs < numChunks && receiver->readMessage()) {}
+	const double xlDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ASSERT_EQ(numChunks, xl.numMsgs);
+	ASSERT_EQ(numChunks*tcan_can::CanXlMsg::Capacity, xl.numBytes);
+
+	// the same chunks segmented into classic frames
+	start = std::chrono::steady_clock::now();
+	for(unsigned int i = 0; i < numChunks; ++i) {
+		for(unsigned int offset = 0; offset < tcan_can::CanXlMsg::Capacity; offset += tcan_can::CanMsg::ClassicCapacity) {
+			sender->sendMessage(tcan_can::CanMsg(0x100u, tcan_can::CanMsg::ClassicCapacity, &chunk.getData()[offset]));
+			sender->writeMessages(nullptr);
+		}
+		while(receiver->readMessage()) {}
+	}
+	while(classic.numBytes < xl.numBytes && receiver->readMessage()) {}
+	const double classicDuration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	ASSERT_EQ(xl.numBytes, classic.numBytes);
+
+	printf("CAN XL: %.1f MB/s, segmented classic CAN: %.1f MB/s\n", xl.numBytes/xlDuration*1e-6, classic.numBytes/classicDuration*1e-6);
+	ASSERT_TRUE(xlDuration < classicDuration);
+}
+
+TEST(socket_bus_vcan, shared_receive) {
+	if(!isVcanAvailable()) {
+		return;
+	}
+
+	auto sender = makeBus(true);
+	ASSERT_TRUE(sender != nullptr);
+
+	auto options = std::make_unique<tcan_can::SocketBusOptions>(interface);
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	options->sharedReceive_ = true;
+	tcan_can::SocketBus bus {std::move(options)};
+	ASSERT_TRUE(bus.initBus());
+
+	auto receiverOptions = std::make_unique<tcan_can::SocketBusOptions>("all");
+	receiverOptions->mode_ = tcan::BusOptions::Mode::Synchronous;
+	tcan_can::SocketBusReceiver receiver {std::move(receiverOptions)};
+	ASSERT_TRUE(receiver.initialize());
+	ASSERT_TRUE(receiver.addBus(&bus));
+	ASSERT_FALSE(receiver.addBus(&bus));
+
+	XlReceiver classic;
+	bus.addCanMessage(0x101u, &classic, &XlReceiver::parseClassic);
+	for(uint8_t i = 0; i < 10; ++i) {
+		sender->sendMessage(tcan_can::CanMsg(0x101u, {i, i}));
+		sender->writeMessages(nullptr);
+	}
+
+	const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while(classic.numMsgs < 10 && std::chrono::steady_clock::now() < timeout) {
+		receiver.readData();
+	}
+	ASSERT_EQ(10u, classic.numMsgs);
+	ASSERT_EQ(20u, classic.numBytes);
+
+	// the socket of the bus itself does not receive
+	ASSERT_FALSE(bus.readMessage());
+}
+
+TEST(socket_bus_vcan, bcm_cyclic_and_content_filter) {
+	if(!isVcanAvailable()) {
+		return;
+	}
+
+	auto options = std::make_unique<tcan_can::SocketBusOptions>(interface);
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	tcan_can::BcmBus sender {std::move(options)};
+	ASSERT_TRUE(sender.initBus());
+
+	options = std::make_unique<tcan_can::SocketBusOptions>(interface);
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	tcan_can::BcmBus receiver {std::move(options)};
+	ASSERT_TRUE(receiver.initBus());
+
+	XlReceiver cyclic;
+	receiver.addCanMessage(0x102u, &cyclic, &XlReceiver::parseClassic);
+	ASSERT_FALSE(sender.updateCyclicMessage(tcan_can::CanMsg(0x102u, {1})));
+	ASSERT_TRUE(sender.startCyclicMessage(tcan_can::CanMsg(0x102u, {1}), std::chrono::milliseconds(1)));
+
+	auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while(cyclic.numMsgs < 10 && std::chrono::steady_clock::now() < timeout) {
+		receiver.readMessage();
+	}
+	ASSERT_EQ(10u, cyclic.numMsgs);
+
+	// unchanged payloads are filtered by the kernel, only the update is delivered
+	ASSERT_TRUE(receiver.setContentFilter(0x102u));
+	const auto filterStart = std::chrono::steady_clock::now();
+	while(std::chrono::steady_clock::now() < filterStart + std::chrono::milliseconds(50)) {
+		receiver.readMessage();
+	}
+	const unsigned int numFiltered = cyclic.numMsgs;
+	ASSERT_TRUE(sender.updateCyclicMessage(tcan_can::CanMsg(0x102u, {2}), true));
+	timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+	while(std::chrono::steady_clock::now() < timeout) {
+		receiver.readMessage();
+	}
+	ASSERT_EQ(numFiltered + 1u, cyclic.numMsgs);
+
+	ASSERT_TRUE(sender.stopCyclicMessage(0x102u));
+	ASSERT_FALSE(sender.stopCyclicMessage(0x102u));
+}
+
+class PduReceiver : public tcan_can::IsoTpBus {
+ public:
+	using tcan_can::IsoTpBus::IsoTpBus;
+
+	void handleMessage(const tcan::GenericMsg& msg) override {
+		pdus.push_back(msg);
+	}
+
+	std::vector<tcan::GenericMsg> pdus;
+};
+
+static std::unique_ptr<PduReceiver> makeIsoTpBus(const uint32_t txId, const uint32_t rxId) {
+	auto options = std::make_unique<tcan_can::IsoTpBusOptions>(interface, txId, rxId);
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	options->blockSize_ = 8;
+	options->stMin_ = 0xF1;
+	options->txPadding_ = true;
+	auto bus = std::make_unique<PduReceiver>(std::move(options));
+	if(!bus->initBus()) {
+		return nullptr;
+	}
+	return bus;
+}
+
+TEST(socket_bus_vcan, isotp_pdu) {
+	if(!isVcanAvailable()) {
+		return;
+	}
+
+	auto tester = makeIsoTpBus(0x7e0u, 0x7e8u);
+	auto ecu = makeIsoTpBus(0x7e8u, 0x7e0u);
+	if(!tester || !ecu) {
+		printf("ISO-TP sockets not available, skipping test\n");
+		return;
+	}
+
+	std::vector<uint8_t> pdu(1000);
+	for(std::size_t i = 0; i < pdu.size(); ++i) {
+		pdu[i] = static_cast<uint8_t>(i);
+	}
+	std::thread transmitter([&tester, &pdu]() {
+		tester->sendMessage(tcan::GenericMsg(static_cast<unsigned int>(pdu.size()), pdu.data()));
+		tester->writeMessages(nullptr);
+	});
+
+	const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+	while(ecu->pdus.empty() && std::chrono::steady_clock::now() < timeout) {
+		ecu->readMessage();
+	}
+	transmitter.join();
+
+	ASSERT_EQ(1u, ecu->pdus.size());
+	ASSERT_EQ(pdu.size(), ecu->pdus[0].getLength());
+	ASSERT_TRUE(std::equal(pdu.begin(), pdu.end(), ecu->pdus[0].getData()));
+}
+
+TEST(socket_bus_vcan, link_monitor) {
+	// uses the loopback interface, which exists without CAN controller
+	tcan_can::CanLinkMonitor loopback {"lo"};
+	ASSERT_TRUE(loopback.open());
+	const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while(!loopback.exists() && std::chrono::steady_clock::now() < timeout) {
+		loopback.update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	ASSERT_TRUE(loopback.exists());
+	ASSERT_EQ(static_cast<int>(if_nametoindex("lo")), loopback.getInterfaceIndex());
+	ASSERT_TRUE(loopback.isLinkUp());
+	ASSERT_EQ(tcan_can::CanLinkMonitor::ControllerState::Unknown, loopback.getControllerState());
+
+	tcan_can::CanLinkMonitor missing {"tcanmissing0"};
+	ASSERT_TRUE(missing.open());
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	missing.update();
+	ASSERT_FALSE(missing.exists());
+	ASSERT_FALSE(missing.restartController());
+}
+
+TEST(socket_bus_vcan, wait_for_interface) {
+	// the bus is initialized without its interface and keeps the messages until the interface is added
+	auto options = std::make_unique<tcan_can::SocketBusOptions>("tcanmissing0");
+	options->mode_ = tcan::BusOptions::Mode::Synchronous;
+	options->monitorLink_ = true;
+	tcan_can::SocketBus bus {std::move(options)};
+	ASSERT_TRUE(bus.initBus());
+	ASSERT_TRUE(bus.getLinkMonitor() != nullptr);
+	ASSERT_EQ(-1, bus.getPollableFileDescriptor());
+	ASSERT_EQ(0, bus.getInterfaceIndex());
+
+	ASSERT_TRUE(bus.sendMessage(tcan_can::CanMsg{0x181u, 1}));
+	ASSERT_FALSE(bus.writeMessages(nullptr));
+	ASSERT_EQ(1u, bus.getNumOutgoingMessagesWithoutLock());
+	ASSERT_FALSE(bus.sendMessageDirectly(tcan_can::CanMsg{0x80u, 0}));
+	ASSERT_FALSE(bus.readMessage());
+	bus.sanityCheck();
+	ASSERT_EQ(-1, bus.getPollableFileDescriptor());
+
+	// without link monitoring, a missing interface is an error
+	ASSERT_FALSE(tcan_can::SocketBus("tcanmissing0").initBus());
+
+	// the link check runs on its own thread in asynchronous mode, which is stopped by the destructor
+	options = std::make_unique<tcan_can::SocketBusOptions>("tcanmissing0");
+	options->monitorLink_ = true;
+	options->linkCheckInterval_ = 10;
+	auto asyncBus = std::make_unique<tcan_can::SocketBus>(std::move(options));
+	ASSERT_TRUE(asyncBus->initBus());
+	asyncBus->startThreads();
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	asyncBus.reset();
+}
+
+int main(int argc, char* argv[]) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
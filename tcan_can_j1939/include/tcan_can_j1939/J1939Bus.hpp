@@ -0,0 +1,112 @@
+#pragma once
+
+#include <linux/can/j1939.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <tcan/RcuPointer.hpp>
+#include <tcan_can/CanBus.hpp>
+#include <tcan_can/CanDevice.hpp>
+#include <tcan_can/CanFrameIdentifier.hpp>
+#include <tcan_can_j1939/J1939BusOptions.hpp>
+#include <tcan_can_j1939/J1939PgnParser.hpp>
+
+namespace tcan_can_j1939 {
+
+/**
+ * CAN bus on a kernel CAN_J1939 socket. The kernel filters PGNs and source addresses and reassembles PGNs segmented with
+ * the transport protocols, so only the PGNs of registered parsers reach user space. It also tracks the address claims
+ * on the bus to map NAMEs to addresses, but does not send claims itself: the address of ecuName_ is claimed with
+ * claimAddress().
+ *
+ * Received PGNs are passed to the parsers added with addParser(..), DeviceJ1939 adds its parsers when it is added to
+ * the bus. PGNs of up to 64 bytes without parser are passed to the callbacks of addCanMessage(..) as a CanMsg with the
+ * 29 bit J1939 CAN id. Sent messages are J1939 CanMsgs; the kernel segments messages longer than 8 bytes and replaces
+ * the source address of the CAN id with the one of this bus.
+ */
+class J1939Bus : public tcan_can::CanBus {
+   public:
+    explicit J1939Bus(const std::string& interface);
+    explicit J1939Bus(std::unique_ptr<J1939BusOptions>&& options);
+
+    ~J1939Bus() override;
+
+    int getPollableFileDescriptor() const override { return socket_; }
+
+    /*!
+     * Pass a PGN received from an address to a parser. Can be called while receiving.
+     * @param parser            parser of the PGN, must outlive the bus
+     * @param sourceAddress     source address of the PGN, J1939_NO_ADDR for all addresses
+     * @param device            device of the parser, whose timeout is reset on reception, or nullptr
+     * @return true if successful
+     */
+    bool addParser(J1939PgnParser& parser, uint8_t sourceAddress = J1939_NO_ADDR, tcan_can::CanDevice* device = nullptr);
+
+    /*!
+     * Send the address claimed PGN with ecuName_ for sourceAddress_. Has to be called after initialization, and again
+     * whenever another ECU claims the same address. The kernel only records the claim: the socket can send from the
+     * address 250 ms after the claim, unless an ECU with a NAME of higher priority claimed it in the meantime.
+     * @return true if the message was queued
+     */
+    bool claimAddress();
+
+    /*!
+     * Compute the kernel filters of the parsers and subscriptions
+     * @param parsers       PGNs and source addresses of the parsers
+     * @param matchers      identifiers and masks of the subscriptions, only 29 bit identifiers are received
+     * @return filters. Empty if all PGNs shall be received: nothing is registered, or there are more than J1939_FILTER_MAX.
+     */
+    static std::vector<j1939_filter> computeFilters(const std::vector<std::pair<uint32_t, uint8_t>>& parsers,
+                                                    const std::vector<tcan_can::CanFrameIdentifier>& matchers);
+
+   protected:
+    struct ParserEntry {
+        uint8_t sourceAddress_;
+        J1939PgnParser* parser_;
+        tcan_can::CanDevice* device_;
+    };
+    using ParserMap = std::map<uint32_t, std::vector<ParserEntry>>;
+
+    bool initializeInterface() override;
+    bool readData() override;
+    bool writeData(std::unique_lock<std::mutex>* lock) override;
+
+    //! Updates the kernel filters
+    void onSubscriptionsChanged() override;
+
+    //! Sets the kernel filters of the parsers and subscriptions
+    bool applyFilters();
+
+    /*!
+     * Pass a received PGN to its parsers, or to the subscriptions
+     * @param pgn                   PGN, including the destination address of PDU1 PGNs
+     * @param sourceAddress         address of the sender
+     * @param priority              priority of the message
+     * @param data                  payload
+     * @param length                length of the payload
+     */
+    void handlePgn(uint32_t pgn, uint8_t sourceAddress, uint8_t priority, const uint8_t* data, std::size_t length);
+
+   protected:
+    int socket_;
+    int recvFlag_;
+    int sendFlag_;
+
+    //! buffer of a received PGN, maxPduLength_ bytes
+    std::vector<uint8_t> receiveBuffer_;
+
+    //! priority set with SO_J1939_SEND_PRIO, only accessed by writeData(..)
+    int sendPriority_;
+
+    tcan::RcuPointer<ParserMap> parsers_;
+
+    //! serializes the updates of the kernel filters
+    std::mutex filtersMutex_;
+};
+
+}  // namespace tcan_can_j1939
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <linux/can/j1939.h>
+
+#include <cstdint>
+#include <string>
+
+#include <tcan_can/CanBusOptions.hpp>
+
+namespace tcan_can_j1939 {
+
+struct J1939BusOptions : public tcan_can::CanBusOptions {
+    J1939BusOptions() : J1939BusOptions(std::string()) {}
+
+    explicit J1939BusOptions(const std::string& interfaceName)
+        : CanBusOptions(interfaceName),
+          sourceAddress_(J1939_NO_ADDR),
+          ecuName_(J1939_NO_NAME),
+          promiscuous_(true),
+          maxPduLength_(1785) {}
+
+    ~J1939BusOptions() override = default;
+
+    //! Address messages are sent from. J1939_NO_ADDR: the address claimed for ecuName_, or receive only without name.
+    uint8_t sourceAddress_;
+
+    //! 64 bit NAME of this ECU, sent by J1939Bus::claimAddress(). J1939_NO_NAME: use sourceAddress_ statically.
+    uint64_t ecuName_;
+
+    //! Also receive PGNs addressed to other ECUs, as needed to monitor devices
+    bool promiscuous_;
+
+    //! Length of the longest PGN that can be received, longer ones are truncated. 1785 is the limit of the transport
+    //! protocol (TP), the extended transport protocol (ETP) allows more.
+    unsigned int maxPduLength_;
+};
+
+}  // namespace tcan_can_j1939
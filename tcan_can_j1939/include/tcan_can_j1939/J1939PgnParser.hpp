@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
+#include <tcan_can/CanBatchDecoder.hpp>
 #include <tcan_can/CanMsg.hpp>
 
 namespace tcan_can_j1939 {
@@ -12,7 +14,39 @@ struct J1939PgnParser {
 
     static double scaledMessageFromRaw(double raw, double resolution, double offset) { return raw * resolution + offset; }
 
+    /*!
+     * Applies scaledMessageFromRaw(..) to an unsigned little endian field of many frames at once, see tcan_can::CanBatchDecoder.
+     * @param frames        frames of this PGN
+     * @param numFrames     number of frames
+     * @param position      position of the field in bytes
+     * @param length        length of the field in bytes
+     * @param resolution    resolution of the field
+     * @param offset        offset of the field
+     * @param scaled        array of numFrames scaled values
+     */
+    static void scaledColumnFromRaw(const tcan_can::CanMsg* frames, std::size_t numFrames, uint8_t position, uint8_t length, double resolution,
+                                    double offset, double* scaled) {
+        tcan_can::CanDbcSignal field;
+        field.startBit_ = static_cast<uint16_t>(8 * position);
+        field.bitLength_ = static_cast<uint8_t>(8 * length);
+        field.factor_ = resolution;
+        field.offset_ = offset;
+        tcan_can::CanBatchDecoder::SignalDecoder decoder;
+        if (tcan_can::CanDbcDecodeTable::makeSignalDecoder(field, decoder)) {
+            tcan_can::CanBatchDecoder::decodeColumn(decoder, frames, numFrames, scaled);
+        }
+    }
+
     const uint32_t pgn_;
     virtual bool parse(const tcan_can::CanMsg& msg) = 0;
+
+    /*!
+     * Is called with PGNs longer than a CanMsg, which J1939Bus receives reassembled by the transport protocol.
+     * @param data              payload
+     * @param length            length of the payload, > 64
+     * @param sourceAddress     address of the sender
+     * @return false if the PGN is not handled
+     */
+    virtual bool parseSegmented(const uint8_t* /*data*/, std::size_t /*length*/, uint8_t /*sourceAddress*/) { return false; }
 };
 }  // namespace tcan_can_j1939
\ No newline at end of file
@@ -14,6 +14,14 @@ struct AccelerationSensor : public J1939PgnParser {
         return true;
     }
 
+    //! Decode the accelerations of many frames at once into columns of numFrames values each
+    static void parseColumns(const tcan_can::CanMsg* frames, std::size_t numFrames, double* lateralAcceleration, double* longitudinalAcceleration,
+                             double* verticalAcceleration) {
+        scaledColumnFromRaw(frames, numFrames, 0, 2, 0.01, -320., lateralAcceleration);
+        scaledColumnFromRaw(frames, numFrames, 2, 2, 0.01, -320., longitudinalAcceleration);
+        scaledColumnFromRaw(frames, numFrames, 4, 2, 0.01, -320., verticalAcceleration);
+    }
+
     double lateralAcceleration_{0.};       // m/s^2
     double longitudinalAcceleration_{0.};  // m/s^2
     double verticalAcceleration{0.};       // m/s^2
@@ -14,6 +14,13 @@ struct AngularRateInformation : public J1939PgnParser {
         return true;
     }
 
+    //! Decode the rates of many frames at once into columns of numFrames values each
+    static void parseColumns(const tcan_can::CanMsg* frames, std::size_t numFrames, double* pitchRate, double* rollRate, double* yawRate) {
+        scaledColumnFromRaw(frames, numFrames, 0, 2, 1. / 128., -250., pitchRate);
+        scaledColumnFromRaw(frames, numFrames, 2, 2, 1. / 128., -250., rollRate);
+        scaledColumnFromRaw(frames, numFrames, 4, 2, 1. / 128., -250., yawRate);
+    }
+
     double pitchRate_{0.};  // deg/s
     double rollRate_{0.};   // deg/s
     double yawRate_{0.};    // deg/s
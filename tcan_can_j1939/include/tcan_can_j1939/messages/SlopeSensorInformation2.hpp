@@ -13,6 +13,12 @@ struct SlopeSensorInformation2 : public J1939PgnParser {
         return true;
     }
 
+    //! Decode the angles of many frames at once into columns of numFrames values each
+    static void parseColumns(const tcan_can::CanMsg* frames, std::size_t numFrames, double* pitchAngle, double* rollAngle) {
+        scaledColumnFromRaw(frames, numFrames, 0, 3, 1. / 32768., -250., pitchAngle);
+        scaledColumnFromRaw(frames, numFrames, 3, 3, 1. / 32768., -250., rollAngle);
+    }
+
     double pitchAngle_{0.};  // deg/s
     double rollAngle_{0.};   // deg/s
 };
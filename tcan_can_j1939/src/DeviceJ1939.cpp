@@ -1,6 +1,7 @@
 #include "tcan_can_j1939/DeviceJ1939.hpp"
 
 #include "tcan_can/CanBus.hpp"
+#include "tcan_can_j1939/J1939Bus.hpp"
 #include "tcan_can_j1939/J1939CanMsg.hpp"
 
 #include <linux/can.h>
@@ -8,6 +9,14 @@
 namespace tcan_can_j1939 {
 
 bool DeviceJ1939::initDevice() {
+    // the kernel filters the PGNs of the parsers
+    if (auto* j1939Bus = dynamic_cast<J1939Bus*>(bus_)) {
+        bool success = true;
+        for (const auto& entry : pgnMap_) {
+            success &= j1939Bus->addParser(*entry.second, static_cast<uint8_t>(getNodeId()), this);
+        }
+        return success;
+    }
     return bus_->addCanMessage(tcan_can::CanFrameIdentifier(CAN_EFF_FLAG | getNodeId(), 0x800000FFU), this, &DeviceJ1939::parseMessage);
 }
 
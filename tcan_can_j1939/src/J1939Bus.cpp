@@ -0,0 +1,344 @@
+#include "tcan_can_j1939/J1939Bus.hpp"
+
+#include <linux/can.h>
+#include <net/if.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <message_logger/message_logger.hpp>
+
+#include "tcan_can_j1939/J1939CanMsg.hpp"
+
+namespace tcan_can_j1939 {
+
+namespace {
+
+//! PDU1 PGNs (PDU format < 240) carry the destination address in the PDU specific byte
+constexpr bool isPdu1(uint32_t pgn) { return ((pgn >> 8u) & 0xFFu) < 240u; }
+
+void addFilter(std::vector<j1939_filter>& filters, uint32_t pgn, uint32_t pgnMask, uint8_t address, uint8_t addressMask) {
+    // the kernel reports PDU1 PGNs without destination address. Clear it also if the PDU format is masked.
+    if ((pgnMask & 0xFF00u) != 0xFF00u || isPdu1(pgn)) {
+        pgnMask &= J1939_PGN_PDU1_MAX;
+    }
+    j1939_filter filter;
+    memset(&filter, 0, sizeof(filter));
+    filter.name = J1939_NO_NAME;
+    filter.name_mask = 0;
+    filter.pgn = pgn & pgnMask;
+    filter.pgn_mask = pgnMask;
+    filter.addr = static_cast<uint8_t>(address & addressMask);
+    filter.addr_mask = addressMask;
+    filters.push_back(filter);
+}
+
+}  // namespace
+
+J1939Bus::J1939Bus(const std::string& interface)
+    : J1939Bus(std::unique_ptr<J1939BusOptions>(new J1939BusOptions(interface))) {}
+
+J1939Bus::J1939Bus(std::unique_ptr<J1939BusOptions>&& options)
+    : CanBus(std::move(options)),
+      socket_(-1),
+      recvFlag_(0),
+      sendFlag_(0),
+      receiveBuffer_(),
+      sendPriority_(-1),
+      parsers_(std::unique_ptr<ParserMap>(new ParserMap())),
+      filtersMutex_() {}
+
+J1939Bus::~J1939Bus() {
+    stopThreads();
+    if (socket_ >= 0) {
+        close(socket_);
+    }
+}
+
+bool J1939Bus::addParser(J1939PgnParser& parser, uint8_t sourceAddress, tcan_can::CanDevice* device) {
+    parsers_.update([&parser, sourceAddress, device](ParserMap& parsers) {
+        parsers[parser.pgn_].push_back(ParserEntry{sourceAddress, &parser, device});
+    });
+    return applyFilters();
+}
+
+bool J1939Bus::claimAddress() {
+    const J1939BusOptions* options = static_cast<const J1939BusOptions*>(options_.get());
+    if (options->ecuName_ == J1939_NO_NAME || options->sourceAddress_ > J1939_MAX_UNICAST_ADDR) {
+        MELO_ERROR("Cannot claim an address on bus %s: ecuName_ and sourceAddress_ have to be set.", options->name_.c_str());
+        return false;
+    }
+
+    // the NAME is sent little endian to the global address
+    tcan_can::CanMsg msg(CAN_EFF_FLAG | 6u << 26u | (J1939_PGN_ADDRESS_CLAIMED | J1939_NO_ADDR) << 8u | options->sourceAddress_, 8);
+    for (uint8_t i = 0; i < 8; ++i) {
+        msg.getData()[i] = static_cast<uint8_t>(options->ecuName_ >> (8u * i));
+    }
+    return sendMessage(msg);
+}
+
+std::vector<j1939_filter> J1939Bus::computeFilters(const std::vector<std::pair<uint32_t, uint8_t>>& parsers,
+                                                   const std::vector<tcan_can::CanFrameIdentifier>& matchers) {
+    std::vector<j1939_filter> filters;
+    for (const auto& parser : parsers) {
+        addFilter(filters, parser.first, J1939_PGN_MAX, parser.second, parser.second == J1939_NO_ADDR ? 0u : 0xFFu);
+    }
+    for (const tcan_can::CanFrameIdentifier& matcher : matchers) {
+        if ((matcher.mask & CAN_EFF_FLAG) && !(matcher.identifier & CAN_EFF_FLAG)) {
+            // 11 bit identifiers are not J1939 messages
+            continue;
+        }
+        addFilter(filters, (matcher.identifier >> 8u) & J1939_PGN_MAX, (matcher.mask >> 8u) & J1939_PGN_MAX,
+                  static_cast<uint8_t>(matcher.identifier), static_cast<uint8_t>(matcher.mask));
+    }
+
+    if (filters.size() > J1939_FILTER_MAX) {
+        filters.clear();
+    }
+    return filters;
+}
+
+bool J1939Bus::initializeInterface() {
+    const J1939BusOptions* options = static_cast<const J1939BusOptions*>(options_.get());
+    const char* interface = options->name_.c_str();
+
+    socket_ = socket(PF_CAN, SOCK_DGRAM, CAN_J1939);
+    if (socket_ < 0) {
+        MELO_FATAL("Opening J1939 channel %s failed (is the can-j1939 module loaded?): (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    struct ifreq ifr;
+    strcpy(ifr.ifr_name, interface);
+    if (ioctl(socket_, SIOCGIFINDEX, &ifr) != 0) {
+        MELO_FATAL("Unknown CAN interface %s: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    int promiscuous = options->promiscuous_;
+    if (setsockopt(socket_, SOL_CAN_J1939, SO_J1939_PROMISC, &promiscuous, sizeof(promiscuous)) != 0) {
+        MELO_WARN("Failed to set promiscuous mode: (%d)\n  %s", errno, strerror(errno));
+    }
+
+    // sending to the global address requires broadcasts
+    int broadcast = 1;
+    if (setsockopt(socket_, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast)) != 0) {
+        MELO_WARN("Failed to enable broadcasts: (%d)\n  %s", errno, strerror(errno));
+    }
+
+    if (options->readTimeout_.tv_sec != 0 || options->readTimeout_.tv_usec != 0) {
+        if (setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &options->readTimeout_, sizeof(options->readTimeout_)) != 0) {
+            MELO_WARN("Failed to set read timeout: (%d)\n  %s", errno, strerror(errno));
+        }
+    }
+
+    if (options->writeTimeout_.tv_sec != 0 || options->writeTimeout_.tv_usec != 0) {
+        if (setsockopt(socket_, SOL_SOCKET, SO_SNDTIMEO, &options->writeTimeout_, sizeof(options->writeTimeout_)) != 0) {
+            MELO_WARN("Failed to set write timeout: (%d)\n  %s", errno, strerror(errno));
+        }
+    }
+
+    if (!isAsynchronous()) {
+        recvFlag_ = MSG_DONTWAIT;
+        if (!options->synchronousBlockingWrite_) {
+            sendFlag_ = MSG_DONTWAIT;
+        }
+    }
+
+    receiveBuffer_.resize(options->maxPduLength_);
+
+    // with a NAME and without address, the socket is idle until an address is claimed
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(struct sockaddr_can));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    addr.can_addr.j1939.name = options->ecuName_;
+    addr.can_addr.j1939.addr =
+        (options->ecuName_ != J1939_NO_NAME && options->sourceAddress_ == J1939_NO_ADDR) ? J1939_IDLE_ADDR : options->sourceAddress_;
+    addr.can_addr.j1939.pgn = J1939_NO_PGN;
+    if (bind(socket_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        MELO_FATAL("Error in socket %s bind: (%d)\n  %s", interface, errno, strerror(errno));
+        return false;
+    }
+
+    applyFilters();
+
+    MELO_INFO("Opened J1939 socket %s.", interface);
+    return true;
+}
+
+void J1939Bus::onSubscriptionsChanged() { applyFilters(); }
+
+bool J1939Bus::applyFilters() {
+    if (socket_ < 0) {
+        // filters are applied in initializeInterface()
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(filtersMutex_);
+    std::vector<std::pair<uint32_t, uint8_t>> parsers;
+    for (const auto& entry : *parsers_.read()) {
+        for (const ParserEntry& parser : entry.second) {
+            parsers.emplace_back(entry.first, parser.sourceAddress_);
+        }
+    }
+    const std::vector<j1939_filter> filters = computeFilters(parsers, dispatchTable_.read()->getMatchers());
+
+    // no filters receive all PGNs
+    if (setsockopt(socket_, SOL_CAN_J1939, SO_J1939_FILTER, filters.data(), static_cast<socklen_t>(sizeof(j1939_filter) * filters.size())) != 0) {
+        MELO_WARN("Failed to set %zu J1939 filters on bus %s: (%d)\n  %s", filters.size(), options_->name_.c_str(), errno, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool J1939Bus::readData() {
+    struct sockaddr_can addr;
+    struct iovec iov;
+    iov.iov_base = receiveBuffer_.data();
+    iov.iov_len = receiveBuffer_.size();
+    alignas(struct cmsghdr) uint8_t control[2 * CMSG_SPACE(sizeof(uint8_t)) + CMSG_SPACE(sizeof(uint64_t))];
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &addr;
+    msg.msg_namelen = sizeof(addr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    const ssize_t bytesRead = recvmsg(socket_, &msg, recvFlag_);
+    if (bytesRead < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            MELO_ERROR_THROTTLE(options_->errorThrottleTime_, "Failed to read data from J1939 bus %s: (%d)\n  %s", options_->name_.c_str(), errno,
+                                strerror(errno));
+            hasBusError_ = true;
+        } else {
+            hasBusError_ = false;
+        }
+        return false;
+    }
+    hasBusError_ = false;
+    errorMsgFlag_ = false;
+
+    uint8_t destination = J1939_NO_ADDR;
+    uint8_t priority = 6;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_CAN_J1939) {
+            continue;
+        }
+        if (cmsg->cmsg_type == SCM_J1939_DEST_ADDR) {
+            destination = *CMSG_DATA(cmsg);
+        } else if (cmsg->cmsg_type == SCM_J1939_PRIO) {
+            priority = *CMSG_DATA(cmsg);
+        }
+    }
+
+    uint32_t pgn = addr.can_addr.j1939.pgn;
+    if (isPdu1(pgn)) {
+        pgn |= destination;
+    }
+    handlePgn(pgn, addr.can_addr.j1939.addr, priority, receiveBuffer_.data(), static_cast<std::size_t>(bytesRead));
+    return true;
+}
+
+void J1939Bus::handlePgn(uint32_t pgn, uint8_t sourceAddress, uint8_t priority, const uint8_t* data, std::size_t length) {
+    const auto parsers = parsers_.read();
+    const auto it = parsers->find(pgn);
+
+    if (length <= tcan_can::CanMsg::Capacity) {
+        const tcan_can::CanMsg msg(CAN_EFF_FLAG | static_cast<uint32_t>(priority & 0x7u) << 26u | pgn << 8u | sourceAddress,
+                                   static_cast<uint8_t>(length), data);
+        bool isParsed = false;
+        if (it != parsers->end()) {
+            for (const ParserEntry& entry : it->second) {
+                if (entry.sourceAddress_ == J1939_NO_ADDR || entry.sourceAddress_ == sourceAddress) {
+                    if (entry.device_ != nullptr) {
+                        entry.device_->resetDeviceTimeoutCounter();
+                        entry.device_->configureDeviceInternal(msg);
+                    }
+                    entry.parser_->parse(msg);
+                    isParsed = true;
+                }
+            }
+        }
+        if (!isParsed) {
+            CanBus::handleMessage(msg);
+        }
+        return;
+    }
+
+    // reassembled by the transport protocol
+    bool isParsed = false;
+    if (it != parsers->end()) {
+        for (const ParserEntry& entry : it->second) {
+            if (entry.sourceAddress_ == J1939_NO_ADDR || entry.sourceAddress_ == sourceAddress) {
+                if (entry.device_ != nullptr) {
+                    entry.device_->resetDeviceTimeoutCounter();
+                }
+                isParsed |= entry.parser_->parseSegmented(data, length, sourceAddress);
+            }
+        }
+    }
+    if (!isParsed) {
+        MELO_INFO_THROTTLE(options_->errorThrottleTime_, "Received PGN 0x%05X of %zu bytes from address %u on bus %s that is not handled", pgn, length,
+                           static_cast<unsigned int>(sourceAddress), options_->name_.c_str());
+    }
+}
+
+bool J1939Bus::writeData(std::unique_lock<std::mutex>* lock) {
+    const J1939CanMsg msg(outgoingMsgs_.front());
+
+    uint32_t pgn = msg.getParameterGroupNumber();
+    uint8_t destination = J1939_NO_ADDR;
+    if (isPdu1(pgn)) {
+        destination = msg.getPduSpecific();
+        pgn &= J1939_PGN_PDU1_MAX;
+    }
+
+    if (lock != nullptr) {
+        lock->unlock();
+    }
+
+    if (msg.getPriority() != sendPriority_) {
+        int priority = msg.getPriority();
+        if (setsockopt(socket_, SOL_CAN_J1939, SO_J1939_SEND_PRIO, &priority, sizeof(priority)) == 0) {
+            sendPriority_ = priority;
+        } else {
+            MELO_WARN_THROTTLE(options_->errorThrottleTime_, "Failed to set J1939 priority %d on bus %s: (%d)\n  %s", priority, options_->name_.c_str(), errno,
+                               strerror(errno));
+        }
+    }
+
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(struct sockaddr_can));
+    addr.can_family = AF_CAN;
+    addr.can_addr.j1939.name = J1939_NO_NAME;
+    addr.can_addr.j1939.addr = destination;
+    addr.can_addr.j1939.pgn = pgn;
+    const ssize_t ret = sendto(socket_, msg.getData(), msg.getLength(), sendFlag_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+
+    if (lock != nullptr) {
+        lock->lock();
+    }
+
+    if (ret != static_cast<ssize_t>(msg.getLength())) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            MELO_ERROR("Error at sending PGN 0x%05X on bus %s (return value=%zd): (%d)\n  %s", msg.getParameterGroupNumber(), options_->name_.c_str(), ret,
+                       errno, strerror(errno));
+            hasBusError_ = true;
+        } else {
+            hasBusError_ = false;
+        }
+        return false;
+    }
+
+    hasBusError_ = false;
+    outgoingMsgs_.pop_front();
+    return true;
+}
+
+}  // namespace tcan_can_j1939
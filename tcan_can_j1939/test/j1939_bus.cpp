@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <linux/can.h>
+
+#include <vector>
+
+#include "tcan_can_j1939/J1939Bus.hpp"
+#include "tcan_can_j1939/messages/AngularRateInformation.hpp"
+
+namespace {
+
+class TestBus : public tcan_can_j1939::J1939Bus {
+   public:
+	using J1939Bus::J1939Bus;
+	using J1939Bus::handlePgn;
+};
+
+struct TransportParser : public tcan_can_j1939::J1939PgnParser {
+	TransportParser() : J1939PgnParser(0xFECAu) {}
+
+	bool parse(const tcan_can::CanMsg& /*msg*/) override { return false; }
+
+	bool parseSegmented(const uint8_t* data, std::size_t length, uint8_t sourceAddress) override {
+		payload_.assign(data, data + length);
+		sourceAddress_ = sourceAddress;
+		return true;
+	}
+
+	std::vector<uint8_t> payload_;
+	uint8_t sourceAddress_ = 0;
+};
+
+}  // namespace
+
+TEST(j1939_bus, filters) {
+	// a parser of a PDU2 PGN from address 0x80 and of a PDU1 PGN from any address
+	const std::vector<std::pair<uint32_t, uint8_t>> parsers{{0xF02Au, 0x80u}, {0xEA12u, J1939_NO_ADDR}};
+	// a DeviceJ1939 subscription and an 11 bit subscription
+	const std::vector<tcan_can::CanFrameIdentifier> matchers{tcan_can::CanFrameIdentifier(CAN_EFF_FLAG | 0x81u, 0x800000FFu),
+	                                                         tcan_can::CanFrameIdentifier(0x181u)};
+
+	const std::vector<j1939_filter> filters = tcan_can_j1939::J1939Bus::computeFilters(parsers, matchers);
+	ASSERT_EQ(3u, filters.size());
+
+	EXPECT_EQ(0xF02Au, filters[0].pgn);
+	EXPECT_EQ(static_cast<uint32_t>(J1939_PGN_MAX), filters[0].pgn_mask);
+	EXPECT_EQ(0x80u, filters[0].addr);
+	EXPECT_EQ(0xFFu, filters[0].addr_mask);
+
+	// the destination address of PDU1 PGNs is not filtered
+	EXPECT_EQ(0xEA00u, filters[1].pgn);
+	EXPECT_EQ(static_cast<uint32_t>(J1939_PGN_PDU1_MAX), filters[1].pgn_mask);
+	EXPECT_EQ(0u, filters[1].addr_mask);
+
+	// all PGNs of address 0x81
+	EXPECT_EQ(0u, filters[2].pgn_mask);
+	EXPECT_EQ(0x81u, filters[2].addr);
+	EXPECT_EQ(0xFFu, filters[2].addr_mask);
+
+	// too many filters receive all PGNs
+	const std::vector<std::pair<uint32_t, uint8_t>> manyParsers(J1939_FILTER_MAX + 1, std::make_pair(0xF02Au, 0x80u));
+	ASSERT_TRUE(tcan_can_j1939::J1939Bus::computeFilters(manyParsers, {}).empty());
+}
+
+TEST(j1939_bus, dispatch) {
+	TestBus bus{"can0"};
+
+	tcan_can_j1939::messages::AngularRateInformation angularRate;
+	TransportParser transport;
+	ASSERT_TRUE(bus.addParser(angularRate, 0x80u));
+	ASSERT_TRUE(bus.addParser(transport));
+
+	// single frame PGNs are parsed as a CanMsg, from the registered address only
+	const uint8_t rates[8] = {0x00, 0x7d, 0x00, 0x7d, 0x10, 0x7d, 0xff, 0xff};
+	bus.handlePgn(0xF02Au, 0x81u, 6, rates, sizeof(rates));
+	EXPECT_DOUBLE_EQ(0.0, angularRate.yawRate_);
+	bus.handlePgn(0xF02Au, 0x80u, 6, rates, sizeof(rates));
+	EXPECT_NE(0.0, angularRate.yawRate_);
+
+	// PGNs reassembled by the transport protocol
+	std::vector<uint8_t> payload(200);
+	for (std::size_t i = 0; i < payload.size(); ++i) {
+		payload[i] = static_cast<uint8_t>(i);
+	}
+	bus.handlePgn(0xFECAu, 0x33u, 6, payload.data(), payload.size());
+	EXPECT_EQ(payload, transport.payload_);
+	EXPECT_EQ(0x33u, transport.sourceAddress_);
+}
@@ -12,11 +12,11 @@ TEST(j1939_can_msg, construct) {
 
 	auto sae = tcan_can_j1939::J1939CanMsg {msg};
 
-	EXPECT_EQ(0xdefacedu, msg.getCobId());
-	ASSERT_EQ(2, msg.getLength());
+	EXPECT_EQ(0xdefacedu, sae.getCobId());
+	ASSERT_EQ(2, sae.getLength());
 
 	std::vector<uint8_t> d;
-	d.assign(msg.getData(), msg.getData() + msg.getLength());
+	d.assign(sae.getData(), sae.getData() + sae.getLength());
 	ASSERT_THAT(d, testing::ElementsAre(0x10, 0x20));
 }
 
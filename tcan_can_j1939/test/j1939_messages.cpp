@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "tcan_can_j1939/messages/AngularRateInformation.hpp"
+
+TEST(j1939_messages, parse_columns) {
+	std::vector<tcan_can::CanMsg> frames;
+	for(uint16_t i = 0; i < 300; ++i) {
+		const uint16_t rate = static_cast<uint16_t>(32000 + 7 * i);
+		frames.emplace_back(0x18f02a80u, std::initializer_list<uint8_t>{
+			static_cast<uint8_t>(rate), static_cast<uint8_t>(rate >> 8), static_cast<uint8_t>(i), 0x7d, 0x00, 0xfa, 0xff, 0xff});
+	}
+
+	std::vector<double> pitchRate(frames.size());
+	std::vector<double> rollRate(frames.size());
+	std::vector<double> yawRate(frames.size());
+	tcan_can_j1939::messages::AngularRateInformation::parseColumns(frames.data(), frames.size(), pitchRate.data(), rollRate.data(), yawRate.data());
+
+	tcan_can_j1939::messages::AngularRateInformation parser;
+	for(std::size_t i = 0; i < frames.size(); ++i) {
+		ASSERT_TRUE(parser.parse(frames[i]));
+		ASSERT_DOUBLE_EQ(parser.pitchRate_, pitchRate[i]);
+		ASSERT_DOUBLE_EQ(parser.rollRate_, rollRate[i]);
+		ASSERT_DOUBLE_EQ(parser.yawRate_, yawRate[i]);
+	}
+}
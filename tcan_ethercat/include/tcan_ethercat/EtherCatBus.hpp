@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include <unordered_map>
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <vector>
 #include <algorithm> // copy(..)
@@ -21,6 +22,7 @@
 #include <soem/soem/ethercat.h>
 
 #include "tcan/Bus.hpp"
+#include "tcan/Delegate.hpp"
 #include "tcan_ethercat/EtherCatBusOptions.hpp"
 #include "tcan_ethercat/EtherCatSlave.hpp"
 
@@ -28,7 +30,8 @@ namespace tcan_ethercat {
 
 class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
  public:
-    typedef std::function<bool(const EtherCatDatagram&)> TxPdoCallbackPtr;
+    typedef tcan::Delegate<bool(const EtherCatDatagram&)> TxPdoCallbackPtr;
+    typedef std::function<bool(const EtherCatDatagram&)> TxPdoCallable;
     typedef std::unordered_map<EtherCatSlave*, TxPdoCallbackPtr> TxPdoCallbackMap;
 
     /*!
@@ -37,8 +40,12 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
      */
     EtherCatBus(std::unique_ptr<EtherCatBusOptions>&& options)
     : tcan::Bus<EtherCatDatagrams>(std::move(options)),
+      slaveStateMonitor_(),
+      slaveStateFlagsMutex_(),
       wkcExpected_(0),
       wkc_(0) {
+      slaveStateMonitor_.addObserver(this, &EtherCatBus::onSlaveStateChanged);
+
       // Initialize all SOEM context data pointers that are not used with null.
       ecatContext_.port->stack.sock = nullptr;
       ecatContext_.port->stack.txbuf = nullptr;
@@ -115,9 +122,18 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
     inline bool addSlave(EtherCatSlave* slave) {
         // assign the slave some id to calculate the offset in ethernet frame address
         slaves_.push_back(slave);
+        slave->setStateMonitor(&slaveStateMonitor_);
+        updateSlaveStateFlags();
         return slave->initDeviceInternal(this);
     }
 
+    /*!
+     * Get the aggregated state of all slaves. Use addObserver(..) to get notified when a slave becomes Active, Missing or Error.
+     * @return Slave state monitor.
+     */
+    inline EtherCatSlave::StateMonitor& getSlaveStateMonitor() { return slaveStateMonitor_; }
+    inline const EtherCatSlave::StateMonitor& getSlaveStateMonitor() const { return slaveStateMonitor_; }
+
     /*!
      * Add a TxPDO callback method. Every slave can only register one callback method.
      * @param slave    Slave to call method from.
@@ -126,7 +142,34 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
      */
     template <class T>
     inline bool addTxPdoCallback(T* slave, bool(std::common_type<T>::type::*function)(const EtherCatDatagram&)) {
-        return txPdoCallbackMap_.emplace(slave, std::bind(function, slave, std::placeholders::_1)).second;
+        return txPdoCallbackMap_.emplace(slave, TxPdoCallbackPtr(slave, function)).second;
+    }
+
+    /*!
+     * Compatibility overload taking an arbitrary callable, which is copied and kept until the callback is removed.
+     * @param slave    Slave the callback belongs to.
+     * @param callable Function to be called on reception of the TxPDO.
+     * @return True if successful.
+     */
+    inline bool addTxPdoCallback(EtherCatSlave* slave, const TxPdoCallable& callable) {
+        if (txPdoCallbackMap_.count(slave) != 0) {
+            return false;
+        }
+        auto owner = std::make_shared<TxPdoCallable>(callable);
+        txPdoCallbackMap_.emplace(slave, TxPdoCallbackPtr::fromCallable(owner.get()));
+        ownedTxPdoCallables_[slave] = std::move(owner);
+        return true;
+    }
+
+    /*!
+     * Remove the TxPDO callback of a slave and release its callable if it was added with the compatibility overload.
+     * Like addTxPdoCallback(..), must not be called while the bus is receiving.
+     * @param slave Slave to remove the callback of.
+     * @return True if the slave had a callback.
+     */
+    inline bool removeTxPdoCallback(EtherCatSlave* slave) {
+        ownedTxPdoCallables_.erase(slave);
+        return txPdoCallbackMap_.erase(slave) != 0;
     }
 
     /*!
@@ -514,6 +557,8 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
                 delete slave;
             }
         }
+        txPdoCallbackMap_.clear();
+        ownedTxPdoCallables_.clear();
     }
 
     /*!
@@ -675,20 +720,33 @@ class EtherCatBus : public tcan::Bus<EtherCatDatagrams> {
             }
         }
 
+        // The slave states are aggregated on state transitions. Checking the slaves updates their timeouts.
         bool isMissingOrError = false;
-        bool allActive = true;
-        bool allMissing = true;
         for (auto slave : slaves_) {
             isMissingOrError |= !slave->sanityCheck();
-            allActive &= slave->isActive();
-            allMissing &= slave->isMissing();
         }
+        updateSlaveStateFlags();
 
-        isMissingDeviceOrHasError_ = isMissingOrError;
-        allDevicesActive_ = allActive;
-        allDevicesMissing_ = allMissing;
+        return !(isMissingOrError || isMissingDeviceOrHasError_ || hasBusError_);
+    }
 
-        return !(isMissingOrError || hasBusError_);
+    /*!
+     * Is called on every state transition of a slave. Updates the device state flags of the bus.
+     */
+    void onSlaveStateChanged(const EtherCatSlave& /*slave*/, const EtherCatSlave::State /*previous*/, const EtherCatSlave::State /*current*/) {
+        updateSlaveStateFlags();
+    }
+
+    /*!
+     * Set isMissingDeviceOrHasError_, allDevicesActive_ and allDevicesMissing_ from the slave state monitor.
+     */
+    void updateSlaveStateFlags() {
+        // Concurrent transitions are serialized, so the flags set last are from the latest snapshot.
+        std::lock_guard<std::mutex> lock(slaveStateFlagsMutex_);
+        const EtherCatSlave::StateMonitor::Counters counters = slaveStateMonitor_.getCounters();
+        isMissingDeviceOrHasError_ = counters.isMissingDeviceOrHasError();
+        allDevicesActive_ = counters.allDevicesActive();
+        allDevicesMissing_ = counters.allDevicesMissing();
     }
 
     /*!
@@ -854,9 +912,15 @@ protected:
 
     // Vector containing all slaves.
     std::vector<EtherCatSlave*> slaves_;
+    // Number of slaves per state, updated on state transitions.
+    EtherCatSlave::StateMonitor slaveStateMonitor_;
+    // Serializes updateSlaveStateFlags().
+    std::mutex slaveStateFlagsMutex_;
 
     // Map mapping COB id to parse functions.
     TxPdoCallbackMap txPdoCallbackMap_;
+    // Callables registered through the compatibility overload, released with the callback of their slave.
+    std::unordered_map<EtherCatSlave*, std::shared_ptr<TxPdoCallable>> ownedTxPdoCallables_;
 
     // Datagrams staged for sending.
     std::shared_ptr<EtherCatDatagrams> stagedDatagrams_;
@@ -5,6 +5,9 @@
 #include <cassert>
 #include <unordered_map>
 
+// tcan
+#include "tcan/SignalLayout.hpp"
+
 
 namespace tcan_ethercat {
 
@@ -100,3 +103,15 @@ class EtherCatDatagrams {
 
 
 } /* namespace tcan_ethercat */
+
+
+namespace tcan {
+
+//! Lets tcan::SignalLayout decode and encode the process data of a datagram
+template <>
+struct SignalBuffer<tcan_ethercat::EtherCatDatagram> {
+    static inline uint8_t* getData(const tcan_ethercat::EtherCatDatagram& datagram) { return datagram.getData(); }
+    static inline std::size_t getLength(const tcan_ethercat::EtherCatDatagram& datagram) { return datagram.getDataLength(); }
+};
+
+} /* namespace tcan */
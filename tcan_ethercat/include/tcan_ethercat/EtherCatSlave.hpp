@@ -4,6 +4,7 @@
 #include <string>
 #include <atomic>
 
+#include "tcan/DeviceStateMonitor.hpp"
 #include "tcan_ethercat/EtherCatSlaveOptions.hpp"
 #include "tcan_ethercat/EtherCatDatagram.hpp"
 
@@ -16,6 +17,8 @@ class EtherCatBus;
 //! A slave that is connected via EtherCat.
 class EtherCatSlave {
  public:
+    using StateMonitor = tcan::DeviceStateMonitor<EtherCatSlave>;
+
     enum State {
         Initializing = 0,
         Active = 1,
@@ -70,7 +73,7 @@ class EtherCatSlave {
     virtual bool sanityCheck() {
         if(!isMissing()) {
             if(isTimedOut()) {
-                state_ = Missing;
+                setState(Missing);
                 MELO_WARN("Slave %s timed out!", getName().c_str());
             }
         }
@@ -139,6 +142,15 @@ class EtherCatSlave {
         deviceTimeoutCounter_ = 0;
     }
 
+    /*!
+     * Register the slave and its current state at the state monitor of the bus. This function is automatically called by EtherCatBus::addSlave(..).
+     * @param stateMonitor Monitor to be notified on state transitions.
+     */
+    inline void setStateMonitor(StateMonitor* stateMonitor) {
+        stateMonitor_ = stateMonitor;
+        stateMonitor_->addDevice(state_);
+    }
+
     /*!
      * Synchronize the distribute clock.
      * @param activate True to activate, false to deactivate.
@@ -177,6 +189,17 @@ class EtherCatSlave {
         return (options_->maxDeviceTimeoutCounter_ != 0 && (deviceTimeoutCounter_++ > options_->maxDeviceTimeoutCounter_));
     }
 
+    /*!
+     * Change the state of the slave and notify the state monitor of the bus. Derived classes shall not assign state_ directly.
+     * @param state New state.
+     */
+    inline void setState(const State state) {
+        const State previous = state_.exchange(state);
+        if (previous != state && stateMonitor_ != nullptr) {
+            stateMonitor_->onStateChanged(*this, previous, state);
+        }
+    }
+
  protected:
     //! Pointer to the EtherCAT slave options.
     const std::unique_ptr<EtherCatSlaveOptions> options_;
@@ -189,6 +212,9 @@ class EtherCatSlave {
 
     //! Pointer to the EtherCat bus the device is connected to.
     EtherCatBus* bus_ = nullptr;
+
+    //! Aggregated slave states of the bus, notified on state transitions.
+    StateMonitor* stateMonitor_ = nullptr;
 };
 
 } /* namespace tcan_ethercat */
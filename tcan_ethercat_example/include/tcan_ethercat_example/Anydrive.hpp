@@ -1,6 +1,9 @@
 #pragma once
 
 
+// tcan
+#include <tcan/SignalLayout.hpp>
+
 // tcan ethercat
 #include <tcan_ethercat/EtherCatSlave.hpp>
 
@@ -110,36 +113,44 @@ inline AnydriveOutdata createOutdata(Dsp402Command command, double /*torque*/)
     return data;
 }
 
-template <typename Value>
-void readValue(const uint8_t* data, const uint16_t pos, Value& value) {
-  value = 0;
-  const uint16_t len = sizeof(Value);
-  for (uint16_t i = 0; i < len; i++) {
-    value |= (static_cast<Value>(data[pos+i]) << i*8);
-  }
-}
+//! Layout of the process data sent by the drive, in the order of AnydriveIndata
+using AnydriveIndataLayout = tcan::SignalLayout<
+    tcan::Signal<uint16_t, 0>,      // statusword
+    tcan::Signal<int16_t, 2*8>,     // mode of operation display
+    tcan::Signal<int16_t, 4*8>,     // measured temperature
+    tcan::Signal<int16_t, 6*8>,     // measured motor voltage
+    tcan::Signal<int64_t, 8*8>,     // measured motor position
+    tcan::Signal<int64_t, 16*8>,    // measured gear position
+    tcan::Signal<int64_t, 24*8>,    // measured joint position
+    tcan::Signal<int32_t, 32*8>,    // measured motor current
+    tcan::Signal<int32_t, 36*8>,    // measured motor velocity
+    tcan::Signal<int32_t, 40*8>,    // measured gear velocity
+    tcan::Signal<int32_t, 44*8>,    // measured joint velocity
+    tcan::Signal<int32_t, 48*8>,    // measured joint acceleration
+    tcan::Signal<int32_t, 52*8>>;   // measured joint torque
 
 inline AnydriveIndata createIndata(const tcan_ethercat::EtherCatDatagram& datagram)
 {
-    // Get data
-    uint8_t databuffer[56];
-    memcpy(&databuffer[0], datagram.getData(), datagram.getDataLength());
+    AnydriveIndata data;
+    if(datagram.getDataLength() < AnydriveIndataLayout::Size) {
+        return data;
+    }
 
     // Store data
-    AnydriveIndata data;
-    readValue(&databuffer[0], 0, data.statusword.all);
-    readValue(&databuffer[0], 2, data.mode_of_operation_display);
-    readValue(&databuffer[0], 4, data.measured_temperature);
-    readValue(&databuffer[0], 6, data.measured_motor_voltage);
-    readValue(&databuffer[0], 8, data.measured_motor_position);
-    readValue(&databuffer[0], 16, data.measured_gear_position);
-    readValue(&databuffer[0], 24, data.measured_joint_position);
-    readValue(&databuffer[0], 32, data.measured_motor_current);
-    readValue(&databuffer[0], 36, data.measured_motor_velocity);
-    readValue(&databuffer[0], 40, data.measured_gear_velocity);
-    readValue(&databuffer[0], 44, data.measured_joint_velocity);
-    readValue(&databuffer[0], 48, data.measured_joint_acceleration);
-    readValue(&databuffer[0], 52, data.measured_joint_torque);
+    const uint8_t* buffer = datagram.getData();
+    data.statusword.all = AnydriveIndataLayout::get<0>(buffer);
+    data.mode_of_operation_display = AnydriveIndataLayout::get<1>(buffer);
+    data.measured_temperature = AnydriveIndataLayout::get<2>(buffer);
+    data.measured_motor_voltage = AnydriveIndataLayout::get<3>(buffer);
+    data.measured_motor_position = AnydriveIndataLayout::get<4>(buffer);
+    data.measured_gear_position = AnydriveIndataLayout::get<5>(buffer);
+    data.measured_joint_position = AnydriveIndataLayout::get<6>(buffer);
+    data.measured_motor_current = AnydriveIndataLayout::get<7>(buffer);
+    data.measured_motor_velocity = AnydriveIndataLayout::get<8>(buffer);
+    data.measured_gear_velocity = AnydriveIndataLayout::get<9>(buffer);
+    data.measured_joint_velocity = AnydriveIndataLayout::get<10>(buffer);
+    data.measured_joint_acceleration = AnydriveIndataLayout::get<11>(buffer);
+    data.measured_joint_torque = AnydriveIndataLayout::get<12>(buffer);
     return data;
 }
 